@@ -37,6 +37,14 @@ struct BuildAction
   #pragma db not_null
   Type type;
 
+  /**
+   * True if every fact of the action has been stored in the database. This is
+   * set in the same transaction as the last facts, so an action without it is
+   * redone when an interrupted parse is resumed.
+   */
+  #pragma db not_null
+  bool completed = false;
+
   #pragma db value_not_null inverse(action)
   std::vector<odb::lazy_weak_ptr<BuildSource>> sources;
 
@@ -51,6 +51,12 @@ struct File
   #pragma db null
   std::uint64_t timestamp;
 
+  // The MIME type and the character set of the file as libmagic reports them,
+  // e.g. "text/x-c++; charset=us-ascii". It is set once by the SourceManager,
+  // and the plugins read it from here instead of classifying the file again.
+  #pragma db null
+  std::string mimeType;
+
   // The reason why the file content attribute is read-only is that when a
   // plugin adds a file through the SourceManager then the content is also added
   // for the first time. When another plugin wants to modify the file type for
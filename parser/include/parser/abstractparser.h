@@ -14,6 +14,20 @@ namespace parser
 class AbstractParser
 {
 public:
+  /**
+   * Resource needs of a parser. The driver runs independent parsers at the
+   * same time, and these decide how the --jobs threads are shared among them.
+   */
+  enum Resource
+  {
+    CPU_HEAVY = 1 << 0, /*!< The parser keeps several threads busy, so it gets
+      a share of the --jobs threads (see ParserContext::jobs()). Other parsers
+      get one thread. */
+
+    DATABASE_HEAVY = 1 << 1 /*!< The parser writes a lot to the database. Such
+      parsers don't run at the same time with each other. */
+  };
+
   /**
    * Constructor, initialize the parsers
    * @param ctx_ - Parser context options
@@ -44,6 +58,25 @@ public:
    * @return Returns true if the parse succeeded, false otherwise.
    */
   virtual bool parse() = 0;
+
+  /**
+   * Returns the names of the parsers (e.g. cppparser) which have to finish a
+   * phase before this parser starts the same phase. The parsers which are not
+   * loaded are ignored.
+   */
+  virtual std::vector<std::string> getDependencies() const
+  {
+    return {};
+  }
+
+  /**
+   * Returns the resource needs of the parser as a combination of Resource
+   * flags. By default a parser is assumed to be both CPU and database heavy.
+   */
+  virtual unsigned getResources() const
+  {
+    return CPU_HEAVY | DATABASE_HEAVY;
+  }
   
 protected:
   ParserContext& _ctx;
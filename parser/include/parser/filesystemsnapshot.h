@@ -0,0 +1,95 @@
+#ifndef CC_PARSER_FILESYSTEMSNAPSHOT_H
+#define CC_PARSER_FILESYSTEMSNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cc
+{
+namespace parser
+{
+
+/**
+ * The metadata of the input files as they were at the start of the last
+ * successful parse. An incremental parse compares the live files to it by
+ * their metadata, and only the files which differ are read and hashed.
+ *
+ * The snapshot is stored in the project directory. It is removed before the
+ * database is modified and written again when the parse succeeded, so an
+ * interrupted parse never leaves a snapshot behind which doesn't describe the
+ * database.
+ */
+class FileSystemSnapshot
+{
+public:
+  struct Entry
+  {
+    std::uint64_t inode = 0;
+    std::uint64_t size = 0;
+
+    /**
+     * Modification time in nanoseconds.
+     */
+    std::int64_t mtime = 0;
+
+    /**
+     * The SHA1 hash of the content of the file in the database. It is empty
+     * if the file is not in the database or its content may have changed
+     * since the snapshot was taken.
+     */
+    std::string hash;
+
+    /**
+     * Returns true if the metadata of the entries are the same.
+     */
+    bool sameMetadata(const Entry& other_) const;
+  };
+
+  /**
+   * Returns the path of the snapshot in the project directory.
+   */
+  static std::string getPath(const std::string& projDir_);
+
+  /**
+   * Fills the metadata of the entry with the status of the file. The symbolic
+   * links are followed.
+   * @return False if the file doesn't exist.
+   */
+  static bool stat(const std::string& path_, Entry& entry_);
+
+  /**
+   * Loads the snapshot from the file. If the file doesn't exist or it can't
+   * be read then the snapshot remains empty.
+   * @return True if the snapshot was loaded.
+   */
+  bool load(const std::string& path_);
+
+  /**
+   * Writes the snapshot to the file. The file is replaced atomically.
+   */
+  bool save(const std::string& path_) const;
+
+  /**
+   * Returns the entry of the path or nullptr if it is not in the snapshot.
+   */
+  const Entry* find(const std::string& path_) const;
+
+  /**
+   * The input directories and files of the parse, sorted.
+   */
+  std::vector<std::string> roots;
+
+  /**
+   * The parser plugins of the parse, sorted.
+   */
+  std::vector<std::string> plugins;
+
+  std::unordered_map<std::string, Entry> entries;
+};
+
+} // parser
+} // cc
+
+#endif // CC_PARSER_FILESYSTEMSNAPSHOT_H
@@ -8,6 +8,11 @@
 
 #include <odb/database.hxx>
 
+#include <util/parserutil.h>
+#include <util/taskgroup.h>
+
+#include <parser/filesystemsnapshot.h>
+
 namespace po = boost::program_options; 
 
 namespace cc
@@ -38,11 +43,65 @@ struct ParserContext
     std::string& compassRoot_,
     po::variables_map& options_);
 
+  /**
+   * Returns the number of worker threads which the calling parser may use.
+   * This is the --jobs option, unless several parsers run at the same time:
+   * then they share the --jobs threads.
+   */
+  int jobs() const;
+
+  /**
+   * Sets the result of jobs() on the current thread while it is alive. The
+   * driver uses this when it runs a parser on a separate thread.
+   */
+  class JobsScope
+  {
+  public:
+    JobsScope(int jobs_);
+    ~JobsScope();
+
+    JobsScope(const JobsScope&) = delete;
+    JobsScope& operator=(const JobsScope&) = delete;
+
+  private:
+    int _previous;
+  };
+
   std::shared_ptr<odb::database> db;
   SourceManager& srcMgr;
   std::string& compassRoot;
   po::variables_map& options;
   std::unordered_map<std::string, IncrementalStatus> fileStatus;
+
+  /**
+   * The worker threads of the whole parser process. There are --jobs of them
+   * and the parsers don't create threads on their own: they run their work in
+   * util::TaskGroup objects on this executor with at most jobs() tasks at the
+   * same time. The phases of the parsers also run on this executor (see
+   * PluginScheduler), so the threads waiting for a task group take part in
+   * its work instead of oversubscribing the machine.
+   */
+  util::TaskExecutor executor;
+
+  /**
+   * The walks of the input directories, shared by the parsers: an input
+   * directory is read from the disk only by the first parser iterating it.
+   * The walks are dropped after the parse phase.
+   */
+  util::DirectoryWalkCache walkCache;
+
+  /**
+   * The metadata of the input files at the start of this parse. The driver
+   * stores it when the parse succeeded, and the next incremental parse reads
+   * and hashes only the files whose metadata differ from it.
+   */
+  FileSystemSnapshot snapshot;
+
+  /**
+   * True if the snapshot of the previous parse was found and no file has
+   * been added, removed or changed since then.
+   */
+  bool inputUnchanged;
 };
 
 } // parser
@@ -0,0 +1,94 @@
+#ifndef CC_PARSER_PLUGINSCHEDULER_H
+#define CC_PARSER_PLUGINSCHEDULER_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <util/taskgroup.h>
+
+#include <parser/pluginhandler.h>
+
+namespace cc
+{
+namespace parser
+{
+
+/**
+ * @brief Runs a phase (e.g. cleanup or parse) of the parser plugins.
+ *
+ * A parser starts the phase when its dependencies (see
+ * AbstractParser::getDependencies()) have finished it. Independent parsers run
+ * at the same time on the threads of the executor, but two database heavy
+ * parsers never do (see AbstractParser::getResources()). The --jobs threads are
+ * a global budget: a parser which is not CPU heavy gets one thread, and the CPU
+ * heavy ones share the rest. A parser learns its share from
+ * ParserContext::jobs().
+ */
+class PluginScheduler
+{
+public:
+  typedef std::function<bool (AbstractParser&)> Phase;
+  typedef std::map<std::string, AbstractParser*> Parsers;
+
+  /**
+   * @param pHandler_ The handler of the created parser plugins.
+   * @param executor_ The executor on which the phases run. It must have at
+   * least jobs_ threads.
+   * @param jobs_ The global thread budget.
+   * @param parallel_ If false then the parsers run one after the other, in the
+   * order of their dependencies.
+   */
+  PluginScheduler(
+    PluginHandler& pHandler_,
+    util::TaskExecutor& executor_,
+    int jobs_,
+    bool parallel_);
+
+  /**
+   * Schedules the given parsers, identified by their names. See the other
+   * constructor for the rest of the parameters.
+   */
+  PluginScheduler(
+    const Parsers& parsers_,
+    util::TaskExecutor& executor_,
+    int jobs_,
+    bool parallel_);
+
+  /**
+   * Returns the names of the loaded parsers in an order in which every parser
+   * follows its dependencies.
+   */
+  const std::vector<std::string>& order() const;
+
+  /**
+   * Runs the phase of every parser.
+   * @param phaseName_ Name of the phase for logging.
+   * @param stopOnFailure_ If true then no parser starts the phase after one of
+   * them failed.
+   * @return False if the phase of any parser failed (returned false or threw
+   * an exception).
+   */
+  bool run(const std::string& phaseName_, Phase phase_, bool stopOnFailure_);
+
+private:
+  struct Plugin
+  {
+    AbstractParser* parser;
+    std::vector<std::string> dependencies;
+    unsigned resources;
+  };
+
+  util::TaskExecutor& _executor;
+  const int _jobs;
+  bool _parallel;
+
+  std::map<std::string, Plugin> _plugins;
+  std::vector<std::string> _order;
+};
+
+} // parser
+} // cc
+
+#endif // CC_PARSER_PLUGINSCHEDULER_H
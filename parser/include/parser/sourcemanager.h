@@ -5,14 +5,14 @@
 #include <mutex>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <unordered_set>
 
-#include <magic.h>
-
 #include <model/file.h>
 #include <model/file-odb.hxx>
 #include <model/filecontent.h>
 
+#include <util/libraryindex.h>
 #include <util/odbtransaction.h>
 
 namespace cc
@@ -23,7 +23,13 @@ namespace parser
 class SourceManager
 {
 public:
-  SourceManager(std::shared_ptr<odb::database> db_);
+  /**
+   * @param libraryIndex_ If given then the content of those files is not
+   * stored which are in this library index with the same content.
+   */
+  SourceManager(
+    std::shared_ptr<odb::database> db_,
+    std::shared_ptr<util::LibraryIndex> libraryIndex_ = nullptr);
   SourceManager(const SourceManager&) = delete;
   ~SourceManager();
 
@@ -70,7 +76,25 @@ public:
   /**
    * This function returns true if the given file is a plain text file.
    */
-  bool isPlainText(const std::string& path_) const;
+  bool isPlainText(const std::string& path_);
+
+  /**
+   * This function returns the MIME type and the character set of the given
+   * file, e.g. "text/x-c++; charset=us-ascii" (see model::File::mimeType).
+   * Files with a known source extension are classified by sniffing their
+   * first block, the others by libmagic. A file is classified only once: the
+   * result is stored in its model::File, or until then in the SourceManager.
+   * This function can be called concurrently: every thread uses its own
+   * libmagic cookie.
+   * @return An empty string if the file can't be classified.
+   */
+  std::string getMimeType(const std::string& path_);
+
+  /**
+   * This function returns true if the MIME type returned by getMimeType()
+   * belongs to a plain text file.
+   */
+  static bool isPlainTextMimeType(const std::string& mimeType_);
 
   // TODO: Maybe this function shouldn't exist.
   void persistFiles();
@@ -82,6 +106,19 @@ public:
    */
   void removeFile(const model::File& file_);
 
+  /**
+   * This function returns true if the file is in the library index with the
+   * same content. The content of these files is not stored in the database of
+   * the project, and the parsers don't need to store their facts either.
+   */
+  bool isLibraryFile(model::FileId fileId_);
+
+  /**
+   * This function returns the library index of the project or nullptr if
+   * there is none.
+   */
+  std::shared_ptr<util::LibraryIndex> libraryIndex() const;
+
 private:
   /**
    * This function creates a model::FileContent object and fills its attributes
@@ -115,13 +152,26 @@ private:
    */
   model::FilePtr getCreateParent(const std::string& path_);
 
+  /**
+   * This function returns true if the library index contains the file with
+   * the given content hash.
+   */
+  bool isInLibraryIndex(model::FileId fileId_, const std::string& hash_) const;
+
   std::shared_ptr<odb::database> _db;
   util::OdbTransaction _transaction;
   std::map<std::string, model::FilePtr> _files;
   std::unordered_set<model::FileId> _persistedFiles;
   std::unordered_set<std::string> _persistedContents;
+  std::shared_ptr<util::LibraryIndex> _libraryIndex;
+  std::unordered_set<model::FileId> _libraryFiles;
   std::mutex _createFileMutex;
-  ::magic_t _magicCookie;
+
+  /**
+   * Classifications of the files which have no model::File yet (e.g. the
+   * files checked by isPlainText() before being added).
+   */
+  std::unordered_map<std::string, std::string> _mimeTypes;
 };
 
 template<typename Filter>
@@ -0,0 +1,163 @@
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+
+#include <sys/stat.h>
+
+#include <util/logutil.h>
+
+#include <parser/filesystemsnapshot.h>
+
+namespace
+{
+
+/**
+ * The first line of the snapshot file. It has to be changed together with
+ * the format of the file.
+ */
+const std::string header = "CodeCompass file system snapshot 1";
+
+} // anonymous namespace
+
+namespace cc
+{
+namespace parser
+{
+
+bool FileSystemSnapshot::Entry::sameMetadata(const Entry& other_) const
+{
+  return inode == other_.inode &&
+         size == other_.size &&
+         mtime == other_.mtime;
+}
+
+std::string FileSystemSnapshot::getPath(const std::string& projDir_)
+{
+  return projDir_ + "/filesystem_snapshot";
+}
+
+bool FileSystemSnapshot::stat(const std::string& path_, Entry& entry_)
+{
+  struct stat st;
+  if (::stat(path_.c_str(), &st) != 0)
+    return false;
+
+  entry_.inode = st.st_ino;
+  entry_.size = st.st_size;
+  entry_.mtime
+    = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000
+    + st.st_mtim.tv_nsec;
+
+  return true;
+}
+
+bool FileSystemSnapshot::load(const std::string& path_)
+{
+  roots.clear();
+  plugins.clear();
+  entries.clear();
+
+  std::ifstream file(path_);
+  std::string line;
+
+  if (!std::getline(file, line) || line != header)
+    return false;
+
+  // The lines are "root <path>", "plugin <name>" and
+  // "<inode> <size> <mtime> <hash or -> <path>".
+  while (std::getline(file, line))
+  {
+    if (line.compare(0, 5, "root ") == 0)
+    {
+      roots.push_back(line.substr(5));
+      continue;
+    }
+
+    if (line.compare(0, 7, "plugin ") == 0)
+    {
+      plugins.push_back(line.substr(7));
+      continue;
+    }
+
+    Entry entry;
+    char hash[41];
+    int pathPos = -1;
+
+    if (std::sscanf(line.c_str(),
+          "%" SCNu64 " %" SCNu64 " %" SCNd64 " %40s%n",
+          &entry.inode, &entry.size, &entry.mtime, hash, &pathPos) != 4 ||
+        pathPos < 0 || static_cast<std::size_t>(pathPos) + 1 >= line.size())
+    {
+      LOG(warning) << "Invalid file system snapshot: " << path_;
+
+      roots.clear();
+      plugins.clear();
+      entries.clear();
+      return false;
+    }
+
+    if (hash[0] != '-')
+      entry.hash = hash;
+
+    entries.emplace(line.substr(pathPos + 1), std::move(entry));
+  }
+
+  return true;
+}
+
+bool FileSystemSnapshot::save(const std::string& path_) const
+{
+  const std::string tmpPath = path_ + ".tmp";
+
+  {
+    std::ofstream file(tmpPath, std::ios::trunc);
+
+    file << header << '\n';
+
+    for (const std::string& root : roots)
+      file << "root " << root << '\n';
+
+    for (const std::string& plugin : plugins)
+      file << "plugin " << plugin << '\n';
+
+    for (const auto& item : entries)
+    {
+      // Such paths couldn't be read back, so these files are always checked.
+      if (item.first.find('\n') != std::string::npos)
+        continue;
+
+      const Entry& entry = item.second;
+
+      file
+        << entry.inode << ' ' << entry.size << ' ' << entry.mtime << ' '
+        << (entry.hash.empty() ? "-" : entry.hash) << ' '
+        << item.first << '\n';
+    }
+
+    if (!file)
+    {
+      LOG(warning) << "Failed to write the file system snapshot: " << tmpPath;
+      std::remove(tmpPath.c_str());
+      return false;
+    }
+  }
+
+  if (std::rename(tmpPath.c_str(), path_.c_str()) != 0)
+  {
+    LOG(warning) << "Failed to write the file system snapshot: " << path_;
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+const FileSystemSnapshot::Entry* FileSystemSnapshot::find(
+  const std::string& path_) const
+{
+  auto it = entries.find(path_);
+  return it == entries.end() ? nullptr : &it->second;
+}
+
+} // parser
+} // cc
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -15,11 +16,14 @@
 
 #include <util/dbutil.h>
 #include <util/filesystem.h>
+#include <util/libraryindex.h>
 #include <util/logutil.h>
 #include <util/odbtransaction.h>
 
+#include <parser/filesystemsnapshot.h>
 #include <parser/parsercontext.h>
 #include <parser/pluginhandler.h>
+#include <parser/pluginscheduler.h>
 #include <parser/sourcemanager.h>
 
 namespace po = boost::program_options;
@@ -62,6 +66,13 @@ po::options_description commandLineArguments()
       "build to support PostgreSQL or SQLite. Connection string has the "
       "following format: 'pgsql:database=name;port=5432;user=user_name' or "
       "'sqlite:database=~/cc/mydatabase.sqlite'.")
+    ("library-index", po::value<std::string>(),
+      "Connection string of a library index database. This is the database of "
+      "an earlier parse of a library (e.g. an SDK version), which is shared "
+      "between the projects and is only read. The files of the project which "
+      "are in the library index with the same content are not stored again: "
+      "neither their content, nor their C++ facts. Incremental parses use the "
+      "library index of the previous parse by default.")
     ("label", po::value<std::vector<std::string>>(),
       "The submodules of a large project can be labeled so it can be easier "
       "later to locate them. With this flag you can provide a label list in "
@@ -316,6 +327,33 @@ int main(int argc, char* argv[])
   if (projDir.empty())
     return 1;
 
+  //--- Check for an interrupted parse ---//
+
+  /*
+   * This file exists while the parse is in progress. If the parser dies (e.g.
+   * it is killed or the machine is rebooted) then the next run finds it and
+   * resumes the parse: the plugins skip the work which has been completely
+   * stored in the database (see e.g. the completion markers of the build
+   * actions in the C++ parser). The file contains "initial" if the interrupted
+   * parse was an initial one, so the resumed one has to finish it by creating
+   * the indexes.
+   */
+  const std::string checkpoint = projDir + "/parse_checkpoint";
+  bool resume = false;
+  bool resumeInitial = false;
+
+  if (!isNewDb && !vm.count("force") && fs::exists(checkpoint))
+  {
+    resume = true;
+
+    std::ifstream checkpointFile(checkpoint);
+    std::string mode;
+    checkpointFile >> mode;
+    resumeInitial = mode == "initial";
+
+    LOG(info) << "The previous parse has been interrupted, resuming it.";
+  }
+
   //--- Create and init database ---//
 
   std::shared_ptr<odb::database> db = cc::util::connectDatabase(
@@ -336,6 +374,8 @@ int main(int argc, char* argv[])
 
   if (vm.count("force") || isNewDb)
     cc::util::createTables(db, SQL_DIR);
+  else
+    cc::util::upgradeSchema(db);
 
   //--- Start parsers ---//
 
@@ -348,14 +388,35 @@ int main(int argc, char* argv[])
    * 5. all plugin parsers perform a parsing operation.
    *
    * In case of an initial or forced parsing, only step 5 is executed.
+   *
+   * In steps 3 and 5 the independent plugins run at the same time, sharing
+   * the --jobs threads (see PluginScheduler). Step 2 is sequential, because
+   * the plugins extend the same list of modified files.
    */
 
-  cc::parser::SourceManager srcMgr(db);
+  std::shared_ptr<cc::util::LibraryIndex> libraryIndex
+    = vm.count("library-index")
+    ? cc::util::LibraryIndex::connect(vm["library-index"].as<std::string>())
+    : cc::util::LibraryIndex::forProject(projDir);
+
+  if (vm.count("library-index") && !libraryIndex)
+    return 1;
+
+  cc::parser::SourceManager srcMgr(db, libraryIndex);
   cc::parser::ParserContext ctx(db, srcMgr, compassRoot, vm);
   pHandler.createPlugins(ctx);
 
-  std::vector<std::string> pluginNames = pHandler.getLoadedPluginNames();
-  for (const std::string& pluginName : pluginNames)
+#ifdef DATABASE_SQLITE
+  // SQLite allows only one writer at a time.
+  const bool parallelPlugins = false;
+#else
+  const bool parallelPlugins = true;
+#endif
+
+  cc::parser::PluginScheduler scheduler(
+    pHandler, ctx.executor, vm["jobs"].as<int>(), parallelPlugins);
+
+  for (const std::string& pluginName : scheduler.order())
   {
     LOG(info) << "[" << pluginName << "] started to mark modified files!";
     pHandler.getParser(pluginName)->markModifiedFiles();
@@ -375,31 +436,83 @@ int main(int argc, char* argv[])
     vm.insert(std::make_pair("force", po::variable_value()));
   }
 
-  if (!vm.count("force"))
+  //--- Check for a parse without changes ---//
+
+  /*
+   * The snapshot describes the database only until the database is modified,
+   * so it is removed here and written again after a successful parse.
+   */
+  const std::string snapshotPath
+    = cc::parser::FileSystemSnapshot::getPath(projDir);
+
+  std::vector<std::string> plugins = scheduler.order();
+  std::sort(plugins.begin(), plugins.end());
+
+  const bool unchanged = !vm.count("force") && !isNewDb && !resume &&
+    ctx.inputUnchanged && ctx.fileStatus.empty() &&
+    ctx.snapshot.plugins == plugins;
+
+  ctx.snapshot.plugins = plugins;
+  fs::remove(snapshotPath);
+
+  if (unchanged)
+    LOG(info) << "No input file changed since the last parse, the parsers "
+                 "are skipped.";
+
   {
-    for (const std::string& pluginName : pluginNames)
+    std::ofstream checkpointFile(checkpoint, std::ios::trunc);
+    checkpointFile
+      << (vm.count("force") || isNewDb || resumeInitial
+        ? "initial" : "incremental");
+  }
+
+  if (!vm.count("force") && !unchanged)
+  {
+    if (!scheduler.run("cleanup",
+      [](cc::parser::AbstractParser& parser_){
+        return parser_.cleanupDatabase(); },
+      true))
     {
-      LOG(info) << "[" << pluginName << "] cleanup started!";
-      if (!pHandler.getParser(pluginName)->cleanupDatabase())
-      {
-        LOG(error) << "[" << pluginName << "] cleanup failed!";
-        return 2;
-      }
+      // Nothing has been parsed yet, so the next run has to detect the changes
+      // again instead of resuming this parse.
+      fs::remove(checkpoint);
+      return 2;
     }
 
     incrementalCleanup(ctx);
   }
 
   // TODO: Handle errors returned by parse().
-  for (const std::string& pluginName : pluginNames)
+  const bool parsed = unchanged ||
+    scheduler.run("parse",
+      [](cc::parser::AbstractParser& parser_){ return parser_.parse(); },
+      false);
+
+  ctx.walkCache.clear();
+
+  //--- Store the snapshot of the input files ---//
+
+  // If a parser failed then the database may not describe the input files, so
+  // the next parse has to check them again.
+  if (parsed)
   {
-    LOG(info) << "[" << pluginName << "] parse started!";
-    pHandler.getParser(pluginName)->parse();
+    // The content of the reparsed files in the database may differ from the
+    // one which was hashed at the start.
+    for (const auto& item : ctx.fileStatus)
+    {
+      auto it = ctx.snapshot.entries.find(item.first);
+      if (it != ctx.snapshot.entries.end())
+        it->second.hash.clear();
+    }
+
+    ctx.snapshot.save(snapshotPath);
   }
+  else
+    LOG(warning) << "Parsing failed, the file system snapshot is not stored.";
 
   //--- Add indexes to the database ---//
 
-  if (vm.count("force") || isNewDb)
+  if (vm.count("force") || isNewDb || resumeInitial)
     cc::util::createIndexes(db, SQL_DIR);
 
   //--- Create project config file ---//
@@ -430,11 +543,16 @@ int main(int argc, char* argv[])
 
   pt.put("database", vm["database"].as<std::string>());
 
+  if (libraryIndex)
+    pt.put("libraryIndex", libraryIndex->connectionString());
+
   if (vm.count("description"))
     pt.put("description", vm["description"].as<std::string>());
 
   boost::property_tree::write_json(projDir + "/project_info.json", pt);
 
+  fs::remove(checkpoint);
+
   // TODO: Print statistics.
 
   return 0;
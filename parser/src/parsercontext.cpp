@@ -1,18 +1,31 @@
+#include <algorithm>
+#include <chrono>
 #include <fstream>
-
-#include <boost/filesystem.hpp>
+#include <unordered_set>
 
 #include <model/file.h>
 #include <model/file-odb.hxx>
 
 #include <util/hash.h>
 #include <util/odbtransaction.h>
+#include <util/logutil.h>
 
 #include <parser/parsercontext.h>
 #include <parser/sourcemanager.h>
 
 namespace po = boost::program_options;
 
+namespace
+{
+
+/**
+ * The number of threads of the parser running on the current thread, or 0 if
+ * it is not set by the driver.
+ */
+thread_local int currentJobs = 0;
+
+}
+
 namespace cc
 {
 namespace parser
@@ -26,9 +39,49 @@ ParserContext::ParserContext(
     db(db_),
     srcMgr(srcMgr_),
     compassRoot(compassRoot_),
-    options(options_)
+    options(options_),
+    executor(std::max(options_["jobs"].as<int>(), 1)),
+    walkCache(executor),
+    inputUnchanged(false)
 {
-  std::unordered_map<std::string, std::string> fileHashes;
+  const auto scanStart = std::chrono::system_clock::now();
+
+  //--- Load the snapshot of the previous parse ---//
+
+  if (options_.count("input"))
+    snapshot.roots = options_["input"].as<std::vector<std::string>>();
+  std::sort(snapshot.roots.begin(), snapshot.roots.end());
+
+  const std::string projDir = options_["workspace"].as<std::string>()
+    + '/' + options_["name"].as<std::string>();
+
+  FileSystemSnapshot previous;
+  bool hasPrevious = previous.load(FileSystemSnapshot::getPath(projDir));
+
+  if (hasPrevious && previous.roots != snapshot.roots)
+  {
+    LOG(info) << "The input paths changed since the last parse.";
+    previous = FileSystemSnapshot();
+    hasPrevious = false;
+  }
+
+  // The driver compares these to the current plugins and replaces them.
+  snapshot.plugins = previous.plugins;
+
+  // A file in the database or under an input directory. Only the files of the
+  // database are hashed, and only if their metadata differ from the snapshot.
+  struct FileCheck
+  {
+    std::string path;
+    model::FilePtr file;
+    const FileSystemSnapshot::Entry* previous = nullptr;
+    FileSystemSnapshot::Entry current;
+    bool exists = false;
+    std::string hash;
+  };
+
+  std::vector<FileCheck> checks;
+  bool changed = false;
 
   (util::OdbTransaction(this->db))([&]
    {
@@ -40,43 +93,166 @@ ParserContext::ParserContext(
      };
      std::vector<model::FilePtr> files = this->srcMgr.getFiles(func);
 
+     std::unordered_set<std::string> paths;
+
      for (model::FilePtr file : files)
-     {
-       if (boost::filesystem::exists(file->path))
+       if (paths.insert(file->path).second)
        {
-         if (!fileStatus.count(file->path))
+         checks.emplace_back();
+         checks.back().path = file->path;
+         checks.back().file = file;
+       }
+
+     // The files which are not in the database are checked only by their
+     // metadata, so that the added files are detected. The walks are shared
+     // with the parsers.
+     for (const std::string& root : snapshot.roots)
+       walkCache.iterate(root, jobs(), [&](const util::DirEntry& entry_)
+       {
+         if (entry_.type == util::DirEntry::Type::Regular &&
+             paths.insert(entry_.path).second)
          {
-           model::FileContentPtr content = file->content.load();
-           if (!content)
-             continue;
+           checks.emplace_back();
+           checks.back().path = entry_.path;
+         }
+         return true;
+       });
+
+     //--- Stat the files and hash the suspicious ones in parallel ---//
 
-           fileHashes[file->path] = content->hash;
+     const std::size_t chunkSize = 512;
+     util::TaskGroup group(executor, jobs());
+
+     for (std::size_t begin = 0; begin < checks.size(); begin += chunkSize)
+       group.run([&, begin]
+       {
+         std::size_t end = std::min(begin + chunkSize, checks.size());
 
-           std::ifstream fileStream(file->path);
+         for (std::size_t i = begin; i < end; ++i)
+         {
+           FileCheck& check = checks[i];
+
+           check.previous = previous.find(check.path);
+           check.exists = FileSystemSnapshot::stat(check.path, check.current);
+
+           // The files without content in the database can't be compared.
+           if (!check.exists || !check.file || !check.file->content ||
+               (check.previous &&
+                check.previous->sameMetadata(check.current)))
+             continue;
+
+           std::ifstream fileStream(check.path);
            std::string fileContent(
              std::istreambuf_iterator<char>{fileStream},
              std::istreambuf_iterator<char>{});
-           fileStream.close();
+           check.hash = util::sha1Hash(fileContent);
+         }
+       });
+
+     group.wait();
 
-           if (content->hash != util::sha1Hash(fileContent))
+     //--- Compare the hashed files to the database ---//
+
+     // Files modified right before the scan may be modified again without
+     // changing their metadata, so these are checked again next time.
+     const std::int64_t racyTime
+       = std::chrono::duration_cast<std::chrono::nanoseconds>(
+           (scanStart - std::chrono::seconds(1)).time_since_epoch()).count();
+
+     std::size_t hashed = 0;
+     std::size_t matched = 0;
+
+     for (FileCheck& check : checks)
+     {
+       if (check.previous)
+         ++matched;
+
+       if (!check.exists)
+       {
+         if (check.file)
+         {
+           if (!fileStatus.count(check.path))
            {
-             this->fileStatus.emplace(
-               file->path, cc::parser::IncrementalStatus::MODIFIED);
-             LOG(debug) << "File modified: " << file->path;
+             fileStatus.emplace(
+               check.path, cc::parser::IncrementalStatus::DELETED);
+             LOG(debug) << "File deleted: " << check.path;
            }
          }
+         else
+           changed = true;
+
+         continue;
        }
-       else
+
+       bool same = check.previous &&
+         check.previous->sameMetadata(check.current);
+
+       if (check.file && same)
+         check.current.hash = check.previous->hash;
+       else if (check.file && !check.file->content)
        {
-         fileStatus.emplace(
-           file->path, cc::parser::IncrementalStatus::DELETED);
-         LOG(debug) << "File deleted: " << file->path;
+         // The files without content in the database can't be compared. They
+         // are recorded without a hash, so they are not read again until
+         // their metadata change.
        }
+       else if (check.file)
+       {
+         ++hashed;
+
+         // The hash in the snapshot is the one in the database, if any.
+         std::string hash;
+
+         if (check.previous && !check.previous->hash.empty())
+           hash = check.previous->hash;
+         else
+           hash = check.file->content.load()->hash;
+
+         if (hash == check.hash)
+           check.current.hash = hash;
+         else if (!fileStatus.count(check.path))
+         {
+           fileStatus.emplace(
+             check.path, cc::parser::IncrementalStatus::MODIFIED);
+           LOG(debug) << "File modified: " << check.path;
+         }
+       }
+       else if (!same)
+         changed = true;
+
+       if (check.current.mtime < racyTime)
+         snapshot.entries.emplace(
+           std::move(check.path), std::move(check.current));
      }
 
+     // Some files of the snapshot don't exist anymore.
+     if (matched != previous.entries.size())
+       changed = true;
+
+     LOG(info)
+       << "Checked " << checks.size() << " files by their metadata, "
+       << hashed << " of them were hashed.";
+
      // TODO: detect ADDED files
    });
+
+  inputUnchanged = hasPrevious && !changed && fileStatus.empty();
+}
+
+int ParserContext::jobs() const
+{
+  return currentJobs > 0 ? currentJobs : options["jobs"].as<int>();
 }
+
+ParserContext::JobsScope::JobsScope(int jobs_) : _previous(currentJobs)
+{
+  currentJobs = jobs_;
+}
+
+ParserContext::JobsScope::~JobsScope()
+{
+  currentJobs = _previous;
+}
+
 }
 }
 
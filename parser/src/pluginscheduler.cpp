@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+
+#include <util/logutil.h>
+
+#include <parser/pluginscheduler.h>
+
+namespace
+{
+
+cc::parser::PluginScheduler::Parsers loadedParsers(
+  cc::parser::PluginHandler& pHandler_)
+{
+  cc::parser::PluginScheduler::Parsers parsers;
+
+  for (const std::string& name : pHandler_.getLoadedPluginNames())
+    parsers[name] = pHandler_.getParser(name).get();
+
+  return parsers;
+}
+
+}
+
+namespace cc
+{
+namespace parser
+{
+
+PluginScheduler::PluginScheduler(
+  PluginHandler& pHandler_,
+  util::TaskExecutor& executor_,
+  int jobs_,
+  bool parallel_)
+    : PluginScheduler(loadedParsers(pHandler_), executor_, jobs_, parallel_)
+{
+}
+
+PluginScheduler::PluginScheduler(
+  const Parsers& parsers_,
+  util::TaskExecutor& executor_,
+  int jobs_,
+  bool parallel_)
+    : _executor(executor_),
+      _jobs(std::max(jobs_, 1)),
+      _parallel(parallel_)
+{
+  for (const auto& parser : parsers_)
+    _plugins[parser.first] = Plugin{
+      parser.second, {}, parser.second->getResources()};
+
+  for (auto& plugin : _plugins)
+    for (const std::string& dep : plugin.second.parser->getDependencies())
+      if (_plugins.count(dep))
+        plugin.second.dependencies.push_back(dep);
+      else
+        LOG(debug)
+          << "[" << plugin.first << "] dependency " << dep << " is not loaded";
+
+  //--- Topological order ---//
+
+  std::set<std::string> done;
+
+  while (_order.size() < _plugins.size())
+  {
+    std::size_t before = _order.size();
+
+    for (const auto& plugin : _plugins)
+      if (!done.count(plugin.first) &&
+          std::all_of(
+            plugin.second.dependencies.begin(),
+            plugin.second.dependencies.end(),
+            [&](const std::string& dep_){ return done.count(dep_); }))
+      {
+        _order.push_back(plugin.first);
+        done.insert(plugin.first);
+      }
+
+    if (_order.size() == before)
+    {
+      LOG(error)
+        << "The dependencies of the parsers are circular, they run one after "
+           "the other in alphabetical order.";
+
+      _order.clear();
+      for (auto& plugin : _plugins)
+      {
+        plugin.second.dependencies.clear();
+        _order.push_back(plugin.first);
+      }
+
+      _parallel = false;
+      break;
+    }
+  }
+}
+
+const std::vector<std::string>& PluginScheduler::order() const
+{
+  return _order;
+}
+
+bool PluginScheduler::run(
+  const std::string& phaseName_,
+  Phase phase_,
+  bool stopOnFailure_)
+{
+  enum class State { Waiting, Running, Done };
+
+  std::mutex lock;
+  std::condition_variable finished;
+
+  std::map<std::string, State> states;
+  for (const std::string& name : _order)
+    states[name] = State::Waiting;
+
+  int freeThreads = _jobs;
+  bool databaseBusy = false;
+  bool failed = false;
+
+  auto start = [&](const std::string& name_, int jobs_)
+  {
+    const Plugin& plugin = _plugins.at(name_);
+
+    states[name_] = State::Running;
+    freeThreads -= jobs_;
+    if (plugin.resources & AbstractParser::DATABASE_HEAVY)
+      databaseBusy = true;
+
+    LOG(info)
+      << "[" << name_ << "] " << phaseName_ << " started with " << jobs_
+      << " thread(s)!";
+
+    _executor.post([&, name_, jobs_,
+      parser = plugin.parser, resources = plugin.resources]()
+    {
+      bool success;
+
+      try
+      {
+        ParserContext::JobsScope scope(jobs_);
+        success = phase_(*parser);
+      }
+      catch (const std::exception& ex_)
+      {
+        LOG(error)
+          << "[" << name_ << "] " << phaseName_ << " threw an exception: "
+          << ex_.what();
+        success = false;
+      }
+      catch (...)
+      {
+        LOG(error)
+          << "[" << name_ << "] " << phaseName_ << " threw an exception!";
+        success = false;
+      }
+
+      if (!success)
+        LOG(error) << "[" << name_ << "] " << phaseName_ << " failed!";
+
+      std::lock_guard<std::mutex> guard(lock);
+
+      states[name_] = State::Done;
+      freeThreads += jobs_;
+      if (resources & AbstractParser::DATABASE_HEAVY)
+        databaseBusy = false;
+      failed = failed || !success;
+
+      finished.notify_all();
+    });
+  };
+
+  std::unique_lock<std::mutex> guard(lock);
+
+  while (true)
+  {
+    bool running = false;
+    bool waiting = false;
+
+    for (const auto& state : states)
+    {
+      running = running || state.second == State::Running;
+      waiting = waiting || state.second == State::Waiting;
+    }
+
+    if (!waiting || (failed && stopOnFailure_))
+    {
+      if (!running)
+        break;
+
+      finished.wait(guard);
+      continue;
+    }
+
+    //--- Collect the parsers which can start now ---//
+
+    std::vector<std::string> light;
+    std::vector<std::string> heavy;
+    bool database = databaseBusy;
+
+    if (_parallel || !running)
+      for (const std::string& name : _order)
+      {
+        const Plugin& plugin = _plugins.at(name);
+
+        if (states[name] != State::Waiting ||
+            !std::all_of(
+              plugin.dependencies.begin(),
+              plugin.dependencies.end(),
+              [&](const std::string& dep_){
+                return states[dep_] == State::Done; }))
+          continue;
+
+        if (plugin.resources & AbstractParser::DATABASE_HEAVY)
+        {
+          if (database)
+            continue;
+          database = true;
+        }
+
+        (plugin.resources & AbstractParser::CPU_HEAVY
+          ? heavy : light).push_back(name);
+
+        if (!_parallel)
+          break;
+      }
+
+    //--- Share the free threads among them ---//
+
+    for (const std::string& name : light)
+      if (freeThreads > 0)
+        start(name, 1);
+
+    const int available = freeThreads;
+    const int count = static_cast<int>(heavy.size());
+
+    for (int i = 0; i < count && freeThreads > 0; ++i)
+      start(heavy[i], std::max(
+        available / count + (i < available % count ? 1 : 0), 1));
+
+    finished.wait(guard);
+  }
+
+  return !failed;
+}
+
+} // parser
+} // cc
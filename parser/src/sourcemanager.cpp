@@ -1,5 +1,8 @@
 #include <fstream>
 #include <algorithm>
+#include <cctype>
+
+#include <magic.h>
 
 #include <boost/filesystem.hpp>
 
@@ -8,14 +11,138 @@
 
 #include <parser/sourcemanager.h>
 
+namespace
+{
+
+/**
+ * A libmagic cookie. The cookies can't be used concurrently, so every thread
+ * has its own one (see classifyFile()).
+ */
+class MagicCookie
+{
+public:
+  MagicCookie() : _cookie(::magic_open(MAGIC_MIME | MAGIC_SYMLINK))
+  {
+    if (!_cookie)
+      LOG(warning) << "Failed to create a libmagic cookie!";
+    else if (::magic_load(_cookie, nullptr) != 0)
+    {
+      LOG(warning) << "libmagic error: " << ::magic_error(_cookie);
+
+      ::magic_close(_cookie);
+      _cookie = nullptr;
+    }
+  }
+
+  ~MagicCookie()
+  {
+    if (_cookie)
+      ::magic_close(_cookie);
+  }
+
+  MagicCookie(const MagicCookie&) = delete;
+  MagicCookie& operator=(const MagicCookie&) = delete;
+
+  ::magic_t get() const { return _cookie; }
+
+private:
+  ::magic_t _cookie;
+};
+
+/**
+ * MIME types of the well-known source file extensions. These files are not
+ * classified by libmagic.
+ */
+const std::unordered_map<std::string, const char*> sourceExtensions{
+  {".c", "text/x-c"}, {".h", "text/x-c"},
+  {".cpp", "text/x-c++"}, {".cc", "text/x-c++"}, {".cxx", "text/x-c++"},
+  {".hpp", "text/x-c++"}, {".hh", "text/x-c++"}, {".hxx", "text/x-c++"},
+  {".ipp", "text/x-c++"}, {".tcc", "text/x-c++"},
+  {".java", "text/x-java"}, {".py", "text/x-python"},
+  {".js", "application/javascript"}, {".sh", "text/x-shellscript"},
+  {".pl", "text/x-perl"}, {".rb", "text/x-ruby"}, {".php", "text/x-php"},
+  {".txt", "text/plain"}, {".md", "text/plain"}, {".cmake", "text/plain"}
+};
+
+/**
+ * Classifies a file with a known source extension by its first block. If the
+ * extension is unknown, the file is empty or the block contains a zero byte,
+ * then an empty string is returned and the file is left to libmagic. The
+ * character set is a guess from the first block: us-ascii or utf-8.
+ */
+std::string sniffSourceFile(const std::string& path_)
+{
+  std::string extension
+    = boost::filesystem::path(path_).extension().string();
+  std::transform(
+    extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+  auto it = sourceExtensions.find(extension);
+  if (it == sourceExtensions.end())
+    return std::string();
+
+  std::ifstream ifs(path_, std::ios::binary);
+  char buffer[4096];
+  ifs.read(buffer, sizeof(buffer));
+  std::streamsize size = ifs.gcount();
+
+  if (size <= 0)
+    return std::string();
+
+  bool ascii = true;
+  for (std::streamsize i = 0; i < size; ++i)
+  {
+    unsigned char c = static_cast<unsigned char>(buffer[i]);
+
+    if (c == 0)
+      return std::string();
+
+    if (c >= 0x80)
+      ascii = false;
+  }
+
+  return std::string(it->second)
+    + "; charset=" + (ascii ? "us-ascii" : "utf-8");
+}
+
+/**
+ * Classifies the file by its extension and first block, or by libmagic.
+ */
+std::string classifyFile(const std::string& path_)
+{
+  std::string mimeType = sniffSourceFile(path_);
+  if (!mimeType.empty())
+    return mimeType;
+
+  thread_local MagicCookie cookie;
+  if (!cookie.get())
+    return std::string();
+
+  const char* magic = ::magic_file(cookie.get(), path_.c_str());
+
+  if (!magic)
+  {
+    LOG(warning) << "Couldn't use magic on file: " << path_;
+    return std::string();
+  }
+
+  return magic;
+}
+
+} // anonymous namespace
+
 namespace cc
 {
 namespace parser
 {
 
-SourceManager::SourceManager(std::shared_ptr<odb::database> db_)
-  : _db(db_), _transaction(db_), _magicCookie(nullptr)
+SourceManager::SourceManager(
+  std::shared_ptr<odb::database> db_,
+  std::shared_ptr<util::LibraryIndex> libraryIndex_)
+  : _db(db_), _transaction(db_), _libraryIndex(libraryIndex_)
 {
+  std::unordered_set<model::FileId> withoutContent;
+
   _transaction([&, this]() {
 
     //--- Reload files from database ---//
@@ -24,36 +151,28 @@ SourceManager::SourceManager(std::shared_ptr<odb::database> db_)
     {
       _files[file.path] = std::make_shared<model::File>(file);
       _persistedFiles.insert(file.id);
+
+      if (!file.content && file.type != model::File::DIRECTORY_TYPE)
+        withoutContent.insert(file.id);
     }
 
     for (const auto& fileContentId : db_->query<model::FileContentIds>())
       _persistedContents.insert(fileContentId.hash);
   });
 
-  //--- Initialize magic for plain text testing ---//
-
-  if ((_magicCookie = ::magic_open(MAGIC_SYMLINK)))
-  {
-    if (::magic_load(_magicCookie, 0) != 0)
-    {
-      LOG(warning)
-        << "libmagic error: "
-        << ::magic_error(_magicCookie);
+  //--- Reload library files ---//
 
-      ::magic_close(_magicCookie);
-      _magicCookie = nullptr;
-    }
-  }
-  else
-    LOG(warning) << "Failed to create a libmagic cookie!";
+  if (_libraryIndex)
+    (*_libraryIndex)([&, this]() {
+      for (const model::File& file : _libraryIndex->db().query<model::File>())
+        if (file.content && withoutContent.count(file.id))
+          _libraryFiles.insert(file.id);
+    });
 }
 
 SourceManager::~SourceManager()
 {
   persistFiles();
-
-  if (_magicCookie)
-    ::magic_close(_magicCookie);
 }
 
 model::FileContentPtr SourceManager::createFileContent(
@@ -132,18 +251,39 @@ model::FilePtr SourceManager::getCreateFileEntry(
 
   if (file->type != model::File::DIRECTORY_TYPE && withContent_)
   {
-    if (!boost::filesystem::is_regular_file(path, ec))
+    bool isRegular = boost::filesystem::is_regular_file(path, ec);
+    if (isRegular)
+      file->mimeType = getMimeType(path_);
+
+    if (!isRegular)
     {
       LOG(debug)
         << "'" << path_ << "' is not a regular file! Skip saving content.";
     }
-    else if (!isPlainText(path_))
+    else if (!isPlainTextMimeType(file->mimeType))
     {
       LOG(debug)
         << "'" << path_ << "' is not a plain text file! Skip saving content.";
     }
     else
-      file->content = createFileContent(path_);
+    {
+      model::FileContentPtr content = createFileContent(path_);
+
+      if (content && isInLibraryIndex(file->id, content->hash))
+      {
+        std::lock_guard<std::mutex> guard(_createFileMutex);
+        _libraryFiles.insert(file->id);
+      }
+      else
+        file->content = content;
+    }
+  }
+
+  // The classification is kept in the file from now on.
+  if (!file->mimeType.empty())
+  {
+    std::lock_guard<std::mutex> guard(_createFileMutex);
+    _mimeTypes.erase(path_);
   }
 
   return file;
@@ -190,23 +330,66 @@ model::FilePtr SourceManager::getCreateParent(const std::string& path_)
   return getFile(parentPath.native());
 }
 
-bool SourceManager::isPlainText(const std::string& path_) const
+bool SourceManager::isInLibraryIndex(
+  model::FileId fileId_,
+  const std::string& hash_) const
 {
-  static std::mutex _magicFileMutex;
-  std::lock_guard<std::mutex> guard(_magicFileMutex);
+  if (!_libraryIndex)
+    return false;
 
-  const char* magic = ::magic_file(_magicCookie, path_.c_str());
+  return (*_libraryIndex)([&, this]() {
+    model::File file;
 
-  if (!magic)
+    return _libraryIndex->db().find<model::File>(fileId_, file) &&
+      file.content && file.content.object_id() == hash_;
+  });
+}
+
+bool SourceManager::isLibraryFile(model::FileId fileId_)
+{
+  std::lock_guard<std::mutex> guard(_createFileMutex);
+  return _libraryFiles.count(fileId_);
+}
+
+std::shared_ptr<util::LibraryIndex> SourceManager::libraryIndex() const
+{
+  return _libraryIndex;
+}
+
+bool SourceManager::isPlainText(const std::string& path_)
+{
+  return isPlainTextMimeType(getMimeType(path_));
+}
+
+std::string SourceManager::getMimeType(const std::string& path_)
+{
   {
-    LOG(warning) << "Couldn't use magic on file: " << path_;
-    return false;
+    std::lock_guard<std::mutex> guard(_createFileMutex);
+
+    auto fileIt = _files.find(path_);
+    if (fileIt != _files.end() && !fileIt->second->mimeType.empty())
+      return fileIt->second->mimeType;
+
+    auto it = _mimeTypes.find(path_);
+    if (it != _mimeTypes.end())
+      return it->second;
   }
 
-  if (std::strstr(magic, "text"))
-    return true;
+  // The classification runs without holding the lock, so the threads
+  // classify their files in parallel.
+  std::string mimeType = classifyFile(path_);
 
-  return false;
+  std::lock_guard<std::mutex> guard(_createFileMutex);
+  _mimeTypes[path_] = mimeType;
+
+  return mimeType;
+}
+
+bool SourceManager::isPlainTextMimeType(const std::string& mimeType_)
+{
+  // Empty files and directories have binary character set too.
+  return !mimeType_.empty() &&
+    mimeType_.find("charset=binary") == std::string::npos;
 }
 
 void SourceManager::updateFile(const model::File& file_)
@@ -0,0 +1,157 @@
+#include <fstream>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <parser/filesystemsnapshot.h>
+
+namespace fs = boost::filesystem;
+
+using namespace cc;
+
+class FileSystemSnapshotTest : public ::testing::Test
+{
+protected:
+  virtual void SetUp() override
+  {
+    _dir = (fs::temp_directory_path() / fs::unique_path()).string();
+    fs::create_directories(_dir);
+  }
+
+  virtual void TearDown() override
+  {
+    fs::remove_all(_dir);
+  }
+
+  std::string _dir;
+};
+
+TEST_F(FileSystemSnapshotTest, SaveAndLoad)
+{
+  parser::FileSystemSnapshot snapshot;
+  snapshot.roots = {"/input/a", "/input/b c"};
+  snapshot.plugins = {"cpp", "search"};
+
+  parser::FileSystemSnapshot::Entry hashed;
+  hashed.inode = 42;
+  hashed.size = 1234;
+  hashed.mtime = 1500000000123456789;
+  hashed.hash = "0123456789abcdef0123456789abcdef01234567";
+  snapshot.entries["/input/a/main.cpp"] = hashed;
+
+  parser::FileSystemSnapshot::Entry unhashed;
+  unhashed.inode = 43;
+  unhashed.size = 0;
+  unhashed.mtime = -1;
+  snapshot.entries["/input/b c/file with spaces.h"] = unhashed;
+
+  const std::string path = parser::FileSystemSnapshot::getPath(_dir);
+  ASSERT_TRUE(snapshot.save(path));
+
+  parser::FileSystemSnapshot loaded;
+  ASSERT_TRUE(loaded.load(path));
+
+  EXPECT_EQ(loaded.roots, snapshot.roots);
+  EXPECT_EQ(loaded.plugins, snapshot.plugins);
+  ASSERT_EQ(loaded.entries.size(), 2u);
+
+  const parser::FileSystemSnapshot::Entry* entry
+    = loaded.find("/input/a/main.cpp");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_TRUE(entry->sameMetadata(hashed));
+  EXPECT_EQ(entry->hash, hashed.hash);
+
+  entry = loaded.find("/input/b c/file with spaces.h");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_TRUE(entry->sameMetadata(unhashed));
+  EXPECT_TRUE(entry->hash.empty());
+
+  EXPECT_EQ(loaded.find("/input/a/other.cpp"), nullptr);
+}
+
+TEST_F(FileSystemSnapshotTest, SkipsUnreadablePaths)
+{
+  parser::FileSystemSnapshot snapshot;
+  snapshot.entries["/input/new\nline.cpp"] = {};
+  snapshot.entries["/input/plain.cpp"] = {};
+
+  const std::string path = parser::FileSystemSnapshot::getPath(_dir);
+  ASSERT_TRUE(snapshot.save(path));
+
+  parser::FileSystemSnapshot loaded;
+  ASSERT_TRUE(loaded.load(path));
+  EXPECT_EQ(loaded.entries.size(), 1u);
+  EXPECT_NE(loaded.find("/input/plain.cpp"), nullptr);
+}
+
+TEST_F(FileSystemSnapshotTest, RejectsInvalidFiles)
+{
+  parser::FileSystemSnapshot snapshot;
+
+  EXPECT_FALSE(snapshot.load(_dir + "/missing"));
+
+  const std::string path = _dir + "/invalid";
+
+  std::ofstream(path) << "Some other file\n";
+  EXPECT_FALSE(snapshot.load(path));
+
+  // A valid snapshot followed by a broken line is dropped as a whole.
+  parser::FileSystemSnapshot valid;
+  valid.roots = {"/input"};
+  valid.entries["/input/main.cpp"] = {};
+  ASSERT_TRUE(valid.save(path));
+  std::ofstream(path, std::ios::app) << "1 2 three /input/broken.cpp\n";
+
+  EXPECT_FALSE(snapshot.load(path));
+  EXPECT_TRUE(snapshot.roots.empty());
+  EXPECT_TRUE(snapshot.entries.empty());
+}
+
+TEST_F(FileSystemSnapshotTest, DetectsChangedFiles)
+{
+  const std::string path = _dir + "/main.cpp";
+  std::ofstream(path) << "int main() {}\n";
+
+  parser::FileSystemSnapshot::Entry before;
+  ASSERT_TRUE(parser::FileSystemSnapshot::stat(path, before));
+  EXPECT_EQ(before.size, 14u);
+
+  parser::FileSystemSnapshot::Entry unchanged;
+  ASSERT_TRUE(parser::FileSystemSnapshot::stat(path, unchanged));
+  EXPECT_TRUE(unchanged.sameMetadata(before));
+
+  std::ofstream(path, std::ios::app) << "// changed\n";
+
+  parser::FileSystemSnapshot::Entry changed;
+  ASSERT_TRUE(parser::FileSystemSnapshot::stat(path, changed));
+  EXPECT_FALSE(changed.sameMetadata(before));
+
+  // The same size with a different modification time is a change too.
+  changed = before;
+  changed.mtime += 1;
+  EXPECT_FALSE(changed.sameMetadata(before));
+
+  parser::FileSystemSnapshot::Entry missing;
+  EXPECT_FALSE(parser::FileSystemSnapshot::stat(_dir + "/missing", missing));
+}
+
+TEST_F(FileSystemSnapshotTest, SaveReplacesPreviousSnapshot)
+{
+  const std::string path = parser::FileSystemSnapshot::getPath(_dir);
+
+  parser::FileSystemSnapshot first;
+  first.entries["/input/old.cpp"] = {};
+  ASSERT_TRUE(first.save(path));
+
+  parser::FileSystemSnapshot second;
+  second.entries["/input/new.cpp"] = {};
+  ASSERT_TRUE(second.save(path));
+
+  parser::FileSystemSnapshot loaded;
+  ASSERT_TRUE(loaded.load(path));
+  EXPECT_EQ(loaded.find("/input/old.cpp"), nullptr);
+  EXPECT_NE(loaded.find("/input/new.cpp"), nullptr);
+  EXPECT_FALSE(fs::exists(path + ".tmp"));
+}
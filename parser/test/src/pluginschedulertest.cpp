@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <parser/abstractparser.h>
+#include <parser/pluginscheduler.h>
+
+using namespace cc;
+
+namespace
+{
+
+/**
+ * A parser with the given dependencies and resources. The scheduler doesn't
+ * touch the parser context, so it is never constructed.
+ */
+class FakeParser : public parser::AbstractParser
+{
+public:
+  FakeParser(
+    parser::ParserContext& ctx_,
+    std::vector<std::string> dependencies_,
+    unsigned resources_)
+      : AbstractParser(ctx_),
+        _dependencies(std::move(dependencies_)),
+        _resources(resources_)
+  {
+  }
+
+  bool parse() override { return true; }
+
+  std::vector<std::string> getDependencies() const override
+  {
+    return _dependencies;
+  }
+
+  unsigned getResources() const override
+  {
+    return _resources;
+  }
+
+private:
+  std::vector<std::string> _dependencies;
+  unsigned _resources;
+};
+
+}
+
+class PluginSchedulerTest : public ::testing::Test
+{
+protected:
+  PluginSchedulerTest() : _executor(4) {}
+
+  void add(
+    const std::string& name_,
+    std::vector<std::string> dependencies_ = {},
+    unsigned resources_ = 0)
+  {
+    // Only a reference to the storage is bound, no member of the context is
+    // accessed.
+    parser::ParserContext& ctx
+      = *reinterpret_cast<parser::ParserContext*>(&_ctxStorage);
+
+    _owned.emplace_back(
+      new FakeParser(ctx, std::move(dependencies_), resources_));
+    _parsers[name_] = _owned.back().get();
+  }
+
+  /**
+   * Returns the name of the parser.
+   */
+  std::string nameOf(const parser::AbstractParser& parser_) const
+  {
+    for (const auto& parser : _parsers)
+      if (parser.second == &parser_)
+        return parser.first;
+    return std::string();
+  }
+
+  /**
+   * Runs the parse phase, and returns the names of the parsers in the order
+   * in which they finished it.
+   */
+  std::vector<std::string> runAndRecord(bool parallel_, int jobs_ = 4)
+  {
+    parser::PluginScheduler scheduler(_parsers, _executor, jobs_, parallel_);
+
+    std::mutex lock;
+    std::vector<std::string> finished;
+
+    EXPECT_TRUE(scheduler.run("parse",
+      [&](parser::AbstractParser& parser_){
+        std::lock_guard<std::mutex> guard(lock);
+        finished.push_back(nameOf(parser_));
+        return true;
+      }, true));
+
+    return finished;
+  }
+
+  static std::size_t indexOf(
+    const std::vector<std::string>& names_,
+    const std::string& name_)
+  {
+    return std::find(names_.begin(), names_.end(), name_) - names_.begin();
+  }
+
+  util::TaskExecutor _executor;
+  std::aligned_storage<sizeof(parser::ParserContext),
+    alignof(parser::ParserContext)>::type _ctxStorage;
+  std::vector<std::unique_ptr<FakeParser>> _owned;
+  parser::PluginScheduler::Parsers _parsers;
+};
+
+TEST_F(PluginSchedulerTest, OrderFollowsDependencies)
+{
+  add("d", {"b", "c"});
+  add("c", {"a"});
+  add("b", {"a", "missing"});
+  add("a");
+
+  parser::PluginScheduler scheduler(_parsers, _executor, 4, true);
+  const std::vector<std::string>& order = scheduler.order();
+
+  ASSERT_EQ(order.size(), 4u);
+  EXPECT_LT(indexOf(order, "a"), indexOf(order, "b"));
+  EXPECT_LT(indexOf(order, "a"), indexOf(order, "c"));
+  EXPECT_LT(indexOf(order, "b"), indexOf(order, "d"));
+  EXPECT_LT(indexOf(order, "c"), indexOf(order, "d"));
+}
+
+TEST_F(PluginSchedulerTest, CircularDependenciesFallBackToAlphabetical)
+{
+  add("b", {"a"});
+  add("a", {"b"});
+  add("c");
+
+  parser::PluginScheduler scheduler(_parsers, _executor, 4, true);
+  EXPECT_EQ(scheduler.order(), (std::vector<std::string>{"a", "b", "c"}));
+
+  // The phase runs the parsers one after the other.
+  EXPECT_EQ(runAndRecord(true), (std::vector<std::string>{"a", "b", "c"}));
+}
+
+TEST_F(PluginSchedulerTest, PhaseStartsAfterDependencies)
+{
+  add("a");
+  add("b", {"a"});
+  add("c", {"a"});
+  add("d", {"b", "c"});
+
+  for (bool parallel : {true, false})
+  {
+    std::vector<std::string> finished = runAndRecord(parallel);
+
+    ASSERT_EQ(finished.size(), 4u);
+    EXPECT_EQ(finished.front(), "a");
+    EXPECT_EQ(finished.back(), "d");
+  }
+}
+
+TEST_F(PluginSchedulerTest, DatabaseHeavyParsersDontOverlap)
+{
+  add("db1", {}, parser::AbstractParser::DATABASE_HEAVY);
+  add("db2", {}, parser::AbstractParser::DATABASE_HEAVY);
+  add("db3", {},
+    parser::AbstractParser::DATABASE_HEAVY |
+    parser::AbstractParser::CPU_HEAVY);
+
+  parser::PluginScheduler scheduler(_parsers, _executor, 4, true);
+
+  std::atomic<int> running(0);
+  std::atomic<int> maxRunning(0);
+
+  EXPECT_TRUE(scheduler.run("parse", [&](parser::AbstractParser&){
+    int current = ++running;
+
+    int max = maxRunning;
+    while (current > max && !maxRunning.compare_exchange_weak(max, current));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    --running;
+    return true;
+  }, true));
+
+  EXPECT_EQ(maxRunning, 1);
+}
+
+TEST_F(PluginSchedulerTest, LightParsersRunAtTheSameTime)
+{
+  add("light1");
+  add("light2");
+  add("db", {}, parser::AbstractParser::DATABASE_HEAVY);
+
+  parser::PluginScheduler scheduler(_parsers, _executor, 4, true);
+
+  std::mutex lock;
+  std::condition_variable cond;
+  int arrived = 0;
+  bool together = true;
+
+  // Each parser waits for the others, which succeeds only if the scheduler
+  // started all of them.
+  EXPECT_TRUE(scheduler.run("parse", [&](parser::AbstractParser&){
+    std::unique_lock<std::mutex> guard(lock);
+    ++arrived;
+    cond.notify_all();
+
+    if (!cond.wait_for(guard, std::chrono::seconds(5),
+          [&]{ return arrived == 3; }))
+      together = false;
+
+    return true;
+  }, true));
+
+  EXPECT_TRUE(together);
+}
+
+TEST_F(PluginSchedulerTest, FailureStopsDependents)
+{
+  add("a");
+  add("b", {"a"});
+  add("c");
+
+  for (bool throws : {false, true})
+  {
+    parser::PluginScheduler scheduler(_parsers, _executor, 4, false);
+    std::vector<std::string> started;
+
+    EXPECT_FALSE(scheduler.run("parse", [&](parser::AbstractParser& parser_){
+      const std::string name = nameOf(parser_);
+      started.push_back(name);
+
+      if (name == "a" && throws)
+        throw std::runtime_error("failure");
+
+      return name != "a";
+    }, true));
+
+    EXPECT_EQ(started, std::vector<std::string>{"a"});
+  }
+}
+
+TEST_F(PluginSchedulerTest, FailureDoesntStopOthersIfAsked)
+{
+  add("a");
+  add("b", {"a"});
+  add("c");
+
+  parser::PluginScheduler scheduler(_parsers, _executor, 4, false);
+  std::vector<std::string> started;
+
+  EXPECT_FALSE(scheduler.run("cleanup", [&](parser::AbstractParser& parser_){
+    const std::string name = nameOf(parser_);
+    started.push_back(name);
+    return name != "a";
+  }, false));
+
+  EXPECT_EQ(started, (std::vector<std::string>{"a", "b", "c"}));
+}
@@ -218,6 +218,36 @@ struct CppAstNodeIds
   CppAstNodeId id;
 };
 
+/**
+ * A lightweight projection of CppAstNode for loading many nodes at once
+ * without their string fields, e.g. every function definition and call of
+ * the workspace.
+ */
+#pragma db view object(CppAstNode)
+struct CppAstNodeLocation
+{
+  CppAstNodeId id;
+
+  std::uint64_t mangledNameHash;
+
+  CppAstNode::AstType astType;
+
+  #pragma db column(CppAstNode::location.file)
+  FileId file;
+
+  #pragma db column(CppAstNode::location.range.start.line)
+  Position::PosType startLine;
+
+  #pragma db column(CppAstNode::location.range.start.column)
+  Position::PosType startColumn;
+
+  #pragma db column(CppAstNode::location.range.end.line)
+  Position::PosType endLine;
+
+  #pragma db column(CppAstNode::location.range.end.column)
+  Position::PosType endColumn;
+};
+
 #pragma db view \
   object(CppAstNode) object(File = LocFile : CppAstNode::location.file) \
   query ((?) + "GROUP BY" + LocFile::id + "ORDER BY" + LocFile::id)
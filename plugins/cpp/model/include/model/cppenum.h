@@ -71,6 +71,14 @@ struct CppEnumConstantsCount
   std::size_t count;
 };
 
+#pragma db view \
+  object(CppEnum) object(CppEnumConstant = EnumConst : CppEnum::enumConstants)
+struct CppEnumConstantAstNodeId
+{
+  #pragma db column(EnumConst::astNodeId)
+  CppAstNodeId astNodeId;
+};
+
 }
 }
 
@@ -47,6 +47,22 @@ struct CppFunctionLocalCount
   std::size_t count;
 };
 
+#pragma db view \
+  object(CppFunction) object(CppVariable = Parameters : CppFunction::parameters)
+struct CppFunctionParamAstNodeId
+{
+  #pragma db column(Parameters::astNodeId)
+  CppAstNodeId astNodeId;
+};
+
+#pragma db view \
+  object(CppFunction) object(CppVariable = Locals : CppFunction::locals)
+struct CppFunctionLocalAstNodeId
+{
+  #pragma db column(Locals::astNodeId)
+  CppAstNodeId astNodeId;
+};
+
 }
 }
 
@@ -90,6 +90,45 @@ struct CppTypeCount
   std::size_t count;
 };
 
+/**
+ * The name, kind and location of a definition, e.g. for exporting every
+ * definition of the workspace to the search index at once. The member kind is
+ * set only for the members of records.
+ */
+#pragma db view \
+  object(CppEntity) \
+  object(CppAstNode : CppEntity::astNodeId == CppAstNode::id) \
+  object(CppMemberType : CppMemberType::memberAstNode == CppAstNode::id)
+struct CppDefinitionLocation
+{
+  #pragma db column(CppAstNode::id)
+  CppAstNodeId astNodeId;
+
+  #pragma db column(CppEntity::name)
+  std::string name;
+
+  #pragma db column(CppAstNode::symbolType)
+  CppAstNode::SymbolType symbolType;
+
+  #pragma db column(CppMemberType::kind)
+  odb::nullable<CppMemberType::Kind> memberKind;
+
+  #pragma db column(CppAstNode::location.file)
+  FileId file;
+
+  #pragma db column(CppAstNode::location.range.start.line)
+  Position::PosType startLine;
+
+  #pragma db column(CppAstNode::location.range.start.column)
+  Position::PosType startColumn;
+
+  #pragma db column(CppAstNode::location.range.end.line)
+  Position::PosType endLine;
+
+  #pragma db column(CppAstNode::location.range.end.column)
+  Position::PosType endColumn;
+};
+
 }
 }
 
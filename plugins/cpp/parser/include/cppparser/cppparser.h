@@ -104,7 +104,16 @@ private:
   bool isSourceFile(const std::string& file_) const;
   bool isNonSourceFlag(const std::string& arg_) const;
   bool parseByJson(const std::string& jsonFile_, std::size_t threadNum_);
-  int parseWorker(const clang::tooling::CompileCommand& command_);
+
+  /**
+   * Parses a translation unit.
+   * @param footprint_ The memory allocated by Clang for the translation unit
+   * is returned here.
+   * @return Non-zero in case of error.
+   */
+  int parseWorker(
+    const clang::tooling::CompileCommand& command_,
+    std::size_t& footprint_);
   
   void initBuildActions();
   void markByInclusion(model::FilePtr file_);
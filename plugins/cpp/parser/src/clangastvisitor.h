@@ -1,10 +1,12 @@
 #ifndef CC_PARSER_CLANGASTVISITOR_H
 #define CC_PARSER_CLANGASTVISITOR_H
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <type_traits>
 #include <stack>
+#include <unordered_set>
 
 #include <clang/Basic/SourceLocation.h>
 #include <clang/Basic/SourceManager.h>
@@ -103,6 +105,9 @@ public:
         _astNodes.push_back(typeLocAstNode);
     }
 
+    if (_ctx.srcMgr.libraryIndex())
+      removeLibraryFacts();
+
     (util::OdbTransaction(_ctx.db))([this]{
       util::persistAll(_astNodes, _ctx.db);
       util::persistAll(_enumConstants, _ctx.db);
@@ -1104,6 +1109,71 @@ public:
   }
 
 private:
+  /**
+   * This function removes those AST nodes (and the entities belonging to them)
+   * which are stored in the library index of the project already. Only the
+   * nodes in library files are looked up: nodes of template instantiations in
+   * library headers may belong to this project only.
+   */
+  void removeLibraryFacts()
+  {
+    std::vector<model::CppAstNodeId> candidates;
+
+    for (const model::CppAstNodePtr& node : _astNodes)
+      if (node->location.file &&
+          _ctx.srcMgr.isLibraryFile(node->location.file.object_id()))
+        candidates.push_back(node->id);
+
+    if (candidates.empty())
+      return;
+
+    std::shared_ptr<util::LibraryIndex> index = _ctx.srcMgr.libraryIndex();
+    std::unordered_set<model::CppAstNodeId> inLibrary;
+
+    (*index)([&]{
+      const std::size_t batchSize = 512;
+
+      for (std::size_t i = 0; i < candidates.size(); i += batchSize)
+      {
+        auto begin = candidates.begin() + i;
+        auto end = candidates.begin()
+          + std::min(i + batchSize, candidates.size());
+
+        for (const model::CppAstNode& node
+          : index->db().query<model::CppAstNode>(
+              odb::query<model::CppAstNode>::id.in_range(begin, end)))
+          inLibrary.insert(node.id);
+      }
+    });
+
+    if (inLibrary.empty())
+      return;
+
+    auto isEntityInLibrary = [&](const auto& entity_) {
+      return inLibrary.count(entity_->astNodeId) != 0;
+    };
+
+    eraseIf(_astNodes, [&](const model::CppAstNodePtr& node_) {
+      return inLibrary.count(node_->id) != 0;
+    });
+    eraseIf(_members, [&](const model::CppMemberTypePtr& member_) {
+      return inLibrary.count(member_->memberAstNode.object_id()) != 0;
+    });
+    eraseIf(_enumConstants, isEntityInLibrary);
+    eraseIf(_enums, isEntityInLibrary);
+    eraseIf(_types, isEntityInLibrary);
+    eraseIf(_typedefs, isEntityInLibrary);
+    eraseIf(_variables, isEntityInLibrary);
+    eraseIf(_namespaces, isEntityInLibrary);
+    eraseIf(_functions, isEntityInLibrary);
+  }
+
+  template <typename Cont, typename Pred>
+  static void eraseIf(Cont& cont_, Pred pred_)
+  {
+    cont_.erase(std::remove_if(cont_.begin(), cont_.end(), pred_), cont_.end());
+  }
+
   /**
    * This function inserts a model::CppAstNodeId to a cache in a thread-safe
    * way. The cache is static so the parsers in each thread can use the same.
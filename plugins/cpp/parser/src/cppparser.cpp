@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <numeric>
 #include <fstream>
+#include <functional>
 #include <iterator>
 #include <memory>
 #include <unordered_map>
@@ -25,7 +26,7 @@
 #include <util/hash.h>
 #include <util/logutil.h>
 #include <util/odbtransaction.h>
-#include <util/threadpool.h>
+#include <util/taskgroup.h>
 
 #include <cppparser/cppparser.h>
 
@@ -35,6 +36,7 @@
 #include "ppincludecallback.h"
 #include "ppmacrocallback.h"
 #include "doccommentcollector.h"
+#include "parseadmission.h"
 
 namespace cc
 {
@@ -57,13 +59,22 @@ public:
     });
   }
 
-  VisitorActionFactory(ParserContext& ctx_) : _ctx(ctx_)
+  VisitorActionFactory(ParserContext& ctx_) : _ctx(ctx_), _footprint(0)
   {
   }
 
   clang::FrontendAction* create() override
   {
-    return new MyFrontendAction(_ctx);
+    return new MyFrontendAction(_ctx, _footprint);
+  }
+
+  /**
+   * Returns the memory allocated by Clang for the parsed translation units
+   * (the AST and the source buffers).
+   */
+  std::size_t footprint() const
+  {
+    return _footprint;
   }
 
 private:
@@ -73,8 +84,10 @@ private:
     MyConsumer(
       ParserContext& ctx_,
       clang::ASTContext& context_,
-      MangledNameCache& mangledNameCache_)
-        : _mangledNameCache(mangledNameCache_), _ctx(ctx_), _context(context_)
+      MangledNameCache& mangledNameCache_,
+      std::size_t& footprint_)
+        : _mangledNameCache(mangledNameCache_), _ctx(ctx_), _context(context_),
+          _footprint(footprint_)
     {
     }
 
@@ -100,6 +113,13 @@ private:
       }
       else
         LOG(info) << "C++ documentation parser has been skipped.";
+
+      const clang::SourceManager& srcMgr = context_.getSourceManager();
+      _footprint
+        += context_.getASTAllocatedMemory()
+        + context_.getSideTableAllocatedMemory()
+        + srcMgr.getContentCacheSize()
+        + srcMgr.getDataStructureSizes();
     }
 
   private:
@@ -108,6 +128,7 @@ private:
 
     ParserContext& _ctx;
     clang::ASTContext& _context;
+    std::size_t& _footprint;
   };
 
   class MyFrontendAction : public clang::ASTFrontendAction
@@ -115,7 +136,8 @@ private:
     friend class VisitorActionFactory;
 
   public:
-    MyFrontendAction(ParserContext& ctx_) : _ctx(ctx_)
+    MyFrontendAction(ParserContext& ctx_, std::size_t& footprint_)
+      : _ctx(ctx_), _footprint(footprint_)
     {
     }
 
@@ -137,16 +159,19 @@ private:
       clang::CompilerInstance& compiler_, llvm::StringRef) override
     {
       return std::unique_ptr<clang::ASTConsumer>(
-        new MyConsumer(_ctx, compiler_.getASTContext(), _mangledNameCache));
+        new MyConsumer(
+          _ctx, compiler_.getASTContext(), _mangledNameCache, _footprint));
     }
 
   private:
     static MangledNameCache _mangledNameCache;
 
     ParserContext& _ctx;
+    std::size_t& _footprint;
   };
 
   ParserContext& _ctx;
+  std::size_t _footprint;
 };
 
 MangledNameCache VisitorActionFactory::MyFrontendAction::_mangledNameCache;
@@ -280,15 +305,20 @@ void CppParser::addCompileCommand(
 
   _ctx.srcMgr.persistFiles();
 
+  buildAction_->completed = true;
+
   transaction([&, this] {
     for (model::BuildSource buildSource : sources)
       _ctx.db->persist(buildSource);
     for (model::BuildTarget buildTarget : targets)
       _ctx.db->persist(buildTarget);
+    _ctx.db->update(*buildAction_);
   });
 }
 
-int CppParser::parseWorker(const clang::tooling::CompileCommand& command_)
+int CppParser::parseWorker(
+  const clang::tooling::CompileCommand& command_,
+  std::size_t& footprint_)
 {
   //--- Assemble compiler command line ---//
 
@@ -326,6 +356,7 @@ int CppParser::parseWorker(const clang::tooling::CompileCommand& command_)
   clang::tooling::ClangTool tool(*compilationDb, command_.Filename);
 
   int error = tool.run(&factory);
+  footprint_ = factory.footprint();
 
   //--- Save build command ---//
 
@@ -510,7 +541,7 @@ bool CppParser::cleanupDatabase()
 
   // Calculate the complete number of cleanup jobs.
 
-  int threadNum = _ctx.options["jobs"].as<int>();
+  int threadNum = _ctx.jobs();
   int numCleanupJobs = std::accumulate(
     topologicallyOrderedFiles.begin(),
     topologicallyOrderedFiles.end(),
@@ -556,17 +587,16 @@ bool CppParser::cleanupDatabase()
   std::size_t jobIndex = 0;
   for (const auto& level : topologicallyOrderedFiles)
   {
-    std::unique_ptr<util::JobQueueThreadPool<CleanupJob>> pool =
-      util::make_thread_pool<CleanupJob>(threadNum, cleanupCommand);
+    util::TaskGroup group(_ctx.executor, threadNum);
 
     LOG(debug) << "[cppparser] Started cleanup level: " << ++levelIndex;
     for (const std::string& filePath : level)
     {
       CleanupJob job(filePath, ++jobIndex);
-      pool->enqueue(job);
+      group.run([&cleanupCommand, job]() mutable { cleanupCommand(job); });
     }
 
-    pool->wait();
+    group.wait();
     LOG(debug)
       << "[cppparser] Finished cleanup level: " << levelIndex
       << " (" << jobIndex << " jobs)";
@@ -666,7 +696,7 @@ bool CppParser::parse()
     : _ctx.options["input"].as<std::vector<std::string>>())
     if (boost::filesystem::is_regular_file(input))
       success
-        = success && parseByJson(input, _ctx.options["jobs"].as<int>());
+        = success && parseByJson(input, _ctx.jobs());
 
   VisitorActionFactory::cleanUp();
   _parsedCommandHashes.clear();
@@ -677,8 +707,32 @@ bool CppParser::parse()
 void CppParser::initBuildActions()
 {
   util::OdbTransaction {_ctx.db} ([&] {
+    typedef odb::query<model::BuildAction> BAQuery;
+    typedef odb::query<model::BuildSource> BSQuery;
+    typedef odb::query<model::BuildTarget> BTQuery;
+
+    std::vector<std::uint64_t> unfinished;
+
     for (const model::BuildAction& ba : _ctx.db->query<model::BuildAction>())
-      _parsedCommandHashes.insert(util::fnvHash(ba.command));
+      if (ba.completed)
+        _parsedCommandHashes.insert(util::fnvHash(ba.command));
+      else
+        unfinished.push_back(ba.id);
+
+    // These actions were being parsed when a previous run was interrupted.
+    // Their facts which have already been stored are kept: these are
+    // deduplicated when the action is parsed again.
+    for (std::uint64_t id : unfinished)
+    {
+      _ctx.db->erase_query<model::BuildSource>(BSQuery::action == id);
+      _ctx.db->erase_query<model::BuildTarget>(BTQuery::action == id);
+      _ctx.db->erase_query<model::BuildAction>(BAQuery::id == id);
+    }
+
+    if (!unfinished.empty())
+      LOG(info)
+        << "[cppparser] " << unfinished.size()
+        << " unfinished build action(s) of an interrupted parse are redone.";
   });
 }
 
@@ -723,27 +777,56 @@ bool CppParser::parseByJson(
     compDb->getAllCompileCommands();
   std::size_t numCompileCommands = compileCommands.size();
 
-  //--- Create a thread pool for the current commands ---//
-  std::unique_ptr<
-    util::JobQueueThreadPool<ParseJob>> pool =
-    util::make_thread_pool<ParseJob>(
-      threadNum_, [this, &numCompileCommands](ParseJob& job_)
-      {
-        const clang::tooling::CompileCommand& command = job_.command;
+  //--- Run the commands on the executor of the parser ---//
 
-        LOG(info)
-          << '(' << job_.index << '/' << numCompileCommands << ')'
-          << " Parsing " << command.Filename;
+  const std::string projDir
+    = _ctx.options["workspace"].as<std::string>() + '/'
+    + _ctx.options["name"].as<std::string>();
 
-        int error = this->parseWorker(command);
+  ParseAdmission admission(
+    threadNum_,
+    _ctx.options.count("memory-limit")
+      ? std::max(_ctx.options["memory-limit"].as<int>(), 1)
+        * std::size_t(1024 * 1024)
+      : 0,
+    projDir + "/cppparser-footprints.txt");
 
-        if (error)
-          LOG(warning)
-            << '(' << job_.index << '/' << numCompileCommands << ')'
-            << " Parsing " << command.Filename << " has been failed.";
-      });
+  util::TaskGroup group(_ctx.executor, threadNum_);
+
+  std::function<void (const ParseJob&)> parseCommand;
+
+  parseCommand = [this, &numCompileCommands, &admission, &group, &parseCommand](
+    const ParseJob& job_)
+  {
+    const clang::tooling::CompileCommand& command = job_.command;
+
+    // The thread is not blocked if the translation unit can't be parsed now:
+    // the job is posted again when it has been admitted.
+    ParseAdmission::Ticket ticket;
+    if (!admission.tryAcquire(command.Filename, ticket,
+      [&group, &parseCommand, job_]{
+        group.run([&parseCommand, job_]{ parseCommand(job_); });
+      }))
+      return;
+
+    ParseAdmission::Guard admitted(admission, command.Filename, ticket);
+
+    LOG(info)
+      << '(' << job_.index << '/' << numCompileCommands << ')'
+      << " Parsing " << command.Filename;
+
+    std::size_t footprint = 0;
+    int error = this->parseWorker(command, footprint);
+
+    if (error)
+      LOG(warning)
+        << '(' << job_.index << '/' << numCompileCommands << ')'
+        << " Parsing " << command.Filename << " has been failed.";
+    else
+      admitted.setFootprint(footprint);
+  };
 
-  //--- Push all commands into the thread pool's queue ---//
+  //--- Push all commands into the task group ---//
   std::size_t index = 0;
 
   for (const auto& command : compileCommands)
@@ -768,11 +851,11 @@ bool CppParser::parseByJson(
 
     //--- Push the job ---//
 
-    pool->enqueue(job);
+    group.run([&parseCommand, job]{ parseCommand(job); });
   }
 
   // Block execution until every job is finished.
-  pool->wait();
+  group.wait();
 
   return true;
 }
@@ -791,7 +874,13 @@ extern "C"
     description.add_options()
       ("skip-doccomment",
        "If this flag is given the parser will skip parsing the documentation "
-       "comments.");
+       "comments.")
+      ("memory-limit", po::value<int>(),
+       "Memory budget of the C++ parser in MiB. The translation units are "
+       "parsed in parallel as long as their expected memory usage (measured "
+       "at the previous parse) fits in this budget. In this case --jobs is "
+       "only an upper bound of the parallelism. By default the available "
+       "memory of the system is the budget.");
     return description;
   }
 
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+#include <util/logutil.h>
+#include <util/sysinfo.h>
+
+#include "parseadmission.h"
+
+namespace
+{
+
+/**
+ * Expected footprint of a translation unit if nothing is known about the
+ * footprints.
+ */
+const std::size_t defaultFootprint = 512 * 1024 * 1024;
+
+/**
+ * Parsing threads below this CPU usage ratio are considered blocked, above
+ * the busy ratio they are considered busy.
+ */
+const double blockedRatio = 0.5;
+const double busyRatio = 0.8;
+
+}
+
+namespace cc
+{
+namespace parser
+{
+
+ParseAdmission::ParseAdmission(
+  std::size_t maxWorkers_,
+  std::size_t memoryLimit_,
+  const std::string& historyFile_)
+  : _maxWorkers(std::max<std::size_t>(maxWorkers_, 1)),
+    _minWorkers(std::min<std::size_t>(
+      _maxWorkers,
+      std::max(std::thread::hardware_concurrency(), 1u))),
+    _memoryLimit(memoryLimit_),
+    _historyFile(historyFile_),
+    _workers(_minWorkers),
+    _running(0),
+    _reserved(0),
+    _cpuRatio(1.0),
+    _footprintSum(0)
+{
+  if (_memoryLimit)
+  {
+    std::size_t rss = util::residentSetSize();
+    _budget = _memoryLimit > rss ? _memoryLimit - rss : 0;
+  }
+  else
+    _budget = util::availableMemory();
+
+  loadHistory();
+
+  LOG(debug)
+    << "[cppparser] Parsing " << _workers << " (at most " << _maxWorkers
+    << ") translation units at the same time with "
+    << _budget / (1024 * 1024) << " MiB memory budget.";
+}
+
+ParseAdmission::~ParseAdmission()
+{
+  saveHistory();
+}
+
+ParseAdmission::Guard::Guard(
+  ParseAdmission& admission_,
+  const std::string& file_,
+  const Ticket& ticket_)
+  : _admission(admission_), _file(file_), _ticket(ticket_), _footprint(0)
+{
+}
+
+ParseAdmission::Guard::~Guard()
+{
+  _admission.release(_file, _ticket, _footprint);
+}
+
+void ParseAdmission::Guard::setFootprint(std::size_t footprint_)
+{
+  _footprint = footprint_;
+}
+
+bool ParseAdmission::tryAcquire(
+  const std::string& file_,
+  Ticket& ticket_,
+  std::function<void ()> retry_)
+{
+  std::lock_guard<std::mutex> guard(_lock);
+
+  std::size_t expected;
+  auto resumed = _resumed.find(file_);
+
+  if (resumed != _resumed.end())
+  {
+    // Admitted by release() while waiting.
+    expected = resumed->second;
+    _resumed.erase(resumed);
+  }
+  else
+  {
+    expected = estimate(file_);
+
+    // The earlier waiting translation units go first. If nothing is parsed
+    // then the translation unit is always admissible, so the waiting ones are
+    // admitted by the release() of a running one.
+    if (!_waiting.empty() || !admissible(expected))
+    {
+      _waiting.push_back(Waiting{file_, std::move(retry_)});
+      return false;
+    }
+
+    ++_running;
+    _reserved += expected;
+  }
+
+  ticket_ = Ticket{
+    expected, std::chrono::steady_clock::now(), util::threadCpuTime()};
+  return true;
+}
+
+void ParseAdmission::release(
+  const std::string& file_,
+  const Ticket& ticket_,
+  std::size_t footprint_)
+{
+  const double wall = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - ticket_.wallStart).count();
+  const double cpu = util::threadCpuTime() - ticket_.cpuStart;
+
+  std::vector<std::function<void ()>> resumed;
+
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+
+    --_running;
+    _reserved -= ticket_.estimate;
+
+    if (footprint_)
+    {
+      auto it = _footprints.find(file_);
+
+      if (it != _footprints.end())
+      {
+        _footprintSum -= it->second;
+        it->second = footprint_;
+      }
+      else
+        _footprints.emplace(file_, footprint_);
+
+      _footprintSum += footprint_;
+    }
+
+    if (wall > 0)
+    {
+      _cpuRatio = 0.8 * _cpuRatio + 0.2 * std::min(cpu / wall, 1.0);
+
+      if (_cpuRatio < blockedRatio && _workers < _maxWorkers)
+      {
+        ++_workers;
+        LOG(debug)
+          << "[cppparser] Parsing threads are mostly blocked, parsing "
+          << _workers << " translation units at the same time.";
+      }
+      else if (_cpuRatio > busyRatio && _workers > _minWorkers)
+      {
+        --_workers;
+        LOG(debug)
+          << "[cppparser] Parsing threads are busy, parsing "
+          << _workers << " translation units at the same time.";
+      }
+    }
+
+    while (!_waiting.empty())
+    {
+      const std::size_t expected = estimate(_waiting.front().file);
+
+      if (!admissible(expected))
+        break;
+
+      ++_running;
+      _reserved += expected;
+
+      _resumed.emplace(_waiting.front().file, expected);
+      resumed.push_back(std::move(_waiting.front().retry));
+      _waiting.pop_front();
+    }
+  }
+
+  for (const std::function<void ()>& retry : resumed)
+    retry();
+}
+
+bool ParseAdmission::admissible(std::size_t estimate_) const
+{
+  if (_running == 0)
+    return true;
+
+  if (_running >= _workers || _reserved + estimate_ > _budget)
+    return false;
+
+  // The translation units being parsed may have allocated only a part of
+  // their footprint yet, but the live memory usage can be higher than the
+  // reserved one, e.g. because of fragmentation or other parsers.
+  return _memoryLimit
+    ? util::residentSetSize() + estimate_ <= _memoryLimit
+    : estimate_ <= util::availableMemory();
+}
+
+std::size_t ParseAdmission::estimate(const std::string& file_) const
+{
+  auto it = _footprints.find(file_);
+
+  if (it != _footprints.end())
+    return it->second;
+
+  return _footprints.empty()
+    ? defaultFootprint
+    : _footprintSum / _footprints.size();
+}
+
+void ParseAdmission::loadHistory()
+{
+  if (_historyFile.empty())
+    return;
+
+  std::ifstream history(_historyFile);
+  std::size_t footprint;
+  std::string file;
+
+  while (history >> footprint && history.get() == ' ' &&
+         std::getline(history, file))
+    if (_footprints.emplace(file, footprint).second)
+      _footprintSum += footprint;
+}
+
+void ParseAdmission::saveHistory() const
+{
+  if (_historyFile.empty())
+    return;
+
+  std::ofstream history(_historyFile, std::ios::trunc);
+
+  for (const auto& footprint : _footprints)
+    history << footprint.second << ' ' << footprint.first << '\n';
+
+  if (!history)
+    LOG(warning)
+      << "[cppparser] Failed to save translation unit footprints to "
+      << _historyFile;
+}
+
+} // parser
+} // cc
@@ -0,0 +1,193 @@
+#ifndef CC_PARSER_PARSEADMISSION_H
+#define CC_PARSER_PARSEADMISSION_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cc
+{
+namespace parser
+{
+
+/**
+ * Decides how many translation units are parsed at the same time.
+ *
+ * A translation unit is admitted if its expected memory footprint fits in the
+ * memory budget and the number of parsed translation units is below the
+ * current worker limit. The expected footprint is the one measured at the
+ * previous run (these are stored in a history file), or the average of the
+ * known ones for new translation units. The budget is either the given memory
+ * limit or the available memory of the system, and the live resident set size
+ * of the process is also checked before admission.
+ *
+ * The worker limit starts at the number of CPU cores (at most maxWorkers_). If
+ * the parsing threads spend most of their time blocked (e.g. waiting for the
+ * database) then the limit is raised up to maxWorkers_, and it is lowered when
+ * they are busy again.
+ *
+ * A single translation unit is always admitted, even if it doesn't fit in the
+ * budget, so the parsing can't stall.
+ *
+ * The admission never blocks the calling thread, which is a worker of the
+ * shared executor: a translation unit which can't be admitted leaves a retry
+ * function. The waiting translation units are admitted in FIFO order by
+ * release(), as many as fit, and only their retry functions are called.
+ */
+class ParseAdmission
+{
+public:
+  /**
+   * Admission of a translation unit.
+   */
+  struct Ticket
+  {
+    std::size_t estimate;
+    std::chrono::steady_clock::time_point wallStart;
+    double cpuStart;
+  };
+
+  /**
+   * Releases the admission of a translation unit when it goes out of scope,
+   * even if the parsing throws.
+   */
+  class Guard
+  {
+  public:
+    Guard(
+      ParseAdmission& admission_,
+      const std::string& file_,
+      const Ticket& ticket_);
+
+    ~Guard();
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+    /**
+     * Sets the measured memory footprint of the translation unit, which is
+     * given to release(). It remains 0 (unknown) if the parsing failed.
+     */
+    void setFootprint(std::size_t footprint_);
+
+  private:
+    ParseAdmission& _admission;
+    const std::string& _file;
+    const Ticket _ticket;
+    std::size_t _footprint;
+  };
+
+  /**
+   * @param maxWorkers_ The maximal number of translation units parsed at the
+   * same time.
+   * @param memoryLimit_ Memory budget of the process in bytes. 0 means that
+   * the available memory of the system is the budget.
+   * @param historyFile_ The file which stores the measured footprints between
+   * runs. Empty string if there is no such file.
+   */
+  ParseAdmission(
+    std::size_t maxWorkers_,
+    std::size_t memoryLimit_,
+    const std::string& historyFile_);
+
+  /**
+   * Saves the measured footprints to the history file.
+   */
+  ~ParseAdmission();
+
+  /**
+   * Admits the translation unit of the given source file if it can be parsed
+   * now. The ticket has to be given back to release() on the same thread,
+   * preferably by a Guard.
+   * @param retry_ If the translation unit is not admitted then this function
+   * is called by a later release() which admits it, e.g. for posting the
+   * parsing job again. The next tryAcquire() of the file then returns true.
+   * @return True if the translation unit is admitted.
+   */
+  bool tryAcquire(
+    const std::string& file_,
+    Ticket& ticket_,
+    std::function<void ()> retry_);
+
+  /**
+   * Finishes the parsing of a translation unit.
+   * @param footprint_ The measured memory footprint of the translation unit in
+   * bytes or 0 if it is unknown (e.g. the parsing failed).
+   *
+   * The waiting translation units which can be admitted now are admitted
+   * here and their retry functions are called. Since a translation unit has
+   * to wait only while others are parsed, every one is admitted eventually.
+   */
+  void release(
+    const std::string& file_,
+    const Ticket& ticket_,
+    std::size_t footprint_);
+
+private:
+  /**
+   * Returns true if a translation unit with the given expected footprint can
+   * be admitted now. The lock must be held by the caller.
+   */
+  bool admissible(std::size_t estimate_) const;
+
+  /**
+   * Expected footprint of a translation unit. The lock must be held by the
+   * caller.
+   */
+  std::size_t estimate(const std::string& file_) const;
+
+  void loadHistory();
+  void saveHistory() const;
+
+  const std::size_t _maxWorkers;
+  const std::size_t _minWorkers;
+  const std::size_t _memoryLimit;
+  const std::string _historyFile;
+
+  /**
+   * Memory which can be used by the parsed translation units.
+   */
+  std::size_t _budget;
+
+  mutable std::mutex _lock;
+
+  struct Waiting
+  {
+    std::string file;
+    std::function<void ()> retry;
+  };
+
+  /**
+   * The translation units which were not admitted, in the order of arrival.
+   */
+  std::deque<Waiting> _waiting;
+
+  /**
+   * The expected footprints of the waiting translation units which have been
+   * admitted by release() but not picked up by tryAcquire() yet. These are
+   * already counted in _running and _reserved.
+   */
+  std::unordered_multimap<std::string, std::size_t> _resumed;
+
+  std::size_t _workers;
+  std::size_t _running;
+  std::size_t _reserved;
+
+  /**
+   * Exponential moving average of the ratio of CPU time and wall time of the
+   * parsed translation units.
+   */
+  double _cpuRatio;
+
+  std::unordered_map<std::string, std::size_t> _footprints;
+  std::size_t _footprintSum;
+};
+
+} // parser
+} // cc
+
+#endif // CC_PARSER_PARSEADMISSION_H
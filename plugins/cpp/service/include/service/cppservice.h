@@ -18,7 +18,9 @@
 #include <model/cpprelation.h>
 #include <model/cpprelation-odb.hxx>
 
+#include <util/libraryindex.h>
 #include <util/odbtransaction.h>
+#include <util/taskgroup.h>
 #include <webserver/servercontext.h>
 
 namespace cc
@@ -28,9 +30,13 @@ namespace service
 namespace language
 {
 
+class DiagramSession;
+class DiagramSessionStore;
+
 class CppServiceHandler : virtual public LanguageServiceIf
 {
   friend class Diagram;
+  friend class DiagramSession;
 
 public:
   CppServiceHandler(
@@ -67,12 +73,32 @@ public:
   void getDiagram(
     std::string& return_,
     const core::AstNodeId& astNodeId_,
-    const std::int32_t diagramId_) override;
+    const std::int32_t diagramId_,
+    const DiagramFormat::type format_) override;
 
   void getDiagramLegend(
     std::string& return_,
     const std::int32_t diagramId_) override;
 
+  void createDiagramSession(
+    DiagramDelta& return_,
+    const core::AstNodeId& astNodeId_,
+    const std::int32_t diagramId_) override;
+
+  void expandDiagramNode(
+    DiagramDelta& return_,
+    const std::string& session_,
+    const core::AstNodeId& astNodeId_,
+    const DiagramRelation::type relation_,
+    const std::int32_t depth_) override;
+
+  void collapseDiagramNode(
+    DiagramDelta& return_,
+    const std::string& session_,
+    const core::AstNodeId& astNodeId_) override;
+
+  void closeDiagramSession(const std::string& session_) override;
+
   void getFileDiagramTypes(
     std::map<std::string, std::int32_t>& return_,
     const core::FileId& fileId_) override;
@@ -80,7 +106,8 @@ public:
   void getFileDiagram(
     std::string& return_,
     const core::FileId& fileId_,
-    const int32_t diagramId_) override;
+    const int32_t diagramId_,
+    const DiagramFormat::type format_) override;
 
   void getFileDiagramLegend(
     std::string& return_,
@@ -271,6 +298,26 @@ private:
     const model::CppAstNode& lhs,
     const model::CppAstNode& rhs);
 
+  /**
+   * This function returns the diagram sessions of the current user session.
+   * These are released together with the user session.
+   */
+  std::shared_ptr<DiagramSessionStore> diagramSessions();
+
+  /**
+   * This function returns the diagram session of the given handle of the
+   * current user session.
+   * @throw core::InvalidInput If the diagram session doesn't exist.
+   */
+  std::shared_ptr<DiagramSession> getDiagramSession(const std::string& handle_);
+
+  /**
+   * This function returns the AstNodeInfo objects of the given AST nodes in
+   * arbitrary order. The nodes are queried at once.
+   */
+  std::vector<AstNodeInfo> queryAstNodeInfos(
+    const std::vector<model::CppAstNodeId>& astNodeIds_);
+
   /**
    * This function returns the corresponding model::CppAstNode to the given AST
    * node.
@@ -289,7 +336,8 @@ private:
 
   /**
    * This function returns the model::CppAstNode objects which meet the
-   * requirements of the given query in the given file.
+   * requirements of the given query in the given file. The nodes of the
+   * library index are included.
    */
   std::vector<model::CppAstNode> queryCppAstNodesInFile(
     const core::FileId& fileId_,
@@ -305,6 +353,40 @@ private:
     const odb::query<model::CppAstNode>& query_
       = odb::query<model::CppAstNode>(true));
 
+  /**
+   * This function returns the model::CppAstNode objects which meet the
+   * requirements of the given query, from the database of the project and
+   * from the library index.
+   */
+  std::vector<model::CppAstNode> queryAllCppAstNodes(
+    const odb::query<model::CppAstNode>& query_);
+
+  /**
+   * This function returns the C++ entities (or the views of the entities)
+   * which meet the requirements of the given query. The parser stores the
+   * entities of the library files in the library index only, so both
+   * databases are queried, and their results don't overlap. The entities of
+   * the library index must not be loaded lazily (e.g. the parameters of a
+   * model::CppFunction), because their pointers belong to the other database.
+   */
+  template <typename T, typename Query>
+  std::vector<T> queryEntities(const Query& query_);
+
+  /**
+   * This function returns the count of a counting view of the C++ entities,
+   * summed over the database of the project and the library index.
+   */
+  template <typename View, typename Query>
+  std::size_t queryEntityCount(const Query& query_);
+
+  /**
+   * This function returns the content of the given file. If the file or its
+   * content is not in the database of the project then it is looked up in the
+   * library index. An empty string is returned if the content is not found.
+   * It has to be called in a transaction of the project database.
+   */
+  std::string queryFileContent(const model::FileId& fileId_);
+
   /**
    * This function returns the model::CppAstNode objects which have the same
    * mangled name as the given astNodeId_ and have
@@ -385,6 +467,26 @@ private:
 
   std::shared_ptr<std::string> _datadir;
   const cc::webserver::ServerContext& _context;
+
+  /**
+   * The library index of the project or nullptr. AST nodes which are not in
+   * the database of the project are looked up here, as well as the nodes,
+   * entities and contents of library files (see queryCppAstNode(),
+   * queryAllCppAstNodes(), queryEntities() and queryFileContent()). The
+   * SymbolGraph of the diagrams covers the database of the project only.
+   */
+  std::shared_ptr<util::LibraryIndex> _libraryIndex;
+
+  /**
+   * Executor for running independent database lookups of a single request in
+   * parallel. See util::TaskGroup.
+   */
+  std::shared_ptr<util::TaskExecutor> _executor;
+
+  /**
+   * Maximal number of lookups of a single request running at the same time.
+   */
+  std::size_t _parallelism;
 };
 
 }
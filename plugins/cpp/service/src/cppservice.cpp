@@ -3,7 +3,9 @@
 #include <regex>
 
 #include <util/util.h>
+#include <util/cancellation.h>
 #include <util/logutil.h>
+#include <util/taskgroup.h>
 
 #include <model/cppfunction.h>
 #include <model/cppfunction-odb.hxx>
@@ -25,9 +27,12 @@
 #include <model/cppdoccomment-odb.hxx>
 
 #include <service/cppservice.h>
+#include <webserver/session.h>
 
 #include "diagram.h"
+#include "diagramsession.h"
 #include "filediagram.h"
+#include "symbolgraph.h"
 
 namespace
 {
@@ -120,8 +125,32 @@ CppServiceHandler::CppServiceHandler(
     : _db(db_),
       _transaction(db_),
       _datadir(datadir_),
-      _context(context_)
+      _context(context_),
+      _libraryIndex(util::LibraryIndex::forProject(*datadir_))
 {
+#ifdef DATABASE_SQLITE
+  // SQLite databases are opened with a single connection, so parallel
+  // transactions would block each other.
+  _parallelism = 1;
+#else
+  _parallelism = _context.options.count("cpp-parallel-queries")
+    ? std::max(_context.options["cpp-parallel-queries"].as<int>(), 1)
+    : 1;
+#endif
+
+  // The executor is shared by every C++ service instance (i.e. every project)
+  // and every webserver thread. A request uses at most _parallelism threads
+  // of it, so it is sized for the case when each webserver thread is busy.
+  static std::shared_ptr<util::TaskExecutor> executor
+    = std::make_shared<util::TaskExecutor>(
+        (_context.options.count("jobs")
+          ? _context.options["jobs"].as<int>() : 1) * (_parallelism - 1));
+
+  _executor = executor;
+
+  // The symbol graph of the diagrams starts loading in the background, so it
+  // is likely ready by the first diagram request.
+  SymbolGraph::get(_db, *_datadir);
 }
 
 void CppServiceHandler::getFileTypes(std::vector<std::string>& return_)
@@ -148,7 +177,7 @@ void CppServiceHandler::getSourceText(
 
     if (astNode.location.file)
       return cc::util::textRange(
-        astNode.location.file.load()->content.load()->content,
+        queryFileContent(astNode.location.file.object_id()),
         astNode.location.range.start.line,
         astNode.location.range.start.column,
         astNode.location.range.end.line,
@@ -162,63 +191,76 @@ void CppServiceHandler::getDocumentation(
     std::string& return_,
     const core::AstNodeId& astNodeId_)
 {
+  std::vector<AstNodeInfo> methods;
+
   _transaction([&, this](){
     model::CppAstNode node = queryCppAstNode(astNodeId_);
 
-    DocCommentResult docComment = _db->query<model::CppDocComment>(
-      DocCommentQuery::mangledNameHash == node.mangledNameHash);
+    std::vector<model::CppDocComment> docComment
+      = queryEntities<model::CppDocComment>(
+          DocCommentQuery::mangledNameHash == node.mangledNameHash);
 
     if (!docComment.empty())
-      return_ = "<div class=\"main-doc\">" + docComment.begin()->contentHTML
+      return_ = "<div class=\"main-doc\">" + docComment.front().contentHTML
         + "</div>";
 
-    switch (node.symbolType)
-    {
-      case model::CppAstNode::SymbolType::Type:
-      {
-        //--- Data members ---//
+    //--- Data members ---//
 
-        std::vector<AstNodeInfo> methods;
-        getReferences(methods, astNodeId_, METHOD, {});
+    if (node.symbolType == model::CppAstNode::SymbolType::Type)
+      getReferences(methods, astNodeId_, METHOD, {});
+  });
 
-        for (const AstNodeInfo& method : methods)
-        {
-          std::map<std::string, std::string> properties;
-          getProperties(properties, method.id);
+  //--- Query documentation of members ---//
 
-          return_ += "<div class=\"group\"><div class=\"signature\">";
+  // The members are independent of each other, so their properties and
+  // documentation are queried in parallel, each in its own transaction.
+  std::vector<std::string> memberDocs(methods.size());
 
-          //--- Add tags ---/
+  util::TaskGroup group(*_executor, _parallelism);
 
-          for (const std::string& tag : method.tags)
-            if (tag == "public" || tag == "private" || tag == "protected")
-              return_ += "<span class=\"icon-visibility icon-" + tag
-                      +  "\"></span>";
-            else
-              return_ += "<span class=\"tag tag-" + tag +"\" title=\""
-                      +  tag + "\">" + (char)std::toupper(tag[0]) + "</span>";
+  for (std::size_t i = 0; i < methods.size(); ++i)
+    group.run([&, i, this](){
+      const AstNodeInfo& method = methods[i];
+      std::string& doc = memberDocs[i];
 
-          auto signature = properties.find("Signature");
-          return_
-            += signature == properties.end()
-            ?  method.astNodeValue
-            :  signature->second;
+      std::map<std::string, std::string> properties;
+      getProperties(properties, method.id);
 
-          return_ += "</div>";
+      doc += "<div class=\"group\"><div class=\"signature\">";
 
-          //--- Query documentation of members ---//
+      //--- Add tags ---/
 
-          DocCommentResult doc = _db->query<model::CppDocComment>(
-            DocCommentQuery::mangledNameHash == method.mangledNameHash);
+      for (const std::string& tag : method.tags)
+        if (tag == "public" || tag == "private" || tag == "protected")
+          doc += "<span class=\"icon-visibility icon-" + tag + "\"></span>";
+        else
+          doc += "<span class=\"tag tag-" + tag +"\" title=\""
+              +  tag + "\">" + (char)std::toupper(tag[0]) + "</span>";
 
-          if (!doc.empty())
-            return_ += doc.begin()->contentHTML;
+      auto signature = properties.find("Signature");
+      doc
+        += signature == properties.end()
+        ?  method.astNodeValue
+        :  signature->second;
 
-          return_ += "</div>";
-        }
-      }
-    }
-  });
+      doc += "</div>";
+
+      _transaction([&, this](){
+        std::vector<model::CppDocComment> docComment
+          = queryEntities<model::CppDocComment>(
+              DocCommentQuery::mangledNameHash == method.mangledNameHash);
+
+        if (!docComment.empty())
+          doc += docComment.front().contentHTML;
+      });
+
+      doc += "</div>";
+    });
+
+  group.wait();
+
+  for (const std::string& doc : memberDocs)
+    return_ += doc;
 }
 
 void CppServiceHandler::getAstNodeInfoByPosition(
@@ -228,7 +270,7 @@ void CppServiceHandler::getAstNodeInfoByPosition(
   _transaction([&, this](){
     //--- Query nodes at the given position ---//
 
-    AstResult nodes = _db->query<model::CppAstNode>(
+    std::vector<model::CppAstNode> nodes = queryAllCppAstNodes(
       AstQuery::location.file == std::stoull(fpos_.file) &&
       // StartPos <= Pos
       ((AstQuery::location.range.start.line == fpos_.pos.line &&
@@ -278,9 +320,12 @@ void CppServiceHandler::getProperties(
     {
       case model::CppAstNode::SymbolType::Variable:
       {
-        VarResult variables = _db->query<model::CppVariable>(
-          VarQuery::mangledNameHash == node.mangledNameHash);
-        model::CppVariable variable = *variables.begin();
+        std::vector<model::CppVariable> variables
+          = queryEntities<model::CppVariable>(
+              VarQuery::mangledNameHash == node.mangledNameHash);
+        if (variables.empty())
+          break;
+        const model::CppVariable& variable = variables.front();
 
         return_["Name"] = variable.name;
         return_["Qualified name"] = variable.qualifiedName;
@@ -290,9 +335,12 @@ void CppServiceHandler::getProperties(
 
       case model::CppAstNode::SymbolType::Function:
       {
-        FuncResult functions = _db->query<model::CppFunction>(
-          FuncQuery::mangledNameHash == node.mangledNameHash);
-        model::CppFunction function = *functions.begin();
+        std::vector<model::CppFunction> functions
+          = queryEntities<model::CppFunction>(
+              FuncQuery::mangledNameHash == node.mangledNameHash);
+        if (functions.empty())
+          break;
+        const model::CppFunction& function = functions.front();
 
         return_["Name"] = function.qualifiedName.substr(
           function.qualifiedName.find_last_of(':') + 1);
@@ -304,9 +352,11 @@ void CppServiceHandler::getProperties(
 
       case model::CppAstNode::SymbolType::Type:
       {
-        TypeResult types = _db->query<model::CppType>(
+        std::vector<model::CppType> types = queryEntities<model::CppType>(
           TypeQuery::mangledNameHash == node.mangledNameHash);
-        model::CppType type = *types.begin();
+        if (types.empty())
+          break;
+        const model::CppType& type = types.front();
 
         if (type.isAbstract)
           return_["Abstract type"] = "true";
@@ -321,9 +371,12 @@ void CppServiceHandler::getProperties(
 
       case model::CppAstNode::SymbolType::Typedef:
       {
-        TypedefResult types = _db->query<model::CppTypedef>(
-          TypedefQuery::mangledNameHash == node.mangledNameHash);
-        model::CppTypedef type = *types.begin();
+        std::vector<model::CppTypedef> types
+          = queryEntities<model::CppTypedef>(
+              TypedefQuery::mangledNameHash == node.mangledNameHash);
+        if (types.empty())
+          break;
+        const model::CppTypedef& type = types.front();
 
         return_["Name"] = type.name;
         return_["Qualified name"] = type.qualifiedName;
@@ -333,10 +386,12 @@ void CppServiceHandler::getProperties(
 
       case model::CppAstNode::SymbolType::EnumConstant:
       {
-        EnumConstResult enumConsts
-          = _db->query<model::CppEnumConstant>(
+        std::vector<model::CppEnumConstant> enumConsts
+          = queryEntities<model::CppEnumConstant>(
               EnumConstQuery::mangledNameHash == node.mangledNameHash);
-        model::CppEnumConstant enumConst = *enumConsts.begin();
+        if (enumConsts.empty())
+          break;
+        const model::CppEnumConstant& enumConst = enumConsts.front();
 
         return_["Name"] = enumConst.name;
         return_["Qualified name"] = enumConst.qualifiedName;
@@ -381,16 +436,18 @@ std::int32_t CppServiceHandler::getReferenceCount(
         std::set<std::uint64_t> defHashes;
         for (const model::CppAstNode& call : queryCalls(astNodeId_))
         {
+          util::CancellationToken::checkCurrent();
+
           model::CppAstNode node = queryCppAstNode(std::to_string(call.id));
           defHashes.insert(node.mangledNameHash);
         }
 
         if (!defHashes.empty())
-          count += _db->query_value<model::CppAstCount>(
+          count += queryAllCppAstNodes(
             AstQuery::mangledNameHash.in_range(
               defHashes.begin(), defHashes.end()) &&
             AstQuery::astType == model::CppAstNode::AstType::Definition &&
-            AstQuery::location.range.end.line != model::Position::npos).count;
+            AstQuery::location.range.end.line != model::Position::npos).size();
 
         return count;
       }
@@ -426,34 +483,37 @@ std::int32_t CppServiceHandler::getReferenceCount(
 
         for (std::uint64_t mangledNameHash : fptrCallers)
         {
-          AstResult result = _db->query<model::CppAstNode>(
+          util::CancellationToken::checkCurrent();
+
+          count += queryAllCppAstNodes(
             AstQuery::mangledNameHash == mangledNameHash &&
-            AstQuery::astType == model::CppAstNode::AstType::Usage);
-          count += result.size();
+            AstQuery::astType == model::CppAstNode::AstType::Usage).size();
         }
 
         return count;
       }
 
       case PARAMETER:
-        return _db->query_value<model::CppFunctionParamCount>(
-          FuncQuery::astNodeId == node.id).count;
+        return queryEntityCount<model::CppFunctionParamCount>(
+          FuncQuery::astNodeId == node.id);
 
       case LOCAL_VAR:
-        return _db->query_value<model::CppFunctionLocalCount>(
-          FuncQuery::astNodeId == node.id).count;
+        return queryEntityCount<model::CppFunctionLocalCount>(
+          FuncQuery::astNodeId == node.id);
 
       case RETURN_TYPE:
       {
         node = queryCppAstNode(astNodeId_);
 
-        FuncResult functions = _db->query<cc::model::CppFunction>(
-          FuncQuery::mangledNameHash == node.mangledNameHash);
+        std::vector<model::CppFunction> functions
+          = queryEntities<model::CppFunction>(
+              FuncQuery::mangledNameHash == node.mangledNameHash);
 
-        const model::CppFunction& function = *functions.begin();
+        if (functions.empty())
+          return 0;
 
-        return _db->query_value<model::CppTypeCount>(
-          TypeQuery::mangledNameHash == function.typeHash).count;
+        return queryEntityCount<model::CppTypeCount>(
+          TypeQuery::mangledNameHash == functions.front().typeHash);
 
         break;
       }
@@ -476,20 +536,22 @@ std::int32_t CppServiceHandler::getReferenceCount(
       {
         node = queryCppAstNode(astNodeId_);
 
-        VarResult varNodes = _db->query<cc::model::CppVariable>(
-          VarQuery::mangledNameHash == node.mangledNameHash);
+        std::vector<model::CppVariable> variables
+          = queryEntities<model::CppVariable>(
+              VarQuery::mangledNameHash == node.mangledNameHash);
 
-        const model::CppVariable& variable = *varNodes.begin();
+        if (variables.empty())
+          return 0;
 
-        return _db->query_value<model::CppTypeCount>(
-          TypeQuery::mangledNameHash == variable.typeHash).count;
+        return queryEntityCount<model::CppTypeCount>(
+          TypeQuery::mangledNameHash == variables.front().typeHash);
 
         break;
       }
 
       case ALIAS:
-        return _db->query_value<model::CppTypedefCount>(
-          TypedefQuery::typeHash == node.mangledNameHash).count;
+        return queryEntityCount<model::CppTypedefCount>(
+          TypedefQuery::typeHash == node.mangledNameHash);
 
       case INHERIT_FROM:
         return _db->query_value<model::CppInheritanceCount>(
@@ -500,26 +562,26 @@ std::int32_t CppServiceHandler::getReferenceCount(
           InhQuery::base == node.mangledNameHash).count;
 
       case DATA_MEMBER:
-        return _db->query_value<model::CppMemberTypeCount>(
+        return queryEntityCount<model::CppMemberTypeCount>(
           MemTypeQuery::typeHash == node.mangledNameHash &&
-          MemTypeQuery::kind == model::CppMemberType::Kind::Field).count;
+          MemTypeQuery::kind == model::CppMemberType::Kind::Field);
 
       case METHOD:
-        return _db->query_value<model::CppMemberTypeCount>(
+        return queryEntityCount<model::CppMemberTypeCount>(
           MemTypeQuery::typeHash == node.mangledNameHash &&
-          MemTypeQuery::kind == model::CppMemberType::Kind::Method).count;
+          MemTypeQuery::kind == model::CppMemberType::Kind::Method);
 
       case FRIEND:
         return _db->query_value<model::CppFriendshipCount>(
           FriendQuery::target == node.mangledNameHash).count;
 
       case UNDERLYING_TYPE:
-        return _db->query_value<model::CppTypedefCount>(
-          TypedefQuery::mangledNameHash == node.mangledNameHash).count;
+        return queryEntityCount<model::CppTypedefCount>(
+          TypedefQuery::mangledNameHash == node.mangledNameHash);
 
       case ENUM_CONSTANTS:
-        return _db->query_value<model::CppEnumConstantsCount>(
-          EnumQuery::mangledNameHash == node.mangledNameHash).count;
+        return queryEntityCount<model::CppEnumConstantsCount>(
+          EnumQuery::mangledNameHash == node.mangledNameHash);
 
       case EXPANSION:
         return _db->query_value<model::CppMacroExpansionCount>(
@@ -632,6 +694,8 @@ void CppServiceHandler::getReferences(
       case CALLEE:
         for (const model::CppAstNode& call : queryCalls(astNodeId_))
         {
+          util::CancellationToken::checkCurrent();
+
           core::AstNodeId astNodeId = std::to_string(call.id);
           std::vector<model::CppAstNode> defs = queryDefinitions(astNodeId);
           nodes.insert(nodes.end(), defs.begin(), defs.end());
@@ -647,10 +711,12 @@ void CppServiceHandler::getReferences(
           astNodeId_,
           AstQuery::astType == model::CppAstNode::AstType::Usage))
         {
+          util::CancellationToken::checkCurrent();
+
           const model::Position& start = astNode.location.range.start;
           const model::Position& end   = astNode.location.range.end;
 
-          AstResult result = _db->query<model::CppAstNode>(
+          std::vector<model::CppAstNode> result = queryAllCppAstNodes(
             AstQuery::astType    == model::CppAstNode::AstType::Definition &&
             AstQuery::symbolType == model::CppAstNode::SymbolType::Function &&
             // Same file
@@ -679,6 +745,8 @@ void CppServiceHandler::getReferences(
 
         for (const model::CppAstNode& node : queryOverrides(astNodeId_, true))
         {
+          util::CancellationToken::checkCurrent();
+
           core::AstNodeId astNodeId = std::to_string(node.id);
           std::vector<model::CppAstNode> calls = queryCppAstNodes(astNodeId,
             AstQuery::astType == model::CppAstNode::AstType::VirtualCall);
@@ -704,7 +772,9 @@ void CppServiceHandler::getReferences(
 
         for (std::uint64_t mangledNameHash : fptrCallers)
         {
-          AstResult result = _db->query<model::CppAstNode>(
+          util::CancellationToken::checkCurrent();
+
+          std::vector<model::CppAstNode> result = queryAllCppAstNodes(
             AstQuery::mangledNameHash == mangledNameHash &&
             AstQuery::astType == model::CppAstNode::AstType::Usage);
           nodes.insert(nodes.end(), result.begin(), result.end());
@@ -717,13 +787,10 @@ void CppServiceHandler::getReferences(
       {
         node = queryCppAstNode(astNodeId_);
 
-        FuncResult functions = _db->query<model::CppFunction>(
-          FuncQuery::mangledNameHash == node.mangledNameHash);
-        model::CppFunction function = *functions.begin();
-
-        for (auto var : function.parameters)
-          nodes.push_back(queryCppAstNode(
-            std::to_string(var.load()->astNodeId)));
+        for (const model::CppFunctionParamAstNodeId& var
+          : queryEntities<model::CppFunctionParamAstNodeId>(
+              FuncQuery::mangledNameHash == node.mangledNameHash))
+          nodes.push_back(queryCppAstNode(std::to_string(var.astNodeId)));
 
         break;
       }
@@ -732,13 +799,10 @@ void CppServiceHandler::getReferences(
       {
         node = queryCppAstNode(astNodeId_);
 
-        FuncResult functions = _db->query<model::CppFunction>(
-          FuncQuery::mangledNameHash == node.mangledNameHash);
-        model::CppFunction function = *functions.begin();
-
-        for (auto var : function.locals)
-          nodes.push_back(queryCppAstNode(
-            std::to_string(var.load()->astNodeId)));
+        for (const model::CppFunctionLocalAstNodeId& var
+          : queryEntities<model::CppFunctionLocalAstNodeId>(
+              FuncQuery::mangledNameHash == node.mangledNameHash))
+          nodes.push_back(queryCppAstNode(std::to_string(var.astNodeId)));
 
         break;
       }
@@ -747,14 +811,15 @@ void CppServiceHandler::getReferences(
       {
         node = queryCppAstNode(astNodeId_);
 
-        FuncResult functions = _db->query<model::CppFunction>(
-          FuncQuery::mangledNameHash == node.mangledNameHash);
-        model::CppFunction function = *functions.begin();
+        std::vector<model::CppFunction> functions
+          = queryEntities<model::CppFunction>(
+              FuncQuery::mangledNameHash == node.mangledNameHash);
 
-        TypeResult result = _db->query<model::CppType>(
-          TypeQuery::mangledNameHash == function.typeHash);
+        if (functions.empty())
+          break;
 
-        for (const model::CppType& type : result)
+        for (const model::CppType& type : queryEntities<model::CppType>(
+          TypeQuery::mangledNameHash == functions.front().typeHash))
         {
           std::vector<model::CppAstNode> defs =
             queryDefinitions(std::to_string(type.astNodeId));
@@ -790,10 +855,9 @@ void CppServiceHandler::getReferences(
       {
         node = queryCppAstNode(astNodeId_);
 
-        TypedefResult result = _db->query<model::CppTypedef>(
-          TypedefQuery::typeHash == node.mangledNameHash);
-
-        for (const auto& typeDef : result)
+        for (const model::CppTypedef& typeDef
+          : queryEntities<model::CppTypedef>(
+              TypedefQuery::typeHash == node.mangledNameHash))
           nodes.push_back(queryCppAstNode(std::to_string(typeDef.astNodeId)));
 
         break;
@@ -803,15 +867,15 @@ void CppServiceHandler::getReferences(
       {
         node = queryCppAstNode(astNodeId_);
 
-        VarResult varNodes = _db->query<cc::model::CppVariable>(
-          VarQuery::mangledNameHash == node.mangledNameHash);
+        std::vector<model::CppVariable> variables
+          = queryEntities<model::CppVariable>(
+              VarQuery::mangledNameHash == node.mangledNameHash);
 
-        const model::CppVariable& variable = *varNodes.begin();
+        if (variables.empty())
+          break;
 
-        TypeResult result = _db->query<model::CppType>(
-          TypeQuery::mangledNameHash == variable.typeHash);
-
-        for (const model::CppType& type : result)
+        for (const model::CppType& type : queryEntities<model::CppType>(
+          TypeQuery::mangledNameHash == variables.front().typeHash))
         {
           std::vector<model::CppAstNode> defs =
             queryDefinitions(std::to_string(type.astNodeId));
@@ -828,7 +892,7 @@ void CppServiceHandler::getReferences(
           _db->query<model::CppInheritance>(
             InhQuery::derived == node.mangledNameHash)) // TODO: Filter by tags
         {
-          AstResult result = _db->query<model::CppAstNode>(
+          std::vector<model::CppAstNode> result = queryAllCppAstNodes(
             AstQuery::mangledNameHash == inh.base &&
             AstQuery::astType == model::CppAstNode::AstType::Definition);
           nodes.insert(nodes.end(), result.begin(), result.end());
@@ -843,7 +907,7 @@ void CppServiceHandler::getReferences(
           _db->query<model::CppInheritance>(
             InhQuery::base == node.mangledNameHash )) // TODO: Filter by tags
         {
-          AstResult result = _db->query<model::CppAstNode>(
+          std::vector<model::CppAstNode> result = queryAllCppAstNodes(
             AstQuery::mangledNameHash == inh.derived &&
             AstQuery::astType == model::CppAstNode::AstType::Definition);
           nodes.insert(nodes.end(), result.begin(), result.end());
@@ -854,15 +918,17 @@ void CppServiceHandler::getReferences(
       case DATA_MEMBER:
         node = queryCppAstNode(astNodeId_);
 
-        for (const model::CppMemberType& mem : _db->query<model::CppMemberType>(
-          MemTypeQuery::typeHash == node.mangledNameHash &&
-          MemTypeQuery::kind == model::CppMemberType::Kind::Field))
+        for (const model::CppMemberType& mem : queryEntities<
+          model::CppMemberType>(
+            MemTypeQuery::typeHash == node.mangledNameHash &&
+            MemTypeQuery::kind == model::CppMemberType::Kind::Field))
           // TODO: Filter by tags
         {
-          model::CppAstNodePtr astNode = mem.memberAstNode.load();
+          model::CppAstNode astNode = queryCppAstNode(
+            std::to_string(mem.memberAstNode.object_id()));
 
-          if (astNode->location.range.end.line != model::Position::npos)
-            nodes.push_back(*astNode);
+          if (astNode.location.range.end.line != model::Position::npos)
+            nodes.push_back(astNode);
         }
 
         break;
@@ -871,14 +937,13 @@ void CppServiceHandler::getReferences(
       {
         node = queryCppAstNode(astNodeId_);
 
-        for (const model::CppMemberType& mem : _db->query<model::CppMemberType>(
-          MemTypeQuery::typeHash == node.mangledNameHash &&
-          MemTypeQuery::kind == model::CppMemberType::Kind::Method))
+        for (const model::CppMemberType& mem : queryEntities<
+          model::CppMemberType>(
+            MemTypeQuery::typeHash == node.mangledNameHash &&
+            MemTypeQuery::kind == model::CppMemberType::Kind::Method))
           // TODO: Filter by tags
-        {
-          model::CppAstNodePtr astNode = mem.memberAstNode.load();
-          nodes.push_back(*astNode);
-        }
+          nodes.push_back(queryCppAstNode(
+            std::to_string(mem.memberAstNode.object_id())));
 
         break;
       }
@@ -889,7 +954,7 @@ void CppServiceHandler::getReferences(
         for (const model::CppFriendship& fr : _db->query<model::CppFriendship>(
           FriendQuery::target == node.mangledNameHash))
         {
-          AstResult result = _db->query<model::CppAstNode>(
+          std::vector<model::CppAstNode> result = queryAllCppAstNodes(
             AstQuery::mangledNameHash == fr.theFriend &&
             AstQuery::astType == model::CppAstNode::AstType::Definition);
           nodes.insert(nodes.end(), result.begin(), result.end());
@@ -901,15 +966,16 @@ void CppServiceHandler::getReferences(
       {
         node = queryCppAstNode(astNodeId_);
 
-        TypedefResult types = _db->query<model::CppTypedef>(
-          TypedefQuery::mangledNameHash == node.mangledNameHash);
-        model::CppTypedef type = *types.begin();
+        std::vector<model::CppTypedef> types
+          = queryEntities<model::CppTypedef>(
+              TypedefQuery::mangledNameHash == node.mangledNameHash);
 
-        AstResult result = _db->query<model::CppAstNode>(
-          AstQuery::mangledNameHash == type.typeHash &&
-          AstQuery::astType == model::CppAstNode::AstType::Definition);
+        if (types.empty())
+          break;
 
-        nodes = std::vector<model::CppAstNode>(result.begin(), result.end());
+        nodes = queryAllCppAstNodes(
+          AstQuery::mangledNameHash == types.front().typeHash &&
+          AstQuery::astType == model::CppAstNode::AstType::Definition);
 
         break;
       }
@@ -918,18 +984,11 @@ void CppServiceHandler::getReferences(
       {
         node = queryCppAstNode(astNodeId_);
 
-        EnumResult cppEnums = _db->query<model::CppEnum>(
-          EnumQuery::mangledNameHash == node.mangledNameHash);
-        model::CppEnum cppEnum = *cppEnums.begin();
-
-        std::transform(
-          cppEnum.enumConstants.begin(),
-          cppEnum.enumConstants.end(),
-          std::back_inserter(nodes),
-          [this](const auto& enumConst) {
-            return this->queryCppAstNode(
-              std::to_string(enumConst.load()->astNodeId));
-          });
+        for (const model::CppEnumConstantAstNodeId& enumConst
+          : queryEntities<model::CppEnumConstantAstNodeId>(
+              EnumQuery::mangledNameHash == node.mangledNameHash))
+          nodes.push_back(queryCppAstNode(
+            std::to_string(enumConst.astNodeId)));
 
         break;
       }
@@ -1117,26 +1176,22 @@ void CppServiceHandler::getSyntaxHighlight(
 
     //--- Load the file content and break it into lines ---//
 
-    model::FilePtr file = _db->query_one<model::File>(
-      FileQuery::id == std::stoull(range_.file));
-
-    if (!file->content.load())
-      return;
-
-    std::istringstream s(file->content->content);
+    std::istringstream s(queryFileContent(std::stoull(range_.file)));
     std::string line;
     while (std::getline(s, line))
       content.push_back(line);
 
     //--- Iterate over AST node elements ---//
 
-    for (const model::CppAstNode& node : _db->query<model::CppAstNode>(
+    for (const model::CppAstNode& node : queryAllCppAstNodes(
       AstQuery::location.file == std::stoull(range_.file) &&
       AstQuery::location.range.start.line >= range_.range.startpos.line &&
       AstQuery::location.range.end.line < range_.range.endpos.line &&
       AstQuery::location.range.end.line != model::Position::npos &&
       AstQuery::visibleInSourceCode == true))
     {
+      util::CancellationToken::checkCurrent();
+
       if (node.astValue.empty())
         continue;
 
@@ -1177,7 +1232,8 @@ void CppServiceHandler::getSyntaxHighlight(
 void CppServiceHandler::getDiagram(
   std::string& return_,
   const core::AstNodeId& astNodeId_,
-  const std::int32_t diagramId_)
+  const std::int32_t diagramId_,
+  const DiagramFormat::type format_)
 {
   Diagram diagram(_db, _datadir, _context);
   util::Graph graph;
@@ -1198,7 +1254,9 @@ void CppServiceHandler::getDiagram(
   }
 
   if (graph.nodeCount() != 0)
-    return_ = graph.output(util::Graph::SVG);
+    return_ = graph.output(format_ == DiagramFormat::JSON
+      ? util::Graph::JSON
+      : util::Graph::SVG);
 }
 
 void CppServiceHandler::getDiagramLegend(
@@ -1223,6 +1281,47 @@ void CppServiceHandler::getDiagramLegend(
   }
 }
 
+void CppServiceHandler::createDiagramSession(
+  DiagramDelta& return_,
+  const core::AstNodeId& astNodeId_,
+  const std::int32_t diagramId_)
+{
+  Diagram diagram(_db, _datadir, _context);
+
+  std::shared_ptr<DiagramSession> session = std::make_shared<DiagramSession>(
+    diagram, astNodeId_, diagramId_ != FUNCTION_CALL, return_);
+
+  return_.session = diagramSessions()->add(session);
+}
+
+void CppServiceHandler::expandDiagramNode(
+  DiagramDelta& return_,
+  const std::string& session_,
+  const core::AstNodeId& astNodeId_,
+  const DiagramRelation::type relation_,
+  const std::int32_t depth_)
+{
+  Diagram diagram(_db, _datadir, _context);
+
+  getDiagramSession(session_)->expand(
+    diagram, return_, astNodeId_, relation_, depth_);
+  return_.session = session_;
+}
+
+void CppServiceHandler::collapseDiagramNode(
+  DiagramDelta& return_,
+  const std::string& session_,
+  const core::AstNodeId& astNodeId_)
+{
+  getDiagramSession(session_)->collapse(return_, astNodeId_);
+  return_.session = session_;
+}
+
+void CppServiceHandler::closeDiagramSession(const std::string& session_)
+{
+  diagramSessions()->remove(session_);
+}
+
 void CppServiceHandler::getFileDiagramTypes(
   std::map<std::string, std::int32_t>& return_,
   const core::FileId& fileId_)
@@ -1249,7 +1348,8 @@ void CppServiceHandler::getFileDiagramTypes(
 void CppServiceHandler::getFileDiagram(
   std::string& return_,
   const core::FileId& fileId_,
-  const int32_t diagramId_)
+  const int32_t diagramId_,
+  const DiagramFormat::type format_)
 {
   FileDiagram diagram(_db, _datadir, _context);
   util::Graph graph;
@@ -1283,7 +1383,9 @@ void CppServiceHandler::getFileDiagram(
   }
 
   if (graph.nodeCount() != 0)
-    return_ = graph.output(util::Graph::SVG);
+    return_ = graph.output(format_ == DiagramFormat::JSON
+      ? util::Graph::JSON
+      : util::Graph::SVG);
 }
 
 void CppServiceHandler::getFileDiagramLegend(
@@ -1334,54 +1436,186 @@ bool CppServiceHandler::compareByValue(
   return lhs.astValue < rhs.astValue;
 }
 
-model::CppAstNode CppServiceHandler::queryCppAstNode(
-  const core::AstNodeId& astNodeId_)
+std::shared_ptr<DiagramSessionStore> CppServiceHandler::diagramSessions()
 {
-  return _transaction([&, this](){
-    model::CppAstNode node;
+  webserver::SessionManagerAccess access(_context.sessionManager);
 
-    if (!_db->find(std::stoull(astNodeId_), node))
+  return access.accessSession([](webserver::Session* session_){
+    if (!session_)
     {
-      core::InvalidId ex;
-      ex.__set_msg("Invalid CppAstNode ID");
-      ex.__set_nodeid(astNodeId_);
+      core::InvalidInput ex;
+      ex.__set_msg("Diagram sessions require a user session");
       throw ex;
     }
 
-    return node;
+    return session_->getData<DiagramSessionStore>("cpp.diagramSessions", [](){
+      return std::make_shared<DiagramSessionStore>();
+    });
   });
 }
 
+std::shared_ptr<DiagramSession> CppServiceHandler::getDiagramSession(
+  const std::string& handle_)
+{
+  std::shared_ptr<DiagramSession> session = diagramSessions()->get(handle_);
+
+  if (!session)
+  {
+    core::InvalidInput ex;
+    ex.__set_msg("Unknown or expired diagram session: " + handle_);
+    throw ex;
+  }
+
+  return session;
+}
+
+std::vector<AstNodeInfo> CppServiceHandler::queryAstNodeInfos(
+  const std::vector<model::CppAstNodeId>& astNodeIds_)
+{
+  std::vector<AstNodeInfo> result;
+
+  if (astNodeIds_.empty())
+    return result;
+
+  _transaction([&, this](){
+    std::vector<model::CppAstNode> nodes = queryAllCppAstNodes(
+      AstQuery::id.in_range(astNodeIds_.begin(), astNodeIds_.end()));
+
+    std::transform(nodes.begin(), nodes.end(),
+      std::back_inserter(result), CreateAstNodeInfo());
+  });
+
+  return result;
+}
+
+model::CppAstNode CppServiceHandler::queryCppAstNode(
+  const core::AstNodeId& astNodeId_)
+{
+  model::CppAstNode node;
+
+  if (_transaction([&, this](){
+        return _db->find(std::stoull(astNodeId_), node); }))
+    return node;
+
+  if (_libraryIndex && (*_libraryIndex)([&, this](){
+        return _libraryIndex->db().find(std::stoull(astNodeId_), node); }))
+    return node;
+
+  core::InvalidId ex;
+  ex.__set_msg("Invalid CppAstNode ID");
+  ex.__set_nodeid(astNodeId_);
+  throw ex;
+}
+
 std::vector<model::CppAstNode> CppServiceHandler::queryCppAstNodes(
   const core::AstNodeId& astNodeId_,
   const AstQuery& query_)
 {
   model::CppAstNode node = queryCppAstNode(astNodeId_);
 
-  AstResult result = _db->query<model::CppAstNode>(
-    AstQuery::mangledNameHash == node.mangledNameHash &&
-    AstQuery::location.range.end.line != model::Position::npos &&
-    query_);
+  const AstQuery query
+    = AstQuery::mangledNameHash == node.mangledNameHash &&
+      AstQuery::location.range.end.line != model::Position::npos &&
+      query_;
+
+  // The declarations and definitions of library symbols are in the library
+  // index, the usages in the project are in the database of the project.
+  return queryAllCppAstNodes(query);
+}
+
+std::vector<model::CppAstNode> CppServiceHandler::queryAllCppAstNodes(
+  const AstQuery& query_)
+{
+  AstResult result = _db->query<model::CppAstNode>(query_);
+  std::vector<model::CppAstNode> nodes(result.begin(), result.end());
+
+  if (_libraryIndex)
+    (*_libraryIndex)([&, this](){
+      for (const model::CppAstNode& libNode
+        : _libraryIndex->db().query<model::CppAstNode>(query_))
+        nodes.push_back(libNode);
+    });
 
-  return std::vector<model::CppAstNode>(result.begin(), result.end());
+  return nodes;
+}
+
+template <typename T, typename Query>
+std::vector<T> CppServiceHandler::queryEntities(const Query& query_)
+{
+  odb::result<T> result = _db->query<T>(query_);
+  std::vector<T> entities(result.begin(), result.end());
+
+  if (_libraryIndex)
+    (*_libraryIndex)([&, this](){
+      for (const T& entity : _libraryIndex->db().query<T>(query_))
+        entities.push_back(entity);
+    });
+
+  return entities;
+}
+
+template <typename View, typename Query>
+std::size_t CppServiceHandler::queryEntityCount(const Query& query_)
+{
+  std::size_t count = _db->query_value<View>(query_).count;
+
+  if (_libraryIndex)
+    count += (*_libraryIndex)([&, this](){
+      return _libraryIndex->db().query_value<View>(query_).count;
+    });
+
+  return count;
 }
 
 std::vector<model::CppAstNode> CppServiceHandler::queryCppAstNodesInFile(
   const core::FileId& fileId_,
   const odb::query<model::CppAstNode>& query_)
 {
-  AstResult result = _db->query<model::CppAstNode>(
+  // The AST nodes of the library headers are in the library index.
+  return queryAllCppAstNodes(
     AstQuery::location.file == std::stoull(fileId_) && query_);
-
-  return std::vector<model::CppAstNode>(result.begin(), result.end());
 }
 
 std::uint32_t CppServiceHandler::queryCppAstNodeCountInFile(
   const core::FileId& fileId_,
   const odb::query<model::CppAstNode>& query_)
 {
-  return _db->query_value<model::CppAstCount>(
-    AstQuery::location.file == std::stoull(fileId_) && query_).count;
+  const AstQuery query = AstQuery::location.file == std::stoull(fileId_)
+    && query_;
+
+  std::uint32_t count = _db->query_value<model::CppAstCount>(query).count;
+
+  if (_libraryIndex)
+    count += (*_libraryIndex)([&, this](){
+      return _libraryIndex->db().query_value<model::CppAstCount>(query).count;
+    });
+
+  return count;
+}
+
+std::string CppServiceHandler::queryFileContent(const model::FileId& fileId_)
+{
+  model::File file;
+
+  if (_db->find(fileId_, file))
+    if (std::shared_ptr<model::FileContent> content = file.content.load())
+      return content->content;
+
+  std::string content;
+
+  // The node may come from the library index or the content of a library
+  // header may be stored only there. See ProjectServiceHandler::getFileContent.
+  if (_libraryIndex)
+    (*_libraryIndex)([&, this](){
+      model::File libFile;
+
+      if (_libraryIndex->db().find(fileId_, libFile))
+        if (std::shared_ptr<model::FileContent> libContent
+              = libFile.content.load())
+          content = libContent->content;
+    });
+
+  return content;
 }
 
 std::vector<model::CppAstNode> CppServiceHandler::queryDefinitions(
@@ -1420,12 +1654,8 @@ std::vector<model::CppAstNode> CppServiceHandler::queryCalls(
   if (nodes.empty())
     return nodes;
 
-  model::CppAstNode node = nodes.front();
-  AstResult result = _db->query<model::CppAstNode>(astCallsQuery(node));
-
-  nodes = std::vector<model::CppAstNode>(result.begin(), result.end());
-
-  return nodes;
+  // The calls are in the file of the definition, which may be a library file.
+  return queryAllCppAstNodes(astCallsQuery(nodes.front()));
 }
 
 std::vector<model::CppAstNode> CppServiceHandler::queryOverrides(
@@ -1442,16 +1672,14 @@ std::vector<model::CppAstNode> CppServiceHandler::queryOverrides(
         node.mangledNameHash,
         reverse_);
 
-  std::transform(
-    overrides.begin(),
-    overrides.end(),
-    std::back_inserter(nodes),
-    [this](std::uint64_t mnh){
-      AstResult result
-        = _db->query<model::CppAstNode>(AstQuery::mangledNameHash == mnh);
+  for (std::uint64_t mnh : overrides)
+  {
+    std::vector<model::CppAstNode> result
+      = queryAllCppAstNodes(AstQuery::mangledNameHash == mnh);
 
-      return *result.begin();
-    });
+    if (!result.empty())
+      nodes.push_back(result.front());
+  }
 
   return nodes;
 }
@@ -1469,6 +1697,8 @@ CppServiceHandler::transitiveClosureOfRel(
 
   while (!q.empty())
   {
+    util::CancellationToken::checkCurrent();
+
     std::uint64_t current = q.front();
     q.pop();
 
@@ -1498,6 +1728,8 @@ CppServiceHandler::getTags(const std::vector<model::CppAstNode>& nodes_)
 
   for (const model::CppAstNode& node : nodes_)
   {
+    util::CancellationToken::checkCurrent();
+
     std::vector<cc::model::CppAstNode> defs
       = queryDefinitions(std::to_string(node.id));
 
@@ -1507,10 +1739,11 @@ CppServiceHandler::getTags(const std::vector<model::CppAstNode>& nodes_)
     {
       case model::CppAstNode::SymbolType::Function:
       {
-        for (const model::CppMemberType& mem : _db->query<model::CppMemberType>(
-          (MemTypeQuery::memberAstNode == defNode.id ||
-           MemTypeQuery::memberAstNode == node.id) &&
-          MemTypeQuery::kind == model::CppMemberType::Kind::Method))
+        for (const model::CppMemberType& mem : queryEntities<
+          model::CppMemberType>(
+            (MemTypeQuery::memberAstNode == defNode.id ||
+             MemTypeQuery::memberAstNode == node.id) &&
+            MemTypeQuery::kind == model::CppMemberType::Kind::Method))
         {
           //--- Visibility Tag---//
 
@@ -1523,22 +1756,24 @@ CppServiceHandler::getTags(const std::vector<model::CppAstNode>& nodes_)
 
         //--- Virtual Tag ---//
 
-        FuncResult funcNodes = _db->query<cc::model::CppFunction>(
-          FuncQuery::mangledNameHash == defNode.mangledNameHash);
-        const model::CppFunction& funcNode = *funcNodes.begin();
+        std::vector<model::CppFunction> funcNodes
+          = queryEntities<model::CppFunction>(
+              FuncQuery::mangledNameHash == defNode.mangledNameHash);
 
-        for (const model::Tag& tag : funcNode.tags)
-          tags[node.id].push_back(model::tagToString(tag));
+        if (!funcNodes.empty())
+          for (const model::Tag& tag : funcNodes.front().tags)
+            tags[node.id].push_back(model::tagToString(tag));
 
         break;
       }
 
       case model::CppAstNode::SymbolType::Variable:
       {
-        for (const model::CppMemberType& mem : _db->query<model::CppMemberType>(
-          (MemTypeQuery::memberAstNode == defNode.id ||
-           MemTypeQuery::memberAstNode == node.id) &&
-          MemTypeQuery::kind == model::CppMemberType::Kind::Field))
+        for (const model::CppMemberType& mem : queryEntities<
+          model::CppMemberType>(
+            (MemTypeQuery::memberAstNode == defNode.id ||
+             MemTypeQuery::memberAstNode == node.id) &&
+            MemTypeQuery::kind == model::CppMemberType::Kind::Field))
         {
           //--- Visibility Tag---//
 
@@ -1550,12 +1785,13 @@ CppServiceHandler::getTags(const std::vector<model::CppAstNode>& nodes_)
 
         //--- Global Tag ---//
 
-        VarResult varNodes = _db->query<cc::model::CppVariable>(
-          VarQuery::mangledNameHash == defNode.mangledNameHash);
-        const model::CppVariable& varNode = *varNodes.begin();
+        std::vector<model::CppVariable> varNodes
+          = queryEntities<model::CppVariable>(
+              VarQuery::mangledNameHash == defNode.mangledNameHash);
 
-        for (const model::Tag& tag : varNode.tags)
-          tags[node.id].push_back(model::tagToString(tag));
+        if (!varNodes.empty())
+          for (const model::Tag& tag : varNodes.front().tags)
+            tags[node.id].push_back(model::tagToString(tag));
 
         break;
       }
@@ -1571,12 +1807,11 @@ std::size_t CppServiceHandler::queryCppAstNodeCount(
 {
   model::CppAstNode node = queryCppAstNode(astNodeId_);
 
-  model::CppAstCount q = _db->query_value<model::CppAstCount>(
+  // Counts the same nodes as queryCppAstNodes().
+  return queryEntityCount<model::CppAstCount>(
     AstQuery::mangledNameHash == node.mangledNameHash &&
     AstQuery::location.range.end.line != model::Position::npos &&
     query_);
-
-  return q.count;
 }
 
 std::size_t CppServiceHandler::queryOverridesCount(
@@ -1597,9 +1832,7 @@ std::size_t CppServiceHandler::queryCallsCount(
   if (nodes.empty())
     return std::size_t(0);
 
-  model::CppAstNode node = nodes.front();
-
-  return _db->query_value<model::CppAstCount>(astCallsQuery(node)).count;
+  return queryEntityCount<model::CppAstCount>(astCallsQuery(nodes.front()));
 }
 
 } // language
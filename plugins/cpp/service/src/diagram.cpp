@@ -5,6 +5,7 @@
 
 #include <util/legendbuilder.h>
 #include <util/util.h>
+
 #include "diagram.h"
 
 namespace
@@ -57,6 +58,13 @@ Diagram::Diagram(
     : _cppHandler(db_, datadir_, context_),
       _projectHandler(db_, datadir_, context_)
 {
+  _depth = context_.options.count("cpp-diagram-depth")
+    ? std::max(context_.options["cpp-diagram-depth"].as<int>(), 1)
+    : 1;
+
+  _maxNodes = context_.options.count("cpp-diagram-max-nodes")
+    ? std::max(context_.options["cpp-diagram-max-nodes"].as<int>(), 1)
+    : 150;
 }
 
 void Diagram::getClassCollaborationDiagram(
@@ -85,65 +93,98 @@ void Diagram::getClassCollaborationDiagram(
   visitedNodes[nodeInfo.id] = centerNode;
   relatedNodes.push_back(nodeInfo);
 
-  nodes.clear();
+  //--- Base and derived types from the in-memory graph ---//
 
-  //--- Types from which the queried type inherits ---//
+  std::shared_ptr<const SymbolGraph> symbols
+    = SymbolGraph::get(_cppHandler._db, *_cppHandler._datadir);
 
-  _cppHandler.getReferences(nodes, nodeInfo.id,
-    CppServiceHandler::INHERIT_FROM, {});
+  std::vector<model::CppAstNodeId> inheritNodes;
+  std::vector<SymbolGraph::Edge> inheritEdges;
 
-  for (const AstNodeInfo& node : nodes)
+  if (symbols)
+  {
+    symbols->bfs(inheritNodes, inheritEdges, std::stoull(nodeInfo.id),
+      SymbolGraph::BASE, _depth, _maxNodes / 2);
+    symbols->bfs(inheritNodes, inheritEdges, std::stoull(nodeInfo.id),
+      SymbolGraph::DERIVED, _depth, _maxNodes);
+  }
+  else
+  {
+    // The graph is still being loaded, so only one level is shown.
+    getNeighbours(inheritNodes, inheritEdges, nodeInfo.id,
+      SymbolGraph::BASE, _maxNodes / 2);
+    getNeighbours(inheritNodes, inheritEdges, nodeInfo.id,
+      SymbolGraph::DERIVED, _maxNodes);
+  }
+
+  for (const AstNodeInfo& node : queryNodeInfos(inheritNodes))
   {
+    if (visitedNodes.count(node.id))
+      continue;
+
     util::Graph::Node inheritNode = addNode(graph_, node);
     graph_.setNodeAttribute(inheritNode, "label",
       node.astNodeValue, true);
     decorateNode(graph_, inheritNode, classNodeDecoration);
 
-    util::Graph::Edge edge = graph_.createEdge(centerNode, inheritNode);
-    decorateEdge(graph_, edge, inheritClassEdgeDecoration);
-
     visitedNodes[node.id] = inheritNode;
     relatedNodes.push_back(node);
   }
 
-  nodes.clear();
-
-  //--- Types by which the queried type is inherited ---//
-
-  _cppHandler.getReferences(nodes, nodeInfo.id,
-    CppServiceHandler::INHERIT_BY, {});
-
-  for (const AstNodeInfo& node : nodes)
+  // Edges point from the derived type to the base type.
+  for (const SymbolGraph::Edge& inheritEdge : inheritEdges)
   {
-    util::Graph::Node inheritNode = addNode(graph_, node);
-    graph_.setNodeAttribute(inheritNode, "label",
-      node.astNodeValue, true);
-    decorateNode(graph_, inheritNode, classNodeDecoration);
+    auto from = visitedNodes.find(std::to_string(inheritEdge.from));
+    auto to = visitedNodes.find(std::to_string(inheritEdge.to));
 
-    util::Graph::Edge edge = graph_.createEdge(inheritNode, centerNode);
-    decorateEdge(graph_, edge, inheritClassEdgeDecoration);
+    if (from == visitedNodes.end() || to == visitedNodes.end() ||
+        graph_.hasEdge(from->second, to->second))
+      continue;
 
-    visitedNodes[node.id] = inheritNode;
-    relatedNodes.push_back(node);
+    util::Graph::Edge edge = graph_.createEdge(from->second, to->second);
+    decorateEdge(graph_, edge, inheritClassEdgeDecoration);
   }
 
   //--- Get related types for the current and related types ---//
 
-  for (const AstNodeInfo& relatedNode : relatedNodes)
-  {
-    std::vector<AstNodeInfo> dataMembers;
-    _cppHandler.getReferences(dataMembers, relatedNode.id,
-      CppServiceHandler::DATA_MEMBER, {});
+  // The data members and their types are queried in parallel for the related
+  // types. The graph itself is not thread-safe, so it is built afterwards in
+  // the original order. Every element is a (data member, type) pair.
+  std::vector<std::vector<std::pair<AstNodeInfo, AstNodeInfo>>> memberTypes(
+    relatedNodes.size());
 
-    for (const AstNodeInfo& node : dataMembers)
-    {
-      std::vector<AstNodeInfo> types;
-      _cppHandler.getReferences(types, node.id, CppServiceHandler::TYPE, {});
+  {
+    util::TaskGroup group(
+      *_cppHandler._executor, _cppHandler._parallelism);
+
+    for (std::size_t i = 0; i < relatedNodes.size(); ++i)
+      group.run([&, i, this](){
+        std::vector<AstNodeInfo> dataMembers;
+        _cppHandler.getReferences(dataMembers, relatedNodes[i].id,
+          CppServiceHandler::DATA_MEMBER, {});
+
+        for (const AstNodeInfo& node : dataMembers)
+        {
+          std::vector<AstNodeInfo> types;
+          _cppHandler.getReferences(
+            types, node.id, CppServiceHandler::TYPE, {});
+
+          if (!types.empty())
+            memberTypes[i].emplace_back(node, types.front());
+        }
+      });
+
+    group.wait();
+  }
 
-      if (types.empty())
-        continue;
+  for (std::size_t i = 0; i < relatedNodes.size(); ++i)
+  {
+    const AstNodeInfo& relatedNode = relatedNodes[i];
 
-      AstNodeInfo typeInfo = types.front();
+    for (const auto& memberType : memberTypes[i])
+    {
+      const AstNodeInfo& node = memberType.first;
+      const AstNodeInfo& typeInfo = memberType.second;
 
       util::Graph::Node typeNode;
       auto it = visitedNodes.find(typeInfo.id);
@@ -181,75 +222,246 @@ void Diagram::getFunctionCallDiagram(
   const core::AstNodeId& astNodeId_)
 {
   std::map<core::AstNodeId, util::Graph::Node> visitedNodes;
-  std::vector<AstNodeInfo> nodes;
+  std::vector<AstNodeInfo> definitions;
 
   graph_.setAttribute("rankdir", "LR");
 
   //--- Center node ---//
 
   _cppHandler.getReferences(
-    nodes, astNodeId_, CppServiceHandler::DEFINITION, {});
+    definitions, astNodeId_, CppServiceHandler::DEFINITION, {});
 
-  if (nodes.empty())
+  if (definitions.empty())
     return;
 
-  util::Graph::Node centerNode = addNode(graph_, nodes.front());
+  const AstNodeInfo& center = definitions.front();
+
+  util::Graph::Node centerNode = addNode(graph_, center);
   decorateNode(graph_, centerNode, centerNodeDecoration);
-  visitedNodes[astNodeId_] = centerNode;
+  visitedNodes[center.id] = centerNode;
 
-  //--- Callees ---//
+  //--- Callees and callers from the in-memory graph ---//
 
-  nodes.clear();
-  _cppHandler.getReferences(nodes, astNodeId_, CppServiceHandler::CALLEE, {});
+  std::shared_ptr<const SymbolGraph> symbols
+    = SymbolGraph::get(_cppHandler._db, *_cppHandler._datadir);
 
-  for (const AstNodeInfo& node : nodes)
+  std::vector<model::CppAstNodeId> callees;
+  std::vector<model::CppAstNodeId> callers;
+  std::vector<SymbolGraph::Edge> calleeEdges;
+  std::vector<SymbolGraph::Edge> callerEdges;
+
+  // Half of the node budget is reserved for the callers.
+  if (symbols)
+  {
+    symbols->bfs(callees, calleeEdges, std::stoull(center.id),
+      SymbolGraph::CALLEE, _depth, _maxNodes / 2);
+    symbols->bfs(callers, callerEdges, std::stoull(center.id),
+      SymbolGraph::CALLER, _depth, _maxNodes - callees.size());
+  }
+  else
   {
-    util::Graph::Node calleeNode;
+    // The graph is still being loaded, so only one level is shown.
+    getNeighbours(callees, calleeEdges, center.id,
+      SymbolGraph::CALLEE, _maxNodes / 2);
+    getNeighbours(callers, callerEdges, center.id,
+      SymbolGraph::CALLER, _maxNodes - callees.size());
+  }
+
+  std::set<core::AstNodeId> virtualNodes;
+  for (const SymbolGraph::Edge& edge : calleeEdges)
+    if (edge.virtualCall)
+      virtualNodes.insert(std::to_string(edge.to));
+
+  std::vector<model::CppAstNodeId> related(callees);
+  related.insert(related.end(), callers.begin(), callers.end());
 
-    auto it = visitedNodes.find(node.id);
-    if (it == visitedNodes.end())
+  std::map<core::AstNodeId, AstNodeInfo> nodeInfos;
+  for (AstNodeInfo& node : queryNodeInfos(related))
+    nodeInfos[node.id] = std::move(node);
+
+  //--- Nodes in the order of their distance from the center ---//
+
+  auto addNodes = [&, this](
+    const std::vector<model::CppAstNodeId>& nodes_,
+    const Decoration& decoration_)
+  {
+    for (model::CppAstNodeId id : nodes_)
     {
-      calleeNode = addNode(graph_, node);
-      decorateNode(graph_, calleeNode, calleeNodeDecoration);
-      visitedNodes.insert(it, std::make_pair(node.id, calleeNode));
+      auto it = nodeInfos.find(std::to_string(id));
+      if (it == nodeInfos.end() || visitedNodes.count(it->first))
+        continue;
+
+      util::Graph::Node node = addNode(graph_, it->second);
+      decorateNode(graph_, node, virtualNodes.count(it->first)
+        ? virtualNodeDecoration
+        : decoration_);
+      visitedNodes[it->first] = node;
     }
-    else
-      calleeNode = it->second;
+  };
+
+  addNodes(callees, calleeNodeDecoration);
+  addNodes(callers, callerNodeDecoration);
 
-    if (!graph_.hasEdge(centerNode, calleeNode))
+  //--- Edges ---//
+
+  auto addEdges = [&, this](
+    const std::vector<SymbolGraph::Edge>& edges_,
+    const Decoration& decoration_)
+  {
+    for (const SymbolGraph::Edge& callEdge : edges_)
     {
-      util::Graph::Edge edge = graph_.createEdge(centerNode, calleeNode);
-      decorateEdge(graph_, edge, calleeEdgeDecoration);
+      auto from = visitedNodes.find(std::to_string(callEdge.from));
+      auto to = visitedNodes.find(std::to_string(callEdge.to));
+
+      if (from == visitedNodes.end() || to == visitedNodes.end() ||
+          graph_.hasEdge(from->second, to->second))
+        continue;
+
+      util::Graph::Edge edge = graph_.createEdge(from->second, to->second);
+      decorateEdge(graph_, edge, decoration_);
     }
-  }
+  };
 
-  //--- Callers ---//
+  addEdges(calleeEdges, calleeEdgeDecoration);
+  addEdges(callerEdges, callerEdgeDecoration);
 
-  nodes.clear();
-  _cppHandler.getReferences(nodes, astNodeId_, CppServiceHandler::CALLER, {});
+  _subgraphs.clear();
+}
 
-  for (const AstNodeInfo& node : nodes)
+std::vector<AstNodeInfo> Diagram::queryNodeInfos(
+  const std::vector<model::CppAstNodeId>& astNodeIds_)
+{
+  std::vector<AstNodeInfo> nodes = _cppHandler.queryAstNodeInfos(astNodeIds_);
+
+  // The nodes are returned in the order of the given IDs, so that the layout
+  // of the diagram doesn't depend on the database.
+  std::map<model::CppAstNodeId, std::size_t> order;
+  for (std::size_t i = 0; i < astNodeIds_.size(); ++i)
+    order.emplace(astNodeIds_[i], i);
+
+  std::sort(nodes.begin(), nodes.end(),
+    [&order](const AstNodeInfo& lhs_, const AstNodeInfo& rhs_){
+      return order[std::stoull(lhs_.id)] < order[std::stoull(rhs_.id)];
+    });
+
+  return nodes;
+}
+
+void Diagram::getNeighbours(
+  std::vector<model::CppAstNodeId>& nodes_,
+  std::vector<SymbolGraph::Edge>& edges_,
+  const core::AstNodeId& astNodeId_,
+  SymbolGraph::Relation relation_,
+  std::size_t maxNodes_)
+{
+  std::vector<AstNodeInfo> related;
+
+  switch (relation_)
   {
-    util::Graph::Node callerNode;
+    case SymbolGraph::CALLEE:
+      _cppHandler.getReferences(
+        related, astNodeId_, CppServiceHandler::CALLEE, {});
+      break;
+
+    case SymbolGraph::CALLER:
+      _cppHandler.getReferences(
+        related, astNodeId_, CppServiceHandler::CALLER, {});
+      break;
+
+    case SymbolGraph::BASE:
+      _cppHandler.getReferences(
+        related, astNodeId_, CppServiceHandler::INHERIT_FROM, {});
+      break;
+
+    case SymbolGraph::DERIVED:
+      _cppHandler.getReferences(
+        related, astNodeId_, CppServiceHandler::INHERIT_BY, {});
+      break;
+  }
 
-    auto it = visitedNodes.find(node.id);
-    if (it == visitedNodes.end())
-    {
-      callerNode = addNode(graph_, node);
-      decorateNode(graph_, callerNode, callerNodeDecoration);
-      visitedNodes.insert(it, std::make_pair(node.id, callerNode));
-    }
-    else
-      callerNode = it->second;
+  const model::CppAstNodeId center = std::stoull(astNodeId_);
+  const bool reverse =
+    relation_ == SymbolGraph::CALLER || relation_ == SymbolGraph::DERIVED;
 
-    if (!graph_.hasEdge(callerNode, centerNode))
-    {
-      util::Graph::Edge edge = graph_.createEdge(callerNode, centerNode);
-      decorateEdge(graph_, edge, callerEdgeDecoration);
-    }
+  for (const AstNodeInfo& node : related)
+  {
+    const model::CppAstNodeId id = std::stoull(node.id);
+
+    if (contains(nodes_, id))
+      continue;
+
+    if (nodes_.size() >= maxNodes_)
+      break;
+
+    nodes_.push_back(id);
+    edges_.push_back(reverse
+      ? SymbolGraph::Edge{id, center, false}
+      : SymbolGraph::Edge{center, id, false});
   }
+}
 
-  _subgraphs.clear();
+void Diagram::getRelatedNodes(
+  std::vector<std::vector<AstNodeInfo>>& return_,
+  const std::vector<core::AstNodeId>& astNodeIds_,
+  DiagramRelation::type relation_)
+{
+  return_.assign(astNodeIds_.size(), std::vector<AstNodeInfo>());
+
+  util::TaskGroup group(*_cppHandler._executor, _cppHandler._parallelism);
+
+  for (std::size_t i = 0; i < astNodeIds_.size(); ++i)
+    group.run([&, i, this](){
+      const core::AstNodeId& astNodeId = astNodeIds_[i];
+      std::vector<AstNodeInfo>& related = return_[i];
+
+      switch (relation_)
+      {
+        case DiagramRelation::CALLEE:
+          _cppHandler.getReferences(
+            related, astNodeId, CppServiceHandler::CALLEE, {});
+          break;
+
+        case DiagramRelation::CALLER:
+          _cppHandler.getReferences(
+            related, astNodeId, CppServiceHandler::CALLER, {});
+          break;
+
+        case DiagramRelation::BASE:
+          _cppHandler.getReferences(
+            related, astNodeId, CppServiceHandler::INHERIT_FROM, {});
+          break;
+
+        case DiagramRelation::DERIVED:
+          _cppHandler.getReferences(
+            related, astNodeId, CppServiceHandler::INHERIT_BY, {});
+          break;
+
+        case DiagramRelation::USED_TYPE:
+        {
+          std::vector<AstNodeInfo> dataMembers;
+          _cppHandler.getReferences(dataMembers, astNodeId,
+            CppServiceHandler::DATA_MEMBER, {});
+
+          for (const AstNodeInfo& node : dataMembers)
+          {
+            std::vector<AstNodeInfo> types;
+            _cppHandler.getReferences(
+              types, node.id, CppServiceHandler::TYPE, {});
+
+            if (!types.empty() &&
+                std::none_of(related.begin(), related.end(),
+                  [&types](const AstNodeInfo& type_){
+                    return type_.id == types.front().id;
+                  }))
+              related.push_back(types.front());
+          }
+
+          break;
+        }
+      }
+    });
+
+  group.wait();
 }
 
 void Diagram::getDetailedClassDiagram(
@@ -5,6 +5,8 @@
 #include <projectservice/projectservice.h>
 #include <util/graph.h>
 
+#include "symbolgraph.h"
+
 namespace cc
 {
 namespace service
@@ -14,6 +16,8 @@ namespace language
 
 class Diagram
 {
+  friend class DiagramSession;
+
 public:
   Diagram(
     std::shared_ptr<odb::database> db_,
@@ -59,10 +63,40 @@ public:
    */
   std::string getClassCollaborationLegend();
 
+  /**
+   * This function returns the nodes which are related to the given AST nodes
+   * by the given relation. The nodes are queried in parallel. This is used for
+   * expanding the nodes of incremental diagrams (see DiagramSession).
+   * @param return_ The related nodes of every AST node in the same order.
+   */
+  void getRelatedNodes(
+    std::vector<std::vector<AstNodeInfo>>& return_,
+    const std::vector<core::AstNodeId>& astNodeIds_,
+    DiagramRelation::type relation_);
+
 private:
   typedef std::vector<std::pair<std::string, std::string>> Decoration;
   typedef std::pair<util::Graph::Node, util::Graph::Node> GraphNodePair;
 
+  /**
+   * This function returns the AstNodeInfo objects of the given AST nodes in
+   * the same order.
+   */
+  std::vector<AstNodeInfo> queryNodeInfos(
+    const std::vector<model::CppAstNodeId>& astNodeIds_);
+
+  /**
+   * This function collects the nodes related to the given AST node like
+   * SymbolGraph::bfs(), but only the direct neighbours by querying the
+   * database. This is used while the symbol graph is being loaded.
+   */
+  void getNeighbours(
+    std::vector<model::CppAstNodeId>& nodes_,
+    std::vector<SymbolGraph::Edge>& edges_,
+    const core::AstNodeId& astNodeId_,
+    SymbolGraph::Relation relation_,
+    std::size_t maxNodes_);
+
   /**
    * This function adds a node which represents an AST node. The label of the
    * node is the AST node value. A node associated with the file is added only
@@ -155,6 +189,17 @@ private:
 
   std::map<core::FileId, util::Graph::Subgraph> _subgraphs;
 
+  /**
+   * Number of levels in the function call and class collaboration diagrams.
+   */
+  std::size_t _depth;
+
+  /**
+   * Maximal number of nodes in the function call and class collaboration
+   * diagrams.
+   */
+  std::size_t _maxNodes;
+
   CppServiceHandler _cppHandler;
   core::ProjectServiceHandler _projectHandler;
 };
@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <iomanip>
+#include <random>
+#include <set>
+#include <sstream>
+
+#include <util/cancellation.h>
+
+#include "diagramsession.h"
+
+namespace
+{
+
+/**
+ * Maximal number of nodes in a diagram session. A few levels of callers of a
+ * commonly used function would make the diagram unusable anyway.
+ */
+const int MaxDiagramNodes = 500;
+
+/**
+ * Maximal number of levels expanded at once.
+ */
+const std::int32_t MaxExpandDepth = 8;
+
+/**
+ * Maximal number of diagram sessions of a user session.
+ */
+const std::size_t MaxDiagramSessions = 32;
+
+/**
+ * A diagram session which hasn't been used for this long may be released when
+ * the number of diagram sessions reaches the limit.
+ */
+const std::chrono::minutes DiagramSessionIdleTime(15);
+
+/**
+ * Returns a random handle of 128 bits.
+ */
+std::string generateHandle()
+{
+  std::random_device rnd;
+  std::ostringstream os;
+
+  os << std::hex << std::setfill('0');
+  for (int i = 0; i < 4; ++i)
+    os << std::setw(8) << static_cast<std::uint32_t>(rnd());
+
+  return os.str();
+}
+
+/**
+ * Returns true if the edges of the relation point from the related node to
+ * the expanded one.
+ */
+bool isReverseRelation(cc::service::language::DiagramRelation::type relation_)
+{
+  using cc::service::language::DiagramRelation;
+
+  return relation_ == DiagramRelation::CALLER
+    || relation_ == DiagramRelation::DERIVED;
+}
+
+}
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+DiagramSession::DiagramSession(
+  Diagram& diagram_,
+  const core::AstNodeId& astNodeId_,
+  bool classDiagram_,
+  DiagramDelta& return_)
+    : _classDiagram(classDiagram_)
+{
+  std::vector<AstNodeInfo> nodes;
+  diagram_._cppHandler.getReferences(
+    nodes, astNodeId_, CppServiceHandler::DEFINITION, {});
+
+  AstNodeInfo nodeInfo;
+  if (nodes.empty())
+    diagram_._cppHandler.getAstNodeInfo(nodeInfo, astNodeId_);
+  else
+    nodeInfo = nodes.front();
+
+  _graph.setAttribute("rankdir", _classDiagram ? "BT" : "LR");
+
+  util::Graph::Node center = diagram_.addNode(_graph, nodeInfo);
+  diagram_.decorateNode(_graph, center, _classDiagram
+    ? Diagram::centerClassNodeDecoration
+    : Diagram::centerNodeDecoration);
+
+  return_.added = _graph.outputJson({center}, {});
+}
+
+void DiagramSession::expand(
+  Diagram& diagram_,
+  DiagramDelta& return_,
+  const core::AstNodeId& astNodeId_,
+  DiagramRelation::type relation_,
+  std::int32_t depth_)
+{
+  std::lock_guard<std::mutex> guard(_lock);
+
+  checkNode(astNodeId_);
+
+  const bool reverse = isReverseRelation(relation_);
+
+  const Diagram::Decoration& nodeDecoration
+    = _classDiagram ? Diagram::classNodeDecoration
+    : reverse ? Diagram::callerNodeDecoration
+    : Diagram::calleeNodeDecoration;
+
+  const Diagram::Decoration& edgeDecoration
+    = relation_ == DiagramRelation::USED_TYPE
+    ? Diagram::usedClassEdgeDecoration
+    : _classDiagram ? Diagram::inheritClassEdgeDecoration
+    : reverse ? Diagram::callerEdgeDecoration
+    : Diagram::calleeEdgeDecoration;
+
+  std::set<util::Graph::Node> addedNodes;
+  std::set<util::Graph::Edge> addedEdges;
+
+  std::set<core::AstNodeId> visited{astNodeId_};
+  std::vector<core::AstNodeId> level{astNodeId_};
+
+  depth_ = std::min(std::max(depth_, 1), MaxExpandDepth);
+
+  for (std::int32_t i = 0;
+       i < depth_ && !level.empty() && _graph.nodeCount() < MaxDiagramNodes;
+       ++i)
+  {
+    util::CancellationToken::checkCurrent();
+
+    //--- Query the uncached nodes of the level in parallel ---//
+
+    std::vector<core::AstNodeId> uncached;
+    for (const core::AstNodeId& id : level)
+      if (!_related.count(RelationKey(id, relation_)))
+        uncached.push_back(id);
+
+    if (!uncached.empty())
+    {
+      std::vector<std::vector<AstNodeInfo>> related;
+      diagram_.getRelatedNodes(related, uncached, relation_);
+
+      for (std::size_t j = 0; j < uncached.size(); ++j)
+        _related[RelationKey(uncached[j], relation_)] = std::move(related[j]);
+    }
+
+    //--- Add the related nodes ---//
+
+    std::vector<core::AstNodeId> nextLevel;
+
+    for (const core::AstNodeId& id : level)
+      for (const AstNodeInfo& node : _related[RelationKey(id, relation_)])
+      {
+        if (!_graph.hasNode(node.id))
+        {
+          if (_graph.nodeCount() >= MaxDiagramNodes)
+            break;
+
+          util::Graph::Node graphNode = diagram_.addNode(_graph, node);
+          diagram_.decorateNode(_graph, graphNode, nodeDecoration);
+
+          _owners[graphNode] = id;
+          addedNodes.insert(graphNode);
+        }
+
+        const util::Graph::Node& from = reverse ? node.id : id;
+        const util::Graph::Node& to = reverse ? id : node.id;
+
+        if (!_graph.hasEdge(from, to))
+        {
+          util::Graph::Edge edge = _graph.createEdge(from, to);
+          diagram_.decorateEdge(_graph, edge, edgeDecoration);
+
+          _edges[edge] = EdgeInfo{from, to, id};
+          addedEdges.insert(edge);
+        }
+
+        if (visited.insert(node.id).second)
+          nextLevel.push_back(node.id);
+      }
+
+    level.swap(nextLevel);
+  }
+
+  return_.added = _graph.outputJson(addedNodes, addedEdges);
+}
+
+void DiagramSession::collapse(
+  DiagramDelta& return_,
+  const core::AstNodeId& astNodeId_)
+{
+  std::lock_guard<std::mutex> guard(_lock);
+
+  checkNode(astNodeId_);
+
+  //--- Collect the nodes owned by the node, recursively ---//
+
+  std::multimap<util::Graph::Node, util::Graph::Node> owned;
+  for (const auto& owner : _owners)
+    owned.emplace(owner.second, owner.first);
+
+  std::set<util::Graph::Node> removed;
+  std::vector<util::Graph::Node> stack{astNodeId_};
+
+  while (!stack.empty())
+  {
+    util::Graph::Node node = stack.back();
+    stack.pop_back();
+
+    auto range = owned.equal_range(node);
+    for (auto it = range.first; it != range.second; ++it)
+      if (removed.insert(it->second).second)
+        stack.push_back(it->second);
+  }
+
+  //--- Remove the edges, then the nodes ---//
+
+  for (auto it = _edges.begin(); it != _edges.end();)
+  {
+    const EdgeInfo& edge = it->second;
+
+    if (edge.owner == astNodeId_ ||
+        removed.count(edge.owner) ||
+        removed.count(edge.from) ||
+        removed.count(edge.to))
+    {
+      _graph.delEdge(edge.from, edge.to);
+      return_.removedEdges.push_back(it->first);
+      it = _edges.erase(it);
+    }
+    else
+      ++it;
+  }
+
+  for (const util::Graph::Node& node : removed)
+  {
+    _graph.delNode(node);
+    _owners.erase(node);
+    return_.removedNodes.push_back(node);
+  }
+}
+
+void DiagramSession::checkNode(const core::AstNodeId& astNodeId_) const
+{
+  if (!_graph.hasNode(astNodeId_))
+  {
+    core::InvalidInput ex;
+    ex.__set_msg("The node is not in the diagram: " + astNodeId_);
+    throw ex;
+  }
+}
+
+std::string DiagramSessionStore::add(std::shared_ptr<DiagramSession> session_)
+{
+  std::lock_guard<std::mutex> guard(_lock);
+
+  const auto now = std::chrono::steady_clock::now();
+
+  if (_sessions.size() >= MaxDiagramSessions)
+    for (auto it = _sessions.begin(); it != _sessions.end();)
+      if (now - it->second.lastUsed >= DiagramSessionIdleTime)
+        it = _sessions.erase(it);
+      else
+        ++it;
+
+  if (_sessions.size() >= MaxDiagramSessions)
+  {
+    core::InvalidInput ex;
+    ex.__set_msg("Too many open diagram sessions, close one of them first");
+    throw ex;
+  }
+
+  std::string handle;
+  do
+    handle = generateHandle();
+  while (_sessions.count(handle));
+
+  _sessions[handle] = Entry{std::move(session_), now};
+
+  return handle;
+}
+
+std::shared_ptr<DiagramSession> DiagramSessionStore::get(
+  const std::string& handle_)
+{
+  std::lock_guard<std::mutex> guard(_lock);
+
+  auto it = _sessions.find(handle_);
+  if (it == _sessions.end())
+    return nullptr;
+
+  it->second.lastUsed = std::chrono::steady_clock::now();
+  return it->second.session;
+}
+
+void DiagramSessionStore::remove(const std::string& handle_)
+{
+  std::lock_guard<std::mutex> guard(_lock);
+  _sessions.erase(handle_);
+}
+
+} // language
+} // service
+} // cc
@@ -0,0 +1,142 @@
+#ifndef CC_SERVICE_LANGUAGE_DIAGRAMSESSION_H
+#define CC_SERVICE_LANGUAGE_DIAGRAMSESSION_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <util/graph.h>
+
+#include "diagram.h"
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+/**
+ * @brief An incremental diagram which is kept in memory between requests.
+ *
+ * The diagram starts with a center node, which can be extended by expanding
+ * its nodes along a relation (e.g. callees or base classes). A node added by
+ * an expansion is owned by the expanded node, so collapsing a node removes the
+ * nodes added by its expansions, recursively. Every operation returns only
+ * the changes of the graph, so the client can keep the layout of the
+ * unchanged parts.
+ *
+ * The related nodes of the expanded nodes are cached, so expanding a node
+ * again (e.g. after a collapse) doesn't query the database.
+ */
+class DiagramSession
+{
+public:
+  /**
+   * Creates the diagram with its center node.
+   * @param classDiagram_ True if the nodes are classes, false if functions.
+   * @param return_ The center node of the diagram.
+   */
+  DiagramSession(
+    Diagram& diagram_,
+    const core::AstNodeId& astNodeId_,
+    bool classDiagram_,
+    DiagramDelta& return_);
+
+  /**
+   * Adds the nodes related to the given node up to the given depth. The
+   * number of nodes in the diagram is limited, the expansion stops when the
+   * limit is reached.
+   * @return The added nodes and edges.
+   */
+  void expand(
+    Diagram& diagram_,
+    DiagramDelta& return_,
+    const core::AstNodeId& astNodeId_,
+    DiagramRelation::type relation_,
+    std::int32_t depth_);
+
+  /**
+   * Removes the nodes added by the expansions of the given node, recursively,
+   * and the edges added by these expansions.
+   * @return The removed nodes and edges.
+   */
+  void collapse(DiagramDelta& return_, const core::AstNodeId& astNodeId_);
+
+private:
+  struct EdgeInfo
+  {
+    util::Graph::Node from;
+    util::Graph::Node to;
+    util::Graph::Node owner;
+  };
+
+  typedef std::pair<core::AstNodeId, DiagramRelation::type> RelationKey;
+
+  /**
+   * Throws common.InvalidInput if the node is not in the diagram.
+   */
+  void checkNode(const core::AstNodeId& astNodeId_) const;
+
+  std::mutex _lock;
+  util::Graph _graph;
+  bool _classDiagram;
+
+  /**
+   * The node by the expansion of which the given node was added. The center
+   * node has no owner.
+   */
+  std::map<util::Graph::Node, util::Graph::Node> _owners;
+  std::map<util::Graph::Edge, EdgeInfo> _edges;
+  std::map<RelationKey, std::vector<AstNodeInfo>> _related;
+};
+
+/**
+ * @brief The diagram sessions of a user session.
+ *
+ * The handles of the diagram sessions are random, so they can't be guessed
+ * from each other. The number of diagram sessions is limited: if the limit is
+ * reached, only the sessions which haven't been used for a while are released
+ * to make room for a new one.
+ */
+class DiagramSessionStore
+{
+public:
+  /**
+   * Stores the diagram session and returns its handle.
+   * @throw core::InvalidInput If the limit is reached and every diagram
+   * session is still in use.
+   */
+  std::string add(std::shared_ptr<DiagramSession> session_);
+
+  /**
+   * Returns the diagram session of the given handle or nullptr if it doesn't
+   * exist. The session is marked as used.
+   */
+  std::shared_ptr<DiagramSession> get(const std::string& handle_);
+
+  /**
+   * Releases the diagram session of the given handle.
+   */
+  void remove(const std::string& handle_);
+
+private:
+  struct Entry
+  {
+    std::shared_ptr<DiagramSession> session;
+    std::chrono::steady_clock::time_point lastUsed;
+  };
+
+  std::mutex _lock;
+  std::map<std::string, Entry> _sessions;
+};
+
+} // language
+} // service
+} // cc
+
+#endif // CC_SERVICE_LANGUAGE_DIAGRAMSESSION_H
@@ -9,6 +9,7 @@
 #include <model/cppedge.h>
 #include <model/cppedge-odb.hxx>
 
+#include <util/cancellation.h>
 #include <util/logutil.h>
 #include <util/dbutil.h>
 #include <util/legendbuilder.h>
@@ -352,6 +353,8 @@ std::vector<util::Graph::Node> FileDiagram::getIncludedFiles(
 
     for (const auto& inclusion : res)
     {
+      util::CancellationToken::checkCurrent();
+
       model::FileId fileId = reverse_
         ? inclusion.includer.object_id()
         : inclusion.included.object_id();
@@ -392,6 +395,8 @@ std::vector<util::Graph::Node> FileDiagram::getSubDirs(
 
     for (const model::File& subdir : sub)
     {
+      util::CancellationToken::checkCurrent();
+
       core::FileInfo fileInfo;
       _projectHandler.getFileInfo(fileInfo, std::to_string(subdir.id));
 
@@ -432,6 +437,8 @@ std::vector<util::Graph::Node> FileDiagram::getImplementedFiles(
 
     for (const model::File &file : contained)
     {
+      util::CancellationToken::checkCurrent();
+
       auto files = getProvidedFileIds(graph_, std::to_string(file.id), reverse_);
       used.insert(files.begin(), files.end());
     }
@@ -452,6 +459,8 @@ std::vector<util::Graph::Node> FileDiagram::getImplementedFiles(
 
   for (const core::FileId& fileId : implements)
   {
+    util::CancellationToken::checkCurrent();
+
     core::FileInfo fileInfo;
     _projectHandler.getFileInfo(fileInfo, fileId);
 
@@ -491,6 +500,8 @@ std::vector<util::Graph::Node> FileDiagram::getDependFiles(
 
     for(const model::File& file : contained)
     {
+      util::CancellationToken::checkCurrent();
+
       auto files = getUsedFileIds(graph_, std::to_string(file.id), reverse_);
       used.insert(files.begin(), files.end());
     }
@@ -519,6 +530,8 @@ std::vector<util::Graph::Node> FileDiagram::getDependFiles(
 
   for (const core::FileId& fileId: depends)
   {
+    util::CancellationToken::checkCurrent();
+
     core::FileInfo fileInfo;
     _projectHandler.getFileInfo(fileInfo, fileId);
 
@@ -552,6 +565,8 @@ std::vector<util::Graph::Node> FileDiagram::getProvidedFiles(
 
   for (const core::FileId& fileId : fileIds)
   {
+    util::CancellationToken::checkCurrent();
+
     core::FileInfo fileInfo;
     _projectHandler.getFileInfo(fileInfo, fileId);
 
@@ -660,6 +675,8 @@ std::vector<util::Graph::Node> FileDiagram::getUsedFiles(
 
   for (const core::FileId& fileId: fileIds)
   {
+    util::CancellationToken::checkCurrent();
+
     core::FileInfo fileInfo;
     _projectHandler.getFileInfo(fileInfo, fileId);
 
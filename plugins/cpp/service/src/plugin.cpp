@@ -2,6 +2,20 @@
 
 #include <service/cppservice.h>
 
+namespace
+{
+
+const std::unordered_set<std::string> pureMethods{
+  "getFileTypes", "getAstNodeInfo", "getAstNodeInfoByPosition",
+  "getSourceText", "getDocumentation", "getProperties", "getDiagramTypes",
+  "getDiagram", "getDiagramLegend", "getFileDiagramTypes", "getFileDiagram",
+  "getFileDiagramLegend", "getReferenceTypes", "getReferenceCount",
+  "getReferences", "getReferencesInFile", "getReferencesPage",
+  "getFileReferenceTypes", "getFileReferences", "getFileReferenceCount",
+  "getSyntaxHighlight"};
+
+} // namespace
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wreturn-type-c-linkage"
 extern "C"
@@ -9,6 +23,25 @@ extern "C"
   boost::program_options::options_description getOptions()
   {
     boost::program_options::options_description description("C++ Plugin");
+
+    description.add_options()
+      ("cpp-parallel-queries",
+        boost::program_options::value<int>()->default_value(4),
+        "Number of independent database queries that a single C++ service "
+        "request (e.g. a diagram or a documentation page) may run in parallel. "
+        "This is always 1 when CodeCompass is built with SQLite.")
+      ("cpp-diagram-depth",
+        boost::program_options::value<int>()->default_value(1),
+        "Number of levels of callers and callees in function call diagrams, "
+        "and of base and derived classes in class collaboration diagrams. "
+        "Until the call and inheritance graph of the workspace is loaded in "
+        "the background, the diagrams have only one level.")
+      ("cpp-diagram-max-nodes",
+        boost::program_options::value<int>()->default_value(150),
+        "Maximal number of nodes in function call and class collaboration "
+        "diagrams. The farthest levels are truncated if the diagram would be "
+        "larger.");
+
     return description;
   }
 
@@ -19,7 +52,7 @@ extern "C"
     cc::webserver::registerPluginSimple(
       context_,
       pluginHandler_,
-      CODECOMPASS_LANGUAGE_SERVICE_FACTORY_WITH_CFG(Cpp),
+      CODECOMPASS_LANGUAGE_SERVICE_FACTORY_WITH_CFG(Cpp, pureMethods),
       "CppService");
   }
 }
@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include <model/cppastnode-odb.hxx>
+#include <model/cppinheritance.h>
+#include <model/cppinheritance-odb.hxx>
+#include <model/cpprelation.h>
+#include <model/cpprelation-odb.hxx>
+
+#include <util/cancellation.h>
+#include <util/filesystem.h>
+#include <util/logutil.h>
+#include <util/odbtransaction.h>
+
+#include "symbolgraph.h"
+
+namespace
+{
+
+typedef odb::query<cc::model::CppAstNode> AstQuery;
+typedef odb::query<cc::model::CppRelation> RelQuery;
+typedef odb::result<cc::model::CppAstNodeLocation> AstLocResult;
+
+/**
+ * A function definition or a function call in a file.
+ */
+struct RangeItem
+{
+  cc::model::CppAstNodeId id;
+  std::uint64_t mangledNameHash;
+  std::pair<std::size_t, std::size_t> start;
+  std::pair<std::size_t, std::size_t> end;
+  bool definition;
+  bool virtualCall;
+};
+
+const std::vector<cc::model::CppAstNodeId> NoNodes;
+
+struct CachedGraph
+{
+  std::string version;
+  std::shared_ptr<const cc::service::language::SymbolGraph> graph;
+  bool loading = false;
+
+  /**
+   * The workspace version of which the graph failed to load, so it is not
+   * loaded again.
+   */
+  std::string failedVersion;
+};
+
+std::mutex cacheLock;
+
+/**
+ * The graphs by database. This is never destroyed, since a loading thread may
+ * still use it at exit.
+ */
+std::map<odb::database*, CachedGraph>& cache
+  = *new std::map<odb::database*, CachedGraph>;
+
+}
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+std::shared_ptr<const SymbolGraph> SymbolGraph::get(
+  std::shared_ptr<odb::database> db_,
+  const std::string& datadir_)
+{
+  const std::string version =
+    util::fileVersion(datadir_ + "/project_info.json");
+
+  std::lock_guard<std::mutex> guard(cacheLock);
+  CachedGraph& cached = cache[db_.get()];
+
+  if (cached.graph && cached.version == version)
+    return cached.graph;
+
+  if (cached.loading || cached.failedVersion == version)
+    return nullptr;
+
+  // The graph is loaded on its own thread, without the cancellation token and
+  // the time limit of the current request.
+  std::thread([db_, version](){
+    std::shared_ptr<const SymbolGraph> graph;
+
+    try
+    {
+      LOG(info) << "Loading the call and inheritance graph of the C++ symbols";
+      graph = std::make_shared<SymbolGraph>(*db_);
+      LOG(info) << "Loaded the call and inheritance graph of "
+        << graph->_hashes.size() << " definitions";
+    }
+    catch (const std::exception& ex)
+    {
+      LOG(error)
+        << "Failed to load the call and inheritance graph of the C++ "
+        << "symbols: " << ex.what();
+    }
+
+    std::lock_guard<std::mutex> guard(cacheLock);
+    CachedGraph& cached = cache[db_.get()];
+
+    cached.loading = false;
+
+    if (graph)
+    {
+      cached.version = version;
+      cached.graph = graph;
+    }
+    else
+      cached.failedVersion = version;
+  }).detach();
+
+  cached.loading = true;
+
+  return nullptr;
+}
+
+SymbolGraph::SymbolGraph(odb::database& db_)
+{
+  util::OdbTransaction transaction(db_);
+
+  transaction([&, this](){
+    loadDefinitionsAndCalls(db_);
+    loadRelations(db_);
+  });
+}
+
+void SymbolGraph::loadDefinitionsAndCalls(odb::database& db_)
+{
+  std::unordered_map<model::FileId, std::vector<RangeItem>> files;
+
+  auto rangeItem = [](const model::CppAstNodeLocation& node_, bool def_){
+    return RangeItem{
+      node_.id, node_.mangledNameHash,
+      {node_.startLine, node_.startColumn},
+      {node_.endLine, node_.endColumn},
+      def_,
+      node_.astType == model::CppAstNode::AstType::VirtualCall};
+  };
+
+  //--- Definitions ---//
+
+  for (const model::CppAstNodeLocation& node : db_.query<
+    model::CppAstNodeLocation>(
+      AstQuery::astType == model::CppAstNode::AstType::Definition &&
+      (AstQuery::symbolType == model::CppAstNode::SymbolType::Type ||
+       AstQuery::symbolType == model::CppAstNode::SymbolType::Function)))
+  {
+    _hashes[node.id] = node.mangledNameHash;
+    _definitions[node.mangledNameHash].push_back(node.id);
+  }
+
+  // The definitions of functions are needed with their location for finding
+  // the enclosing function of the calls.
+  for (const model::CppAstNodeLocation& node : db_.query<
+    model::CppAstNodeLocation>(
+      AstQuery::astType == model::CppAstNode::AstType::Definition &&
+      AstQuery::symbolType == model::CppAstNode::SymbolType::Function &&
+      AstQuery::location.range.end.line != model::Position::npos))
+    files[node.file].push_back(rangeItem(node, true));
+
+  //--- Calls ---//
+
+  for (const model::CppAstNodeLocation& node : db_.query<
+    model::CppAstNodeLocation>(
+      (AstQuery::astType == model::CppAstNode::AstType::Usage ||
+       AstQuery::astType == model::CppAstNode::AstType::VirtualCall) &&
+      AstQuery::symbolType == model::CppAstNode::SymbolType::Function))
+  {
+    auto it = files.find(node.file);
+    if (it != files.end())
+      it->second.push_back(rangeItem(node, false));
+  }
+
+  //--- Assign the calls to the enclosing function definitions ---//
+
+  for (auto& file : files)
+  {
+    std::vector<RangeItem>& items = file.second;
+
+    // Definitions precede the calls at the same position, and the enclosing
+    // definitions precede the nested ones.
+    std::sort(items.begin(), items.end(),
+      [](const RangeItem& lhs_, const RangeItem& rhs_){
+        if (lhs_.start != rhs_.start)
+          return lhs_.start < rhs_.start;
+        if (lhs_.definition != rhs_.definition)
+          return lhs_.definition;
+        return lhs_.end > rhs_.end;
+      });
+
+    std::vector<const RangeItem*> enclosing;
+
+    for (const RangeItem& item : items)
+    {
+      while (!enclosing.empty() && enclosing.back()->end <= item.start)
+        enclosing.pop_back();
+
+      if (item.definition)
+      {
+        enclosing.push_back(&item);
+        continue;
+      }
+
+      for (const RangeItem* def : enclosing)
+      {
+        if (def->end <= item.end)
+          continue;
+
+        _calls[def->id].emplace_back(item.mangledNameHash, item.virtualCall);
+
+        if (!item.virtualCall)
+          _callers[item.mangledNameHash].push_back(def->id);
+      }
+    }
+  }
+
+  for (auto& callers : _callers)
+  {
+    std::vector<model::CppAstNodeId>& ids = callers.second;
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  }
+}
+
+void SymbolGraph::loadRelations(odb::database& db_)
+{
+  for (const model::CppRelation& relation : db_.query<model::CppRelation>(
+    RelQuery::kind == model::CppRelation::Kind::Override))
+    _overriders[relation.rhs].push_back(relation.lhs);
+
+  for (const model::CppInheritance& inheritance :
+    db_.query<model::CppInheritance>())
+  {
+    _bases[inheritance.derived].push_back(inheritance.base);
+    _derived[inheritance.base].push_back(inheritance.derived);
+  }
+}
+
+const std::vector<model::CppAstNodeId>& SymbolGraph::definitions(
+  std::uint64_t mangledNameHash_) const
+{
+  auto it = _definitions.find(mangledNameHash_);
+  return it == _definitions.end() ? NoNodes : it->second;
+}
+
+std::vector<SymbolGraph::Neighbour> SymbolGraph::neighbours(
+  model::CppAstNodeId node_,
+  Relation relation_) const
+{
+  std::vector<Neighbour> result;
+  std::unordered_set<model::CppAstNodeId> added;
+
+  auto add = [&](model::CppAstNodeId id_, bool virtualCall_){
+    if (added.insert(id_).second)
+      result.emplace_back(id_, virtualCall_);
+  };
+
+  auto hashIt = _hashes.find(node_);
+  if (hashIt == _hashes.end())
+    return result;
+
+  const std::uint64_t hash = hashIt->second;
+
+  switch (relation_)
+  {
+    case CALLEE:
+    {
+      auto it = _calls.find(node_);
+      if (it == _calls.end())
+        break;
+
+      for (const auto& call : it->second)
+      {
+        for (model::CppAstNodeId def : definitions(call.first))
+          add(def, false);
+
+        if (!call.second)
+          continue;
+
+        // A virtual call may call any override of the function.
+        std::unordered_set<std::uint64_t> visited{call.first};
+        std::vector<std::uint64_t> stack{call.first};
+
+        while (!stack.empty())
+        {
+          auto overIt = _overriders.find(stack.back());
+          stack.pop_back();
+
+          if (overIt == _overriders.end())
+            continue;
+
+          for (std::uint64_t overrider : overIt->second)
+            if (visited.insert(overrider).second)
+            {
+              stack.push_back(overrider);
+              for (model::CppAstNodeId def : definitions(overrider))
+                add(def, true);
+            }
+        }
+      }
+
+      break;
+    }
+
+    case CALLER:
+    {
+      auto it = _callers.find(hash);
+      if (it != _callers.end())
+        for (model::CppAstNodeId def : it->second)
+          add(def, false);
+      break;
+    }
+
+    case BASE:
+    case DERIVED:
+    {
+      const auto& relations = relation_ == BASE ? _bases : _derived;
+
+      auto it = relations.find(hash);
+      if (it != relations.end())
+        for (std::uint64_t related : it->second)
+          for (model::CppAstNodeId def : definitions(related))
+            add(def, false);
+      break;
+    }
+  }
+
+  return result;
+}
+
+bool SymbolGraph::bfs(
+  std::vector<model::CppAstNodeId>& nodes_,
+  std::vector<Edge>& edges_,
+  model::CppAstNodeId start_,
+  Relation relation_,
+  std::size_t depth_,
+  std::size_t maxNodes_) const
+{
+  const bool reverse = relation_ == CALLER || relation_ == DERIVED;
+
+  std::unordered_set<model::CppAstNodeId> visited{start_};
+  std::vector<model::CppAstNodeId> level{start_};
+  bool complete = true;
+
+  for (std::size_t i = 0; i < depth_ && !level.empty(); ++i)
+  {
+    util::CancellationToken::checkCurrent();
+
+    std::vector<model::CppAstNodeId> nextLevel;
+
+    for (model::CppAstNodeId node : level)
+      for (const Neighbour& neighbour : neighbours(node, relation_))
+      {
+        if (!visited.count(neighbour.first))
+        {
+          if (nodes_.size() >= maxNodes_)
+          {
+            complete = false;
+            continue;
+          }
+
+          visited.insert(neighbour.first);
+          nodes_.push_back(neighbour.first);
+          nextLevel.push_back(neighbour.first);
+        }
+
+        edges_.push_back(reverse
+          ? Edge{neighbour.first, node, neighbour.second}
+          : Edge{node, neighbour.first, neighbour.second});
+      }
+
+    level.swap(nextLevel);
+  }
+
+  return complete;
+}
+
+} // language
+} // service
+} // cc
@@ -0,0 +1,161 @@
+#ifndef CC_SERVICE_LANGUAGE_SYMBOLGRAPH_H
+#define CC_SERVICE_LANGUAGE_SYMBOLGRAPH_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <odb/database.hxx>
+
+#include <model/cppastnode.h>
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+/**
+ * @brief In-memory adjacency of the functions and types of a workspace.
+ *
+ * The graph is loaded from the database at once: the function and type
+ * definitions, the function calls (CppAstNode), the overrides (CppRelation)
+ * and the inheritance relations (CppInheritance). The calls are assigned to
+ * the enclosing function definitions by their source ranges, the same way as
+ * the CALLEE and CALLER references of CppServiceHandler.
+ *
+ * Multi-level diagrams are computed by breadth-first search over the loaded
+ * graph, so they don't need any database query except for the labels of the
+ * resulting nodes.
+ *
+ * Only the database of the project is loaded, the symbols of the library
+ * index are not part of the graph.
+ */
+class SymbolGraph
+{
+public:
+  enum Relation
+  {
+    CALLEE, /*!< Functions called by a function. */
+    CALLER, /*!< Functions calling a function. */
+    BASE, /*!< Types from which a type inherits. */
+    DERIVED /*!< Types inheriting from a type. */
+  };
+
+  struct Edge
+  {
+    /**
+     * The caller function or the derived type.
+     */
+    model::CppAstNodeId from;
+
+    /**
+     * The called function or the base type.
+     */
+    model::CppAstNodeId to;
+
+    /**
+     * True if the called function is an override of the function which is
+     * called virtually.
+     */
+    bool virtualCall;
+  };
+
+  /**
+   * Returns the graph of the given database, or nullptr if it is not loaded
+   * yet. The graph is shared by the requests until the workspace is parsed
+   * again, i.e. the project_info.json in the data directory changes.
+   *
+   * The first call for a workspace version starts loading the graph on a
+   * background thread and returns immediately, so the loading doesn't count
+   * in the time limit of any request and can't be cancelled by it. Until the
+   * graph is loaded the callers have to query the database instead.
+   */
+  static std::shared_ptr<const SymbolGraph> get(
+    std::shared_ptr<odb::database> db_,
+    const std::string& datadir_);
+
+  /**
+   * Loads the graph from the database.
+   */
+  SymbolGraph(odb::database& db_);
+
+  /**
+   * Collects the nodes reachable from the given definition node along the
+   * given relation in breadth-first order.
+   * @param nodes_ The reached nodes except for the start node.
+   * @param edges_ The edges between the start node and the reached nodes.
+   * @param depth_ Maximal distance of the reached nodes from the start node.
+   * @param maxNodes_ Maximal number of reached nodes. The search stops when
+   * this is reached, so the farthest level may be incomplete.
+   * @return False if some nodes were left out because of maxNodes_.
+   */
+  bool bfs(
+    std::vector<model::CppAstNodeId>& nodes_,
+    std::vector<Edge>& edges_,
+    model::CppAstNodeId start_,
+    Relation relation_,
+    std::size_t depth_,
+    std::size_t maxNodes_) const;
+
+private:
+  typedef std::pair<model::CppAstNodeId, bool> Neighbour;
+
+  /**
+   * Returns the direct neighbours of the node along the relation and whether
+   * they are reached by a virtual call.
+   */
+  std::vector<Neighbour> neighbours(
+    model::CppAstNodeId node_,
+    Relation relation_) const;
+
+  /**
+   * Returns the definitions of the given mangled name hash.
+   */
+  const std::vector<model::CppAstNodeId>& definitions(
+    std::uint64_t mangledNameHash_) const;
+
+  void loadDefinitionsAndCalls(odb::database& db_);
+  void loadRelations(odb::database& db_);
+
+  /**
+   * The mangled name hash of the definition nodes.
+   */
+  std::unordered_map<model::CppAstNodeId, std::uint64_t> _hashes;
+
+  /**
+   * The definition nodes of functions and types by their mangled name hash.
+   */
+  std::unordered_map<std::uint64_t, std::vector<model::CppAstNodeId>>
+    _definitions;
+
+  /**
+   * The called mangled name hashes in the function definitions and whether
+   * they are called virtually.
+   */
+  std::unordered_map<model::CppAstNodeId, std::vector<std::pair<
+    std::uint64_t, bool>>> _calls;
+
+  /**
+   * The function definitions calling the given mangled name hash.
+   */
+  std::unordered_map<std::uint64_t, std::vector<model::CppAstNodeId>>
+    _callers;
+
+  /**
+   * The direct overrides of a function by mangled name hash.
+   */
+  std::unordered_map<std::uint64_t, std::vector<std::uint64_t>> _overriders;
+
+  std::unordered_map<std::uint64_t, std::vector<std::uint64_t>> _bases;
+  std::unordered_map<std::uint64_t, std::vector<std::uint64_t>> _derived;
+};
+
+} // language
+} // service
+} // cc
+
+#endif // CC_SERVICE_LANGUAGE_SYMBOLGRAPH_H
@@ -0,0 +1,218 @@
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <util/sysinfo.h>
+
+#include "parseadmission.h"
+
+using namespace cc;
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+const std::size_t MiB = 1024 * 1024;
+
+}
+
+class ParseAdmissionTest : public ::testing::Test
+{
+protected:
+  virtual void SetUp() override
+  {
+    _history = (fs::temp_directory_path() / fs::unique_path()).string();
+  }
+
+  virtual void TearDown() override
+  {
+    _admission.reset();
+    fs::remove(_history);
+  }
+
+  /**
+   * Creates the admission with the given footprints in its history file. The
+   * budget is 1000 MiB above the current memory usage.
+   */
+  void create(
+    std::size_t maxWorkers_,
+    const std::map<std::string, std::size_t>& footprints_ = {})
+  {
+    {
+      std::ofstream history(_history);
+      for (const auto& footprint : footprints_)
+        history << footprint.second * MiB << ' ' << footprint.first << '\n';
+    }
+
+    _admission.reset(new parser::ParseAdmission(
+      maxWorkers_, util::residentSetSize() + 1000 * MiB, _history));
+  }
+
+  bool acquire(const std::string& file_)
+  {
+    return _admission->tryAcquire(file_, _tickets[file_], [this, file_]{
+      _retried.push_back(file_);
+    });
+  }
+
+  void release(const std::string& file_, std::size_t footprint_ = 0)
+  {
+    _admission->release(file_, _tickets[file_], footprint_);
+  }
+
+  /**
+   * Parses the file repeatedly with threads which don't use the CPU, so the
+   * worker limit is raised.
+   */
+  void parseBlocked(const std::string& file_, int times_)
+  {
+    for (int i = 0; i < times_; ++i)
+    {
+      ASSERT_TRUE(acquire(file_));
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      release(file_);
+    }
+  }
+
+  std::string _history;
+  std::unique_ptr<parser::ParseAdmission> _admission;
+  std::map<std::string, parser::ParseAdmission::Ticket> _tickets;
+  std::vector<std::string> _retried;
+};
+
+TEST_F(ParseAdmissionTest, SingleTranslationUnitIsAlwaysAdmitted)
+{
+  create(4, {{"huge", 2000}, {"other", 2000}});
+
+  // Neither fits in the budget, but the parsing can't stall.
+  EXPECT_TRUE(acquire("huge"));
+  EXPECT_FALSE(acquire("other"));
+
+  release("huge");
+  EXPECT_EQ(_retried, std::vector<std::string>{"other"});
+
+  EXPECT_TRUE(acquire("other"));
+  release("other");
+}
+
+TEST_F(ParseAdmissionTest, WaitingAreResumedInOrder)
+{
+  create(1);
+
+  EXPECT_TRUE(acquire("a"));
+  EXPECT_FALSE(acquire("b"));
+  EXPECT_FALSE(acquire("c"));
+  EXPECT_TRUE(_retried.empty());
+
+  // Only as many are resumed as can be parsed.
+  release("a");
+  EXPECT_EQ(_retried, std::vector<std::string>{"b"});
+
+  // The resumed translation unit is admitted without waiting again.
+  EXPECT_TRUE(acquire("b"));
+  release("b");
+  EXPECT_EQ(_retried, (std::vector<std::string>{"b", "c"}));
+
+  EXPECT_TRUE(acquire("c"));
+  release("c");
+}
+
+TEST_F(ParseAdmissionTest, WorkerLimitGrowsWhenBlocked)
+{
+  create(2, {{"a", 10}, {"b", 10}});
+
+  // The limit starts at the number of CPU cores.
+  if (std::thread::hardware_concurrency() < 2)
+  {
+    EXPECT_TRUE(acquire("a"));
+    EXPECT_FALSE(acquire("b"));
+    release("a");
+    EXPECT_TRUE(acquire("b"));
+    release("b");
+  }
+
+  parseBlocked("a", 5);
+
+  EXPECT_TRUE(acquire("a"));
+  EXPECT_TRUE(acquire("b"));
+  release("a");
+  release("b");
+}
+
+TEST_F(ParseAdmissionTest, NewArrivalsDontOvertakeWaiting)
+{
+  create(2, {{"big1", 600}, {"big2", 600}, {"small", 10}});
+  parseBlocked("small", 5);
+
+  EXPECT_TRUE(acquire("big1"));
+
+  // The second big one doesn't fit in the budget, and the small one has to
+  // wait for it even though it would fit.
+  EXPECT_FALSE(acquire("big2"));
+  EXPECT_FALSE(acquire("small"));
+
+  release("big1");
+  EXPECT_EQ(_retried, (std::vector<std::string>{"big2", "small"}));
+
+  EXPECT_TRUE(acquire("big2"));
+  EXPECT_TRUE(acquire("small"));
+  release("big2");
+  release("small");
+}
+
+TEST_F(ParseAdmissionTest, GuardReleasesOnException)
+{
+  create(1);
+
+  const std::string file = "a";
+  parser::ParseAdmission::Ticket ticket;
+  ASSERT_TRUE(_admission->tryAcquire(file, ticket, []{}));
+  EXPECT_FALSE(acquire("b"));
+
+  try
+  {
+    parser::ParseAdmission::Guard guard(*_admission, file, ticket);
+    throw std::runtime_error("parsing failed");
+  }
+  catch (const std::runtime_error&)
+  {
+  }
+
+  EXPECT_EQ(_retried, std::vector<std::string>{"b"});
+}
+
+TEST_F(ParseAdmissionTest, FootprintsAreKeptBetweenRuns)
+{
+  create(1);
+
+  ASSERT_TRUE(acquire("a"));
+  EXPECT_EQ(_tickets["a"].estimate, 512 * MiB);
+  release("a", 100 * MiB);
+
+  ASSERT_TRUE(acquire("b"));
+  EXPECT_EQ(_tickets["b"].estimate, 100 * MiB);
+  release("b", 300 * MiB);
+
+  // The destructor saves the history file which is loaded by the next run.
+  _admission.reset();
+  _admission.reset(new parser::ParseAdmission(1, 0, _history));
+
+  ASSERT_TRUE(acquire("a"));
+  EXPECT_EQ(_tickets["a"].estimate, 100 * MiB);
+  release("a");
+
+  // New translation units are expected to take the average footprint.
+  ASSERT_TRUE(acquire("c"));
+  EXPECT_EQ(_tickets["c"].estimate, 200 * MiB);
+  release("c");
+}
@@ -8,11 +8,18 @@ require([
 function (topic, Menu, MenuItem, PopupMenuItem, model, viewHandler) {
   model.addService('cppservice', 'CppService', LanguageServiceClient);
 
+  /**
+   * Value of CppServiceHandler::FUNCTION_CALL. The other diagram types of the
+   * diagram sessions are class diagrams.
+   */
+  var FUNCTION_CALL_DIAGRAM = 0;
+
   var astDiagram = {
     id : 'cpp-ast-diagram',
 
     getDiagram : function (diagramType, nodeId, callback) {
-      model.cppservice.getDiagram(nodeId, diagramType, callback);
+      model.cppservice.getDiagram(
+        nodeId, diagramType, DiagramFormat.SVG, callback);
     },
 
     getDiagramLegend : function (diagramType) {
@@ -39,11 +46,201 @@ function (topic, Menu, MenuItem, PopupMenuItem, model, viewHandler) {
     type : viewHandler.moduleType.Diagram
   });
 
+  /**
+   * This function merges the given list of graph elements into the other one.
+   * The elements with the same ID are replaced.
+   */
+  function mergeById(elements, added) {
+    (added || []).forEach(function (element) {
+      for (var i = 0; i < elements.length; ++i)
+        if (elements[i].id === element.id) {
+          elements[i] = element;
+          return;
+        }
+
+      elements.push(element);
+    });
+  }
+
+  /**
+   * This function applies a DiagramDelta returned by a diagram session to the
+   * JSON graph model kept by the client. The clusters which become empty are
+   * removed, the added nodes of an existing cluster are appended to it.
+   */
+  function applyDelta(graph, delta) {
+    var removedNodes = {};
+    var removedEdges = {};
+
+    (delta.removedNodes || []).forEach(function (id) {
+      removedNodes[id] = true;
+    });
+
+    (delta.removedEdges || []).forEach(function (id) {
+      removedEdges[id] = true;
+    });
+
+    graph.nodes = graph.nodes.filter(function (node) {
+      return !removedNodes[node.id];
+    });
+
+    graph.edges = graph.edges.filter(function (edge) {
+      return !removedEdges[edge.id]
+        && !removedNodes[edge.from]
+        && !removedNodes[edge.to];
+    });
+
+    graph.clusters = graph.clusters.filter(function (cluster) {
+      cluster.nodes = cluster.nodes.filter(function (id) {
+        return !removedNodes[id];
+      });
+      return cluster.nodes.length !== 0;
+    });
+
+    if (!delta.added)
+      return;
+
+    var added = JSON.parse(delta.added);
+
+    if (added.directed !== undefined)
+      graph.directed = added.directed;
+
+    for (var key in added.attributes)
+      graph.attributes[key] = added.attributes[key];
+
+    mergeById(graph.nodes, added.nodes);
+    mergeById(graph.edges, added.edges);
+
+    (added.clusters || []).forEach(function (cluster) {
+      var existing = graph.clusters.filter(function (c) {
+        return c.id === cluster.id;
+      })[0];
+
+      if (!existing) {
+        graph.clusters.push(cluster);
+        return;
+      }
+
+      cluster.nodes.forEach(function (id) {
+        if (existing.nodes.indexOf(id) === -1)
+          existing.nodes.push(id);
+      });
+    });
+  }
+
+  /**
+   * This handler draws the diagrams of the incremental diagram sessions. The
+   * server sends only the changes of the graph, which are merged into a JSON
+   * graph model laid out by the diagram view. The nodes can be expanded and
+   * collapsed from their context menu.
+   */
+  var sessionDiagram = {
+    id : 'cpp-ast-diagram-session',
+
+    getDiagram : function (diagramType, nodeId, callback) {
+      var that = this;
+
+      this._closeSession();
+
+      model.cppservice.createDiagramSession(nodeId, diagramType,
+      function (delta) {
+        if (!(delta instanceof DiagramDelta)) {
+          console.error(delta);
+          callback(null);
+          return;
+        }
+
+        that._session = delta.session;
+        that._graph = {
+          nodes      : [],
+          edges      : [],
+          clusters   : [],
+          attributes : {}
+        };
+
+        applyDelta(that._graph, delta);
+        callback(that._graph);
+      });
+    },
+
+    getDiagramLegend : function (diagramType) {
+      return astDiagram.getDiagramLegend(diagramType);
+    },
+
+    mouseOverInfo : function (diagramType, nodeId) {
+      return astDiagram.mouseOverInfo(diagramType, nodeId);
+    },
+
+    /**
+     * This function returns the menu items of a diagram node. Their action
+     * gets a callback which is called with the changed graph model.
+     */
+    getNodeActions : function (diagramType, nodeId) {
+      var that = this;
+
+      function expand(label, relation) {
+        return {
+          label  : label,
+          action : function (callback) {
+            model.cppservice.expandDiagramNode(
+              that._session, nodeId, relation, 1,
+              that._deltaHandler(callback));
+          }
+        };
+      }
+
+      // The diagram type comes from the URL as a string after a reload.
+      var actions = Number(diagramType) === FUNCTION_CALL_DIAGRAM
+        ? [expand('Show callees', DiagramRelation.CALLEE),
+           expand('Show callers', DiagramRelation.CALLER)]
+        : [expand('Show base classes', DiagramRelation.BASE),
+           expand('Show derived classes', DiagramRelation.DERIVED),
+           expand('Show used types', DiagramRelation.USED_TYPE)];
+
+      actions.push({
+        label  : 'Collapse',
+        action : function (callback) {
+          model.cppservice.collapseDiagramNode(
+            that._session, nodeId, that._deltaHandler(callback));
+        }
+      });
+
+      return actions;
+    },
+
+    _deltaHandler : function (callback) {
+      var that = this;
+
+      return function (delta) {
+        if (!(delta instanceof DiagramDelta)) {
+          // The session may have expired, the last graph is kept.
+          console.error(delta);
+          return;
+        }
+
+        applyDelta(that._graph, delta);
+        callback(that._graph);
+      };
+    },
+
+    _closeSession : function () {
+      if (!this._session)
+        return;
+
+      model.cppservice.closeDiagramSession(this._session, function () {});
+      this._session = null;
+    }
+  };
+
+  viewHandler.registerModule(sessionDiagram, {
+    type : viewHandler.moduleType.Diagram
+  });
+
   var fileDiagramHandler = {
     id : 'cpp-file-diagram-handler',
 
     getDiagram : function (diagramType, nodeId, callback) {
-      model.cppservice.getFileDiagram(nodeId, diagramType, callback);
+      model.cppservice.getFileDiagram(
+        nodeId, diagramType, DiagramFormat.SVG, callback);
     },
 
     getDiagramLegend : function (diagramType) {
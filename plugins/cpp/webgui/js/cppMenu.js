@@ -99,6 +99,23 @@ function (topic, Menu, MenuItem, PopupMenuItem, astHelper, model, viewHandler) {
           }
         }));
 
+      // The incremental diagrams start from the center node, which can be
+      // expanded from its context menu.
+      for (diagramType in diagramTypes)
+        submenu.addChild(new MenuItem({
+          label   : 'Interactive ' + diagramType.toLowerCase(),
+          type    : diagramType,
+          onClick : function () {
+            var that = this;
+
+            topic.publish('codecompass/openDiagram', {
+              handler : 'cpp-ast-diagram-session',
+              diagramType : diagramTypes[that.type],
+              node : nodeInfo.id
+            });
+          }
+        }));
+
       submenu.addChild(new MenuItem({
         label : "CodeBites",
         onClick : function () {
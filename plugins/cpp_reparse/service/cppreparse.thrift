@@ -33,6 +33,26 @@ struct ASTNodeDetail
   2: list<ASTNodeBasic> children /** Basic details about the children nodes. */
 }
 
+/**
+ * A node of the lazily loaded syntax tree of a file (see getASTRoots()).
+ */
+struct ASTTreeNode
+{
+  1: string handle /** Opaque identifier of the node in the syntax tree of the file. */
+  2: string type /** The type name of the AST node (e.g. FunctionDecl). */
+  3: string label /** Short description of the node, e.g. the declared name and the line. */
+  4: bool   hasChildren /** Whether the node has further nodes as children. */
+}
+
+/**
+ * A page of AST nodes.
+ */
+struct ASTTreePage
+{
+  1: list<ASTTreeNode> nodes
+  2: bool hasMore /** True if there are nodes after this page. */
+}
+
 service CppReparseService
 {
   /**
@@ -43,6 +63,9 @@ service CppReparseService
 
   /**
    * Returns the Abstract Syntax Tree (AST) for the given file as HTML string.
+   * Only the declarations of the file itself are printed, without the ones of
+   * the included headers, and the output is cut at the limit of the server. Large syntax trees can be
+   * browsed by getASTRoots() and getASTChildren() instead.
    */
   string getAsHTML(1: common.FileId fileId);
 
@@ -50,4 +73,40 @@ service CppReparseService
    * Returns the AST for the given AST Node('s subtree) as an HTML string.
    */
   string getAsHTMLForNode(1: common.AstNodeId nodeId);
+
+  /**
+   * Returns the top-level declarations of the given file, without the ones
+   * coming from included files. At most limit nodes are returned starting at
+   * the given offset.
+   */
+  ASTTreePage getASTRoots(
+    1: common.FileId fileId,
+    2: i32 offset,
+    3: i32 limit);
+
+  /**
+   * Returns the children of the node of the given handle in the syntax tree of
+   * the file. At most limit nodes are returned starting at the given offset.
+   */
+  ASTTreePage getASTChildren(
+    1: common.FileId fileId,
+    2: string handle,
+    3: i32 offset,
+    4: i32 limit);
+
+  /**
+   * Returns the subtree of the node of the given handle as an HTML string. The
+   * output is cut at maxSize bytes (or at the limit of the server if that is
+   * smaller).
+   */
+  string getASTNodeAsHTML(
+    1: common.FileId fileId,
+    2: string handle,
+    3: i32 maxSize);
+
+  /**
+   * Hints that the AST of the given file is likely to be requested soon, e.g.
+   * because the file has been opened. The AST is built in the background.
+   */
+  void prewarm(1: common.FileId fileId);
 }
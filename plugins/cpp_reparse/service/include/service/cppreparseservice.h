@@ -5,6 +5,7 @@
 #include <memory>
 
 #include <boost/program_options/variables_map.hpp>
+#include <boost/variant.hpp>
 
 #include <odb/database.hxx>
 
@@ -13,6 +14,11 @@
 
 #include <CppReparseService.h>
 
+namespace clang
+{
+class ASTUnit;
+} // namespace clang
+
 namespace cc
 {
 
@@ -23,6 +29,7 @@ namespace reparse
 {
 
 class ASTCache;
+class ASTPrewarmer;
 class CppReparser;
 
 } // namespace reparse
@@ -35,7 +42,7 @@ class CppReparseServiceHandler: virtual public CppReparseServiceIf
 public:
   CppReparseServiceHandler(
     std::shared_ptr<odb::database> db_,
-    std::shared_ptr<std::string> /* datadir_ */,
+    std::shared_ptr<std::string> datadir_,
     const cc::webserver::ServerContext& context_);
 
   ~CppReparseServiceHandler();
@@ -50,13 +57,48 @@ public:
     std::string& return_,
     const core::AstNodeId& nodeId_) override;
 
+  virtual void getASTRoots(
+    ASTTreePage& return_,
+    const core::FileId& fileId_,
+    const int32_t offset_,
+    const int32_t limit_) override;
+
+  virtual void getASTChildren(
+    ASTTreePage& return_,
+    const core::FileId& fileId_,
+    const std::string& handle_,
+    const int32_t offset_,
+    const int32_t limit_) override;
+
+  virtual void getASTNodeAsHTML(
+    std::string& return_,
+    const core::FileId& fileId_,
+    const std::string& handle_,
+    const int32_t maxSize_) override;
+
+  virtual void prewarm(const core::FileId& fileId_) override;
+
 private:
+  /**
+   * Returns the AST of the given file from the reparser and records the
+   * access for the prewarming.
+   */
+  boost::variant<std::shared_ptr<clang::ASTUnit>, std::string>
+  getAST(const core::FileId& fileId_);
+
   std::shared_ptr<odb::database> _db;
   util::OdbTransaction _transaction;
   const boost::program_options::variables_map& _config;
 
   std::shared_ptr<reparse::ASTCache> _astCache;
   std::unique_ptr<reparse::CppReparser> _reparser;
+  std::unique_ptr<reparse::ASTPrewarmer> _prewarmer;
+
+  /**
+   * The maximum size of the HTML output of a single call in bytes (before
+   * formatting), or 0 if it is not limited.
+   */
+  size_t _htmlLimit;
 };
 
 } // namespace language
@@ -2,6 +2,8 @@
 #define CC_SERVICE_CPPREPARSESERVICE_REPARSER_H
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <boost/variant.hpp>
 
@@ -29,13 +31,24 @@ namespace reparse
 {
 
 class ASTCache;
+class ASTDiskCache;
+struct ASTFingerprint;
 
 class CppReparser
 {
 public:
+  /**
+   * @param datadir_ The data directory of the project. The version of the
+   * workspace is read from there.
+   * @param diskCache_ If not nullptr, the built ASTs are also stored on disk
+   * and the ones not in astCache_ are loaded from there if they are still up
+   * to date.
+   */
   CppReparser(
     std::shared_ptr<odb::database> db_,
-    std::shared_ptr<ASTCache> astCache_);
+    const std::string& datadir_,
+    std::shared_ptr<ASTCache> astCache_,
+    std::shared_ptr<ASTDiskCache> diskCache_ = nullptr);
   CppReparser(const CppReparser&) = delete;
   CppReparser& operator=(const CppReparser&) = delete;
   ~CppReparser() = default;
@@ -52,7 +65,13 @@ public:
   getCompilationCommandForFile(const core::FileId& fileId_);
 
   /**
-   * Returns the ASTUnit instance for the given source file
+   * Returns the ASTUnit instance for the given source file. The AST is taken
+   * from the memory or the disk cache if the build command and the contents of
+   * the files of the translation unit are unchanged. The fingerprint of an AST
+   * in memory is only checked once per version of the workspace, so repeated
+   * requests don't query the database. An outdated AST in memory
+   * is reparsed, reusing its precompiled preamble if the headers at the
+   * beginning of the main file have not changed.
    * @param fileId_ The file ID of the file to build the AST for.
    * @return An ASTUnit pointer, on which ASTConsumers can be executed. If an
    * error happened and the AST could not be obtained, a string explaining the
@@ -64,9 +83,33 @@ public:
 private:
   std::shared_ptr<odb::database> _db;
   util::OdbTransaction _transaction;
+  const std::string _datadir;
   std::shared_ptr<ASTCache> _astCache;
+  std::shared_ptr<ASTDiskCache> _diskCache;
 
   std::string getFilenameForId(const core::FileId& fileId_);
+
+  /**
+   * Returns the build command of the given source file, or an empty string if
+   * the file isn't a source file of any build action.
+   */
+  std::string getBuildCommandForFile(const core::FileId& fileId_);
+
+  /**
+   * Computes the current fingerprint of a translation unit from the database.
+   * @param paths_ The files of the translation unit.
+   */
+  ASTFingerprint getFingerprint(
+    const std::string& buildCommand_,
+    const std::vector<std::string>& paths_);
+
+  /**
+   * Computes the fingerprint of a translation unit for the files used by the
+   * given AST.
+   */
+  ASTFingerprint getFingerprint(
+    const std::string& buildCommand_,
+    clang::ASTUnit& AST_);
 };
 
 } // namespace reparse
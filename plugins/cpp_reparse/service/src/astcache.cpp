@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <tuple>
 
 #include <clang/Frontend/ASTUnit.h>
 
@@ -21,19 +22,31 @@ ASTCache::ASTCache(size_t maxCacheSize_)
   : _maxCacheSize(maxCacheSize_)
 {}
 
-std::shared_ptr<clang::ASTUnit> ASTCache::getAST(const core::FileId& id_)
+std::shared_ptr<clang::ASTUnit> ASTCache::getAST(
+  const core::FileId& id_,
+  ASTFingerprint* fingerprint_)
 {
   std::lock_guard<std::mutex> lock(_lock);
   auto it = _cache.find(id_);
   if (it == _cache.end())
     return nullptr;
 
+  if (fingerprint_)
+    *fingerprint_ = it->second.fingerprint();
+
   return it->second.getAST();
 }
 
+bool ASTCache::isCached(const core::FileId& id_)
+{
+  std::lock_guard<std::mutex> lock(_lock);
+  return _cache.find(id_) != _cache.end();
+}
+
 std::shared_ptr<ASTUnit> ASTCache::storeAST(
   const core::FileId& id_,
-  std::unique_ptr<ASTUnit> AST_)
+  std::shared_ptr<ASTUnit> AST_,
+  ASTFingerprint fingerprint_)
 {
   if (_cache.size() >= _maxCacheSize)
     pruneEntries();
@@ -45,10 +58,35 @@ std::shared_ptr<ASTUnit> ASTCache::storeAST(
     // This cannot be done pre-C++17 without clearing the element first.
     _cache.erase(it);
 
-  auto result = _cache.emplace(id_, std::move(AST_));
+  auto result = _cache.emplace(std::piecewise_construct,
+    std::forward_as_tuple(id_),
+    std::forward_as_tuple(std::move(AST_), std::move(fingerprint_)));
   return result.first->second.getAST();
 }
 
+std::shared_ptr<ASTUnit> ASTCache::takeAST(const core::FileId& id_)
+{
+  std::lock_guard<std::mutex> lock(_lock);
+  auto it = _cache.find(id_);
+  if (it == _cache.end())
+    return nullptr;
+
+  std::shared_ptr<ASTUnit> AST = it->second.getAST();
+  _cache.erase(it);
+
+  return AST;
+}
+
+void ASTCache::setWorkspaceVersion(
+  const core::FileId& id_,
+  const std::string& version_)
+{
+  std::lock_guard<std::mutex> lock(_lock);
+  auto it = _cache.find(id_);
+  if (it != _cache.end())
+    it->second.setWorkspaceVersion(version_);
+}
+
 void ASTCache::pruneEntries()
 {
   std::lock_guard<std::mutex> lock(_lock);
@@ -67,8 +105,11 @@ void ASTCache::pruneEntries()
   }
 }
 
-ASTCache::ASTCacheEntry::ASTCacheEntry(std::unique_ptr<clang::ASTUnit> AST_)
+ASTCache::ASTCacheEntry::ASTCacheEntry(
+  std::shared_ptr<clang::ASTUnit> AST_,
+  ASTFingerprint fingerprint_)
   : _AST(std::move(AST_)),
+    _fingerprint(std::move(fingerprint_)),
     _hitCount(0),
     _lastHit(std::chrono::steady_clock::now())
 {}
@@ -80,6 +121,16 @@ std::shared_ptr<ASTUnit> ASTCache::ASTCacheEntry::getAST()
   return _AST;
 }
 
+const ASTFingerprint& ASTCache::ASTCacheEntry::fingerprint() const
+{
+  return _fingerprint;
+}
+
+void ASTCache::ASTCacheEntry::setWorkspaceVersion(const std::string& version_)
+{
+  _fingerprint.workspaceVersion = version_;
+}
+
 size_t ASTCache::ASTCacheEntry::hitCount() const
 {
   return _hitCount;
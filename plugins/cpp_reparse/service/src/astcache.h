@@ -2,9 +2,11 @@
 #define CC_SERVICE_CPPREPARSESERVICE_ASTCACHE_H
 
 #include <chrono>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <string>
 
 // Required for the Thrift objects, such as core::FileId.
 #include "cppreparse_types.h"
@@ -23,6 +25,44 @@ namespace service
 namespace reparse
 {
 
+/**
+ * Identifies the inputs an AST was built from: the build command and the
+ * contents of every file of the translation unit. An AST can be reused as long
+ * as its fingerprint matches the one computed from the current database.
+ */
+struct ASTFingerprint
+{
+  /**
+   * The hash of the build command of the translation unit.
+   */
+  std::uint64_t commandHash = 0;
+
+  /**
+   * The content hashes of the files of the translation unit (including the
+   * main file) by path. Files which are not in the database are omitted.
+   */
+  std::map<std::string, std::string> contentHashes;
+
+  /**
+   * The version of the workspace in which the fingerprint was last found to
+   * match the database (see CppReparser). The database only changes when the
+   * workspace is parsed again, so until then the fingerprint doesn't have to
+   * be computed again. It is not part of the comparison.
+   */
+  std::string workspaceVersion;
+
+  bool operator==(const ASTFingerprint& other_) const
+  {
+    return commandHash == other_.commandHash &&
+      contentHashes == other_.contentHashes;
+  }
+
+  bool operator!=(const ASTFingerprint& other_) const
+  {
+    return !(*this == other_);
+  }
+};
+
 /**
  * Implements a caching mechanism over Clang ASTs to ease the runtime overhead
  * of having to parse source files over and over again, as it is a *very*
@@ -49,24 +89,52 @@ public:
   /**
    * Retrieves the AST stored for the given file ID, or a nullptr if none is
    * stored.
+   * @param fingerprint_ If given, the fingerprint of the AST is copied here.
+   */
+  std::shared_ptr<clang::ASTUnit> getAST(
+    const core::FileId& id_,
+    ASTFingerprint* fingerprint_ = nullptr);
+
+  /**
+   * Returns whether an AST is stored for the given file ID. Unlike getAST(),
+   * this doesn't count as a hit.
    */
-  std::shared_ptr<clang::ASTUnit> getAST(const core::FileId& id_);
+  bool isCached(const core::FileId& id_);
 
   /**
    * Store the AST for the given file in the cache. The AST Cache takes
-   * ownership over the ASTUnit. The method returns the shared pointer that
-   * wraps the ASTUnit argument given.
+   * (shared) ownership over the ASTUnit. The method returns the shared pointer
+   * that wraps the ASTUnit argument given.
    */
   std::shared_ptr<clang::ASTUnit> storeAST(
     const core::FileId& id_,
-    std::unique_ptr<clang::ASTUnit> AST_);
+    std::shared_ptr<clang::ASTUnit> AST_,
+    ASTFingerprint fingerprint_ = ASTFingerprint());
+
+  /**
+   * Removes the AST of the given file from the cache and returns it, or
+   * returns nullptr if none is stored. After this, nobody else can obtain the
+   * AST from the cache, so if the caller holds the only reference, it may
+   * modify the AST (e.g. reparse it).
+   */
+  std::shared_ptr<clang::ASTUnit> takeAST(const core::FileId& id_);
+
+  /**
+   * Records that the stored AST of the given file was found up to date in the
+   * given version of the workspace. See ASTFingerprint::workspaceVersion.
+   */
+  void setWorkspaceVersion(
+    const core::FileId& id_,
+    const std::string& version_);
 
 private:
 
   class ASTCacheEntry
   {
   public:
-    ASTCacheEntry(std::unique_ptr<clang::ASTUnit> AST_);
+    ASTCacheEntry(
+      std::shared_ptr<clang::ASTUnit> AST_,
+      ASTFingerprint fingerprint_);
     ASTCacheEntry(const ASTCacheEntry&) = delete;
     ASTCacheEntry(ASTCacheEntry&&) = default;
     ~ASTCacheEntry() = default;
@@ -75,6 +143,9 @@ private:
 
     std::shared_ptr<clang::ASTUnit> getAST();
 
+    const ASTFingerprint& fingerprint() const;
+    void setWorkspaceVersion(const std::string& version_);
+
     size_t hitCount() const;
     std::chrono::steady_clock::time_point lastHit() const;
 
@@ -88,6 +159,8 @@ private:
   private:
     std::shared_ptr<clang::ASTUnit> _AST;
 
+    ASTFingerprint _fingerprint;
+
     /**
      * The number of times the AST has been retrieved.
      */
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include <clang/Basic/FileSystemOptions.h>
+#include <clang/Frontend/ASTUnit.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+
+#include <util/logutil.h>
+
+#include "astdiskcache.h"
+
+namespace fs = boost::filesystem;
+
+namespace cc
+{
+
+namespace service
+{
+
+namespace reparse
+{
+
+using namespace clang;
+
+ASTDiskCache::ASTDiskCache(
+  const std::string& directory_,
+  std::uint64_t sizeLimit_)
+  : _directory(directory_),
+    _sizeLimit(sizeLimit_),
+    _size(0)
+{
+  boost::system::error_code ec;
+  fs::create_directories(_directory, ec);
+
+  if (ec)
+  {
+    LOG(warning) << "Couldn't create AST cache directory " << _directory
+                 << ": " << ec.message();
+    return;
+  }
+
+  for (fs::directory_iterator it(_directory, ec), end; !ec && it != end;
+       it.increment(ec))
+  {
+    const fs::path& path = it->path();
+    if (path.extension() != ".ast")
+      continue;
+
+    StoredAST stored;
+    stored.size = fs::file_size(path, ec);
+    stored.lastUse = fs::last_write_time(path, ec);
+    if (ec)
+    {
+      ec.clear();
+      continue;
+    }
+
+    _stored[path.stem().string()] = stored;
+    _size += stored.size;
+  }
+}
+
+bool ASTDiskCache::getFingerprint(
+  const core::FileId& id_,
+  ASTFingerprint& fingerprint_)
+{
+  std::ifstream file(fingerprintPath(id_));
+  if (!(file >> fingerprint_.commandHash))
+    return false;
+
+  fingerprint_.contentHashes.clear();
+
+  std::string hash, path;
+  while (file >> hash && file.get() == ' ' && std::getline(file, path))
+    fingerprint_.contentHashes[path] = hash;
+
+  return !fingerprint_.contentHashes.empty();
+}
+
+std::unique_ptr<ASTUnit> ASTDiskCache::loadAST(const core::FileId& id_)
+{
+  // The reader of the AST keeps a reference to this object until the AST is
+  // destroyed, which may happen during the destruction of static objects.
+  static const PCHContainerOperations* operations =
+    new PCHContainerOperations();
+
+  IntrusiveRefCntPtr<DiagnosticsEngine> diags =
+    CompilerInstance::createDiagnostics(new DiagnosticOptions());
+
+  std::unique_ptr<ASTUnit> AST = ASTUnit::LoadFromASTFile(
+    astPath(id_), operations->getRawReader(), ASTUnit::LoadEverything, diags,
+    FileSystemOptions());
+
+  if (!AST)
+  {
+    LOG(debug) << "Failed to load the stored AST of file #" << id_;
+    return AST;
+  }
+
+  std::lock_guard<std::mutex> lock(_lock);
+
+  auto it = _stored.find(id_);
+  if (it != _stored.end())
+  {
+    boost::system::error_code ec;
+    it->second.lastUse = std::time(nullptr);
+    fs::last_write_time(astPath(id_), it->second.lastUse, ec);
+  }
+
+  return AST;
+}
+
+void ASTDiskCache::storeAST(
+  const core::FileId& id_,
+  ASTUnit& AST_,
+  const ASTFingerprint& fingerprint_)
+{
+  // Save() writes into a temporary file and renames it, so a concurrent
+  // loadAST() never sees a half written AST.
+  if (AST_.Save(astPath(id_)))
+  {
+    LOG(warning) << "Failed to store the AST of file #" << id_;
+    return;
+  }
+
+  const std::string path = fingerprintPath(id_);
+
+  // The same AST may be stored by more threads at once.
+  const std::string tmpPath
+    = fs::unique_path(path + ".%%%%-%%%%-%%%%.tmp").string();
+
+  {
+    std::ofstream file(tmpPath, std::ios::trunc);
+    file << fingerprint_.commandHash << '\n';
+
+    for (const auto& content : fingerprint_.contentHashes)
+      file << content.second << ' ' << content.first << '\n';
+
+    if (!file)
+    {
+      LOG(warning) << "Failed to store the AST fingerprint of file #" << id_;
+      std::remove(tmpPath.c_str());
+      return;
+    }
+  }
+
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+  {
+    std::remove(tmpPath.c_str());
+    return;
+  }
+
+  boost::system::error_code ec;
+  StoredAST stored;
+  stored.size = fs::file_size(astPath(id_), ec);
+  stored.lastUse = std::time(nullptr);
+  if (ec)
+    return;
+
+  std::lock_guard<std::mutex> lock(_lock);
+
+  auto it = _stored.find(id_);
+  if (it != _stored.end())
+    _size -= it->second.size;
+
+  _stored[id_] = stored;
+  _size += stored.size;
+
+  pruneEntries(id_);
+}
+
+void ASTDiskCache::removeAST(const core::FileId& id_)
+{
+  boost::system::error_code ec;
+  fs::remove(fingerprintPath(id_), ec);
+  fs::remove(astPath(id_), ec);
+
+  std::lock_guard<std::mutex> lock(_lock);
+
+  auto it = _stored.find(id_);
+  if (it != _stored.end())
+  {
+    _size -= it->second.size;
+    _stored.erase(it);
+  }
+}
+
+void ASTDiskCache::pruneEntries(const core::FileId& keep_)
+{
+  while (_sizeLimit && _size > _sizeLimit && _stored.size() > 1)
+  {
+    auto elemToRemove = std::min_element(
+      _stored.begin(), _stored.end(),
+      [&keep_](const auto& lhs, const auto& rhs)
+      {
+        // The kept AST is never the least recently used one.
+        if (lhs.first == keep_ || rhs.first == keep_)
+          return rhs.first == keep_ && lhs.first != keep_;
+        return lhs.second.lastUse < rhs.second.lastUse;
+      });
+
+    LOG(debug) << "Removing the stored AST of file #" << elemToRemove->first
+               << " to keep the AST cache within its size limit.";
+
+    boost::system::error_code ec;
+    fs::remove(fingerprintPath(elemToRemove->first), ec);
+    fs::remove(astPath(elemToRemove->first), ec);
+
+    _size -= elemToRemove->second.size;
+    _stored.erase(elemToRemove);
+  }
+}
+
+std::string ASTDiskCache::astPath(const core::FileId& id_) const
+{
+  return _directory + '/' + id_ + ".ast";
+}
+
+std::string ASTDiskCache::fingerprintPath(const core::FileId& id_) const
+{
+  return _directory + '/' + id_ + ".fingerprint";
+}
+
+} // namespace reparse
+} // namespace service
+} // namespace cc
@@ -0,0 +1,112 @@
+#ifndef CC_SERVICE_CPPREPARSESERVICE_ASTDISKCACHE_H
+#define CC_SERVICE_CPPREPARSESERVICE_ASTDISKCACHE_H
+
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "astcache.h"
+
+namespace clang
+{
+class ASTUnit;
+} // namespace clang
+
+namespace cc
+{
+
+namespace service
+{
+
+namespace reparse
+{
+
+/**
+ * Stores serialized ASTs in a directory, so they survive the restarts of the
+ * server. Loading a serialized AST is much faster than parsing the source
+ * files again.
+ *
+ * Every AST is stored with its fingerprint. The caller is responsible for
+ * checking that the fingerprint still matches the database before loading the
+ * AST itself.
+ *
+ * The total size of the stored ASTs is limited. When a new AST would exceed
+ * the limit, the least recently used ones are removed.
+ */
+class ASTDiskCache
+{
+public:
+  /**
+   * @param directory_ The directory of the cache. It is created if it doesn't
+   * exist.
+   * @param sizeLimit_ The maximum total size of the stored ASTs in bytes, or
+   * 0 if the size is not limited.
+   */
+  ASTDiskCache(const std::string& directory_, std::uint64_t sizeLimit_ = 0);
+
+  ASTDiskCache(const ASTDiskCache&) = delete;
+  ASTDiskCache& operator=(const ASTDiskCache&) = delete;
+  ~ASTDiskCache() = default;
+
+  /**
+   * Reads the fingerprint of the stored AST of the given file.
+   * @return False if no AST is stored for the file.
+   */
+  bool getFingerprint(const core::FileId& id_, ASTFingerprint& fingerprint_);
+
+  /**
+   * Loads the stored AST of the given file, or returns nullptr if it can't be
+   * loaded.
+   */
+  std::unique_ptr<clang::ASTUnit> loadAST(const core::FileId& id_);
+
+  /**
+   * Serializes the AST of the given file along with its fingerprint.
+   */
+  void storeAST(
+    const core::FileId& id_,
+    clang::ASTUnit& AST_,
+    const ASTFingerprint& fingerprint_);
+
+  /**
+   * Removes the stored AST of the given file, e.g. because it is outdated.
+   */
+  void removeAST(const core::FileId& id_);
+
+private:
+  struct StoredAST
+  {
+    std::uint64_t size;
+
+    /**
+     * The last time the AST was stored or loaded. It is kept as the
+     * modification time of the file, so it survives the restarts.
+     */
+    std::time_t lastUse;
+  };
+
+  std::string astPath(const core::FileId& id_) const;
+  std::string fingerprintPath(const core::FileId& id_) const;
+
+  /**
+   * Removes the least recently used ASTs, except for the given one, until the
+   * total size is within the limit. _lock has to be held.
+   */
+  void pruneEntries(const core::FileId& keep_);
+
+  const std::string _directory;
+  const std::uint64_t _sizeLimit;
+
+  std::mutex _lock;
+  std::map<core::FileId, StoredAST> _stored;
+  std::uint64_t _size;
+};
+
+} // namespace reparse
+} // namespace service
+} // namespace cc
+
+#endif // CC_SERVICE_CPPREPARSESERVICE_ASTDISKCACHE_H
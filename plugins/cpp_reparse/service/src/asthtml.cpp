@@ -3,7 +3,6 @@
 
 #include <clang/AST/ASTConsumer.h>
 #include <clang/AST/RecursiveASTVisitor.h>
-#include <clang/Frontend/ASTConsumers.h>
 
 #include <model/cppastnode-odb.hxx>
 
@@ -204,6 +203,30 @@ private:
   cc::service::reparse::ASTNodeLocator _locator;
 };
 
+/**
+ * Prints the top-level declarations of the main file. Unlike Clang's AST
+ * dumper, the declarations of the included files are filtered out before
+ * printing, so they cost nothing.
+ */
+class MainFileHTMLPrinter : public ASTConsumer
+{
+public:
+  MainFileHTMLPrinter(std::unique_ptr<raw_ostream> out_)
+    : _out(std::move(out_))
+  {}
+
+  void HandleTranslationUnit(ASTContext& context_) override
+  {
+    cc::service::reparse::ASTTreeNavigator navigator(context_);
+
+    for (const auto& node : navigator.roots())
+      node.decl->dump(*_out, /* Deserialize = */ false);
+  }
+
+private:
+  std::unique_ptr<raw_ostream> _out;
+};
+
 } // namespace (anonymous)
 
 
@@ -220,7 +243,7 @@ std::unique_ptr<clang::ASTConsumer> ASTHTMLActionFactory::newASTConsumer()
 {
   assert(_stream && "Must not call newASTConsumer twice as the underlying "
     "stream has been moved out.");
-  return clang::CreateASTDumper(std::move(_stream), "", true, true, false);
+  return std::make_unique<MainFileHTMLPrinter>(std::move(_stream));
 }
 
 std::unique_ptr<clang::ASTConsumer>
@@ -233,6 +256,22 @@ ASTHTMLActionFactory::newASTConsumerForNode(clang::ASTContext& context_,
                                                  context_, astNode_);
 }
 
+void ASTHTMLActionFactory::dumpNode(
+  clang::ASTContext& context_,
+  const reparse::ASTTreeNavigator::Node& node_)
+{
+  assert(_stream && "Must not call dumpNode twice as the underlying stream "
+    "has been moved out.");
+
+  // The output is formatted into _out when the stream is destroyed.
+  std::unique_ptr<raw_ostream> out = std::move(_stream);
+
+  if (node_.decl)
+    node_.decl->dump(*out, /* Deserialize = */ false);
+  else
+    node_.stmt->dump(*out, context_.getSourceManager());
+}
+
 std::string ASTHTMLActionFactory::str() const
 {
   return _out.str();
@@ -248,6 +287,10 @@ ColouredHTMLOutputStream::~ColouredHTMLOutputStream()
     _string << ptr->getFormatted();
     delete ptr;
   }
+
+  if (_truncated)
+    _string << "<br />\n<i>The output was truncated at " << _sizeLimit
+            << " bytes.</i>";
 }
 
 void ColouredHTMLOutputStream::flushToParts()
@@ -258,6 +301,14 @@ void ColouredHTMLOutputStream::flushToParts()
 
 void ColouredHTMLOutputStream::write_impl(const char* ptr_, size_t size_)
 {
+  if (_sizeLimit && _bufferSize + size_ > _sizeLimit)
+  {
+    _truncated = true;
+    size_ = _sizeLimit - _bufferSize;
+    if (!size_)
+      return;
+  }
+
   if (_lastPartAppendable)
     _parts.back()->append(ptr_, size_);
   else
@@ -279,6 +330,10 @@ ColouredHTMLOutputStream& ColouredHTMLOutputStream::changeColor(
   // Finish writing everything that was in the buffer originally.
   flushToParts();
 
+  // The text after the limit is dropped, so is its colouring.
+  if (_truncated)
+    return *this;
+
   UnformattedString* colourTag = new ColourTag(colour_);
   _parts.push_back(colourTag);
 
@@ -290,6 +345,10 @@ ColouredHTMLOutputStream& ColouredHTMLOutputStream::resetColor()
   // Finish writing everything that was in the buffer originally.
   flushToParts();
 
+  // The text after the limit is dropped, so is its colouring.
+  if (_truncated)
+    return *this;
+
   UnformattedString* colourTag = new ColourTag();
   _parts.push_back(colourTag);
 
@@ -10,6 +10,8 @@
 
 #include <model/cppastnode.h>
 
+#include "asttree.h"
+
 namespace cc
 {
 
@@ -51,15 +53,21 @@ protected:
 /**
  * Provides an llvm::raw_ostream implementation that can format colourful
  * sentences into HTML colours.
+ *
+ * If a size limit is given, the text written beyond the limit is dropped
+ * instead of being buffered, and a notice about the truncation is appended to
+ * the output.
  */
 class ColouredHTMLOutputStream : public llvm::raw_ostream
 {
 public:
-  ColouredHTMLOutputStream(std::ostringstream& os_)
+  ColouredHTMLOutputStream(std::ostringstream& os_, size_t sizeLimit_ = 0)
     : raw_ostream(false),
       _string(os_),
       _lastPartAppendable(false),
-      _bufferSize(0)
+      _bufferSize(0),
+      _sizeLimit(sizeLimit_),
+      _truncated(false)
   {}
 
   ~ColouredHTMLOutputStream() override;
@@ -92,6 +100,17 @@ private:
 
   size_t _bufferSize;
 
+  /**
+   * The maximum number of bytes (before formatting) kept from the written
+   * text, or 0 if there is no limit.
+   */
+  size_t _sizeLimit;
+
+  /**
+   * Indicates if some text was dropped because of the size limit.
+   */
+  bool _truncated;
+
   /**
    * Calls flush() on the inherited buffer and handles keeping the state of
    * the current class' members.
@@ -121,10 +140,19 @@ private:
 class ASTHTMLActionFactory
 {
 public:
-  ASTHTMLActionFactory()
-    : _stream(std::make_unique<ColouredHTMLOutputStream>(_out))
+  /**
+   * @param sizeLimit_ The maximum size of the output before formatting, or 0
+   * if the output is not limited.
+   */
+  ASTHTMLActionFactory(size_t sizeLimit_ = 0)
+    : _stream(std::make_unique<ColouredHTMLOutputStream>(_out, sizeLimit_))
   {}
 
+  /**
+   * Creates a new AST Consumer which emits the top-level declarations of the
+   * main file into a formatted HTML string. The declarations of the included
+   * files are skipped without being dumped.
+   */
   std::unique_ptr<clang::ASTConsumer> newASTConsumer();
 
   /**
@@ -135,6 +163,14 @@ public:
     clang::ASTContext& context_,
     model::CppAstNodePtr astNode_);
 
+  /**
+   * Emits the subtree of the given node of the in-memory AST into a formatted
+   * HTML string.
+   */
+  void dumpNode(
+    clang::ASTContext& context_,
+    const reparse::ASTTreeNavigator::Node& node_);
+
   /**
    * Retrieve the HTML string that was populated by the ASTConsumer created by
    * this factory.
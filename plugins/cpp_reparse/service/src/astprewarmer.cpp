@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <boost/variant.hpp>
+
+#include <clang/Frontend/ASTUnit.h>
+
+#include <util/logutil.h>
+#include <util/sysinfo.h>
+
+#include <service/reparser.h>
+
+#include "astcache.h"
+#include "astprewarmer.h"
+
+namespace
+{
+
+/**
+ * The age after which an access counts half as much in the popularity of a
+ * file.
+ */
+const double accessHalfLife = 7 * 24 * 60 * 60;
+
+/**
+ * The maximum number of files waiting to be prewarmed. If more files are
+ * scheduled, the least recently scheduled ones are dropped.
+ */
+const std::size_t maxQueueSize = 64;
+
+} // namespace (anonymous)
+
+namespace cc
+{
+
+namespace service
+{
+
+namespace reparse
+{
+
+ASTPrewarmer::ASTPrewarmer(
+  CppReparser& reparser_,
+  std::shared_ptr<ASTCache> astCache_,
+  double cpuBudget_,
+  std::size_t minAvailableMemory_,
+  std::size_t popularCount_,
+  const std::string& statsFile_)
+  : _reparser(reparser_),
+    _astCache(std::move(astCache_)),
+    _cpuBudget(std::min(cpuBudget_, 1.0)),
+    _minAvailableMemory(minAvailableMemory_),
+    _statsFile(statsFile_),
+    _stop(false)
+{
+  loadStats();
+  _queue = popularFiles(popularCount_);
+
+  LOG(debug) << "Prewarming the ASTs of " << _queue.size()
+             << " popular translation units.";
+
+  _thread = std::thread(&ASTPrewarmer::work, this);
+}
+
+ASTPrewarmer::~ASTPrewarmer()
+{
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+    _stop = true;
+  }
+
+  _cond.notify_all();
+  _thread.join();
+
+  saveStats();
+}
+
+void ASTPrewarmer::recordAccess(const core::FileId& fileId_)
+{
+  std::lock_guard<std::mutex> lock(_lock);
+
+  AccessStats& stats = _stats[fileId_];
+  ++stats.count;
+  stats.lastAccess = now();
+}
+
+void ASTPrewarmer::prewarm(const core::FileId& fileId_)
+{
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+
+    auto it = std::find(_queue.begin(), _queue.end(), fileId_);
+    if (it != _queue.end())
+      _queue.erase(it);
+
+    _queue.push_front(fileId_);
+
+    if (_queue.size() > maxQueueSize)
+      _queue.pop_back();
+  }
+
+  _cond.notify_all();
+}
+
+void ASTPrewarmer::work()
+{
+  // The nice value of a thread can be set through its thread ID on Linux.
+  ::setpriority(PRIO_PROCESS, ::syscall(SYS_gettid), 19);
+
+  while (true)
+  {
+    core::FileId fileId;
+
+    {
+      std::unique_lock<std::mutex> lock(_lock);
+      _cond.wait(lock, [this]{ return _stop || !_queue.empty(); });
+
+      if (_stop)
+        return;
+
+      fileId = _queue.front();
+      _queue.pop_front();
+    }
+
+    if (underMemoryPressure())
+    {
+      std::lock_guard<std::mutex> lock(_lock);
+      LOG(debug) << "Low memory, cancelling the prewarming of "
+                 << _queue.size() + 1 << " ASTs.";
+      _queue.clear();
+      continue;
+    }
+
+    const double cpuTime = build(fileId);
+
+    // Sleep in proportion to the CPU time used to keep the average CPU usage
+    // of the thread within the budget.
+    std::unique_lock<std::mutex> lock(_lock);
+    _cond.wait_for(
+      lock,
+      std::chrono::duration<double>(cpuTime * (1 - _cpuBudget) / _cpuBudget),
+      [this]{ return _stop; });
+  }
+}
+
+double ASTPrewarmer::build(const core::FileId& fileId_)
+{
+  if (_astCache->isCached(fileId_))
+    return 0;
+
+  const double start = util::threadCpuTime();
+
+  auto result = _reparser.getASTForTranslationUnitFile(fileId_);
+  if (std::string* err = boost::get<std::string>(&result))
+    LOG(debug) << "Failed to prewarm the AST of file #" << fileId_ << ": "
+               << *err;
+  else if (underMemoryPressure())
+  {
+    // Clang can't be interrupted, so the result is thrown away instead.
+    _astCache->takeAST(fileId_);
+
+    std::lock_guard<std::mutex> lock(_lock);
+    LOG(debug) << "Low memory, cancelling the prewarming of "
+               << _queue.size() << " ASTs.";
+    _queue.clear();
+  }
+  else
+    LOG(debug) << "Prewarmed the AST of file #" << fileId_;
+
+  return util::threadCpuTime() - start;
+}
+
+bool ASTPrewarmer::underMemoryPressure() const
+{
+  return util::availableMemory() < _minAvailableMemory;
+}
+
+std::deque<core::FileId> ASTPrewarmer::popularFiles(std::size_t count_) const
+{
+  const std::int64_t current = now();
+
+  std::vector<std::pair<double, core::FileId>> scores;
+  scores.reserve(_stats.size());
+
+  for (const auto& stats : _stats)
+    scores.emplace_back(
+      stats.second.count * std::exp2(
+        -(current - stats.second.lastAccess) / accessHalfLife),
+      stats.first);
+
+  count_ = std::min(count_, scores.size());
+  std::partial_sort(
+    scores.begin(), scores.begin() + count_, scores.end(),
+    [](const auto& lhs_, const auto& rhs_) { return lhs_.first > rhs_.first; });
+
+  std::deque<core::FileId> files;
+  for (std::size_t i = 0; i < count_; ++i)
+    files.push_back(scores[i].second);
+
+  return files;
+}
+
+void ASTPrewarmer::loadStats()
+{
+  if (_statsFile.empty())
+    return;
+
+  std::ifstream file(_statsFile);
+  AccessStats stats;
+  core::FileId fileId;
+
+  while (file >> stats.count >> stats.lastAccess >> fileId)
+    _stats[fileId] = stats;
+}
+
+void ASTPrewarmer::saveStats() const
+{
+  if (_statsFile.empty())
+    return;
+
+  std::ofstream file(_statsFile, std::ios::trunc);
+
+  for (const auto& stats : _stats)
+    file << stats.second.count << ' ' << stats.second.lastAccess << ' '
+         << stats.first << '\n';
+
+  if (!file)
+    LOG(warning) << "Failed to save AST access statistics to " << _statsFile;
+}
+
+std::int64_t ASTPrewarmer::now()
+{
+  return std::chrono::duration_cast<std::chrono::seconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace reparse
+} // namespace service
+} // namespace cc
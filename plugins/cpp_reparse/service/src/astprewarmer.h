@@ -0,0 +1,139 @@
+#ifndef CC_SERVICE_CPPREPARSESERVICE_ASTPREWARMER_H
+#define CC_SERVICE_CPPREPARSESERVICE_ASTPREWARMER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Required for the Thrift objects, such as core::FileId.
+#include "cppreparse_types.h"
+
+namespace cc
+{
+
+namespace service
+{
+
+namespace reparse
+{
+
+class ASTCache;
+class CppReparser;
+
+/**
+ * Builds the ASTs which are likely to be requested soon on a low-priority
+ * background thread, so that the requests don't have to wait for Clang.
+ *
+ * The prewarmer keeps access statistics per file. At start it prewarms the
+ * most popular translation units, weighting old accesses less. The files
+ * opened by the users can be prewarmed explicitly (see prewarm()).
+ *
+ * The parsing is limited to a fraction of a CPU core: after each parse, the
+ * thread sleeps in proportion to the CPU time it used. If the available
+ * memory of the system drops below a limit, the pending work is cancelled and
+ * the AST just built is dropped from the cache.
+ */
+class ASTPrewarmer
+{
+public:
+  /**
+   * @param cpuBudget_ The fraction of a CPU core the prewarming may use.
+   * @param minAvailableMemory_ The amount of available memory in bytes below
+   * which no prewarming is done.
+   * @param popularCount_ The number of popular translation units to prewarm
+   * at start.
+   * @param statsFile_ The file in which the access statistics are kept between
+   * server runs. If empty, the statistics are not persisted.
+   */
+  ASTPrewarmer(
+    CppReparser& reparser_,
+    std::shared_ptr<ASTCache> astCache_,
+    double cpuBudget_,
+    std::size_t minAvailableMemory_,
+    std::size_t popularCount_,
+    const std::string& statsFile_);
+
+  ASTPrewarmer(const ASTPrewarmer&) = delete;
+  ASTPrewarmer& operator=(const ASTPrewarmer&) = delete;
+
+  /**
+   * Stops the background thread after the current parse and saves the access
+   * statistics.
+   */
+  ~ASTPrewarmer();
+
+  /**
+   * Records that the AST of the given file was requested.
+   */
+  void recordAccess(const core::FileId& fileId_);
+
+  /**
+   * Schedules the AST of the given file to be built before the other pending
+   * ones.
+   */
+  void prewarm(const core::FileId& fileId_);
+
+private:
+  struct AccessStats
+  {
+    std::size_t count = 0;
+
+    /**
+     * The time of the last access in seconds since the epoch.
+     */
+    std::int64_t lastAccess = 0;
+  };
+
+  /**
+   * Body of the background thread.
+   */
+  void work();
+
+  /**
+   * Builds the AST of the file unless it is already in the cache.
+   * @return The CPU time used by the thread in seconds.
+   */
+  double build(const core::FileId& fileId_);
+
+  /**
+   * Returns whether the available memory is below the limit.
+   */
+  bool underMemoryPressure() const;
+
+  /**
+   * Returns the files with the highest access scores. An access is worth less
+   * the older it is.
+   */
+  std::deque<core::FileId> popularFiles(std::size_t count_) const;
+
+  void loadStats();
+  void saveStats() const;
+
+  static std::int64_t now();
+
+  CppReparser& _reparser;
+  std::shared_ptr<ASTCache> _astCache;
+  const double _cpuBudget;
+  const std::size_t _minAvailableMemory;
+  const std::string _statsFile;
+
+  std::mutex _lock;
+  std::condition_variable _cond;
+  std::deque<core::FileId> _queue;
+  std::map<core::FileId, AccessStats> _stats;
+  bool _stop;
+
+  std::thread _thread;
+};
+
+} // namespace reparse
+} // namespace service
+} // namespace cc
+
+#endif // CC_SERVICE_CPPREPARSESERVICE_ASTPREWARMER_H
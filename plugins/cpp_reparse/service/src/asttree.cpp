@@ -0,0 +1,185 @@
+#include <sstream>
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclBase.h>
+#include <clang/AST/Expr.h>
+#include <clang/AST/Stmt.h>
+#include <clang/Basic/SourceManager.h>
+
+#include "asttree.h"
+
+namespace cc
+{
+
+namespace service
+{
+
+namespace reparse
+{
+
+using namespace clang;
+
+ASTTreeNavigator::ASTTreeNavigator(ASTContext& context_) : _context(context_)
+{
+}
+
+std::vector<ASTTreeNavigator::Node> ASTTreeNavigator::roots() const
+{
+  const SourceManager& srcMgr = _context.getSourceManager();
+  std::vector<Node> nodes;
+
+  for (Decl* decl : _context.getTranslationUnitDecl()->decls())
+  {
+    if (decl->isImplicit())
+      continue;
+
+    SourceLocation loc = srcMgr.getExpansionLoc(decl->getLocation());
+    if (loc.isInvalid() || !srcMgr.isInMainFile(loc))
+      continue;
+
+    Node node;
+    node.decl = decl;
+    nodes.push_back(node);
+  }
+
+  return nodes;
+}
+
+std::vector<ASTTreeNavigator::Node> ASTTreeNavigator::children(
+  const Node& node_) const
+{
+  std::vector<Node> nodes;
+
+  auto addDecl = [&nodes](Decl* decl_) {
+    if (decl_ && !decl_->isImplicit())
+    {
+      Node node;
+      node.decl = decl_;
+      nodes.push_back(node);
+    }
+  };
+
+  auto addStmt = [&nodes](Stmt* stmt_) {
+    if (stmt_)
+    {
+      Node node;
+      node.stmt = stmt_;
+      nodes.push_back(node);
+    }
+  };
+
+  if (Decl* decl = node_.decl)
+  {
+    if (DeclContext* dc = dyn_cast<DeclContext>(decl))
+      for (Decl* child : dc->decls())
+        addDecl(child);
+
+    if (FunctionDecl* fd = dyn_cast<FunctionDecl>(decl))
+    {
+      // The body of another redeclaration belongs to that one.
+      if (fd->doesThisDeclarationHaveABody())
+        addStmt(fd->getBody());
+    }
+    else if (VarDecl* vd = dyn_cast<VarDecl>(decl))
+      addStmt(vd->getInit());
+    else if (decl->hasBody())
+      addStmt(decl->getBody());
+  }
+  else if (DeclStmt* ds = dyn_cast_or_null<DeclStmt>(node_.stmt))
+  {
+    for (Decl* child : ds->decls())
+      addDecl(child);
+  }
+  else if (node_.stmt)
+  {
+    for (Stmt* child : node_.stmt->children())
+      addStmt(child);
+  }
+
+  return nodes;
+}
+
+bool ASTTreeNavigator::resolve(const std::string& handle_, Node& node_) const
+{
+  std::istringstream path(handle_);
+  std::string index;
+  bool first = true;
+
+  while (std::getline(path, index, '/'))
+  {
+    std::size_t i;
+
+    try
+    {
+      std::size_t length;
+      i = std::stoul(index, &length);
+      if (length != index.size())
+        return false;
+    }
+    catch (const std::exception&)
+    {
+      return false;
+    }
+
+    std::vector<Node> nodes = first ? roots() : children(node_);
+    if (i >= nodes.size())
+      return false;
+
+    node_ = nodes[i];
+    first = false;
+  }
+
+  return !first;
+}
+
+std::string ASTTreeNavigator::childHandle(
+  const std::string& parentHandle_,
+  std::size_t index_)
+{
+  return parentHandle_.empty()
+    ? std::to_string(index_)
+    : parentHandle_ + '/' + std::to_string(index_);
+}
+
+std::string ASTTreeNavigator::type(const Node& node_) const
+{
+  if (node_.decl)
+    return std::string(node_.decl->getDeclKindName()) + "Decl";
+
+  return node_.stmt->getStmtClassName();
+}
+
+std::string ASTTreeNavigator::label(const Node& node_) const
+{
+  const SourceManager& srcMgr = _context.getSourceManager();
+
+  std::string name;
+  SourceLocation loc;
+
+  if (node_.decl)
+  {
+    if (NamedDecl* nd = dyn_cast<NamedDecl>(node_.decl))
+      name = nd->getNameAsString();
+    loc = node_.decl->getLocation();
+  }
+  else
+  {
+    if (DeclRefExpr* dre = dyn_cast<DeclRefExpr>(node_.stmt))
+      name = dre->getNameInfo().getAsString();
+    else if (MemberExpr* me = dyn_cast<MemberExpr>(node_.stmt))
+      name = me->getMemberNameInfo().getAsString();
+    loc = node_.stmt->getLocStart();
+  }
+
+  PresumedLoc presumed = srcMgr.getPresumedLoc(srcMgr.getExpansionLoc(loc));
+  if (presumed.isInvalid())
+    return name;
+
+  std::string line = "line " + std::to_string(presumed.getLine());
+  return name.empty() ? line : name + " (" + line + ')';
+}
+
+} // namespace reparse
+} // namespace service
+} // namespace cc
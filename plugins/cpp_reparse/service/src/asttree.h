@@ -0,0 +1,90 @@
+#ifndef CC_SERVICE_CPPREPARSESERVICE_ASTTREE_H
+#define CC_SERVICE_CPPREPARSESERVICE_ASTTREE_H
+
+#include <string>
+#include <vector>
+
+namespace clang
+{
+class ASTContext;
+class Decl;
+class Stmt;
+} // namespace clang
+
+namespace cc
+{
+
+namespace service
+{
+
+namespace reparse
+{
+
+/**
+ * Navigates the syntax tree of a translation unit one level at a time, so the
+ * client can expand the subtrees on demand instead of receiving the whole
+ * tree.
+ *
+ * The roots are the top-level declarations of the main file: declarations of
+ * included files are filtered out without visiting them. A node is identified
+ * by a handle, which is the path of child indices from the roots, e.g.
+ * "3/0/5". The handles are valid as long as the same AST is used, i.e. until
+ * the file is reparsed.
+ */
+class ASTTreeNavigator
+{
+public:
+  /**
+   * A node of the tree: either a declaration or a statement.
+   */
+  struct Node
+  {
+    clang::Decl* decl = nullptr;
+    clang::Stmt* stmt = nullptr;
+  };
+
+  ASTTreeNavigator(clang::ASTContext& context_);
+
+  /**
+   * Returns the top-level declarations of the main file.
+   */
+  std::vector<Node> roots() const;
+
+  /**
+   * Returns the children of the node.
+   */
+  std::vector<Node> children(const Node& node_) const;
+
+  /**
+   * Finds the node of the handle.
+   * @return False if the handle is invalid.
+   */
+  bool resolve(const std::string& handle_, Node& node_) const;
+
+  /**
+   * Returns the handle of the child of a node with the given handle. An empty
+   * parent handle means the roots.
+   */
+  static std::string childHandle(
+    const std::string& parentHandle_,
+    std::size_t index_);
+
+  /**
+   * Returns the type name of the node, e.g. FunctionDecl or CallExpr.
+   */
+  std::string type(const Node& node_) const;
+
+  /**
+   * Returns a short description of the node: its name (if any) and its line.
+   */
+  std::string label(const Node& node_) const;
+
+private:
+  clang::ASTContext& _context;
+};
+
+} // namespace reparse
+} // namespace service
+} // namespace cc
+
+#endif // CC_SERVICE_CPPREPARSESERVICE_ASTTREE_H
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
 
 #include <boost/optional.hpp>
 #include <boost/variant.hpp>
@@ -15,13 +17,52 @@
 #include <service/reparser.h>
 
 #include "astcache.h"
+#include "astdiskcache.h"
 #include "asthtml.h"
+#include "astprewarmer.h"
+#include "asttree.h"
 
 namespace
 {
 
 typedef odb::query<cc::model::CppAstNode> AstQuery;
 
+using cc::service::reparse::ASTTreeNavigator;
+
+/**
+ * Fills the page with the nodes in the range given by offset_ and limit_.
+ * @param parentHandle_ The handle of the parent of the nodes, or an empty
+ * string for the roots.
+ */
+void fillPage(
+  cc::service::language::ASTTreePage& page_,
+  const ASTTreeNavigator& navigator_,
+  const std::vector<ASTTreeNavigator::Node>& nodes_,
+  const std::string& parentHandle_,
+  std::int32_t offset_,
+  std::int32_t limit_)
+{
+  const std::size_t begin = std::min<std::size_t>(
+    std::max(offset_, 0), nodes_.size());
+  const std::size_t end = limit_ > 0
+    ? std::min<std::size_t>(begin + limit_, nodes_.size())
+    : nodes_.size();
+
+  page_.nodes.reserve(end - begin);
+
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    cc::service::language::ASTTreeNode node;
+    node.handle = ASTTreeNavigator::childHandle(parentHandle_, i);
+    node.type = navigator_.type(nodes_[i]);
+    node.label = navigator_.label(nodes_[i]);
+    node.hasChildren = !navigator_.children(nodes_[i]).empty();
+    page_.nodes.push_back(std::move(node));
+  }
+
+  page_.hasMore = end < nodes_.size();
+}
+
 } // namespace (anonymous)
 
 namespace cc
@@ -38,11 +79,12 @@ using namespace clang::tooling;
 
 CppReparseServiceHandler::CppReparseServiceHandler(
   std::shared_ptr<odb::database> db_,
-  std::shared_ptr<std::string> /* datadir_ */,
+  std::shared_ptr<std::string> datadir_,
   const cc::webserver::ServerContext& context_)
   : _db(db_),
     _transaction(db_),
-    _config(context_.options)
+    _config(context_.options),
+    _htmlLimit(_config["ast-html-limit"].as<size_t>())
 {
   if (isEnabled())
   {
@@ -56,13 +98,37 @@ CppReparseServiceHandler::CppReparseServiceHandler(
       maxCacheSize = jobs;
     }
 
+    std::shared_ptr<ASTDiskCache> diskCache;
+    if (!_config["disable-ast-disk-cache"].as<bool>())
+      diskCache = std::make_shared<ASTDiskCache>(
+        *datadir_ + "/cppreparse",
+        _config["ast-disk-cache-limit"].as<size_t>() * 1024 * 1024);
+
     _astCache = std::make_shared<ASTCache>(maxCacheSize);
-    _reparser = std::make_unique<CppReparser>(_db, _astCache);
+    _reparser = std::make_unique<CppReparser>(
+      _db, *datadir_, _astCache, diskCache);
+
+    double cpuBudget = _config["ast-prewarm-cpu"].as<double>();
+    if (cpuBudget > 0)
+      _prewarmer = std::make_unique<ASTPrewarmer>(
+        *_reparser, _astCache, cpuBudget,
+        _config["ast-prewarm-min-memory"].as<size_t>() * 1024 * 1024,
+        maxCacheSize / 2,
+        *datadir_ + "/cppreparse-access.txt");
   }
 }
 
 CppReparseServiceHandler::~CppReparseServiceHandler() = default;
 
+boost::variant<std::shared_ptr<ASTUnit>, std::string>
+CppReparseServiceHandler::getAST(const core::FileId& fileId_)
+{
+  if (_prewarmer)
+    _prewarmer->recordAccess(fileId_);
+
+  return _reparser->getASTForTranslationUnitFile(fileId_);
+}
+
 bool CppReparseServiceHandler::isEnabled()
 {
   return !_config["disable-cpp-reparse"].as<bool>();
@@ -78,7 +144,7 @@ void CppReparseServiceHandler::getAsHTML(
     return;
   }
 
-  auto result = _reparser->getASTForTranslationUnitFile(fileId_);
+  auto result = getAST(fileId_);
   if (std::string* err = boost::get<std::string>(&result))
   {
     return_ = "The AST could not be obtained. " + *err + " - The server log "
@@ -87,7 +153,7 @@ void CppReparseServiceHandler::getAsHTML(
   }
   std::shared_ptr<ASTUnit> AST = boost::get<std::shared_ptr<ASTUnit>>(result);
 
-  ASTHTMLActionFactory htmlFactory;
+  ASTHTMLActionFactory htmlFactory(_htmlLimit);
   htmlFactory.newASTConsumer()->HandleTranslationUnit(AST->getASTContext());
   return_ = htmlFactory.str();
 }
@@ -117,7 +183,7 @@ void CppReparseServiceHandler::getAsHTMLForNode(
   }
 
   core::FileId fileId_ = std::to_string(astNode->location.file.object_id());
-  auto result = _reparser->getASTForTranslationUnitFile(fileId_);
+  auto result = getAST(fileId_);
   if (std::string* err = boost::get<std::string>(&result))
   {
     return_ = "The AST could not be obtained. " + *err + " - The server log "
@@ -137,13 +203,112 @@ void CppReparseServiceHandler::getAsHTMLForNode(
              << astNode->location.range.end.line << ":"
              << astNode->location.range.end.column;
 
-  ASTHTMLActionFactory htmlFactory;
+  ASTHTMLActionFactory htmlFactory(_htmlLimit);
   ASTContext& context = AST->getASTContext();
   htmlFactory.newASTConsumerForNode(context, astNode)
     ->HandleTranslationUnit(context);
   return_ = htmlFactory.str();
 }
 
+void CppReparseServiceHandler::getASTRoots(
+  ASTTreePage& return_,
+  const core::FileId& fileId_,
+  const int32_t offset_,
+  const int32_t limit_)
+{
+  if (!isEnabled())
+    return;
+
+  auto result = getAST(fileId_);
+  if (std::string* err = boost::get<std::string>(&result))
+  {
+    LOG(warning) << "The AST of file #" << fileId_ << " could not be obtained. "
+                 << *err;
+    return;
+  }
+  std::shared_ptr<ASTUnit> AST = boost::get<std::shared_ptr<ASTUnit>>(result);
+
+  ASTTreeNavigator navigator(AST->getASTContext());
+  fillPage(return_, navigator, navigator.roots(), "", offset_, limit_);
+}
+
+void CppReparseServiceHandler::getASTChildren(
+  ASTTreePage& return_,
+  const core::FileId& fileId_,
+  const std::string& handle_,
+  const int32_t offset_,
+  const int32_t limit_)
+{
+  if (!isEnabled())
+    return;
+
+  auto result = getAST(fileId_);
+  if (std::string* err = boost::get<std::string>(&result))
+  {
+    LOG(warning) << "The AST of file #" << fileId_ << " could not be obtained. "
+                 << *err;
+    return;
+  }
+  std::shared_ptr<ASTUnit> AST = boost::get<std::shared_ptr<ASTUnit>>(result);
+
+  ASTTreeNavigator navigator(AST->getASTContext());
+  ASTTreeNavigator::Node node;
+  if (!navigator.resolve(handle_, node))
+  {
+    LOG(warning) << "Invalid AST handle '" << handle_ << "' for file #"
+                 << fileId_;
+    return;
+  }
+
+  fillPage(
+    return_, navigator, navigator.children(node), handle_, offset_, limit_);
+}
+
+void CppReparseServiceHandler::getASTNodeAsHTML(
+  std::string& return_,
+  const core::FileId& fileId_,
+  const std::string& handle_,
+  const int32_t maxSize_)
+{
+  if (!isEnabled())
+  {
+    return_ = "Reparse capabilities has been disabled at server start.";
+    return;
+  }
+
+  auto result = getAST(fileId_);
+  if (std::string* err = boost::get<std::string>(&result))
+  {
+    return_ = "The AST could not be obtained. " + *err + " - The server log "
+      "might contain more details.";
+    return;
+  }
+  std::shared_ptr<ASTUnit> AST = boost::get<std::shared_ptr<ASTUnit>>(result);
+
+  ASTContext& context = AST->getASTContext();
+  ASTTreeNavigator navigator(context);
+  ASTTreeNavigator::Node node;
+  if (!navigator.resolve(handle_, node))
+  {
+    return_ = "Invalid AST handle given, the file might have been reparsed.";
+    return;
+  }
+
+  size_t sizeLimit = _htmlLimit;
+  if (maxSize_ > 0 && (!sizeLimit || size_t(maxSize_) < sizeLimit))
+    sizeLimit = maxSize_;
+
+  ASTHTMLActionFactory htmlFactory(sizeLimit);
+  htmlFactory.dumpNode(context, node);
+  return_ = htmlFactory.str();
+}
+
+void CppReparseServiceHandler::prewarm(const core::FileId& fileId_)
+{
+  if (_prewarmer)
+    _prewarmer->prewarm(fileId_);
+}
+
 } // namespace language
 } // namespace service
 } // namespace cc
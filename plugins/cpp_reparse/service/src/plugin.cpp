@@ -2,6 +2,15 @@
 
 #include <service/cppreparseservice.h>
 
+namespace
+{
+
+const std::unordered_set<std::string> pureMethods{
+  "isEnabled", "getAsHTML", "getAsHTMLForNode", "getASTRoots",
+  "getASTChildren", "getASTNodeAsHTML"};
+
+} // namespace
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wreturn-type-c-linkage"
 extern "C"
@@ -23,6 +32,35 @@ extern "C"
        "The maximum number of reparsed syntax trees that should be cached in "
        "memory.");
 
+    description.add_options()
+      ("disable-ast-disk-cache", po::value<bool>()->default_value(false),
+       "Don't store the reparsed syntax trees in the workspace. The stored "
+       "trees can be loaded much faster than the source files can be parsed "
+       "after a server restart.");
+
+    description.add_options()
+      ("ast-disk-cache-limit", po::value<size_t>()->default_value(4096),
+       "The maximum total size of the syntax trees stored in the workspace in "
+       "MiB. The least recently used trees are removed above this size. 0 "
+       "means no limit.");
+
+    description.add_options()
+      ("ast-prewarm-cpu", po::value<double>()->default_value(0.5),
+       "The fraction of a CPU core used to build the syntax trees of the "
+       "popular and the recently opened files in the background. 0 turns off "
+       "the prewarming.");
+
+    description.add_options()
+      ("ast-prewarm-min-memory", po::value<size_t>()->default_value(2048),
+       "The prewarming of syntax trees stops if the available memory of the "
+       "system is less than this amount in MiB.");
+
+    description.add_options()
+      ("ast-html-limit",
+       po::value<size_t>()->default_value(8 * 1024 * 1024),
+       "The maximum size of the syntax tree dump returned by a single request "
+       "in bytes. Longer dumps are truncated. 0 means no limit.");
+
     return description;
   }
 
@@ -33,7 +71,7 @@ extern "C"
     cc::webserver::registerPluginSimple(
       context_,
       pluginHandler_,
-      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(CppReparse, language),
+      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(CppReparse, language, pureMethods),
       "CppReparseService");
   }
 }
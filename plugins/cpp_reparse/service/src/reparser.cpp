@@ -1,6 +1,10 @@
+#include <algorithm>
+
 #include <boost/algorithm/string.hpp>
 
+#include <clang/Basic/FileManager.h>
 #include <clang/Frontend/ASTUnit.h>
+#include <clang/Frontend/CompilerInstance.h>
 #include <clang/Tooling/CompilationDatabase.h>
 #include <clang/Tooling/Tooling.h>
 
@@ -9,11 +13,14 @@
 #include <model/file.h>
 #include <model/file-odb.hxx>
 
+#include <util/filesystem.h>
+#include <util/hash.h>
 #include <util/logutil.h>
 
 #include <service/reparser.h>
 
 #include "astcache.h"
+#include "astdiskcache.h"
 #include "databasefilesystem.h"
 
 namespace
@@ -23,6 +30,118 @@ typedef odb::query<cc::model::BuildSource> BuildSourceQuery;
 typedef odb::result<cc::model::BuildSource> BuildSourceResult;
 typedef odb::query<cc::model::File> FileQuery;
 
+/**
+ * The number of paths queried from the database at once when computing
+ * fingerprints.
+ */
+const std::size_t pathBatchSize = 512;
+
+/**
+ * Builds the ASTs like clang::tooling::buildASTs(), but with a precompiled
+ * preamble: the headers included at the beginning of the main file are
+ * compiled into a PCH, which is reused when the AST is reparsed, as long as
+ * those headers don't change.
+ */
+class PreambleASTBuilderAction : public clang::tooling::ToolAction
+{
+public:
+  PreambleASTBuilderAction(std::vector<std::unique_ptr<clang::ASTUnit>>& ASTs_)
+    : _ASTs(ASTs_)
+  {}
+
+  bool runInvocation(
+    std::shared_ptr<clang::CompilerInvocation> invocation_,
+    clang::FileManager* files_,
+    std::shared_ptr<clang::PCHContainerOperations> pchContainerOps_,
+    clang::DiagnosticConsumer* diagConsumer_) override
+  {
+    std::unique_ptr<clang::ASTUnit> AST =
+      clang::ASTUnit::LoadFromCompilerInvocation(
+        invocation_, std::move(pchContainerOps_),
+        clang::CompilerInstance::createDiagnostics(
+          &invocation_->getDiagnosticOpts(), diagConsumer_,
+          /* ShouldOwnClient = */ false),
+        files_,
+        /* OnlyLocalDecls = */ false,
+        /* CaptureDiagnostics = */ false,
+        /* PrecompilePreambleAfterNParses = */ 1);
+
+    if (!AST)
+      return false;
+
+    _ASTs.push_back(std::move(AST));
+    return true;
+  }
+
+private:
+  std::vector<std::unique_ptr<clang::ASTUnit>>& _ASTs;
+};
+
+/**
+ * Creates the compilation database for a build command, leaving out the
+ * options which would not work on a reparse.
+ */
+boost::variant<
+  std::unique_ptr<clang::tooling::FixedCompilationDatabase>, std::string>
+createCompilationDatabase(const std::string& buildCommand_)
+{
+  using namespace clang::tooling;
+
+  //--- Assemble compiler command line ---//
+
+  std::vector<const char*> commandLine;
+  std::vector<std::string> split;
+  boost::split(split, buildCommand_, boost::is_any_of(" "));
+
+  commandLine.reserve(split.size());
+  commandLine.push_back("--");
+
+  // The build command must be filtered so that certain options, such as
+  // dependency files that don't exist anymore as we are not doing an actual
+  // parse of the build directory, are omitted.
+  size_t numArgsToKeepSkipping = 0;
+  for (const auto& it : split)
+  {
+    if (numArgsToKeepSkipping > 0)
+    {
+      --numArgsToKeepSkipping;
+      continue;
+    }
+
+    if (it == "-MM" || it == "-MP" || it == "-MD" || it == "-MV"
+        || it == "-MMD")
+      // Make dependency options that take no arguments.
+      continue;
+    if (it == "-MT" || it == "-MQ" || it == "-MF" || it == "-MJ")
+    {
+      // Make dependency arguments that take an extra file argument.
+      // (These files won't be found by the Clang infrastructure at this
+      // point...)
+      numArgsToKeepSkipping = 1;
+      continue;
+    }
+
+    commandLine.push_back(it.c_str());
+  }
+
+  int argc = commandLine.size();
+
+  std::string compilationDbLoadError;
+  std::unique_ptr<FixedCompilationDatabase> compilationDb(
+    FixedCompilationDatabase::loadFromCommandLine(
+      argc,
+      commandLine.data(),
+      compilationDbLoadError));
+
+  if (!compilationDb)
+  {
+    return "Failed to create compilation database from build action: " +
+           compilationDbLoadError;
+  }
+
+  return std::move(compilationDb);
+}
+
 } // namespace (anonymous)
 
 namespace cc
@@ -38,10 +157,14 @@ using namespace clang::tooling;
 
 CppReparser::CppReparser(
   std::shared_ptr<odb::database> db_,
-  std::shared_ptr<ASTCache> astCache_)
+  const std::string& datadir_,
+  std::shared_ptr<ASTCache> astCache_,
+  std::shared_ptr<ASTDiskCache> diskCache_)
   : _db(db_),
     _transaction(db_),
-    _astCache(astCache_)
+    _datadir(datadir_),
+    _astCache(astCache_),
+    _diskCache(diskCache_)
 {}
 
 std::string CppReparser::getFilenameForId(const core::FileId& fileId_)
@@ -59,10 +182,7 @@ std::string CppReparser::getFilenameForId(const core::FileId& fileId_)
   return fileName;
 }
 
-boost::variant<
-  std::unique_ptr<clang::tooling::FixedCompilationDatabase>, std::string>
-CppReparser::getCompilationCommandForFile(
-  const core::FileId& fileId_)
+std::string CppReparser::getBuildCommandForFile(const core::FileId& fileId_)
 {
   std::string buildCommand;
 
@@ -83,110 +203,198 @@ CppReparser::getCompilationCommandForFile(
       }
   });
 
+  return buildCommand;
+}
+
+boost::variant<
+  std::unique_ptr<clang::tooling::FixedCompilationDatabase>, std::string>
+CppReparser::getCompilationCommandForFile(
+  const core::FileId& fileId_)
+{
+  std::string buildCommand = getBuildCommandForFile(fileId_);
+
   if (buildCommand.empty())
   {
     return "Build command not found for the file! Is this not a C++ file, "
       "or a header?";
   }
 
-  //--- Assemble compiler command line ---//
-
-  std::vector<const char*> commandLine;
-  std::vector<std::string> split;
-  boost::split(split, buildCommand, boost::is_any_of(" "));
+  return createCompilationDatabase(buildCommand);
+}
 
-  commandLine.reserve(split.size());
-  commandLine.push_back("--");
+ASTFingerprint CppReparser::getFingerprint(
+  const std::string& buildCommand_,
+  const std::vector<std::string>& paths_)
+{
+  ASTFingerprint fingerprint;
+  fingerprint.commandHash = util::fnvHash(buildCommand_);
 
-  // The build command must be filtered so that certain options, such as
-  // dependency files that don't exist anymore as we are not doing an actual
-  // parse of the build directory, are omitted.
-  size_t numArgsToKeepSkipping = 0;
-  for (const auto& it : split)
-  {
-    if (numArgsToKeepSkipping > 0)
+  _transaction([&, this](){
+    for (auto begin = paths_.begin(); begin != paths_.end();)
     {
-      --numArgsToKeepSkipping;
-      continue;
-    }
+      auto end = begin + std::min<std::size_t>(
+        pathBatchSize, std::distance(begin, paths_.end()));
 
-    if (it == "-MM" || it == "-MP" || it == "-MD" || it == "-MV"
-        || it == "-MMD")
-      // Make dependency options that take no arguments.
-      continue;
-    if (it == "-MT" || it == "-MQ" || it == "-MF" || it == "-MJ")
-    {
-      // Make dependency arguments that take an extra file argument.
-      // (These files won't be found by the Clang infrastructure at this
-      // point...)
-      numArgsToKeepSkipping = 1;
-      continue;
+      for (const model::File& file : _db->query<model::File>(
+             FileQuery::path.in_range(begin, end)))
+        if (file.content)
+          fingerprint.contentHashes[file.path] = file.content.object_id();
+
+      begin = end;
     }
+  });
 
-    commandLine.push_back(it.c_str());
-  }
+  return fingerprint;
+}
 
-  int argc = commandLine.size();
+ASTFingerprint CppReparser::getFingerprint(
+  const std::string& buildCommand_,
+  ASTUnit& AST_)
+{
+  // The file manager knows every file of the translation unit, including the
+  // ones which were read from the precompiled preamble.
+  llvm::SmallVector<const FileEntry*, 256> files;
+  AST_.getFileManager().GetUniqueIDMapping(files);
 
-  std::string compilationDbLoadError;
-  std::unique_ptr<FixedCompilationDatabase> compilationDb(
-    FixedCompilationDatabase::loadFromCommandLine(
-      argc,
-      commandLine.data(),
-      compilationDbLoadError));
+  std::vector<std::string> paths;
+  paths.reserve(files.size());
 
-  if (!compilationDb)
-  {
-    return "Failed to create compilation database from build action: " +
-           compilationDbLoadError;
-  }
+  for (const FileEntry* file : files)
+    if (file)
+      paths.push_back(file->getName());
 
-  return std::move(compilationDb);
+  return getFingerprint(buildCommand_, paths);
 }
 
 boost::variant<std::shared_ptr<clang::ASTUnit>, std::string>
 CppReparser::getASTForTranslationUnitFile(
   const core::FileId& fileId_)
 {
-  std::shared_ptr<ASTUnit> AST = _astCache->getAST(fileId_);
-  if (!AST)
+  const std::string version =
+    util::fileVersion(_datadir + "/project_info.json");
+
+  //--- Memory cache ---//
+
+  ASTFingerprint fingerprint;
+  std::shared_ptr<ASTUnit> AST = _astCache->getAST(fileId_, &fingerprint);
+
+  // The database only changes when the workspace is parsed again, so an AST
+  // which was up to date in this version still is.
+  if (AST && !version.empty() && fingerprint.workspaceVersion == version)
+    return AST;
+
+  const std::string buildCommand = getBuildCommandForFile(fileId_);
+  if (buildCommand.empty())
+  {
+    return "Failed to generate compilation command for file #" +
+      std::to_string(std::stoull(fileId_)) + ": Build command not found for "
+      "the file! Is this not a C++ file, or a header?";
+  }
+
+  auto isCurrent = [&, this](const ASTFingerprint& fingerprint_) {
+    std::vector<std::string> paths;
+    paths.reserve(fingerprint_.contentHashes.size());
+
+    for (const auto& content : fingerprint_.contentHashes)
+      paths.push_back(content.first);
+
+    return fingerprint_ == getFingerprint(buildCommand, paths);
+  };
+
+  if (AST && isCurrent(fingerprint))
+  {
+    _astCache->setWorkspaceVersion(fileId_, version);
+    return AST;
+  }
+
+  IntrusiveRefCntPtr<DatabaseFileSystem> dbfs(
+    new DatabaseFileSystem(_db));
+  IntrusiveRefCntPtr<vfs::OverlayFileSystem> overlayFs(
+    new vfs::OverlayFileSystem(vfs::getRealFileSystem()));
+  overlayFs->pushOverlay(dbfs);
+
+  if (AST)
   {
-    LOG(debug) << "Fetching AST for " << fileId_ << " from database...";
+    LOG(debug) << "AST of " << fileId_ << " is outdated, reparsing...";
 
-    auto compilation = getCompilationCommandForFile(fileId_);
-    if (std::string* err = boost::get<std::string>(&compilation))
+    // An AST can only be reparsed if nobody else uses it. Once it is taken out
+    // of the cache, nobody else can obtain it.
+    AST.reset();
+    AST = _astCache->takeAST(fileId_);
+
+    // Reparse() returns true on error, e.g. for the ASTs which were loaded
+    // from the disk and thus have no compiler invocation.
+    if (AST && (AST.use_count() > 1 || AST->Reparse(
+          std::make_shared<PCHContainerOperations>(), llvm::None, overlayFs)))
+      AST.reset();
+
+    if (AST)
     {
-      return "Failed to generate compilation command for file #" +
-        std::to_string(std::stoull(fileId_)) + ": " + *err;
-    }
+      fingerprint = getFingerprint(buildCommand, *AST);
+      fingerprint.workspaceVersion = version;
 
-    // TODO: FIXME: Change this into the shortcutting overlay creation once the interface is upstreamed. (https://reviews.llvm.org/D45094)
-    IntrusiveRefCntPtr<DatabaseFileSystem> dbfs(
-      new DatabaseFileSystem(_db));
-    IntrusiveRefCntPtr<vfs::OverlayFileSystem> overlayFs(
-      new vfs::OverlayFileSystem(vfs::getRealFileSystem()));
-    overlayFs->pushOverlay(dbfs);
+      if (_diskCache)
+        _diskCache->storeAST(fileId_, *AST, fingerprint);
 
-    auto compileDb = std::move(
-      boost::get<std::unique_ptr<clang::tooling::FixedCompilationDatabase>>(
-        compilation));
+      return _astCache->storeAST(fileId_, AST, std::move(fingerprint));
+    }
+  }
 
-    ClangTool tool(
-      *compileDb, getFilenameForId(fileId_),
-      std::make_shared<clang::PCHContainerOperations>(), overlayFs);
+  //--- Disk cache ---//
 
-    std::vector<std::unique_ptr<ASTUnit>> vect;
-    int error = tool.buildASTs(vect);
-    if (error)
+  if (_diskCache && _diskCache->getFingerprint(fileId_, fingerprint))
+  {
+    if (isCurrent(fingerprint))
     {
-      return "Execution of parsing the AST failed with error code " +
-        std::to_string(error);
+      LOG(debug) << "Loading AST for " << fileId_ << " from disk...";
+
+      fingerprint.workspaceVersion = version;
+
+      if (std::unique_ptr<ASTUnit> loaded = _diskCache->loadAST(fileId_))
+        return _astCache->storeAST(
+          fileId_, std::move(loaded), std::move(fingerprint));
     }
+    else
+      _diskCache->removeAST(fileId_);
+  }
+
+  //--- Parse ---//
 
-    AST = _astCache->storeAST(fileId_, std::move(vect.at(0)));
+  LOG(debug) << "Fetching AST for " << fileId_ << " from database...";
+
+  auto compilation = createCompilationDatabase(buildCommand);
+  if (std::string* err = boost::get<std::string>(&compilation))
+  {
+    return "Failed to generate compilation command for file #" +
+      std::to_string(std::stoull(fileId_)) + ": " + *err;
   }
 
-  return AST;
+  // TODO: FIXME: Change this into the shortcutting overlay creation once the interface is upstreamed. (https://reviews.llvm.org/D45094)
+  auto compileDb = std::move(
+    boost::get<std::unique_ptr<clang::tooling::FixedCompilationDatabase>>(
+      compilation));
+
+  ClangTool tool(
+    *compileDb, getFilenameForId(fileId_),
+    std::make_shared<clang::PCHContainerOperations>(), overlayFs);
+
+  std::vector<std::unique_ptr<ASTUnit>> vect;
+  PreambleASTBuilderAction action(vect);
+  int error = tool.run(&action);
+  if (error)
+  {
+    return "Execution of parsing the AST failed with error code " +
+      std::to_string(error);
+  }
+
+  fingerprint = getFingerprint(buildCommand, *vect.at(0));
+  fingerprint.workspaceVersion = version;
+
+  if (_diskCache)
+    _diskCache->storeAST(fileId_, *vect.at(0), fingerprint);
+
+  return _astCache->storeAST(
+    fileId_, std::move(vect.at(0)), std::move(fingerprint));
 }
 
 } // namespace reparse
@@ -17,6 +17,12 @@ function (on, topic, declare, Color, Deferred, dom, ContentPane, Tooltip,
                    CppReparseServiceClient);
 
   var ASTText = declare(ContentPane, {
+    /**
+     * The number of AST nodes fetched at once when a level of the syntax tree
+     * of a file is loaded.
+     */
+    pageSize : 100,
+
     constructor : function () {
       this._subscribeTopics();
     },
@@ -50,16 +56,103 @@ function (on, topic, declare, Color, Deferred, dom, ContentPane, Tooltip,
       var that = this;
       this.setLoading();
 
-      model.cppreparseservice.getAsHTML(
-        fileInfo.id,
-        function(astHtml) {
-          /* TODO: {Long-term} Allow the user to click on the SourceLocation in
-           * TODO: the AST which jumps back to the source code view,
-           * TODO: highlighting that area.
-           */
-          that.set('content', astHtml);
+      // The syntax tree of a file may be huge, so it is loaded level by level
+      // and page by page as the user expands its nodes.
+      var tree = dom.create('ul', { class : 'cppreparse-tree' });
+
+      this._loadPage(fileInfo.id, null, tree, 0, function (page) {
+        if (!page.nodes.length)
+          that.set('content', 'The syntax tree of the file is not available.');
+        else
+          that.set('content', tree);
+      });
+    },
+
+    /**
+     * Appends a page of the children of the given node to the list. The roots
+     * of the file are loaded if handle is null.
+     */
+    _loadPage : function (fileId, handle, list, offset, callback) {
+      var that = this;
+
+      function addPage(page) {
+        page.nodes.forEach(function (node) {
+          that._addNode(fileId, node, list);
+        });
+
+        if (page.hasMore) {
+          var more = dom.create('li', {
+            class     : 'cppreparse-more',
+            innerHTML : 'More...'
+          }, list);
+
+          on.once(more, 'click', function () {
+            dom.destroy(more);
+            that._loadPage(fileId, handle, list, offset + page.nodes.length);
+          });
         }
-      );
+
+        if (callback)
+          callback(page);
+      }
+
+      if (handle === null)
+        model.cppreparseservice.getASTRoots(
+          fileId, offset, this.pageSize, addPage);
+      else
+        model.cppreparseservice.getASTChildren(
+          fileId, handle, offset, this.pageSize, addPage);
+    },
+
+    /**
+     * Appends a node of the syntax tree to the list. The children of the node
+     * are loaded when it is expanded for the first time, its subtree is dumped
+     * as HTML on request.
+     */
+    _addNode : function (fileId, node, list) {
+      var that = this;
+      var item = dom.create('li', {}, list);
+
+      var toggle = dom.create('span', {
+        class     : 'cppreparse-toggle',
+        innerHTML : node.hasChildren ? '&#9656;' : '&nbsp;'
+      }, item);
+      dom.create('b', { textContent : node.type }, item);
+      dom.create('span', { textContent : ' ' + node.label + ' ' }, item);
+      var showHtml = dom.create('a', { innerHTML : '[AST HTML]' }, item);
+
+      var html = null;
+      on(showHtml, 'click', function () {
+        if (html) {
+          dom.destroy(html);
+          html = null;
+          return;
+        }
+
+        html = dom.create('div', { class : 'cppreparse-html' }, showHtml,
+                          'after');
+        var target = html;
+        model.cppreparseservice.getASTNodeAsHTML(
+          fileId, node.handle, 0, function (astHtml) {
+            target.innerHTML = astHtml;
+          });
+      });
+
+      if (!node.hasChildren)
+        return;
+
+      var children = null;
+      on(toggle, 'click', function () {
+        if (!children) {
+          children = dom.create('ul', {}, item);
+          that._loadPage(fileId, node.handle, children, 0);
+        } else
+          children.style.display
+            = children.style.display === 'none' ? '' : 'none';
+
+        toggle.innerHTML
+          = children.style.display === 'none' ? '&#9656;' : '&#9662;';
+      });
     },
 
     loadASTForNode : function (nodeInfo) {
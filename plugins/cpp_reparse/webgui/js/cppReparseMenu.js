@@ -14,6 +14,16 @@ function (topic, Menu, MenuItem, PopupMenuItem, model, viewHandler) {
     // Don't create the menus if the server can't reparse.
     return;
 
+  // Let the server build the syntax tree of a C++ file opened from the file
+  // manager in the background, so the AST view of the file can be shown
+  // without waiting for the parse. Only the file manager sends the fileInfo,
+  // the files opened by navigation (e.g. jump to definition) are not
+  // prewarmed.
+  topic.subscribe('codecompass/openFile', function (message) {
+    if (message.fileInfo && message.fileInfo.type === 'CPP')
+      model.cppreparseservice.prewarm(message.fileId, function () {});
+  });
+
   //--- Reparse menu for source codes ---//
   var nodeMenu = {
     id : 'cppreparse-node',
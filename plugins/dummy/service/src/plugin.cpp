@@ -2,6 +2,14 @@
 
 #include <service/dummyservice.h>
 
+namespace
+{
+
+const std::unordered_set<std::string> pureMethods{
+  "getDummyString"};
+
+} // namespace
+
 /* These two methods are used by the plugin manager to allow dynamic loading
    of CodeCompass Service plugins. Clang (>= version 6.0) gives a warning that
    these C-linkage specified methods return types that are not proper from a
@@ -36,7 +44,7 @@ extern "C"
     cc::webserver::registerPluginSimple(
       context_,
       pluginHandler_,
-      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(Dummy, dummy),
+      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(Dummy, dummy, pureMethods),
       "DummyService");
   }
 }
@@ -17,8 +17,9 @@ public:
   GitParser(ParserContext& ctx_);
   virtual ~GitParser();
   virtual bool parse() override;
+  virtual unsigned getResources() const override;
 private:
-  util::DirIterCallback getParserCallback();
+  util::DirEntryCallback getParserCallback();
 };
 
 } // parser
@@ -20,19 +20,21 @@ GitParser::GitParser(ParserContext& ctx_) : AbstractParser(ctx_)
   git_libgit2_init();
 }
 
-util::DirIterCallback GitParser::getParserCallback()
+util::DirEntryCallback GitParser::getParserCallback()
 {
   std::string wsDir = _ctx.options["workspace"].as<std::string>();
   std::string projDir = wsDir + '/' + _ctx.options["name"].as<std::string>();
   std::string versionDataDir = projDir + "/version";
 
-  return [&, versionDataDir](const std::string& path_)
+  return [&, versionDataDir](const util::DirEntry& entry_)
   {
+    const std::string& path_ = entry_.path;
     boost::filesystem::path path(path_);
 
     //--- Check for .git folder ---//
 
-    if (!boost::filesystem::is_directory(path) || ".git" != path.filename())
+    if (entry_.type != util::DirEntry::Type::Directory ||
+        ".git" != path.filename())
       return true;
 
     path = boost::filesystem::canonical(path);
@@ -85,6 +87,12 @@ util::DirIterCallback GitParser::getParserCallback()
   };
 }
 
+unsigned GitParser::getResources() const
+{
+  // Cloning the repositories is I/O bound.
+  return 0;
+}
+
 bool GitParser::parse()
 {
   for (const std::string& path :
@@ -98,7 +106,7 @@ bool GitParser::parse()
        in the current root directory. ---*/
     try
     {
-      util::iterateDirectoryRecursive(path, cb);
+      _ctx.walkCache.iterate(path, _ctx.jobs(), cb);
     }
     catch (const std::exception& ex_)
     {
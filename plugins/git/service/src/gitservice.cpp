@@ -3,6 +3,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/ini_parser.hpp>
 
+#include <util/cancellation.h>
 #include <util/dbutil.h>
 #include <util/logutil.h>
 
@@ -20,6 +21,10 @@ int gitDiffToStringCallback(
   const git_diff_line* l_,
   void* payload_)
 {
+  // A non-zero return value stops git_diff_print().
+  if (cc::util::CancellationToken::isCurrentCancelled())
+    return GIT_EUSER;
+
   std::string& ret = *static_cast<std::string*>(payload_);
 
   if (l_->origin == GIT_DIFF_LINE_CONTEXT ||
@@ -43,6 +48,9 @@ int gitDiffToStringCompactCallback(
   const git_diff_line* l,
   void* payload)
 {
+  if (cc::util::CancellationToken::isCurrentCancelled())
+    return GIT_EUSER;
+
   std::string& ret = *static_cast<std::string*>(payload);
 
   if (l->origin != GIT_DIFF_LINE_CONTEXT &&
@@ -157,6 +165,8 @@ void GitServiceHandler::getRepositoryList(std::vector<GitRepository>& return_)
        dirIter != endIter;
        ++dirIter)
   {
+    util::CancellationToken::checkCurrent();
+
     if (!fs::is_directory(dirIter->status()))
       continue;
 
@@ -311,6 +321,8 @@ void GitServiceHandler::getBlameInfo(
 
   for (std::uint32_t i = 0; i < git_blame_get_hunk_count(blame.get()); ++i)
   {
+    util::CancellationToken::checkCurrent();
+
     const git_blame_hunk* hunk = git_blame_get_hunk_byindex(blame.get(), i);
 
     GitBlameHunk blameHunk;
@@ -424,6 +436,8 @@ void GitServiceHandler::getCommitListFiltered(
   int32_t cnt = 0;
   while (cnt < count_ && git_revwalk_next(&oid, revWalk.get()) != GIT_ITEROVER)
   {
+    util::CancellationToken::checkCurrent();
+
     ++i;
 
     if (i < offset_)
@@ -667,6 +681,8 @@ std::string GitServiceHandler::gitDiffToString(git_diff* diff_, bool isCompact_)
 
   git_diff_print(diff_, GIT_DIFF_FORMAT_PATCH, cb, &ret);
 
+  cc::util::CancellationToken::checkCurrent();
+
   return ret;
 }
 
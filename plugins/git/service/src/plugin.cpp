@@ -2,6 +2,17 @@
 
 #include <service/gitservice.h>
 
+namespace
+{
+
+const std::unordered_set<std::string> pureMethods{
+  "getRepositoryList", "getRepositoryByProjectPath", "getCommit", "getTag",
+  "getCommitListFiltered", "getReferenceList", "getBranchList", "getTagList",
+  "getReferenceTopObject", "getCommitDiffAsString", "getBlobOidByPath",
+  "getBlobContent", "getBlameInfo"};
+
+} // namespace
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wreturn-type-c-linkage"
 extern "C"
@@ -20,7 +31,7 @@ extern "C"
     cc::webserver::registerPluginSimple(
       context_,
       pluginHandler_,
-      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(Git, git),
+      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(Git, git, pureMethods),
       "GitService");
   }
 }
@@ -5,6 +5,7 @@
 #include <parser/parsercontext.h>
 
 #include <util/parserutil.h>
+#include <util/taskgroup.h>
 
 namespace cc
 {
@@ -17,9 +18,11 @@ public:
   MetricsParser(ParserContext& ctx_);
   virtual bool cleanupDatabase() override;
   virtual bool parse() override;
+  virtual std::vector<std::string> getDependencies() const override;
+  virtual unsigned getResources() const override;
 
 private:
-  util::DirIterCallback getParserCallback();
+  util::DirEntryCallback getParserCallback(util::TaskGroup& group_);
 
   struct Loc
   {
@@ -49,7 +52,6 @@ private:
   void persistLoc(const Loc& loc_, model::FileId file_);
 
   std::unordered_set<model::FileId> _fileIdCache;
-  std::unique_ptr<util::JobQueueThreadPool<std::string>> _pool;
 };
 
 } // namespace parser
@@ -7,7 +7,7 @@
 #include <util/logutil.h>
 #include <util/dbutil.h>
 #include <util/odbtransaction.h>
-#include <util/threadpool.h>
+#include <util/taskgroup.h>
 
 #include <parser/sourcemanager.h>
 
@@ -30,20 +30,18 @@ MetricsParser::MetricsParser(ParserContext& ctx_): AbstractParser(ctx_)
       _fileIdCache.insert(mf.file);
     }
   });
+}
 
-  int threadNum = _ctx.options["jobs"].as<int>();
-  _pool = util::make_thread_pool<std::string>(
-    threadNum, [this](const std::string& path_)
-    {
-      model::FilePtr file = _ctx.srcMgr.getFile(path_);
-      if (file)
-      {
-        if (_fileIdCache.find(file->id) == _fileIdCache.end())
-          this->persistLoc(getLocFromFile(file), file->id);
-        else
-          LOG(info) << "Metrics already counted for file: " << file->path;
-      }
-    });
+std::vector<std::string> MetricsParser::getDependencies() const
+{
+  // The C++ parser sets the type of the C++ files, which selects the comment
+  // syntax.
+  return {"cppparser"};
+}
+
+unsigned MetricsParser::getResources() const
+{
+  return CPU_HEAVY;
 }
 
 bool MetricsParser::cleanupDatabase()
@@ -82,19 +80,21 @@ bool MetricsParser::cleanupDatabase()
 
 bool MetricsParser::parse()
 {
+  util::TaskGroup group(_ctx.executor, _ctx.jobs());
+
   for(std::string path : _ctx.options["input"].as<std::vector<std::string>>())
   {
     LOG(info) << "Metrics parse path: " << path;
 
     util::OdbTransaction trans(_ctx.db);
     trans([&, this]() {
-      auto cb = getParserCallback();
+      auto cb = getParserCallback(group);
 
       /*--- Call non-empty iter-callback for all files
          in the current root directory. ---*/
       try
       {
-        util::iterateDirectoryRecursive(path, cb);
+        _ctx.walkCache.iterate(path, _ctx.jobs(), cb);
       }
       catch (std::exception& ex_)
       {
@@ -110,19 +110,30 @@ bool MetricsParser::parse()
     });
   }
 
-  _pool->wait();
+  group.wait();
 
   return true;
 }
 
-util::DirIterCallback MetricsParser::getParserCallback()
+util::DirEntryCallback MetricsParser::getParserCallback(
+  util::TaskGroup& group_)
 {
-  return [this](const std::string& currPath_)
+  return [this, &group_](const util::DirEntry& entry_)
   {
-    boost::filesystem::path path(currPath_);
+    const std::string& currPath_ = entry_.path;
 
-    if (boost::filesystem::is_regular_file(path))
-      _pool->enqueue(currPath_);
+    if (entry_.type == util::DirEntry::Type::Regular)
+      group_.run([this, currPath_]
+      {
+        model::FilePtr file = _ctx.srcMgr.getFile(currPath_);
+        if (file)
+        {
+          if (_fileIdCache.find(file->id) == _fileIdCache.end())
+            this->persistLoc(getLocFromFile(file), file->id);
+          else
+            LOG(info) << "Metrics already counted for file: " << file->path;
+        }
+      });
 
     return true;
   };
@@ -4,6 +4,8 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <util/cancellation.h>
+
 #include <metricsservice/metricsservice.h>
 
 namespace cc
@@ -99,6 +101,8 @@ std::string MetricsServiceHandler::getMetricsFromDir(
 
     for (const model::Metrics& metric : metrics)
     {
+      util::CancellationToken::checkCurrent();
+
       core::FileId fileId = std::to_string(metric.file);
 
       core::FileInfo fileInfo;
@@ -2,6 +2,14 @@
 
 #include <metricsservice/metricsservice.h>
 
+namespace
+{
+
+const std::unordered_set<std::string> pureMethods{
+  "getMetrics", "getMetricsTypeNames"};
+
+} // namespace
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wreturn-type-c-linkage"
 extern "C"
@@ -18,7 +26,7 @@ extern "C"
     cc::webserver::registerPluginSimple(
       context_,
       pluginHandler_,
-      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(Metrics, metrics),
+      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(Metrics, metrics, pureMethods),
       "MetricsService");
   }
 }
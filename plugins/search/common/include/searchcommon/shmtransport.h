@@ -0,0 +1,99 @@
+#ifndef CC_SEARCH_SHMTRANSPORT_H
+#define CC_SEARCH_SHMTRANSPORT_H
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <thrift/transport/TTransportException.h>
+#include <thrift/transport/TVirtualTransport.h>
+
+#include <util/shmring.h>
+
+namespace cc
+{
+namespace search
+{
+
+/**
+ * Thrift transport over the shared memory ring buffers of util::ShmRing. The
+ * written bytes are buffered until flush, so a Thrift message (or a batch of
+ * them) is one frame. The Java counterpart is cc.search.common.ipc
+ * .ShmRingTransport.
+ */
+class ShmTransport
+  : public apache::thrift::transport::TVirtualTransport<ShmTransport>
+{
+public:
+  /**
+   * @param ring_ The shared memory of the child process.
+   * @param inFd_ Reader end of the pipe from the child process.
+   * @param outFd_ Writer end of the pipe to the child process.
+   */
+  ShmTransport(std::shared_ptr<util::ShmRing> ring_, int inFd_, int outFd_)
+    : _ring(std::move(ring_)), _inFd(inFd_), _outFd(outFd_), _inPos(0)
+  {
+  }
+
+  std::uint32_t read(std::uint8_t* buf_, std::uint32_t len_)
+  {
+    if (_inPos == _in.size())
+    {
+      _in.clear();
+      _inPos = 0;
+
+      try
+      {
+        _ring->read(_inFd, _in);
+      }
+      catch (const util::ShmRing::Failure& ex_)
+      {
+        throw apache::thrift::transport::TTransportException(
+          apache::thrift::transport::TTransportException::END_OF_FILE,
+          ex_.what());
+      }
+    }
+
+    const std::size_t n = std::min<std::size_t>(len_, _in.size() - _inPos);
+    std::memcpy(buf_, _in.data() + _inPos, n);
+    _inPos += n;
+
+    return n;
+  }
+
+  void write(const std::uint8_t* buf_, std::uint32_t len_)
+  {
+    _out.insert(_out.end(), buf_, buf_ + len_);
+  }
+
+  void flush() override
+  {
+    try
+    {
+      _ring->write(_outFd, _out.data(), _out.size());
+    }
+    catch (const util::ShmRing::Failure& ex_)
+    {
+      _out.clear();
+      throw apache::thrift::transport::TTransportException(
+        apache::thrift::transport::TTransportException::UNKNOWN, ex_.what());
+    }
+
+    _out.clear();
+  }
+
+private:
+  std::shared_ptr<util::ShmRing> _ring;
+  int _inFd;
+  int _outFd;
+
+  std::vector<std::uint8_t> _in;
+  std::size_t _inPos;
+  std::vector<std::uint8_t> _out;
+};
+
+} // search
+} // cc
+
+#endif // CC_SEARCH_SHMTRANSPORT_H
@@ -46,6 +46,10 @@ public class IndexFields {
    * Document boost value.
    */
   public static final String boostValue = "boost";
+  /**
+   * Last modification time of the file (for ordering by recency).
+   */
+  public static final String modifiedField = "modified";
   
   /**
    * Maps a Tag.Kind to a document field name. 
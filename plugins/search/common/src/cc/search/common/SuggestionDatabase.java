@@ -70,6 +70,23 @@ public enum SuggestionDatabase {
     return dir;
   }
 
+  /**
+   * Returns the path of the prefix index of the suggestion database. The
+   * prefix index is a text file which is loaded by the C++ search service to
+   * answer the suggestions without calling the Java process. Each line
+   * contains the weight, the lower case key and the suggested text of an
+   * entry, separated by tabs.
+   *
+   * @param opts_ common options.
+   * @return the path of the prefix index file.
+   */
+  public File getPrefixIndex(CommonOptions opts_) throws IOException {
+    final File dir = createDirectoryWithParents(opts_.indexDirPath +
+      "/suggest");
+
+    return new File(dir, _dirName + ".prefix");
+  }
+
   /**
    * Creates the given directory with its parents. On any error the method
    * throws an IOException.
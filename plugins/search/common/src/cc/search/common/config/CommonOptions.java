@@ -24,6 +24,12 @@ public abstract class CommonOptions {
    * Output file descriptor for thrift IPC.
    */
   public int ipcOutFd;
+  /**
+   * File descriptor of the shared memory ring buffers for thrift IPC (see
+   * ShmRingTransport). If it is 0 then the messages are sent through the IPC
+   * file descriptors.
+   */
+  public int ipcShmFd = 0;
   /**
    * Use SimpleFileLock in Lucene. It's more NFS friendly, but not as stable as
    * a native lock. This option is basically because artf448170.
@@ -95,6 +101,15 @@ public abstract class CommonOptions {
             argIter.remove();
           }
           break;
+        case "-ipcShmFd":
+          if (!argIter.hasNext()) {
+            throw new InvalidValueException("-ipcShmFd is empty");
+          } else {
+            argIter.remove();
+            ipcShmFd = Integer.parseInt(argIter.next());
+            argIter.remove();
+          }
+          break;
         case "-useSimpleFileLock":
           useSimpleLock = true;
           argIter.remove();
@@ -135,6 +150,7 @@ public abstract class CommonOptions {
       + "\t-indexDB path\n\t\tPath of index database.\n"
       + "\t-ipcInFd fd\n\t\tFile descriptor for IPC IN.\n"
       + "\t-ipcOutFd id\n\t\tFile descriptor for IPC OUT.\n"
+      + "\t-ipcShmFd fd\n\t\tShared memory file descriptor for IPC.\n"
       + "\t-useSimpleFileLock\n\t\tUse NFS friendly file locks.\n"
       + "\t-cleanupLocks\n\t\tCleanup locks before first lock..\n";
   }
@@ -2,8 +2,8 @@ package cc.search.common.ipc;
 
 import cc.search.common.config.CommonOptions;
 import java.io.FileInputStream;
-import java.io.FileNotFoundException;
 import java.io.FileOutputStream;
+import java.io.IOException;
 import java.util.logging.Level;
 import java.util.logging.Logger;
 import org.apache.thrift.TException;
@@ -54,17 +54,25 @@ public class IPCProcessor implements AutoCloseable {
    * 
    * @param options_ app options.
    * @param processor_  a thrift processor.
-   * @throws java.io.FileNotFoundException 
+   * @throws java.io.IOException 
    */
   public IPCProcessor(CommonOptions options_, TProcessor processor_)
-    throws FileNotFoundException {
+    throws IOException {
     _processor = processor_;
     
     TProtocolFactory factory = new TBinaryProtocol.Factory();
-    _inTransport = new TIOStreamTransport(
-      new FileInputStream(getFileNameFromFd(options_.ipcInFd)));
-    _outTransport = new TIOStreamTransport(
-      new FileOutputStream(getFileNameFromFd(options_.ipcOutFd)));
+
+    if (options_.ipcShmFd != 0) {
+      // The messages are in shared memory, the pipes carry only their length.
+      _inTransport = new ShmRingTransport(
+        options_.ipcShmFd, options_.ipcInFd, options_.ipcOutFd);
+      _outTransport = _inTransport;
+    } else {
+      _inTransport = new TIOStreamTransport(
+        new FileInputStream(getFileNameFromFd(options_.ipcInFd)));
+      _outTransport = new TIOStreamTransport(
+        new FileOutputStream(getFileNameFromFd(options_.ipcOutFd)));
+    }
     
     _inProtocol = factory.getProtocol(_inTransport);
     _outProtocol = factory.getProtocol(_outTransport);
@@ -118,6 +126,8 @@ public class IPCProcessor implements AutoCloseable {
   @Override
   public void close() {
     _inTransport.close();
-    _outTransport.close();
+    if (_outTransport != _inTransport) {
+      _outTransport.close();
+    }
   }
 }
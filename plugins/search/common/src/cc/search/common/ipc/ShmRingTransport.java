@@ -0,0 +1,237 @@
+package cc.search.common.ipc;
+
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
+import java.io.EOFException;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
+import org.apache.thrift.TByteArrayOutputStream;
+import org.apache.thrift.transport.TTransport;
+import org.apache.thrift.transport.TTransportException;
+
+/**
+ * Thrift transport over the shared memory ring buffers of the parent process
+ * (see util::ShmRing in the C++ code).
+ *
+ * The memory file contains two rings: the parent writes the first one and
+ * reads the second one. A ring starts with a 64 byte header of which the first
+ * 8 bytes are the read position of the reader. The pipes carry only the
+ * length of the frames as big-endian integers: a positive length means that
+ * the frame is in the ring, a negative one means that the frame follows the
+ * length on the pipe.
+ */
+public class ShmRingTransport extends TTransport {
+  /**
+   * Size of the ring header in bytes.
+   */
+  private static final int HEADER_SIZE = 64;
+  /**
+   * Ring of the messages of the parent process.
+   */
+  private static final int TO_CHILD = 0;
+  /**
+   * Ring of the messages of this process.
+   */
+  private static final int TO_PARENT = 1;
+  /**
+   * Volatile field for ordering the accesses of the shared memory.
+   */
+  private static volatile int _fence;
+  /**
+   * The mapped memory file.
+   */
+  private final MappedByteBuffer _memory;
+  /**
+   * Size of the data part of a ring.
+   */
+  private final int _capacity;
+  /**
+   * Pipe of the length tokens from the parent.
+   */
+  private final DataInputStream _pipeIn;
+  /**
+   * Pipe of the length tokens to the parent.
+   */
+  private final DataOutputStream _pipeOut;
+  /**
+   * Read position in the TO_CHILD ring.
+   */
+  private long _readPos = 0;
+  /**
+   * Write position in the TO_PARENT ring.
+   */
+  private long _writePos = 0;
+  /**
+   * The frame being read.
+   */
+  private byte[] _frame = new byte[4096];
+  private int _frameLength = 0;
+  private int _framePos = 0;
+  /**
+   * The frame being written. It is sent on flush.
+   */
+  private final TByteArrayOutputStream _out = new TByteArrayOutputStream(4096);
+
+  /**
+   * Maps the memory file.
+   *
+   * @param shmFd_ file descriptor of the memory file.
+   * @param inFd_ file descriptor of the incoming pipe.
+   * @param outFd_ file descriptor of the outgoing pipe.
+   * @throws IOException
+   */
+  public ShmRingTransport(int shmFd_, int inFd_, int outFd_)
+    throws IOException {
+    try (RandomAccessFile file = new RandomAccessFile(fdPath(shmFd_), "rw");
+         FileChannel channel = file.getChannel()) {
+      _memory = channel.map(FileChannel.MapMode.READ_WRITE, 0, channel.size());
+      _memory.order(ByteOrder.nativeOrder());
+      _capacity = (int)(channel.size() / 2 - HEADER_SIZE);
+    }
+
+    _pipeIn = new DataInputStream(new FileInputStream(fdPath(inFd_)));
+    _pipeOut = new DataOutputStream(new FileOutputStream(fdPath(outFd_)));
+  }
+
+  @Override
+  public boolean isOpen() {
+    return true;
+  }
+
+  @Override
+  public void open() throws TTransportException {
+  }
+
+  @Override
+  public void close() {
+    try {
+      _pipeIn.close();
+      _pipeOut.close();
+    } catch (IOException ex) {
+    }
+  }
+
+  @Override
+  public int read(byte[] buf_, int off_, int len_) throws TTransportException {
+    if (_framePos == _frameLength) {
+      readFrame();
+    }
+
+    int n = Math.min(len_, _frameLength - _framePos);
+    System.arraycopy(_frame, _framePos, buf_, off_, n);
+    _framePos += n;
+
+    return n;
+  }
+
+  @Override
+  public void write(byte[] buf_, int off_, int len_) {
+    _out.write(buf_, off_, len_);
+  }
+
+  @Override
+  public void flush() throws TTransportException {
+    final int size = _out.len();
+    if (size == 0) {
+      return;
+    }
+
+    try {
+      fence();
+      long readerPos = _memory.getLong(ringOffset(TO_PARENT) - HEADER_SIZE);
+
+      if (size > _capacity - (_writePos - readerPos)) {
+        _pipeOut.writeInt(-size);
+        _pipeOut.write(_out.get(), 0, size);
+      } else {
+        copyToRing(_out.get(), size);
+        _writePos += size;
+        _pipeOut.writeInt(size);
+      }
+
+      _pipeOut.flush();
+    } catch (IOException ex) {
+      throw new TTransportException(TTransportException.UNKNOWN, ex);
+    } finally {
+      _out.reset();
+    }
+  }
+
+  /**
+   * Reads the next frame from the ring or from the pipe.
+   */
+  private void readFrame() throws TTransportException {
+    try {
+      int token = _pipeIn.readInt();
+      int size = Math.abs(token);
+
+      if (_frame.length < size) {
+        _frame = new byte[Math.max(size, _frame.length * 2)];
+      }
+
+      if (token < 0) {
+        _pipeIn.readFully(_frame, 0, size);
+      } else {
+        copyFromRing(size);
+        _readPos += size;
+
+        // The frame has to be copied before the parent may overwrite it.
+        fence();
+        _memory.putLong(ringOffset(TO_CHILD) - HEADER_SIZE, _readPos);
+      }
+
+      _frameLength = size;
+      _framePos = 0;
+    } catch (EOFException ex) {
+      throw new TTransportException(TTransportException.END_OF_FILE, ex);
+    } catch (IOException ex) {
+      throw new TTransportException(TTransportException.UNKNOWN, ex);
+    }
+  }
+
+  private void copyFromRing(int size_) {
+    final int base = ringOffset(TO_CHILD);
+    final int offset = (int)(_readPos % _capacity);
+    final int first = Math.min(size_, _capacity - offset);
+
+    ByteBuffer ring = _memory.duplicate();
+    ring.position(base + offset);
+    ring.get(_frame, 0, first);
+    ring.position(base);
+    ring.get(_frame, first, size_ - first);
+  }
+
+  private void copyToRing(byte[] buf_, int size_) {
+    final int base = ringOffset(TO_PARENT);
+    final int offset = (int)(_writePos % _capacity);
+    final int first = Math.min(size_, _capacity - offset);
+
+    ByteBuffer ring = _memory.duplicate();
+    ring.position(base + offset);
+    ring.put(buf_, 0, first);
+    ring.position(base);
+    ring.put(buf_, first, size_ - first);
+  }
+
+  private int ringOffset(int ring_) {
+    return ring_ * (HEADER_SIZE + _capacity) + HEADER_SIZE;
+  }
+
+  /**
+   * A volatile write and read: the memory accesses before this are not
+   * reordered with the ones after this.
+   */
+  private static void fence() {
+    _fence = _fence + 1;
+  }
+
+  private static String fdPath(int fd_) {
+    return "/proc/self/fd/" + Integer.toString(fd_);
+  }
+}
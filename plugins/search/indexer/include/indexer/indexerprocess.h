@@ -1,11 +1,13 @@
 #ifndef CC_PARSER_INDEXERPROCESS_H
 #define CC_PARSER_INDEXERPROCESS_H
 
+#include <memory>
 #include <unordered_map>
 #include <string>
 #include <vector>
 
 #include <util/pipedprocess.h>
+#include <util/shmring.h>
 #include <IndexerService.h>
 
 namespace cc
@@ -73,12 +75,29 @@ public:
   ~IndexerProcess();
   
 public:
+  /**
+   * Sends the pending files and stops the indexer process, which closes the
+   * index. The other methods mustn't be called afterwards.
+   */
   virtual void stop() override;
   
+  /**
+   * Adds the file to the current batch. The batch is sent when it is full or
+   * before any other request.
+   */
   virtual void indexFile(
     const std::string& fileId_,
     const std::string& filePath_,
     const std::string& mimeType_) override;
+
+  /**
+   * Adds the file to the current batch like the other overload. The file may
+   * carry its definitions, then the indexer doesn't run ctags on it.
+   */
+  void indexFile(search::IndexedFile file_);
+
+  virtual void indexFiles(
+    const std::vector<search::IndexedFile>& files_) override;
   
   virtual void addFieldValues(
     const std::string& fileId_,
@@ -90,6 +109,16 @@ public:
     std::map<std::string, std::string>& stat_) override;
   
 private:
+  /**
+   * Sends the batch of indexFile() calls, if any.
+   */
+  void flushFiles();
+
+  /**
+   * Aborts if the indexer process has died.
+   */
+  void checkProcess();
+
   /**
    * Second pipe for thrift.
    */
@@ -98,6 +127,15 @@ private:
    * Indexer interface for IPC communication.
    */
   std::unique_ptr<search::IndexerServiceIf> _indexer;
+  /**
+   * Shared memory for the thrift messages. If it couldn't be created then the
+   * messages go through the pipes.
+   */
+  std::shared_ptr<util::ShmRing> _shm;
+  /**
+   * Files of indexFile() calls which are not sent yet.
+   */
+  std::vector<search::IndexedFile> _pendingFiles;
 };
 
 } // parser
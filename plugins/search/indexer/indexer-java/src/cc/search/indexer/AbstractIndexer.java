@@ -239,6 +239,9 @@ abstract public class AbstractIndexer {
     // Text content
     doc.add(new Field(IndexFields.contentField, fileContent_,
       _contentFieldType));
+    // Modification time
+    doc.add(new NumericDocValuesField(IndexFields.modifiedField,
+      file_.lastModified()));
     
     if (isSourceFile(fileMimeType_)) {
       doc.add(new NumericDocValuesField(IndexFields.boostValue, 2L));
@@ -291,7 +294,10 @@ abstract public class AbstractIndexer {
   private static Tags generateTagsForContext(Context context_)
     throws IOException {
     BytesRef tagsBin = context_.document.getBinaryValue(IndexFields.tagsField);
-    if (tagsBin == null) {
+    if (tagsBin == null && !context_.generateTags) {
+      // The tags come from the extra definitions.
+      return new Tags();
+    } else if (tagsBin == null) {
       TagGenerator generator = TagGeneratorManager.get().getGenerator();
       try {
         Tags tags = new Tags();
@@ -27,6 +27,11 @@ public final class Context {
    * Additional fields or null.
    */
   public Map<String, List<FieldValue>> extraFields = null;
+  /**
+   * If false, the tags of the document come only from the definitions of the
+   * extra fields and the tag generator is not run.
+   */
+  public boolean generateTags = true;
   /**
    * Line informations.
    */
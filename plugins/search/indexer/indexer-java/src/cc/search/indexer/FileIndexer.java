@@ -1,10 +1,14 @@
 package cc.search.indexer;
 
+import cc.parser.search.FieldValue;
+import cc.parser.search.searchindexerConstants;
 import com.j256.simplemagic.ContentInfo;
 import com.j256.simplemagic.ContentInfoUtil;
 import java.io.File;
 import java.io.FileNotFoundException;
 import java.io.IOException;
+import java.util.HashMap;
+import java.util.List;
 import java.util.logging.Level;
 import java.util.logging.Logger;
 import org.apache.lucene.index.IndexWriter;
@@ -30,6 +34,10 @@ public class FileIndexer extends AbstractIndexer {
    * The mime type of the file.
    */
   private final String _fileMimeType;
+  /**
+   * Definitions of the file from the parsers or null.
+   */
+  private final List<FieldValue> _definitions;
   
 
   /**
@@ -40,11 +48,25 @@ public class FileIndexer extends AbstractIndexer {
    */
   public FileIndexer(String file_, String fileId_, String mimeType_,
     IndexWriter indexWriter_) {
+    this(file_, fileId_, mimeType_, null, indexWriter_);
+  }
+
+  /**
+   * @param file_ file to index
+   * @param fileId_ database id of the file
+   * @param mimeType_ mime type of the file.
+   * @param definitions_ definitions of the file (see FIELD_DEFINITIONS). If
+   *   it is not null then the tag generator is not run for the file.
+   * @param indexWriter_ index database
+   */
+  public FileIndexer(String file_, String fileId_, String mimeType_,
+    List<FieldValue> definitions_, IndexWriter indexWriter_) {
     super(indexWriter_);
     
     _filePath = file_;
     _fileId = fileId_;
     _fileMimeType = mimeType_;
+    _definitions = definitions_;
   }
   
   @Override
@@ -67,7 +89,15 @@ public class FileIndexer extends AbstractIndexer {
           }
         }
         
-        return new Context(_fileId, file, mimeType);
+        final Context ctx = new Context(_fileId, file, mimeType);
+        if (_definitions != null) {
+          ctx.extraFields = new HashMap<>();
+          ctx.extraFields.put(searchindexerConstants.FIELD_DEFINITIONS,
+            _definitions);
+          ctx.generateTags = false;
+        }
+
+        return ctx;
       } catch (FileNotFoundException e) {
         _log.log(Level.SEVERE, "File not found: {0}! Skipping!",file.getPath());
         return null;
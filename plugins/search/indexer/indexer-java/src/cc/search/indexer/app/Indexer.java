@@ -1,6 +1,7 @@
 package cc.search.indexer.app;
 
 import cc.parser.search.FieldValue;
+import cc.parser.search.IndexedFile;
 import cc.parser.search.IndexerService;
 import cc.search.analysis.SourceAnalyzer;
 import cc.search.analysis.tags.TagGeneratorManager;
@@ -212,6 +213,27 @@ public class Indexer implements AutoCloseable, IndexerService.Iface {
     }
   }
 
+  @Override
+  public void indexFiles(List<IndexedFile> files_) {
+    for (IndexedFile file : files_) {
+      if (!file.isSetDefinitions()) {
+        indexFile(file.fileId, file.filePath, file.mimeType);
+        continue;
+      }
+
+      _log.log(Level.FINEST, "Adding file {0} with {1} definition(s) to index.",
+        new Object[] { file.filePath, file.definitions.size() });
+
+      try {
+        _indexers.add(_executor.submit(new IndexerTask(
+          new FileIndexer(file.filePath, file.fileId, file.mimeType,
+            file.definitions, _indexWriter))));
+      } catch (Exception ex) {
+        _log.log(Level.SEVERE, "An unknown exception caught!", ex);
+      }
+    }
+  }
+
   @Override
   public void addFieldValues(String fileId_,
     Map<String, List<FieldValue>> fields_) throws org.apache.thrift.TException {
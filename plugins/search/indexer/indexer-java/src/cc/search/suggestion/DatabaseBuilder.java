@@ -3,9 +3,12 @@ package cc.search.suggestion;
 import cc.search.common.IndexFields;
 import cc.search.common.SuggestionDatabase;
 import cc.search.common.config.CommonOptions;
+import java.io.BufferedWriter;
 import java.io.IOException;
 import java.io.File;
 import java.io.FileOutputStream;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
 import java.util.logging.Level;
 import java.util.logging.Logger;
 import org.apache.lucene.analysis.core.WhitespaceAnalyzer;
@@ -64,6 +67,17 @@ public final class DatabaseBuilder {
     } catch (IOException ex) {
       _log.log(Level.SEVERE, "Failed to create symbol suggestions!", ex);
     }
+
+    try {
+      writePrefixIndex(SuggestionDatabase.FileName.getPrefixIndex(_opts),
+        new DocumentDictionary(_reader, IndexFields.fileNameField,
+          IndexFields.boostValue).getEntryIterator());
+      writePrefixIndex(SuggestionDatabase.Symbol.getPrefixIndex(_opts),
+        createSymbolIterator());
+    } catch (IOException ex) {
+      _log.log(Level.SEVERE, "Failed to create suggestion prefix indexes!",
+        ex);
+    }
   }
 
   /**
@@ -104,18 +118,58 @@ public final class DatabaseBuilder {
       Version.LUCENE_4_9, FSDirectory.open(db, _opts.createLockFactory()),
       new WhitespaceAnalyzer(Version.LUCENE_4_9))) {
 
-      InputIterator iter = new UniqueInputIterator(
-        new TagInputIterator(_reader)) {
-        @Override
-        protected void updateData(BytesRef item_, Data itemData_,
-          InputIterator iter_) {
-          if (itemData_.weight < iter_.weight()) {
-            itemData_.weight = iter_.weight();
-          }
+      suggester.build(createSymbolIterator());
+    }
+  }
+
+  /**
+   * Creates an iterator over the unique symbols with their highest weights.
+   *
+   * @return the symbol iterator.
+   * @throws IOException on any error.
+   */
+  private InputIterator createSymbolIterator() throws IOException {
+    return new UniqueInputIterator(new TagInputIterator(_reader)) {
+      @Override
+      protected void updateData(BytesRef item_, Data itemData_,
+        InputIterator iter_) {
+        if (itemData_.weight < iter_.weight()) {
+          itemData_.weight = iter_.weight();
+        }
+      }
+    };
+  }
+
+  /**
+   * Writes the entries of the iterator into a prefix index file (see
+   * SuggestionDatabase.getPrefixIndex()).
+   *
+   * @param file_ the prefix index file.
+   * @param iter_ the entries.
+   * @throws IOException on any error.
+   */
+  private static void writePrefixIndex(File file_, InputIterator iter_)
+    throws IOException {
+    try (BufferedWriter out = Files.newBufferedWriter(file_.toPath(),
+      StandardCharsets.UTF_8)) {
+
+      for (BytesRef key = iter_.next(); key != null; key = iter_.next()) {
+        final BytesRef payload = iter_.hasPayloads() ? iter_.payload() : null;
+        final String text = payload != null ?
+          payload.utf8ToString() : key.utf8ToString();
+
+        if (text.isEmpty() || text.indexOf('\t') >= 0 ||
+          text.indexOf('\n') >= 0) {
+          continue;
         }
-      };
 
-      suggester.build(iter);
+        out.write(Long.toString(iter_.weight()));
+        out.write('\t');
+        out.write(key.utf8ToString().toLowerCase());
+        out.write('\t');
+        out.write(text);
+        out.newLine();
+      }
     }
   }
 }
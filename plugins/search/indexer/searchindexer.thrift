@@ -85,6 +85,31 @@ struct FieldValue
  */
 typedef map<string, list<FieldValue>> Fields
 
+/**
+ * A file to add to the index database (see IndexerService.indexFile).
+ */
+struct IndexedFile
+{
+  /**
+   * Database id of the file.
+   */
+  1: string fileId,
+  /**
+   * Indexable file path.
+   */
+  2: string filePath,
+  /**
+   * Mime type of the file.
+   */
+  3: string mimeType,
+  /**
+   * Definitions of the file in the form of FIELD_DEFINITIONS values. If it is
+   * set, the indexer uses these instead of running a tag generator (ctags) on
+   * the file.
+   */
+  4: optional list<FieldValue> definitions
+}
+
 /**
  * Interface for search indexer.
  */
@@ -108,6 +133,14 @@ service IndexerService
     2:string filePath_,
     3:string mimeType_),
 
+  /**
+   * Add a batch of files to the index database. This is the same as calling
+   * indexFile() for each file, but it is only one message.
+   *
+   * @param files_ indexable files.
+   */
+  oneway void indexFiles(1:list<IndexedFile> files_),
+
   /**
    * Adds the given field values to a document. The document will not be
    * created if it does not exists (so it does nothing in this case).
@@ -8,6 +8,7 @@
 
 #include <util/logutil.h>
 
+#include <searchcommon/shmtransport.h>
 #include <indexer/indexerprocess.h>
 
 #ifdef JAVAMEMORYAMOUNT
@@ -21,6 +22,16 @@
   #define JAVAMEMORYAMOUNT "-Xmx2g"
 #endif
 
+namespace
+{
+
+/**
+ * Number of indexFile() calls sent in one message.
+ */
+const std::size_t IndexBatchSize = 256;
+
+}
+
 namespace cc
 {
 namespace parser
@@ -34,11 +45,25 @@ IndexerProcess::IndexerProcess(
 {
   openPipe(_pipeFd2[0], _pipeFd2[1]);
 
+  try
+  {
+    _shm = std::make_shared<util::ShmRing>();
+  }
+  catch (const util::ShmRing::Failure& ex_)
+  {
+    LOG(warning)
+      << "Shared memory for the indexer is not available, using pipes: "
+      << ex_.what();
+  }
+
+  _pendingFiles.reserve(IndexBatchSize);
+
   if (startProcess() == 0)
   {
     // This is the child process.
     std::string inFd(std::to_string(_pipeFd[0]));
     std::string outFd(std::to_string(_pipeFd2[1]));
+    std::string shmFd(_shm ? std::to_string(_shm->inheritInChild()) : "");
 
     std::string logLevelOpt("-Dcc.search.logLevel=");
 
@@ -68,6 +93,12 @@ IndexerProcess::IndexerProcess(
       "-ipcOutFd", outFd.c_str()
     };
 
+    if (_shm)
+    {
+      execArguments.push_back("-ipcShmFd");
+      execArguments.push_back(shmFd.c_str());
+    }
+
     switch (openMode_)
     {
       case OpenMode::Create:
@@ -102,6 +133,24 @@ IndexerProcess::IndexerProcess(
   else
   {
     // Get the client interface
+    if (_shm)
+    {
+      using Transport = cc::search::ShmTransport;
+      using ProtocolFactory =
+        apache::thrift::protocol::TBinaryProtocolFactoryT<Transport>;
+
+      std::shared_ptr<apache::thrift::transport::TTransport> trans(
+        new Transport(_shm, _pipeFd2[0], _pipeFd[1]));
+
+      ProtocolFactory protFactory;
+
+      _indexer.reset(new search::IndexerServiceClient(
+        protFactory.getProtocol(trans),
+        protFactory.getProtocol(trans)));
+
+      return;
+    }
+
     using Transport = apache::thrift::transport::TFDTransport;
     using ProtocolFactory =
       apache::thrift::protocol::TBinaryProtocolFactoryT<Transport>;
@@ -121,8 +170,7 @@ IndexerProcess::IndexerProcess(
 
 IndexerProcess::~IndexerProcess()
 {
-  if (_indexer && isAlive())
-    _indexer->stop();
+  stop();
 
   closePipe(_pipeFd[0], _pipeFd[1]);
   closePipe(_pipeFd2[0], _pipeFd2[1]);
@@ -132,7 +180,15 @@ IndexerProcess::~IndexerProcess()
 
 void IndexerProcess::stop()
 {
-  assert(false && "IndexerProcess::stop called");
+  if (!_indexer || !isAlive())
+    return;
+
+  flushFiles();
+  _indexer->stop();
+
+  // The indexer process exits after the stop message, so the client mustn't
+  // be used any more.
+  _indexer.reset(nullptr);
 }
 
 void IndexerProcess::indexFile(
@@ -140,48 +196,74 @@ void IndexerProcess::indexFile(
   const std::string& filePath_,
   const std::string& mimeType_)
 {
-  if (!isAlive())
-  {
-    LOG(error) << "Index process is not alive!";
-    ::abort();
-  }
-  
-  _indexer->indexFile(fileId_, filePath_, mimeType_);
+  search::IndexedFile file;
+  file.fileId = fileId_;
+  file.filePath = filePath_;
+  file.mimeType = mimeType_;
+
+  indexFile(std::move(file));
 }
-  
+
+void IndexerProcess::indexFile(search::IndexedFile file_)
+{
+  _pendingFiles.push_back(std::move(file_));
+
+  if (_pendingFiles.size() >= IndexBatchSize)
+    flushFiles();
+}
+
+void IndexerProcess::indexFiles(const std::vector<search::IndexedFile>& files_)
+{
+  flushFiles();
+  checkProcess();
+
+  _indexer->indexFiles(files_);
+}
+
 void IndexerProcess::addFieldValues(
   const std::string& fileId_,
   const search::Fields& fields_)
 {
-  if (!isAlive())
-  {
-    LOG(error) << "Index process is not alive!";
-    ::abort();
-  }
+  flushFiles();
+  checkProcess();
 
   _indexer->addFieldValues(fileId_, fields_);
 }
 
 void IndexerProcess::buildSuggestions()
 {
-  if (!isAlive())
-  {
-    LOG(error) << "Index process is not alive!";
-    ::abort();
-  }
+  flushFiles();
+  checkProcess();
 
   _indexer->buildSuggestions();
 }
 
 void IndexerProcess::getStatistics(std::map<std::string, std::string>& stat_)
 {
-  if (!isAlive())
+  flushFiles();
+  checkProcess();
+
+  _indexer->getStatistics(stat_);
+}
+
+void IndexerProcess::flushFiles()
+{
+  if (_pendingFiles.empty())
+    return;
+
+  checkProcess();
+
+  _indexer->indexFiles(_pendingFiles);
+  _pendingFiles.clear();
+}
+
+void IndexerProcess::checkProcess()
+{
+  if (!_indexer || !isAlive())
   {
     LOG(error) << "Index process is not alive!";
     ::abort();
   }
-
-  _indexer->getStatistics(stat_);
 }
 
 } // namespace parser
@@ -1,13 +1,18 @@
 #ifndef CC_PARSER_SEARCHPARSER_H
 #define CC_PARSER_SEARCHPARSER_H
 
-#include <magic.h>
+#include <unordered_map>
+#include <vector>
+
+#include <model/file.h>
 
 #include <util/parserutil.h>
 
 #include <parser/abstractparser.h>
 #include <parser/parsercontext.h>
 
+#include <searchindexer_types.h>
+
 namespace cc
 {
 namespace parser
@@ -21,11 +26,19 @@ public:
   SearchParser(ParserContext& ctx_);
   virtual ~SearchParser();
 
+  virtual std::vector<std::string> getDependencies() const override;
   virtual bool parse() override;
+  virtual unsigned getResources() const override;
 
 private:
+  /**
+   * Loads the definitions of the C++ parser from the database with one query,
+   * so the C++ files are indexed without running ctags on them.
+   */
+  void collectDefinitions();
+
   void postParse();
-  util::DirIterCallback getParserCallback(const std::string& path_);
+  util::DirEntryCallback getParserCallback(const std::string& path_);
   bool shouldHandle(const std::string& path_);
 
 private:
@@ -34,11 +47,6 @@ private:
    */
   std::unique_ptr<IndexerProcess> _indexProcess;
 
-  /**
-   * libmagic handler for mime types.
-   */
-  ::magic_t _fileMagic;
-
   /**
    * Directory of search database.
    */
@@ -48,6 +56,12 @@ private:
    * Directories which have to be skipped during the parse.
    */
   std::vector<std::string> _skipDirectories;
+
+  /**
+   * Definitions of the C++ files by file id (see collectDefinitions()).
+   */
+  std::unordered_map<model::FileId, std::vector<search::FieldValue>>
+    _definitions;
 };
 
 } // parser
@@ -2,6 +2,7 @@
 #include <cstdlib>
 #include <algorithm>
 #include <array>
+#include <unordered_set>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -9,9 +10,14 @@
 #include <boost/filesystem.hpp>
 
 #include <util/logutil.h>
+#include <util/odbtransaction.h>
 
 #include <model/file.h>
 #include <model/file-odb.hxx>
+#include <model/cppfunction.h>
+#include <model/cppfunction-odb.hxx>
+#include <model/cpptype.h>
+#include <model/cpptype-odb.hxx>
 
 #include <parser/sourcemanager.h>
 #include <indexer/indexerprocess.h>
@@ -31,23 +37,47 @@ std::array<const char*, 15> excludedSuffixes{{
   ".Metrics.dat", ".pp"
 }};
 
-SearchParser::SearchParser(ParserContext& ctx_) : AbstractParser(ctx_),
-  _fileMagic(::magic_open(MAGIC_MIME_TYPE | MAGIC_SYMLINK))
+namespace
 {
-  if (!_fileMagic)
-  {
-    LOG(warning) << "Failed to create a libmagic cookie!";
-  }
-  else if (::magic_load(_fileMagic, nullptr) != 0)
+
+/**
+ * Returns the name of the Tag.Kind of the indexer which corresponds to the
+ * definition.
+ */
+std::string getTagKind(const model::CppDefinitionLocation& def_)
+{
+  switch (def_.symbolType)
   {
-    LOG(warning)
-      << "magic_load failed! libmagic error: "
-      << ::magic_error(_fileMagic);
+    case model::CppAstNode::SymbolType::Type:
+    case model::CppAstNode::SymbolType::Typedef:
+    case model::CppAstNode::SymbolType::Enum:
+      return "Type";
+
+    case model::CppAstNode::SymbolType::Function:
+      return "Function";
+
+    case model::CppAstNode::SymbolType::Variable:
+    case model::CppAstNode::SymbolType::FunctionPtr:
+      return def_.memberKind.null() ? "Variable" : "Field";
 
-    ::magic_close(_fileMagic);
-    _fileMagic = nullptr;
+    case model::CppAstNode::SymbolType::EnumConstant:
+      return "Constant";
+
+    case model::CppAstNode::SymbolType::Macro:
+      return "Macro";
+
+    case model::CppAstNode::SymbolType::Namespace:
+      return "Module";
+
+    default:
+      return "Other";
   }
+}
+
+} // namespace
 
+SearchParser::SearchParser(ParserContext& ctx_) : AbstractParser(ctx_)
+{
   std::string wsDir = ctx_.options["workspace"].as<std::string>();
   std::string projDir = wsDir + '/' + ctx_.options["name"].as<std::string>();
   _searchDatabase = projDir + "/search";
@@ -78,6 +108,12 @@ SearchParser::SearchParser(ParserContext& ctx_) : AbstractParser(ctx_),
   }
 }
 
+std::vector<std::string> SearchParser::getDependencies() const
+{
+  // The definitions of the C++ files come from the C++ parser.
+  return {"cppparser"};
+}
+
 bool SearchParser::parse()
 {
   if (fs::is_directory(_searchDatabase))
@@ -87,6 +123,8 @@ bool SearchParser::parse()
     LOG(info) << "Search database already exists, dropping.";
   }
 
+  collectDefinitions();
+
   for (const std::string& path :
     _ctx.options["input"].as<std::vector<std::string>>())
   {
@@ -94,7 +132,7 @@ bool SearchParser::parse()
 
     try
     {
-      util::iterateDirectoryRecursive(path, getParserCallback(path));
+      _ctx.walkCache.iterate(path, _ctx.jobs(), getParserCallback(path));
     }
     catch (const std::exception& ex_)
     {
@@ -111,17 +149,88 @@ bool SearchParser::parse()
   return true;
 }
 
-util::DirIterCallback SearchParser::getParserCallback(const std::string& path_)
+void SearchParser::collectDefinitions()
+{
+  typedef odb::query<model::CppDefinitionLocation> DefQuery;
+
+  _definitions.clear();
+
+  try
+  {
+    util::OdbTransaction {_ctx.db} ([this] {
+      // The parameters and the local variables are not indexed, like ctags
+      // does.
+      std::unordered_set<model::CppAstNodeId> locals;
+
+      for (const model::CppFunctionParamAstNodeId& param
+        : _ctx.db->query<model::CppFunctionParamAstNodeId>())
+        locals.insert(param.astNodeId);
+
+      for (const model::CppFunctionLocalAstNodeId& local
+        : _ctx.db->query<model::CppFunctionLocalAstNodeId>())
+        locals.insert(local.astNodeId);
+
+      for (const model::CppDefinitionLocation& def
+        : _ctx.db->query<model::CppDefinitionLocation>(
+          DefQuery::CppAstNode::astType ==
+            model::CppAstNode::AstType::Definition))
+      {
+        if (def.name.empty() ||
+            def.startLine == model::Position::npos ||
+            def.endLine == model::Position::npos ||
+            locals.count(def.astNodeId))
+          continue;
+
+        search::Location location;
+        location.startLine = def.startLine;
+        location.startColumn = def.startColumn;
+        location.endLine = def.endLine;
+        location.endColumn = def.endColumn;
+
+        search::FieldValue value;
+        value.__set_location(location);
+        value.value = def.name;
+        value.__set_context(getTagKind(def));
+
+        _definitions[def.file].push_back(std::move(value));
+      }
+    });
+  }
+  catch (const odb::exception& ex_)
+  {
+    // E.g. the C++ plugin is not loaded, so its tables don't exist.
+    LOG(info)
+      << "No C++ definitions for the search index, ctags is used for every "
+         "file: " << ex_.what();
+
+    _definitions.clear();
+    return;
+  }
+
+  LOG(info) << "Search parser loaded the C++ definitions of "
+    << _definitions.size() << " file(s).";
+}
+
+unsigned SearchParser::getResources() const
+{
+  // The files are indexed by the Java indexer process.
+  return 0;
+}
+
+util::DirEntryCallback SearchParser::getParserCallback(
+  const std::string& path_)
 {
   if (!_indexProcess)
   {
     LOG(warning) << "Indexer process is not available, skip path: " << path_;
-    return [](const std::string&){ return false; };
+    return [](const util::DirEntry&){ return false; };
   }
 
-  return [this](const std::string& currPath_)
+  return [this](const util::DirEntry& entry_)
   {
-    if (fs::is_directory(currPath_))
+    const std::string& currPath_ = entry_.path;
+
+    if (entry_.type == util::DirEntry::Type::Directory)
     {
       fs::path canonicalPath = fs::canonical(currPath_);
 
@@ -134,31 +243,43 @@ util::DirIterCallback SearchParser::getParserCallback(const std::string& path_)
       }
     }
 
-    if (!shouldHandle(currPath_))
+    if (entry_.type != util::DirEntry::Type::Regular ||
+        !shouldHandle(currPath_))
       return true;
 
     model::FilePtr file = _ctx.srcMgr.getFile(currPath_);
 
     if (file)
     {
-      std::string mimeType("text/plain");
-      if (_fileMagic)
-      {
-        const char* mimeStr = ::magic_file(_fileMagic, currPath_.c_str());
-
-        if (mimeStr)
-          mimeType = mimeStr;
-        else
-          LOG(warning)
-            << "Failed to get mime type for file '"
-            << currPath_ << "'. libmagic error: "
-            << ::magic_error(_fileMagic);
-      }
+      // The file is classified by the source manager once, the indexer needs
+      // only the type without the character set.
+      std::string mimeType = file->mimeType.empty()
+        ? _ctx.srcMgr.getMimeType(currPath_)
+        : file->mimeType;
+      mimeType = mimeType.substr(0, mimeType.find(';'));
+      if (mimeType.empty())
+        mimeType = "text/plain";
 
       file->inSearchIndex = true;
       _ctx.srcMgr.persistFiles();
-      _indexProcess->indexFile(
-        std::to_string(file->id), file->path, mimeType);
+
+      search::IndexedFile indexedFile;
+      indexedFile.fileId = std::to_string(file->id);
+      indexedFile.filePath = file->path;
+      indexedFile.mimeType = mimeType;
+
+      // The C++ files are tagged by their definitions in the database, even
+      // if they have none.
+      auto it = _definitions.find(file->id);
+      if (it != _definitions.end())
+      {
+        indexedFile.__set_definitions(std::move(it->second));
+        _definitions.erase(it);
+      }
+      else if (file->type == "CPP")
+        indexedFile.__set_definitions({});
+
+      _indexProcess->indexFile(std::move(indexedFile));
     }
 
     return true;
@@ -167,11 +288,6 @@ util::DirIterCallback SearchParser::getParserCallback(const std::string& path_)
 
 bool SearchParser::shouldHandle(const std::string& path_)
 {
-  //--- The file is not regular. ---//
-
-  if (!fs::is_regular(path_))
-    return false;
-
   //--- The file is excluded by suffix. ---//
 
   std::string normPath(path_);
@@ -189,10 +305,10 @@ bool SearchParser::shouldHandle(const std::string& path_)
     }
   }
 
-  //--- The file is larger than one megabyte. ---//
+  //--- The file is not regular or it is larger than one megabyte. ---//
 
   struct stat statbuf;
-  if (::stat(path_.c_str(), &statbuf) == -1)
+  if (::stat(path_.c_str(), &statbuf) == -1 || !S_ISREG(statbuf.st_mode))
     return false;
 
   if (statbuf.st_size > (1024 * 1024))
@@ -225,8 +341,6 @@ void SearchParser::postParse()
 
 SearchParser::~SearchParser()
 {
-  if (_fileMagic)
-    ::magic_close(_fileMagic);
 }
 
 #pragma clang diagnostic push
@@ -0,0 +1,142 @@
+#ifndef CC_SERVICE_SEARCHRESULTCACHE_H
+#define CC_SERVICE_SEARCHRESULTCACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <search_types.h>
+
+namespace cc
+{
+namespace service
+{
+namespace search
+{
+
+/**
+ * LRU cache of the text search results, bounded by their approximate size in
+ * bytes.
+ *
+ * An entry belongs to a normalised query (see makeKey()) and holds the files
+ * fetched so far from the Java search process, from the first one on. The
+ * pages are served from this list and it is extended on demand, so a query
+ * which is never paged costs only its first chunks.
+ *
+ * The whole cache is dropped when the version of the search index changes,
+ * i.e. when the workspace is parsed again.
+ */
+class SearchResultCache
+{
+public:
+  /**
+   * The cached result of a query. The fields may be read and extended only
+   * while holding the mutex of the entry.
+   */
+  struct Entry
+  {
+    std::mutex mutex;
+
+    /**
+     * Number of matching files, or -1 if nothing was fetched yet.
+     */
+    std::int64_t totalFiles = -1;
+
+    /**
+     * Number of files requested from the Java process so far. It may be more
+     * than the size of results, because files without matching lines are
+     * left out.
+     */
+    std::int64_t fetchedFiles = 0;
+
+    std::vector<SearchResultEntry> results;
+
+    /**
+     * Approximate size of the results in bytes.
+     */
+    std::size_t bytes = 0;
+  };
+
+  /**
+   * @param maxBytes_ Approximate limit of the size of the cached results. If
+   * it is 0, nothing is cached.
+   */
+  SearchResultCache(std::size_t maxBytes_);
+
+  /**
+   * Returns the normalised form of the parameters without the range: the same
+   * query with different leading or trailing whitespace, filter case or paging
+   * has the same key.
+   *
+   * @param maxMatchesPerFile_ The effective per-file match limit.
+   */
+  static std::string makeKey(
+    const SearchParams& params_,
+    std::int64_t maxMatchesPerFile_);
+
+  /**
+   * Returns the entry of the key, or a new empty entry if the key is not
+   * cached. If the version differs from the one of the cached entries, the
+   * cache is cleared first.
+   */
+  std::shared_ptr<Entry> get(
+    const std::string& key_,
+    const std::string& version_);
+
+  /**
+   * Updates the size of an entry after its results were extended, and evicts
+   * the least recently used entries if the cache is over its limit.
+   */
+  void updateSize(const std::string& key_, std::size_t bytes_);
+
+  /**
+   * Records whether a request was served from the cache without calling the
+   * Java process. The statistics are logged periodically.
+   */
+  void recordRequest(bool hit_);
+
+  /**
+   * Returns the approximate size of a search result entry in bytes.
+   */
+  static std::size_t entrySize(const SearchResultEntry& entry_);
+
+private:
+  typedef std::list<std::string> LruList;
+
+  struct Item
+  {
+    std::shared_ptr<Entry> entry;
+    std::size_t bytes;
+    LruList::iterator lruPos;
+  };
+
+  void evict();
+
+  const std::size_t _maxBytes;
+
+  std::mutex _mutex;
+  std::unordered_map<std::string, Item> _items;
+
+  /**
+   * Keys from the most recently used to the least recently used.
+   */
+  LruList _lru;
+
+  std::size_t _bytes;
+  std::string _version;
+
+  std::uint64_t _hits;
+  std::uint64_t _misses;
+  std::uint64_t _evictions;
+  std::uint64_t _invalidations;
+};
+
+} // search
+} // service
+} // cc
+
+#endif // CC_SERVICE_SEARCHRESULTCACHE_H
@@ -4,17 +4,19 @@
 #include <cstdio>
 #include <memory>
 #include <functional>
-#include <mutex>
 
 #include <boost/regex.hpp>
 #include <boost/program_options/variables_map.hpp>
 
 #include <odb/database.hxx>
+#include <util/processpool.h>
 #include <webserver/servercontext.h>
 
 #include <SearchService.h>
 
+#include <service/searchresultcache.h>
 #include <service/serviceprocess.h>
+#include <service/suggestionindex.h>
 
 namespace cc
 {
@@ -55,10 +57,57 @@ private:
    */
   static void validateRegexp(const std::string& regexp_);
 
+  /**
+   * Returns the smaller of the two limits, where 0 means no limit.
+   */
+  static std::int64_t minLimit(std::int64_t a_, std::int64_t b_);
+
+  /**
+   * Returns a string which changes when the search index is rebuilt.
+   */
+  std::string getIndexVersion() const;
+
   std::shared_ptr<odb::database> _db;
 
-  std::unique_ptr<ServiceProcess> _javaProcess;
-  std::mutex _javaProcessMutex;
+  /**
+   * Number of files in a chunk of search results requested from the Java
+   * search process.
+   */
+  std::int64_t _chunkSize;
+
+  /**
+   * Maximum number of matching lines in a search response (0 means no limit).
+   */
+  std::int64_t _maxResultLines;
+
+  /**
+   * Maximum number of matching lines per file (0 means no limit).
+   */
+  std::int64_t _maxMatchesPerFile;
+
+  /**
+   * The Java search processes. A process serves one request at a time, so
+   * concurrent requests are dispatched to the least loaded one.
+   */
+  std::unique_ptr<util::ProcessPool<ServiceProcess>> _javaProcesses;
+
+  /**
+   * In-memory prefix indexes of the file name and the symbol suggestions. If
+   * an index couldn't be loaded (e.g. the workspace was parsed by an older
+   * version), the suggestions come from the Java search process.
+   */
+  std::unique_ptr<SuggestionIndex> _fileNameSuggestions;
+  std::unique_ptr<SuggestionIndex> _symbolSuggestions;
+
+  /**
+   * Cached text search results.
+   */
+  std::unique_ptr<SearchResultCache> _resultCache;
+
+  /**
+   * Directory of the search index.
+   */
+  std::string _indexDir;
 };
 
 } // search
@@ -8,6 +8,9 @@
 
 #include <util/pipedprocess.h>
 #include <util/logutil.h>
+#include <util/shmring.h>
+
+#include <searchcommon/shmtransport.h>
 
 #include <SearchService.h>
 
@@ -38,11 +41,23 @@ public:
   {
     openPipe(_pipeFd2[0], _pipeFd2[1]);
 
+    try
+    {
+      _shm = std::make_shared<util::ShmRing>();
+    }
+    catch (const util::ShmRing::Failure& ex_)
+    {
+      LOG(warning)
+        << "Shared memory for the search service is not available, using "
+           "pipes: " << ex_.what();
+    }
+
     int pid = startProcess();
     if (pid == 0)
     {
       std::string inFd(std::to_string(_pipeFd[0]));
       std::string outFd(std::to_string(_pipeFd2[1]));
+      std::string shmFd(_shm ? std::to_string(_shm->inheritInChild()) : "0");
 
       std::string logLevelOpt("-Dcc.search.logLevel=");
       auto fmtSeverity = util::getSeverityLevel();
@@ -69,6 +84,7 @@ public:
         "-indexDB", _indexDatabase.c_str(),
         "-ipcInFd", inFd.c_str(),
         "-ipcOutFd", outFd.c_str(),
+        "-ipcShmFd", shmFd.c_str(),
         "-useSimpleFileLock",
         "-cleanupLocks",
         nullptr);
@@ -159,6 +175,24 @@ private:
    */
   void getClientInterface()
   {
+    if (_shm)
+    {
+      using Transport = cc::search::ShmTransport;
+      using ProtocolFactory =
+        apache::thrift::protocol::TBinaryProtocolFactoryT<Transport>;
+
+      std::shared_ptr<apache::thrift::transport::TTransport> trans(
+        new Transport(_shm, _pipeFd2[0], _pipeFd[1]));
+
+      ProtocolFactory protFactory;
+
+      _service.reset(new SearchServiceClient(
+        protFactory.getProtocol(trans),
+        protFactory.getProtocol(trans)));
+
+      return;
+    }
+
     using Transport = apache::thrift::transport::TFDTransport;
     using ProtocolFactory =
       apache::thrift::protocol::TBinaryProtocolFactoryT<Transport>;
@@ -187,6 +221,12 @@ private:
    */
   std::unique_ptr<SearchServiceIf> _service;
 
+  /**
+   * Shared memory for the thrift messages. If it couldn't be created then the
+   * messages go through the pipes.
+   */
+  std::shared_ptr<util::ShmRing> _shm;
+
   /**
    * Second pipe.
    */
@@ -0,0 +1,83 @@
+#ifndef CC_SERVICE_SUGGESTIONINDEX_H
+#define CC_SERVICE_SUGGESTIONINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cc
+{
+namespace service
+{
+namespace search
+{
+
+/**
+ * In-memory prefix index of a suggestion database.
+ *
+ * The entries are loaded from the prefix index file written by the search
+ * parser. They are kept in an array sorted by their lower case keys, so the
+ * entries of a prefix form a contiguous range. A segment tree over the weights
+ * gives the highest weighted entries of a range in O(k log n) time, no matter
+ * how many entries the prefix has.
+ */
+class SuggestionIndex
+{
+public:
+  /**
+   * Loads the prefix index from the given file. If the file can't be read,
+   * the index is empty and isLoaded() returns false.
+   */
+  SuggestionIndex(const std::string& path_);
+
+  /**
+   * Returns true if the prefix index file was loaded.
+   */
+  bool isLoaded() const;
+
+  /**
+   * Returns the texts of the highest weighted entries whose keys start with
+   * the lower case form of the given prefix.
+   *
+   * @param prefix_ the user input.
+   * @param limit_ the maximum number of results.
+   */
+  std::vector<std::string> suggest(
+    const std::string& prefix_,
+    std::size_t limit_) const;
+
+private:
+  struct Entry
+  {
+    std::string key;
+    std::string text;
+    std::uint64_t weight;
+  };
+
+  /**
+   * Returns the index of the highest weighted entry in [begin_, end_).
+   */
+  std::size_t maxEntry(std::size_t begin_, std::size_t end_) const;
+
+  /**
+   * Returns the one of two entry indices with the higher weight.
+   */
+  std::uint32_t heavier(std::uint32_t lhs_, std::uint32_t rhs_) const;
+
+  std::vector<Entry> _entries;
+
+  /**
+   * Bottom-up segment tree of entry indices: the leaves are at
+   * [_entries.size(), 2 * _entries.size()), and every inner node holds the
+   * heavier one of its children.
+   */
+  std::vector<std::uint32_t> _tree;
+
+  bool _loaded;
+};
+
+} // search
+} // service
+} // cc
+
+#endif // CC_SERVICE_SUGGESTIONINDEX_H
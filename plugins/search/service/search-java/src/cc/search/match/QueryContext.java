@@ -47,6 +47,10 @@ public class QueryContext {
    * Filter overlapping result lines.
    */
   private boolean _filterOverlapping = false;
+  /**
+   * Maximum number of matching lines per file or 0 for no limit.
+   */
+  private int _maxMatchesPerFile = 0;
   /**
    * Creates an empty context.
    */
@@ -139,4 +143,20 @@ public class QueryContext {
   public void setFilterOverlapping(boolean value_) {
     _filterOverlapping = value_;
   }
+  /**
+   * Getter for {@link QueryContext#_maxMatchesPerFile}.
+   * 
+   * @return {@link QueryContext#_maxMatchesPerFile}
+   */
+  public int getMaxMatchesPerFile() {
+    return _maxMatchesPerFile;
+  }
+  /**
+   * Setter for {@link QueryContext#_maxMatchesPerFile}.
+   * 
+   * @param value_ value for {@link QueryContext#_maxMatchesPerFile}.
+   */
+  public void setMaxMatchesPerFile(int value_) {
+    _maxMatchesPerFile = value_;
+  }
 }
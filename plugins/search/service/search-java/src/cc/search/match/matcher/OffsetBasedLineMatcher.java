@@ -138,10 +138,16 @@ class OffsetBasedLineMatcher implements ResultMatcher {
   public List<LineMatch> match() throws IOException {
     _tokenStream.reset();
     
+    // The rest of the token stream is not read after the last allowed match.
+    final int limit = _context.query.getMaxMatchesPerFile();
+
     ArrayList<LineMatch> matches = new ArrayList<>(100);
     LineMatch match = matchOne();
     while (match != null) {
       matches.add(match);
+      if (limit > 0 && matches.size() >= limit) {
+        break;
+      }
       match = matchOne();
     }
     _tokenStream.end();
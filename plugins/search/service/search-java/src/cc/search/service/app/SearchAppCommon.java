@@ -36,6 +36,7 @@ import org.apache.lucene.search.Filter;
 import org.apache.lucene.search.IndexSearcher;
 import org.apache.lucene.search.Query;
 import org.apache.lucene.search.ScoreDoc;
+import org.apache.lucene.search.Sort;
 import org.apache.lucene.search.TopDocs;
 import org.apache.lucene.store.FSDirectory;
 import org.apache.lucene.util.Version;
@@ -135,7 +136,18 @@ public abstract class SearchAppCommon implements AutoCloseable {
         match = filterOverlapping(match);
       }
 
-      return new SearchResultEntry(match, docsInfo);
+      final int limit = _query.getMaxMatchesPerFile();
+      final boolean moreMatches = limit > 0 && match.size() >= limit;
+      if (moreMatches && match.size() > limit) {
+        match = new ArrayList<>(match.subList(0, limit));
+      }
+
+      SearchResultEntry entry = new SearchResultEntry(match, docsInfo);
+      if (moreMatches) {
+        entry.setMoreMatches(true);
+      }
+
+      return entry;
     }
     
     /**
@@ -283,6 +295,26 @@ public abstract class SearchAppCommon implements AutoCloseable {
     return _searcher.search(query_, filter_, hitLimit_);
   }
 
+  /**
+   * Does a document search in the given order. Only the best hitLimit_
+   * documents are kept during the search.
+   *
+   * @param query_ Search query
+   * @param filter_ Search filter
+   * @param hitLimit_ Hit limit
+   * @param sort_ Order of the documents or null for relevance order.
+   * @return Matching document ids
+   * @throws IOException
+   */
+  protected TopDocs search(Query query_, Filter filter_, int hitLimit_,
+    Sort sort_) throws IOException {
+    if (sort_ == null) {
+      return search(query_, filter_, hitLimit_);
+    }
+
+    return _searcher.search(query_, filter_, hitLimit_, sort_);
+  }
+
   /**
    * Does a document search with the default search limit.
    *
@@ -342,9 +374,27 @@ public abstract class SearchAppCommon implements AutoCloseable {
    */
   protected TopDocs rangedSearch(Query query_, Filter filter_, int startIndex_,
     int endIndex_) throws IOException {
+    return rangedSearch(query_, filter_, startIndex_, endIndex_, null);
+  }
+
+  /**
+   * Does a ranged document search in the given order. The search keeps only
+   * the documents up to the end of the range (top-k).
+   * 
+   * @param query_ Search query
+   * @param filter_ Search filter
+   * @param startIndex_ Start index
+   * @param endIndex_ End index (inclusive)
+   * @param sort_ Order of the documents or null for relevance order.
+   * @return Matching document ids
+   * @throws IOException
+   */
+  protected TopDocs rangedSearch(Query query_, Filter filter_, int startIndex_,
+    int endIndex_, Sort sort_) throws IOException {
     
     // Run the query
-    TopDocs result = search(query_, filter_);
+    TopDocs result = search(query_, filter_,
+      Math.max(1, Math.min(endIndex_ + 1, DEFAULT_HIT_LIMIT)), sort_);
 
     if (result.scoreDocs.length <= startIndex_) {
       // Empty result
@@ -18,6 +18,7 @@ import cc.service.search.SearchResult;
 import cc.service.search.SearchResultEntry;
 import cc.service.search.SearchException;
 import cc.service.search.SearchOptions;
+import cc.service.search.SearchOrder;
 import cc.service.search.SearchParams;
 import cc.service.search.SearchSuggestionParams;
 import cc.service.search.SearchSuggestions;
@@ -38,6 +39,8 @@ import org.apache.lucene.search.Filter;
 import org.apache.lucene.search.Query;
 import org.apache.lucene.search.QueryWrapperFilter;
 import org.apache.lucene.search.RegexpQuery;
+import org.apache.lucene.search.Sort;
+import org.apache.lucene.search.SortField;
 import org.apache.lucene.search.TopDocs;
 import org.apache.thrift.TException;
 
@@ -95,6 +98,22 @@ abstract class SearchHandler extends SearchAppCommon
     return new QueryWrapperFilter(filterQuery);
   }
   
+  /**
+   * Construct the sort order for a search query.
+   * 
+   * @param params_ search parameters.
+   * @return a sort order or null for relevance order.
+   */
+  private static Sort getSortForSearch(SearchParams params_) {
+    if (params_.isSetOrder() && params_.order == SearchOrder.Recency) {
+      return new Sort(
+        new SortField(IndexFields.modifiedField, SortField.Type.LONG, true),
+        SortField.FIELD_SCORE);
+    }
+
+    return null;
+  }
+  
   /**
    * Does a full text search.
    * 
@@ -112,13 +131,14 @@ abstract class SearchHandler extends SearchAppCommon
     Date start = new Date();
     
     final Filter filter = getFilterForSearch(params_);
+    final Sort sort = getSortForSearch(params_);
     TopDocs docs;
     
     if (params_.isSetRange()) {
       docs = rangedSearch(context_.get(), filter, (int) params_.range.start,
-        (int) (params_.range.start + params_.range.maxSize - 1));
+        (int) (params_.range.start + params_.range.maxSize - 1), sort);
     } else {
-      docs = search(context_.get(), filter);
+      docs = search(context_.get(), filter, DEFAULT_HIT_LIMIT, sort);
     }
     
     _log.log(Level.INFO, "Got {1} doc(s) in {0} total milliseconds",
@@ -182,6 +202,10 @@ abstract class SearchHandler extends SearchAppCommon
           params_.query, collector), collector);
       }
       
+      if (params_.isSetMaxMatchesPerFile()) {
+        qcontext.setMaxMatchesPerFile(Math.max(0, params_.maxMatchesPerFile));
+      }
+      
       if (qcontext.isEmpty()) {
         // empty search
         return new SearchResult(0, null);
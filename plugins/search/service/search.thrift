@@ -42,6 +42,21 @@ struct SearchType
   2:string name
 }
 
+/**
+ * Order of the files in a search result.
+ */
+enum SearchOrder
+{
+  /**
+   * The most relevant files first.
+   */
+  Relevance = 0,
+  /**
+   * The most recently modified files first.
+   */
+  Recency = 1
+}
+
 /**
  * Describes a search range.
  */
@@ -92,7 +107,16 @@ struct SearchParams
   /**
    * Optional filter.
    */
-  4: optional SearchFilter filter
+  4: optional SearchFilter filter,
+  /**
+   * Order of the files. The default is Relevance.
+   */
+  5: optional SearchOrder order,
+  /**
+   * Maximum number of matching lines per file. The server may use a lower
+   * limit.
+   */
+  6: optional i32 maxMatchesPerFile
 }
 
 /**
@@ -172,6 +196,11 @@ struct SearchResultEntry
    * File informations
    */
   2:project.FileInfo finfo,
+  /**
+   * True if the matching lines were cut at the per-file limit, so the file
+   * may have more matches.
+   */
+  3:optional bool moreMatches
 }
 
 /**
@@ -186,7 +215,12 @@ struct SearchResult
   /**
    * The results in the actual range: [firstFileIndex, lastFileIndex]
    */
-  2:list<SearchResultEntry> results
+  2:list<SearchResultEntry> results,
+  /**
+   * True if the result has less files than the range because the server
+   * limit of matching lines per response was reached.
+   */
+  3:optional bool truncated
 }
 
 /**
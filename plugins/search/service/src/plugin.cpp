@@ -1,6 +1,14 @@
 #include <webserver/pluginhelper.h>
 #include <service/searchservice.h>
 
+namespace
+{
+
+const std::unordered_set<std::string> pureMethods{
+  "search", "searchFile", "getSearchTypes", "suggest"};
+
+} // namespace
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wreturn-type-c-linkage"
 extern "C"
@@ -8,6 +16,36 @@ extern "C"
   boost::program_options::options_description getOptions()
   {
     boost::program_options::options_description description("Search Plugin");
+
+    description.add_options()
+      ("search-processes",
+        boost::program_options::value<int>()->default_value(1),
+        "Number of Java search processes serving the text, definition and "
+        "log searches and the suggestions. Concurrent requests are dispatched "
+        "to the least loaded process, and a process which dies is restarted.")
+      ("search-chunk-size",
+        boost::program_options::value<int>()->default_value(20),
+        "The text searches fetch their results from the Java search process "
+        "in chunks of this many files. No further chunks are fetched once the "
+        "response has search-max-result-lines matching lines. Each chunk runs "
+        "the whole Lucene query again with a top-k covering every file up to "
+        "the end of the chunk, so small chunks make long results expensive.")
+      ("search-max-result-lines",
+        boost::program_options::value<int>()->default_value(0),
+        "Maximum number of matching lines in a search response (0 means no "
+        "limit). The last file is returned whole, so this limit may be "
+        "exceeded by the lines of one file. A response which reaches the "
+        "limit has fewer files than requested and it is marked truncated, the "
+        "client continues from the first file it did not receive.")
+      ("search-max-matches-per-file",
+        boost::program_options::value<int>()->default_value(0),
+        "Maximum number of matching lines of a file in a search result (0 "
+        "means no limit). The matching of a file stops at this limit.")
+      ("search-cache-size",
+        boost::program_options::value<int>()->default_value(64),
+        "Size limit of the text search result cache in megabytes (0 disables "
+        "the cache). The cache is dropped when the search index changes.");
+
     return description;
   }
 
@@ -18,7 +56,7 @@ extern "C"
     cc::webserver::registerPluginSimple(
       context_,
       pluginHandler_,
-      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(Search, search),
+      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(Search, search, pureMethods),
       "SearchService");
   }
 }
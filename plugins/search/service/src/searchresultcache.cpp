@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cctype>
+
+#include <util/logutil.h>
+
+#include <service/searchresultcache.h>
+
+namespace
+{
+
+/**
+ * Trims the leading and trailing whitespace of the string. The inner
+ * whitespace is kept, because it may be significant in a query or a regex.
+ * The filters are also lower cased, like the Java search does.
+ */
+std::string normalise(const std::string& str_, bool lowerCase_)
+{
+  auto isSpace = [](char c_) {
+    return std::isspace(static_cast<unsigned char>(c_));
+  };
+
+  auto begin = std::find_if_not(str_.begin(), str_.end(), isSpace);
+  auto end = std::find_if_not(str_.rbegin(), str_.rend(), isSpace).base();
+
+  std::string result(begin, begin < end ? end : begin);
+
+  if (lowerCase_)
+    std::transform(result.begin(), result.end(), result.begin(),
+      [](char c_) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c_)));
+      });
+
+  return result;
+}
+
+/**
+ * The cache statistics are logged after this many requests.
+ */
+const std::uint64_t statisticsInterval = 100;
+
+} // anonymous namespace
+
+namespace cc
+{
+namespace service
+{
+namespace search
+{
+
+SearchResultCache::SearchResultCache(std::size_t maxBytes_)
+  : _maxBytes(maxBytes_),
+    _bytes(0),
+    _hits(0),
+    _misses(0),
+    _evictions(0),
+    _invalidations(0)
+{
+}
+
+std::string SearchResultCache::makeKey(
+  const SearchParams& params_,
+  std::int64_t maxMatchesPerFile_)
+{
+  std::string key;
+
+  key += std::to_string(params_.options);
+  key += '\0';
+  key += std::to_string(params_.__isset.order
+    ? static_cast<int>(params_.order)
+    : static_cast<int>(SearchOrder::Relevance));
+  key += '\0';
+  key += std::to_string(maxMatchesPerFile_);
+  key += '\0';
+
+  if (params_.__isset.filter)
+  {
+    key += normalise(params_.filter.fileFilter, true);
+    key += '\0';
+    key += normalise(params_.filter.dirFilter, true);
+  }
+  else
+    key += '\0';
+
+  key += '\0';
+  key += normalise(params_.query, false);
+
+  return key;
+}
+
+std::shared_ptr<SearchResultCache::Entry> SearchResultCache::get(
+  const std::string& key_,
+  const std::string& version_)
+{
+  if (!_maxBytes)
+    return std::make_shared<Entry>();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if (version_ != _version)
+  {
+    if (!_items.empty())
+    {
+      LOG(info)
+        << "Search index changed, dropping " << _items.size()
+        << " cached search result(s).";
+      ++_invalidations;
+    }
+
+    _items.clear();
+    _lru.clear();
+    _bytes = 0;
+    _version = version_;
+  }
+
+  auto it = _items.find(key_);
+  if (it != _items.end())
+  {
+    _lru.splice(_lru.begin(), _lru, it->second.lruPos);
+    return it->second.entry;
+  }
+
+  _lru.push_front(key_);
+
+  Item& item = _items[key_];
+  item.entry = std::make_shared<Entry>();
+  item.bytes = 0;
+  item.lruPos = _lru.begin();
+
+  return item.entry;
+}
+
+void SearchResultCache::updateSize(const std::string& key_, std::size_t bytes_)
+{
+  if (!_maxBytes)
+    return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  auto it = _items.find(key_);
+  if (it == _items.end())
+    return;
+
+  _bytes = _bytes - it->second.bytes + bytes_;
+  it->second.bytes = bytes_;
+
+  evict();
+}
+
+void SearchResultCache::evict()
+{
+  // The most recently used entry is kept even if it is larger than the limit,
+  // because it is being served.
+  while (_bytes > _maxBytes && _lru.size() > 1)
+  {
+    auto it = _items.find(_lru.back());
+
+    _bytes -= it->second.bytes;
+    _items.erase(it);
+    _lru.pop_back();
+
+    ++_evictions;
+  }
+}
+
+void SearchResultCache::recordRequest(bool hit_)
+{
+  if (!_maxBytes)
+    return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if (hit_)
+    ++_hits;
+  else
+    ++_misses;
+
+  const std::uint64_t requests = _hits + _misses;
+  if (requests % statisticsInterval == 0)
+    LOG(info)
+      << "Search result cache: " << requests << " request(s), hit rate "
+      << (100 * _hits / requests) << "%, " << _items.size() << " entries, "
+      << _bytes << " bytes, " << _evictions << " eviction(s), "
+      << _invalidations << " invalidation(s).";
+}
+
+std::size_t SearchResultCache::entrySize(const SearchResultEntry& entry_)
+{
+  // The fixed costs approximate the sizes of the structures and the
+  // allocation overhead.
+  std::size_t size = sizeof(SearchResultEntry)
+    + entry_.finfo.id.size()
+    + entry_.finfo.name.size()
+    + entry_.finfo.path.size()
+    + entry_.finfo.type.size();
+
+  for (const LineMatch& line : entry_.matchingLines)
+    size += sizeof(LineMatch) + line.text.size() + line.range.file.size();
+
+  return size;
+}
+
+} // search
+} // service
+} // cc
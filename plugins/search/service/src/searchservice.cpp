@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <limits>
 #include <cctype>
 #include <memory>
@@ -105,34 +106,181 @@ SearchServiceHandler::SearchServiceHandler(
   const cc::webserver::ServerContext& context_) :
     _db(db_)
 {
-  _javaProcess.reset(new ServiceProcess(*datadir_ + "/search",
-                                        context_.compassRoot));
+  const std::size_t processes = context_.options.count("search-processes")
+    ? std::max(context_.options["search-processes"].as<int>(), 1)
+    : 1;
+
+  auto intOption = [&context_](const char* name_, int default_)
+  {
+    return context_.options.count(name_)
+      ? std::max(context_.options[name_].as<int>(), 0)
+      : default_;
+  };
+
+  _chunkSize = std::max(intOption("search-chunk-size", 20), 1);
+  _maxResultLines = intOption("search-max-result-lines", 0);
+  _maxMatchesPerFile = intOption("search-max-matches-per-file", 0);
+
+  const std::string indexDir = *datadir_ + "/search";
+  _indexDir = indexDir;
+
+  const int cacheSize = intOption("search-cache-size", 64);
+  _resultCache.reset(new SearchResultCache(
+    static_cast<std::size_t>(cacheSize) * 1024 * 1024));
+  const std::string compassRoot = context_.compassRoot;
+
+  _javaProcesses.reset(new util::ProcessPool<ServiceProcess>(
+    processes,
+    [indexDir, compassRoot](std::size_t)
+    {
+      return std::unique_ptr<ServiceProcess>(
+        new ServiceProcess(indexDir, compassRoot));
+    }));
+
+  _fileNameSuggestions.reset(
+    new SuggestionIndex(indexDir + "/suggest/filename.prefix"));
+  _symbolSuggestions.reset(
+    new SuggestionIndex(indexDir + "/suggest/symbols.prefix"));
 }
 
 void SearchServiceHandler::search(
   SearchResult& _return,
   const SearchParams& params_)
 {
-  std::lock_guard<std::mutex> lock(_javaProcessMutex);
+  // The Java side returns at most this many files, see DEFAULT_HIT_LIMIT.
+  const std::int64_t hitLimit = 100;
+
+  const std::size_t first = params_.__isset.range
+    ? std::max<std::int64_t>(params_.range.start, 0) : 0;
+  const std::size_t last = first + (params_.__isset.range
+    ? std::max<std::int64_t>(params_.range.maxSize, 0) : hitLimit);
+
+  const std::int64_t maxMatchesPerFile = minLimit(
+    params_.__isset.maxMatchesPerFile ? params_.maxMatchesPerFile : 0,
+    _maxMatchesPerFile);
+
+  // The pages are served from the cached files of the same query, which are
+  // fetched on demand. Concurrent requests of the same query wait for each
+  // other, so the second one is served from the cache.
+  const std::string key
+    = SearchResultCache::makeKey(params_, maxMatchesPerFile);
+  std::shared_ptr<SearchResultCache::Entry> entry
+    = _resultCache->get(key, getIndexVersion());
+
+  std::lock_guard<std::mutex> lock(entry->mutex);
+
+  // The results are fetched in chunks, so the matching stops as soon as the
+  // response is large enough, and no single message holds the whole result.
+  SearchParams chunkParams = params_;
+  chunkParams.__isset.range = true;
+  chunkParams.__set_maxMatchesPerFile(
+    static_cast<std::int32_t>(maxMatchesPerFile));
 
   try
   {
     auto start = std::chrono::steady_clock::now();
 
-    _javaProcess->search(_return, params_);
+    bool hit = true;
+    std::int64_t lines = 0;
+
+    for (std::size_t i = first;
+      i < std::min(last, entry->results.size());
+      ++i)
+    {
+      lines += entry->results[i].matchingLines.size();
+    }
+
+    while (entry->results.size() < last &&
+      (entry->totalFiles < 0 || entry->fetchedFiles < entry->totalFiles))
+    {
+      if (_maxResultLines && lines >= _maxResultLines)
+      {
+        _return.__set_truncated(true);
+        break;
+      }
+
+      chunkParams.range.start = entry->fetchedFiles;
+      chunkParams.range.maxSize = _chunkSize;
+
+      SearchResult chunk;
+      _javaProcesses->call([&](ServiceProcess& process_, std::uint64_t id_){
+        LOG(debug)
+          << "Search request " << id_ << ", files from "
+          << chunkParams.range.start;
+        process_.search(chunk, chunkParams);
+      });
+
+      hit = false;
+      entry->fetchedFiles += _chunkSize;
+      entry->totalFiles = chunk.totalFiles;
+
+      for (SearchResultEntry& result : chunk.results)
+      {
+        if (entry->results.size() >= first && entry->results.size() < last)
+          lines += result.matchingLines.size();
+
+        entry->bytes += SearchResultCache::entrySize(result);
+        entry->results.push_back(std::move(result));
+      }
+    }
+
+    _return.totalFiles = std::max<std::int64_t>(entry->totalFiles, 0);
+    _return.results.clear();
+
+    // The line limit is applied to the page itself too, so a page served from
+    // the cache is not larger than a freshly fetched one.
+    lines = 0;
+    for (std::size_t i = first;
+      i < std::min(last, entry->results.size());
+      ++i)
+    {
+      if (_maxResultLines && lines >= _maxResultLines)
+      {
+        _return.__set_truncated(true);
+        break;
+      }
+
+      lines += entry->results[i].matchingLines.size();
+      _return.results.push_back(entry->results[i]);
+    }
+
+    _resultCache->updateSize(key, entry->bytes);
+    _resultCache->recordRequest(hit);
 
     auto end = std::chrono::steady_clock::now();
     auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
 
-    LOG(info) << "Search time: " << dur.count() << " milliseconds.";
+    LOG(info)
+      << "Search time: " << dur.count() << " milliseconds, "
+      << _return.results.size() << " file(s), " << lines << " line(s)"
+      << (hit ? " from the cache." : ".");
   }
-  catch (const ServiceProcess::ProcessDied&)
+  catch (const util::ProcessPool<ServiceProcess>::Unavailable&)
   {
-    LOG(error) << "Java search service died! Terminating server...";
+    LOG(error) << "Java search service keeps dying! Terminating server...";
     ::abort();
   }
 }
 
+std::string SearchServiceHandler::getIndexVersion() const
+{
+  // The parser recreates the index directory and Lucene writes a new
+  // segments file on every commit, so their modification times change when
+  // the index is rebuilt.
+  boost::system::error_code ec;
+  std::string version;
+
+  std::time_t dirTime = fs::last_write_time(_indexDir, ec);
+  version += ec ? "-" : std::to_string(dirTime);
+  version += ':';
+
+  std::time_t segmentsTime
+    = fs::last_write_time(_indexDir + "/segments.gen", ec);
+  version += ec ? "-" : std::to_string(segmentsTime);
+
+  return version;
+}
+
 void SearchServiceHandler::searchFile(
     FileSearchResult& _return,
     const SearchParams&     params_)
@@ -255,26 +403,53 @@ void SearchServiceHandler::pleaseStop()
 void SearchServiceHandler::suggest(SearchSuggestions& _return,
   const SearchSuggestionParams& params_)
 {
-  std::lock_guard<std::mutex> lock(_javaProcessMutex);
+  const SuggestionIndex* index = nullptr;
+  if (params_.options & SearchOptions::SearchForFileName)
+    index = _fileNameSuggestions.get();
+  else if (params_.options & SearchOptions::SearchInDefs)
+    index = _symbolSuggestions.get();
+
+  if (index && index->isLoaded())
+  {
+    if (params_.__isset.tag)
+      _return.__set_tag(params_.tag);
+
+    _return.results = index->suggest(
+      params_.userInput,
+      static_cast<std::size_t>(std::max<std::int64_t>(params_.limit, 0)));
+
+    return;
+  }
 
   try
   {
     auto start = std::chrono::steady_clock::now();
 
-    _javaProcess->suggest(_return, params_);
+    _javaProcesses->call([&](ServiceProcess& process_, std::uint64_t id_){
+      LOG(debug) << "Suggest request " << id_;
+      process_.suggest(_return, params_);
+    });
 
     auto end = std::chrono::steady_clock::now();
     auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
 
     LOG(info) << "Suggest time: " << dur.count() << " milliseconds.";
   }
-  catch (const ServiceProcess::ProcessDied&)
+  catch (const util::ProcessPool<ServiceProcess>::Unavailable&)
   {
-    LOG(error) << "Java search service died! Terminating server...";
+    LOG(error) << "Java search service keeps dying! Terminating server...";
     ::abort();
   }
 }
 
+std::int64_t SearchServiceHandler::minLimit(std::int64_t a_, std::int64_t b_)
+{
+  if (a_ <= 0)
+    return std::max<std::int64_t>(b_, 0);
+
+  return b_ <= 0 ? a_ : std::min(a_, b_);
+}
+
 void SearchServiceHandler::validateRegexp(const std::string& regexp_)
 {
   try
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <queue>
+#include <tuple>
+
+#include <util/logutil.h>
+
+#include <service/suggestionindex.h>
+
+namespace cc
+{
+namespace service
+{
+namespace search
+{
+
+SuggestionIndex::SuggestionIndex(const std::string& path_) : _loaded(false)
+{
+  std::ifstream file(path_);
+  if (!file)
+  {
+    LOG(debug) << "No suggestion prefix index at " << path_;
+    return;
+  }
+
+  std::string line;
+  while (std::getline(file, line))
+  {
+    std::size_t keyPos = line.find('\t');
+    std::size_t textPos = keyPos == std::string::npos
+      ? keyPos
+      : line.find('\t', keyPos + 1);
+
+    if (textPos == std::string::npos)
+      continue;
+
+    Entry entry;
+
+    try
+    {
+      entry.weight = std::stoull(line.substr(0, keyPos));
+    }
+    catch (const std::exception&)
+    {
+      continue;
+    }
+
+    entry.key = line.substr(keyPos + 1, textPos - keyPos - 1);
+    entry.text = line.substr(textPos + 1);
+
+    _entries.push_back(std::move(entry));
+  }
+
+  std::sort(_entries.begin(), _entries.end(),
+    [](const Entry& lhs_, const Entry& rhs_)
+    {
+      return std::tie(lhs_.key, lhs_.text) < std::tie(rhs_.key, rhs_.text);
+    });
+
+  // The same file name occurs in many directories: these are merged keeping
+  // the highest weight.
+  auto last = std::unique(_entries.begin(), _entries.end(),
+    [](Entry& lhs_, const Entry& rhs_)
+    {
+      if (lhs_.key != rhs_.key || lhs_.text != rhs_.text)
+        return false;
+
+      lhs_.weight = std::max(lhs_.weight, rhs_.weight);
+      return true;
+    });
+  _entries.erase(last, _entries.end());
+  _entries.shrink_to_fit();
+
+  const std::size_t size = _entries.size();
+  _tree.resize(2 * size);
+
+  for (std::size_t i = 0; i < size; ++i)
+    _tree[size + i] = i;
+
+  for (std::size_t i = size; i-- > 1;)
+    _tree[i] = heavier(_tree[2 * i], _tree[2 * i + 1]);
+
+  _loaded = true;
+
+  LOG(info) << "Loaded " << size << " suggestions from " << path_;
+}
+
+bool SuggestionIndex::isLoaded() const
+{
+  return _loaded;
+}
+
+std::vector<std::string> SuggestionIndex::suggest(
+  const std::string& prefix_,
+  std::size_t limit_) const
+{
+  std::vector<std::string> result;
+
+  std::string prefix = prefix_;
+  std::transform(prefix.begin(), prefix.end(), prefix.begin(),
+    [](unsigned char c_) { return std::tolower(c_); });
+
+  auto begin = std::lower_bound(_entries.begin(), _entries.end(), prefix,
+    [](const Entry& entry_, const std::string& prefix_)
+    {
+      return entry_.key < prefix_;
+    });
+
+  auto end = std::upper_bound(begin, _entries.end(), prefix,
+    [](const std::string& prefix_, const Entry& entry_)
+    {
+      return entry_.key.compare(0, prefix_.size(), prefix_) > 0;
+    });
+
+  // Ranges of entries ordered by their highest weight. Taking the heaviest
+  // entry of a range splits it into the ranges before and after the entry.
+  typedef std::tuple<std::uint64_t, std::size_t, std::size_t, std::size_t>
+    Range;
+  std::priority_queue<Range> ranges;
+
+  auto push = [&, this](std::size_t begin_, std::size_t end_)
+  {
+    if (begin_ < end_)
+    {
+      std::size_t max = maxEntry(begin_, end_);
+      ranges.emplace(_entries[max].weight, max, begin_, end_);
+    }
+  };
+
+  push(begin - _entries.begin(), end - _entries.begin());
+
+  while (!ranges.empty() && result.size() < limit_)
+  {
+    std::size_t max, rangeBegin, rangeEnd;
+    std::tie(std::ignore, max, rangeBegin, rangeEnd) = ranges.top();
+    ranges.pop();
+
+    if (std::find(result.begin(), result.end(), _entries[max].text)
+        == result.end())
+      result.push_back(_entries[max].text);
+
+    push(rangeBegin, max);
+    push(max + 1, rangeEnd);
+  }
+
+  return result;
+}
+
+std::size_t SuggestionIndex::maxEntry(std::size_t begin_, std::size_t end_) const
+{
+  const std::size_t size = _entries.size();
+  std::uint32_t max = begin_;
+
+  for (begin_ += size, end_ += size; begin_ < end_; begin_ /= 2, end_ /= 2)
+  {
+    if (begin_ & 1)
+      max = heavier(max, _tree[begin_++]);
+    if (end_ & 1)
+      max = heavier(max, _tree[--end_]);
+  }
+
+  return max;
+}
+
+std::uint32_t SuggestionIndex::heavier(
+  std::uint32_t lhs_,
+  std::uint32_t rhs_) const
+{
+  // On equal weights the entry with the shorter key (i.e. the lower index) is
+  // preferred.
+  return _entries[rhs_].weight > _entries[lhs_].weight ||
+    (_entries[rhs_].weight == _entries[lhs_].weight && rhs_ < lhs_)
+    ? rhs_ : lhs_;
+}
+
+} // search
+} // service
+} // cc
@@ -0,0 +1,155 @@
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <service/searchresultcache.h>
+
+using namespace cc::service::search;
+
+namespace
+{
+
+SearchParams makeParams(const std::string& query_)
+{
+  SearchParams params;
+  params.__set_options(SearchOptions::SearchInSource);
+  params.__set_query(query_);
+  return params;
+}
+
+SearchResultEntry makeEntry(const std::string& text_)
+{
+  LineMatch line;
+  line.__set_text(text_);
+
+  SearchResultEntry entry;
+  entry.matchingLines.push_back(line);
+  return entry;
+}
+
+} // anonymous namespace
+
+TEST(SearchResultCacheTest, KeyIgnoresPagingAndOuterWhitespace)
+{
+  SearchParams params = makeParams("foo bar");
+  const std::string key = SearchResultCache::makeKey(params, 0);
+
+  SearchRange range;
+  range.__set_start(100);
+  range.__set_maxSize(20);
+  params.__set_range(range);
+  EXPECT_EQ(SearchResultCache::makeKey(params, 0), key);
+
+  EXPECT_EQ(SearchResultCache::makeKey(makeParams("  foo bar\t"), 0), key);
+}
+
+TEST(SearchResultCacheTest, KeyKeepsInnerWhitespace)
+{
+  EXPECT_NE(
+    SearchResultCache::makeKey(makeParams("foo bar"), 0),
+    SearchResultCache::makeKey(makeParams("foo  bar"), 0));
+}
+
+TEST(SearchResultCacheTest, KeyDependsOnSearchParameters)
+{
+  const SearchParams params = makeParams("foo");
+  const std::string key = SearchResultCache::makeKey(params, 0);
+
+  EXPECT_NE(SearchResultCache::makeKey(makeParams("Foo"), 0), key);
+  EXPECT_NE(SearchResultCache::makeKey(params, 10), key);
+
+  SearchParams other = params;
+  other.__set_options(SearchOptions::SearchInDefs);
+  EXPECT_NE(SearchResultCache::makeKey(other, 0), key);
+
+  other = params;
+  other.__set_order(SearchOrder::Recency);
+  EXPECT_NE(SearchResultCache::makeKey(other, 0), key);
+
+  // The filters are case insensitive.
+  SearchFilter filter;
+  filter.__set_fileFilter(".*\\.CPP");
+  other = params;
+  other.__set_filter(filter);
+  const std::string filteredKey = SearchResultCache::makeKey(other, 0);
+  EXPECT_NE(filteredKey, key);
+
+  filter.__set_fileFilter(".*\\.cpp");
+  other.__set_filter(filter);
+  EXPECT_EQ(SearchResultCache::makeKey(other, 0), filteredKey);
+}
+
+TEST(SearchResultCacheTest, ReturnsCachedEntries)
+{
+  SearchResultCache cache(1024);
+
+  std::shared_ptr<SearchResultCache::Entry> entry = cache.get("a", "1");
+  EXPECT_EQ(entry->totalFiles, -1);
+  EXPECT_TRUE(entry->results.empty());
+
+  entry->totalFiles = 1;
+  EXPECT_EQ(cache.get("a", "1"), entry);
+  EXPECT_NE(cache.get("b", "1"), entry);
+}
+
+TEST(SearchResultCacheTest, DropsEntriesOfOldIndexVersion)
+{
+  SearchResultCache cache(1024);
+
+  std::shared_ptr<SearchResultCache::Entry> entry = cache.get("a", "1");
+  EXPECT_NE(cache.get("a", "2"), entry);
+}
+
+TEST(SearchResultCacheTest, EvictsLeastRecentlyUsedEntries)
+{
+  SearchResultCache cache(100);
+
+  std::shared_ptr<SearchResultCache::Entry> a = cache.get("a", "1");
+  cache.updateSize("a", 40);
+  std::shared_ptr<SearchResultCache::Entry> b = cache.get("b", "1");
+  cache.updateSize("b", 40);
+
+  // Using a makes b the least recently used entry.
+  EXPECT_EQ(cache.get("a", "1"), a);
+
+  cache.get("c", "1");
+  cache.updateSize("c", 40);
+
+  EXPECT_EQ(cache.get("a", "1"), a);
+  EXPECT_NE(cache.get("b", "1"), b);
+}
+
+TEST(SearchResultCacheTest, KeepsEntryBeingServed)
+{
+  SearchResultCache cache(100);
+
+  cache.get("a", "1");
+  cache.updateSize("a", 10);
+
+  // An entry larger than the whole cache evicts the others, but not itself.
+  std::shared_ptr<SearchResultCache::Entry> big = cache.get("big", "1");
+  cache.updateSize("big", 1000);
+
+  EXPECT_EQ(cache.get("big", "1"), big);
+}
+
+TEST(SearchResultCacheTest, DisabledCacheStoresNothing)
+{
+  SearchResultCache cache(0);
+
+  std::shared_ptr<SearchResultCache::Entry> entry = cache.get("a", "1");
+  cache.updateSize("a", 10);
+
+  EXPECT_NE(cache.get("a", "1"), entry);
+}
+
+TEST(SearchResultCacheTest, EntrySizeGrowsWithContent)
+{
+  const std::size_t small = SearchResultCache::entrySize(makeEntry("x"));
+  const std::size_t large = SearchResultCache::entrySize(
+    makeEntry(std::string(1000, 'x')));
+
+  EXPECT_GT(small, 0u);
+  EXPECT_GE(large, small + 999);
+}
@@ -0,0 +1,111 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <service/suggestionindex.h>
+
+namespace fs = boost::filesystem;
+
+using namespace cc::service::search;
+
+class SuggestionIndexTest : public ::testing::Test
+{
+protected:
+  virtual void SetUp() override
+  {
+    _path = (fs::temp_directory_path() / fs::unique_path()).string();
+
+    // The lines are "<weight>\t<lower case key>\t<text>".
+    std::ofstream(_path)
+      << "5\tmain.cpp\tmain.cpp\n"
+      << "9\tmakefile\tMakefile\n"
+      << "1\tmap.h\tmap.h\n"
+      << "7\tmain.cpp\tmain.cpp\n"
+      << "3\tparser.cpp\tparser.cpp\n"
+      << "not a weight\tmangled\tmangled\n"
+      << "missing text\n";
+  }
+
+  virtual void TearDown() override
+  {
+    fs::remove(_path);
+  }
+
+  std::string _path;
+};
+
+TEST_F(SuggestionIndexTest, MissingFile)
+{
+  SuggestionIndex index(_path + ".missing");
+
+  EXPECT_FALSE(index.isLoaded());
+  EXPECT_TRUE(index.suggest("m", 10).empty());
+}
+
+TEST_F(SuggestionIndexTest, SuggestsByWeight)
+{
+  SuggestionIndex index(_path);
+  ASSERT_TRUE(index.isLoaded());
+
+  // The duplicates are merged keeping their highest weight, and the invalid
+  // lines are skipped.
+  EXPECT_EQ(
+    index.suggest("m", 10),
+    std::vector<std::string>({"Makefile", "main.cpp", "map.h"}));
+
+  EXPECT_EQ(
+    index.suggest("ma", 2),
+    std::vector<std::string>({"Makefile", "main.cpp"}));
+}
+
+TEST_F(SuggestionIndexTest, PrefixIsCaseInsensitive)
+{
+  SuggestionIndex index(_path);
+
+  EXPECT_EQ(
+    index.suggest("MAI", 10),
+    std::vector<std::string>({"main.cpp"}));
+  EXPECT_EQ(
+    index.suggest("Par", 10),
+    std::vector<std::string>({"parser.cpp"}));
+}
+
+TEST_F(SuggestionIndexTest, NoMatches)
+{
+  SuggestionIndex index(_path);
+
+  EXPECT_TRUE(index.suggest("x", 10).empty());
+  EXPECT_TRUE(index.suggest("main.cppx", 10).empty());
+  EXPECT_TRUE(index.suggest("m", 0).empty());
+}
+
+TEST_F(SuggestionIndexTest, EmptyPrefixMatchesEverything)
+{
+  SuggestionIndex index(_path);
+
+  EXPECT_EQ(
+    index.suggest("", 10),
+    std::vector<std::string>({"Makefile", "main.cpp", "parser.cpp", "map.h"}));
+}
+
+TEST_F(SuggestionIndexTest, LargeIndex)
+{
+  {
+    std::ofstream file(_path, std::ios::trunc);
+    for (int i = 0; i < 10000; ++i)
+      file << i << "\tkey" << i << "\tkey" << i << '\n';
+  }
+
+  SuggestionIndex index(_path);
+
+  EXPECT_EQ(
+    index.suggest("key", 3),
+    std::vector<std::string>({"key9999", "key9998", "key9997"}));
+  EXPECT_EQ(
+    index.suggest("key12", 2),
+    std::vector<std::string>({"key1299", "key1298"}));
+}
@@ -17,6 +17,8 @@ function (ObjectStoreModel, BorderContainer, declare, Memory, Observable, topic,
 
   var moreSize = 5;
   var moreText = 'More ...';
+  var truncatedText = 'More files ... (the response was cut by the server '
+    + 'at its limit of matching lines)';
 
   var IconTree = declare([HtmlTree, TooltipTreeMixin], {
     getIconClass : function (item, opened) {
@@ -120,7 +122,11 @@ function (ObjectStoreModel, BorderContainer, declare, Memory, Observable, topic,
         showRoot    : false,
         openOnClick : true,
         onClick     : function (item, node, event) {
-          if (item.name === moreText) {
+          if (item.name === truncatedText) {
+            that._store.remove(item.id);
+            that._loadSearch(
+              that._currentQueryData, item.start, item.maxSize);
+          } else if (item.name === moreText) {
             that._store.remove(item.id);
             
             that._moreMap[item.parent].splice(0, moreSize).forEach(
@@ -228,8 +234,12 @@ function (ObjectStoreModel, BorderContainer, declare, Memory, Observable, topic,
      * - fileFilter: File name filter. (optional)
      * - dirFilter: Directory (path) filter. (optional)
      * - searchType: A value from SearchOptions enum type.
+     * @param {Number} start The index of the first file to load. By default
+     * the first file of the current page. (optional)
+     * @param {Number} maxSize The number of files to load. By default the size
+     * of the page. (optional)
      */
-    _loadSearch : function(data) {
+    _loadSearch : function(data, start, maxSize) {
       var that = this;
   
       //--- Query search results ---//
@@ -241,8 +251,10 @@ function (ObjectStoreModel, BorderContainer, declare, Memory, Observable, topic,
       var range  = new SearchRange();
       var filter = new SearchFilter();
   
-      range.start   = (pageNumber - 1) * pageSize;
-      range.maxSize = pageSize;
+      var continued = start !== undefined;
+
+      range.start   = continued ? start : (pageNumber - 1) * pageSize;
+      range.maxSize = continued ? maxSize : pageSize;
   
       filter.fileFilter = data.fileFilter || '';
       filter.dirFilter  = data.dirFilter  || '';
@@ -254,7 +266,8 @@ function (ObjectStoreModel, BorderContainer, declare, Memory, Observable, topic,
   
       //--- Build new tree ---//
   
-      this._moreMap = {};
+      if (!continued)
+        this._moreMap = {};
   
       try {
         var searchResult
@@ -265,8 +278,9 @@ function (ObjectStoreModel, BorderContainer, declare, Memory, Observable, topic,
         topic.publish('codecompass/searchError', { exception : ex });
       }
   
-      this._pager.set(
-        'total', searchResult ? searchResult.totalFiles : 0);
+      if (!continued)
+        this._pager.set(
+          'total', searchResult ? searchResult.totalFiles : 0);
   
       if (!searchResult || searchResult.totalFiles === 0) {
         this._store.add({
@@ -303,6 +317,18 @@ function (ObjectStoreModel, BorderContainer, declare, Memory, Observable, topic,
           
           that._moreMap[fileNode.id] = searchResultEntry.matchingLines;
         });
+
+      // The server returns fewer files than requested if the response reached
+      // its limit of matching lines. The rest of the page is loaded from the
+      // first file which was not received.
+      var received = searchResult.results.length;
+      if (searchResult.truncated && received > 0 && received < range.maxSize)
+        this._store.add({
+          name    : truncatedText,
+          parent  : 'root',
+          start   : range.start + received,
+          maxSize : range.maxSize - received
+        });
     }
   });
 
@@ -14,6 +14,29 @@ struct AstNodeInfo
   7:list<string> tags /** Meta information of the AST node (e.g. public, static, virtual etc.) */
 }
 
+enum DiagramFormat
+{
+  SVG = 0, /** Diagram laid out and rendered by the server. */
+  JSON = 1 /** Graph model (nodes, edges, clusters and their Graphviz attributes) without layout. */
+}
+
+enum DiagramRelation
+{
+  CALLEE = 0, /** Functions called by a function. */
+  CALLER = 1, /** Functions calling a function. */
+  BASE = 2, /** Types from which a type inherits. */
+  DERIVED = 3, /** Types inheriting from a type. */
+  USED_TYPE = 4 /** Types of the data members of a type. */
+}
+
+struct DiagramDelta
+{
+  1:string session, /** Handle of the diagram session. */
+  2:string added, /** The added nodes, edges and their clusters in the JSON format of getDiagram(). */
+  3:list<string> removedNodes, /** IDs of the removed nodes. */
+  4:list<string> removedEdges /** IDs of the removed edges. */
+}
+
 struct SyntaxHighlight
 {
   1:common.Range range, /** Source code range of an AST node. */
@@ -98,14 +121,19 @@ service LanguageService
    * @param astNodeId The AST node we want to draw diagram about.
    * @param diagramId The diagram type we want to draw. The diagram types can be
    * queried by getDiagramTypes().
-   * @return SVG represenation of the diagram. If the diagram can't be generated
-   * then empty string returns.
+   * @param format The format of the diagram. If JSON is requested then the
+   * graph is not laid out by the server, it has to be done by the client.
+   * @return SVG or JSON represenation of the diagram. If the diagram can't be
+   * generated then empty string returns.
    * @exception common.InvalidId Exception is thrown if no AST node belongs to
    * the given ID.
    * @exception common.Timeout Exception is thrown if the diagram generation
    * times out.
    */
-  string getDiagram(1:common.AstNodeId astNodeId, 2:i32 diagramId)
+  string getDiagram(
+    1:common.AstNodeId astNodeId,
+    2:i32 diagramId,
+    3:DiagramFormat format = DiagramFormat.SVG)
     throws (1:common.InvalidId exId, 2:common.Timeout exLong)
 
   /**
@@ -117,6 +145,69 @@ service LanguageService
    */
   string getDiagramLegend(1:i32 diagramId)
 
+  /**
+   * Creates an incremental diagram session about the AST node. Unlike
+   * getDiagram(), the graph is kept by the server between the calls, and it
+   * can be extended or shrunk by expandDiagramNode() and collapseDiagramNode(),
+   * which return only the changes of the graph. The diagram sessions belong to
+   * the session of the user, and they are released together with it.
+   * @param astNodeId The center node of the diagram.
+   * @param diagramId The diagram type which determines the decoration of the
+   * center node. The diagram types can be queried by getDiagramTypes().
+   * @return The handle of the new session and the center node. The handle is
+   * random.
+   * @exception common.InvalidId Exception is thrown if no AST node belongs to
+   * the given ID.
+   * @exception common.InvalidInput Exception is thrown if there is no user
+   * session or the user has too many diagram sessions in use. The sessions
+   * which haven't been used for a while are released to make room for the new
+   * one, but the others have to be closed by closeDiagramSession().
+   */
+  DiagramDelta createDiagramSession(
+    1:common.AstNodeId astNodeId,
+    2:i32 diagramId)
+    throws (1:common.InvalidId ex, 2:common.InvalidInput exInput)
+
+  /**
+   * Adds the nodes related to the given node of the diagram session up to the
+   * given depth.
+   * @param session Handle of the diagram session.
+   * @param astNodeId A node of the diagram.
+   * @param relation The relation along which the node is expanded.
+   * @param depth Number of levels to expand.
+   * @return The added nodes and edges.
+   * @exception common.InvalidInput Exception is thrown if the session doesn't
+   * exist (e.g. it has expired) or the node is not in the diagram.
+   * @exception common.Timeout Exception is thrown if the expansion times out.
+   */
+  DiagramDelta expandDiagramNode(
+    1:string session,
+    2:common.AstNodeId astNodeId,
+    3:DiagramRelation relation,
+    4:i32 depth = 1)
+    throws (1:common.InvalidInput exInput, 2:common.Timeout exLong)
+
+  /**
+   * Removes the nodes which were added by expanding the given node of the
+   * diagram session, recursively.
+   * @param session Handle of the diagram session.
+   * @param astNodeId A node of the diagram.
+   * @return The removed nodes and edges. Clusters which become empty have to
+   * be removed by the client.
+   * @exception common.InvalidInput Exception is thrown if the session doesn't
+   * exist (e.g. it has expired) or the node is not in the diagram.
+   */
+  DiagramDelta collapseDiagramNode(
+    1:string session,
+    2:common.AstNodeId astNodeId)
+    throws (1:common.InvalidInput ex)
+
+  /**
+   * Releases the diagram session. Unknown sessions are ignored.
+   * @param session Handle of the diagram session.
+   */
+  void closeDiagramSession(1:string session)
+
   /**
    * Returns a list of diagram types that can be drawn for the specified file.
    * @param fileId The file ID we would like to draw the diagram about.
@@ -132,13 +223,17 @@ service LanguageService
    * @param fileId The file ID we would like to draw the diagram aboue.
    * @param diagramId The diagram type we want to draw. These can be queried by
    * getFileDiagramTypes().
-   * @return SVG represenation of the diagram.
+   * @param format The format of the diagram, see getDiagram().
+   * @return SVG or JSON represenation of the diagram.
    * @exception common.InvalidId Exception is thrown if no ID belongs to the
    * given fileId.
    * @exception common.Timeout Exception is thrown if the diagram generation
    * times out.
    */
-  string getFileDiagram(1:common.FileId fileId, 2:i32 diagramId)
+  string getFileDiagram(
+    1:common.FileId fileId,
+    2:i32 diagramId,
+    3:DiagramFormat format = DiagramFormat.SVG)
     throws (1:common.InvalidId exId, 2:common.Timeout exLong)
 
   /**
@@ -8,6 +8,7 @@
 #include <odb/database.hxx>
 
 #include <model/file.h>
+#include <util/libraryindex.h>
 #include <util/odbtransaction.h>
 #include <webserver/servercontext.h>
 
@@ -54,6 +55,12 @@ private:
   std::shared_ptr<odb::database> _db;
   util::OdbTransaction _transaction;
   std::string _datadir;
+
+  /**
+   * The library index of the project or nullptr. The contents of library
+   * files are stored only there.
+   */
+  std::shared_ptr<util::LibraryIndex> _libraryIndex;
 };
 
 } // project
@@ -2,6 +2,17 @@
 
 #include <projectservice/projectservice.h>
 
+namespace
+{
+
+const std::unordered_set<std::string> pureMethods{
+  "getFileInfo", "getFileInfoByPath", "getFileContent", "getParent",
+  "getRootFiles", "getChildFiles", "getSubtree", "getOpenTreeTillFile",
+  "getPathTillFile", "getBuildLog", "searchFile", "getStatistics",
+  "getFileTypes", "getLabels"};
+
+} // namespace
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wreturn-type-c-linkage"
 extern "C"
@@ -20,7 +31,7 @@ extern "C"
     cc::webserver::registerPluginSimple(
       context_,
       pluginHandler_,
-      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(Project, core),
+      CODECOMPASS_SERVICE_FACTORY_WITH_CFG(Project, core, pureMethods),
       "ProjectService");
   }
 }
@@ -28,7 +28,8 @@ ProjectServiceHandler::ProjectServiceHandler(
   std::shared_ptr<odb::database> db_,
   std::shared_ptr<std::string> datadir_,
   const cc::webserver::ServerContext& /*context_*/)
-    : _db(db_), _transaction(db_), _datadir(*datadir_)
+    : _db(db_), _transaction(db_), _datadir(*datadir_),
+      _libraryIndex(util::LibraryIndex::forProject(*datadir_))
 {
 }
 
@@ -89,6 +90,15 @@ void ProjectServiceHandler::getFileContent(
 
     if(std::shared_ptr<model::FileContent> fileContent = f.content.load())
       return_ = fileContent->content;
+    else if (_libraryIndex && f.type != model::File::DIRECTORY_TYPE)
+      (*_libraryIndex)([&, this](){
+        model::File libFile;
+
+        if (_libraryIndex->db().find(f.id, libFile))
+          if (std::shared_ptr<model::FileContent> libContent
+                = libFile.content.load())
+            return_ = libContent->content;
+      });
   });
 }
 
@@ -0,0 +1,149 @@
+#ifndef CC_UTIL_CANCELLATION_H
+#define CC_UTIL_CANCELLATION_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * Exception thrown by CancellationToken::throwIfCancelled() when the work
+ * belonging to the token has to be abandoned.
+ */
+class RequestCancelled : public std::runtime_error
+{
+public:
+  RequestCancelled(const std::string& what_) : std::runtime_error(what_) {}
+};
+
+/**
+ * @brief Cooperative cancellation of a unit of work, typically a request.
+ *
+ * A token is cancelled if cancel() has been called, its deadline has expired
+ * or its probe reports that the work is no longer needed (e.g. the client
+ * closed the connection). Nothing is interrupted forcibly: long running code
+ * has to check the token from time to time.
+ *
+ * The webserver installs a token for the current thread of execution for the
+ * lifetime of each request (see CancellationScope), which can be reached with
+ * CancellationToken::current() from service implementations, similarly to the
+ * current session in webserver::SessionManagerAccess. util::TaskGroup forwards
+ * the token of its creator to its tasks.
+ *
+ * @code
+ *   for (const model::CppAstNode& node : nodes)
+ *   {
+ *     util::CancellationToken::checkCurrent();
+ *     ...
+ *   }
+ * @endcode
+ */
+class CancellationToken
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * The probe is called by isCancelled() to detect external cancellation.
+   * If it returns true then the token becomes cancelled.
+   */
+  typedef std::function<bool ()> Probe;
+
+  /**
+   * @param deadline_ The token counts as cancelled after this time point.
+   * @param probe_ Optional function to detect external cancellation.
+   * @param probeInterval_ The probe is called at most once in this interval,
+   * since it may be expensive (e.g. a system call).
+   */
+  CancellationToken(
+    Clock::time_point deadline_ = Clock::time_point::max(),
+    Probe probe_ = Probe(),
+    Clock::duration probeInterval_ = std::chrono::milliseconds(250));
+
+  /**
+   * Cancels the work belonging to this token.
+   */
+  void cancel();
+
+  /**
+   * Returns true if the token has been cancelled, its deadline has expired or
+   * the probe reports cancellation. This function is thread-safe.
+   */
+  bool isCancelled();
+
+  /**
+   * Returns true if the deadline of the token has expired.
+   */
+  bool isExpired() const;
+
+  /**
+   * Returns the deadline of the token.
+   */
+  Clock::time_point deadline() const;
+
+  /**
+   * Throws RequestCancelled if the token is cancelled.
+   */
+  void throwIfCancelled();
+
+  /**
+   * Returns the token of the current thread of execution. It might be null if
+   * there is no token associated with the current thread.
+   */
+  static std::shared_ptr<CancellationToken> current();
+
+  /**
+   * Throws RequestCancelled if the current thread of execution has a token and
+   * it is cancelled.
+   */
+  static void checkCurrent();
+
+  /**
+   * Returns true if the current thread of execution has a token and it is
+   * cancelled.
+   */
+  static bool isCurrentCancelled();
+
+private:
+  friend class CancellationScope;
+
+  const Clock::time_point _deadline;
+  const Probe _probe;
+  const Clock::duration _probeInterval;
+
+  std::atomic_bool _cancelled;
+  std::atomic<Clock::rep> _lastProbe;
+
+  /**
+   * Identifies the token of the work being done by the current thread.
+   */
+  static thread_local std::shared_ptr<CancellationToken> tokenOfCurrentThread;
+};
+
+/**
+ * This class sets the token of the current thread of execution for the
+ * lifetime of the object and restores the previous one at destruction.
+ */
+class CancellationScope
+{
+public:
+  CancellationScope(std::shared_ptr<CancellationToken> token_);
+  ~CancellationScope();
+
+  CancellationScope(const CancellationScope&) = delete;
+  CancellationScope& operator=(const CancellationScope&) = delete;
+
+private:
+  std::shared_ptr<CancellationToken> _prevToken;
+};
+
+} // util
+} // cc
+
+#endif // CC_UTIL_CANCELLATION_H
@@ -62,6 +62,32 @@ void removeTables(
   std::shared_ptr<odb::database> db_,
   const std::string& sqlDir_);
 
+/**
+ * This function adds a column to a table of an existing database if it doesn't
+ * have it yet, e.g. because the database was created by an earlier version of
+ * the model. The existing rows get the default value of the column.
+ * @param db_ Pointer to the ODB database.
+ * @param table_ The name of the table.
+ * @param column_ The name of the column.
+ * @param definition_ The SQL type, constraints and default value of the
+ * column, which depend on the database system.
+ * @return True if the column has been added.
+ */
+bool addMissingColumn(
+  std::shared_ptr<odb::database> db_,
+  const std::string& table_,
+  const std::string& column_,
+  const std::string& definition_);
+
+/**
+ * This function adds the columns to the database of an earlier parse which
+ * have been added to the model since then, so that the entities of the current
+ * model can be loaded from it. Both the parser and the webserver call it on
+ * the existing databases.
+ * @param db_ Pointer to the ODB database.
+ */
+void upgradeSchema(std::shared_ptr<odb::database> db_);
+
 /**
  * This function updates a value for a given key in the connection string. The
  * connection string has the following format: dbsystem:key1=value1;key2=value2.
@@ -1,6 +1,8 @@
 #ifndef CC_UTIL_FILESYSTEM_H
 #define CC_UTIL_FILESYSTEM_H
 
+#include <string>
+
 namespace cc
 {
 namespace util
@@ -16,6 +18,16 @@ namespace util
  */
 std::string binaryPathToInstallDir(const char* path);
 
+/**
+ * Returns the version of the given file made of its modification time and
+ * size, which changes whenever the file is written. An empty string is
+ * returned if the file can't be accessed.
+ *
+ * The project_info.json file of a project is written on every parse, so its
+ * version is the version of the workspace (see ThriftHandler).
+ */
+std::string fileVersion(const std::string& path_);
+
 } // namespace util
 } // namespace cc
 
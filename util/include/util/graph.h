@@ -9,6 +9,7 @@
 #include <functional>
 #include <unordered_set>
 
+#include <util/cancellation.h>
 #include <util/logutil.h>
 
 namespace cc 
@@ -23,11 +24,29 @@ struct GraphPimpl;
  * output in several formats, like DOT or SVG. Since this implementation uses
  * GraphViz's representation, it is trivial to layout the graph with different
  * algorithms.
+ *
+ * The JSON format contains the graph model without layout, so that it can be
+ * laid out by the client:
+ *
+ * @code
+ *   {
+ *     "directed": true,
+ *     "attributes": {"rankdir": "LR", ...},
+ *     "nodes": [{"id": "a", "attributes": {"label": "...", ...},
+ *                "html": ["label"]}, ...],
+ *     "edges": [{"id": "b", "from": "a", "to": "c", "attributes": {...}}, ...],
+ *     "clusters": [{"id": "cluster_x", "nodes": ["a", ...],
+ *                   "attributes": {...}}, ...]
+ *   }
+ * @endcode
+ *
+ * Only the non-empty attributes are written. The "html" array lists the
+ * attributes of which the value is an HTML-like label.
  */
 class Graph
 {
 public:
-  enum Format {DOT, SVG};
+  enum Format {DOT, SVG, JSON};
 
   typedef std::string Node;
   typedef std::string Edge;
@@ -203,10 +222,20 @@ public:
 
   /**
    * This function generates the string representation of the graph in the
-   * given format.
+   * given format. The graph is laid out by the dot algorithm except for the
+   * JSON format.
    */
   std::string output(Format format_) const;
 
+  /**
+   * This function generates the JSON representation of a part of the graph:
+   * the given nodes and edges and the clusters of the given nodes. This way
+   * only the changes of a graph can be sent to the client.
+   */
+  std::string outputJson(
+    const std::set<Node>& nodes_,
+    const std::set<Edge>& edges_) const;
+
   /**
    * This function returns the child nodes of a given node.
    */
@@ -298,6 +327,8 @@ inline std::set<Graph::Node> bfsBuild(
   bool walkLevel = true;
   while (!queue.empty() && walkLevel)
   {
+    CancellationToken::checkCurrent();
+
     Graph::Node current = queue.front();
     queue.pop();
 
@@ -0,0 +1,81 @@
+#ifndef CC_UTIL_LIBRARYINDEX_H
+#define CC_UTIL_LIBRARYINDEX_H
+
+#include <memory>
+#include <string>
+
+#include <odb/database.hxx>
+#include <odb/session.hxx>
+#include <odb/transaction.hxx>
+
+#include <util/odbtransaction.h>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * @brief A shared, read-only database of library headers.
+ *
+ * A library index is the database of an ordinary parse of a library (e.g. an
+ * SDK or Boost version). Projects parsed with the --library-index option don't
+ * store the contents and the C++ facts of those files which are in the library
+ * index with the same content hash: the file and AST node identifiers are
+ * computed from paths and symbols, so they are the same in both databases. The
+ * services look up these facts in the library index of the project (see
+ * forProject()).
+ */
+class LibraryIndex
+{
+public:
+  LibraryIndex(std::shared_ptr<odb::database> db_, const std::string& connStr_);
+
+  /**
+   * Connects to the library index of the given connection string. The
+   * connections are shared, so the projects using the same library index use
+   * the same connection pool.
+   * @return nullptr if the database can't be opened.
+   */
+  static std::shared_ptr<LibraryIndex> connect(const std::string& connStr_);
+
+  /**
+   * Returns the library index of the project of which the project_info.json
+   * is in the given directory, or nullptr if the project doesn't use any.
+   */
+  static std::shared_ptr<LibraryIndex> forProject(const std::string& datadir_);
+
+  /**
+   * Runs the function in a separate transaction on the library index, even if
+   * the current thread is in a transaction of another database (e.g. the one
+   * of the project). The previous transaction is restored afterwards.
+   */
+  template <typename F>
+  auto operator()(F func_)
+  {
+    internal::TransRestore restore;
+
+    odb::session session(false);
+    odb::transaction transaction(_db->begin(), false);
+    odb::session::current(session);
+    odb::transaction::current(transaction);
+
+    internal::Holder<decltype(func_())> holder(func_);
+    transaction.commit();
+
+    return holder.getValue();
+  }
+
+  odb::database& db() const;
+
+  const std::string& connectionString() const;
+
+private:
+  std::shared_ptr<odb::database> _db;
+  const std::string _connStr;
+};
+
+} // util
+} // cc
+
+#endif // CC_UTIL_LIBRARYINDEX_H
@@ -1,6 +1,15 @@
 #ifndef CC_UTIL_PARSEUTIL_H
 #define CC_UTIL_PARSEUTIL_H
 
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <util/taskgroup.h>
+
 namespace cc
 {
 namespace util
@@ -26,6 +35,128 @@ bool iterateDirectoryRecursive(
   const std::string& path_,
   DirIterCallback callback_);
 
+/**
+ * An entry found by walkDirectory().
+ */
+struct DirEntry
+{
+  /**
+   * The type of the entry. Symbolic links have the type of their target, like
+   * boost::filesystem::is_directory() and is_regular_file() report them.
+   */
+  enum class Type
+  {
+    Regular,
+    Directory,
+    Other
+  };
+
+  /**
+   * Value of parent for the root of the walk.
+   */
+  static const std::size_t npos = static_cast<std::size_t>(-1);
+
+  std::string path;
+  Type type;
+
+  /**
+   * The index of the entry of the parent directory in the walk. The entries
+   * are numbered in the order of their delivery, and a directory is always
+   * delivered before its contents.
+   */
+  std::size_t parent;
+};
+
+/**
+ * Callback function type for walkDirectory(). It receives the entries in
+ * batches. The calls are serialised, but they may come from any thread.
+ */
+typedef std::function<void (const std::vector<DirEntry>&)> DirBatchCallback;
+
+/**
+ * Callback function type for DirectoryWalkCache::iterate(). If it returns
+ * false on a directory then the contents of the directory are skipped.
+ */
+typedef std::function<bool (const DirEntry&)> DirEntryCallback;
+
+struct DirWalkOptions
+{
+  /**
+   * Directories which are left out of the walk together with their contents.
+   * These are compared to the canonical paths of the directories.
+   */
+  std::vector<std::string> skipDirectories;
+
+  /**
+   * Maximal number of entries passed to the callback at once.
+   */
+  std::size_t batchSize = 1024;
+};
+
+/**
+ * Walks the directory tree under path_ on the executor, reading at most
+ * maxParallel_ directories at the same time. The types of the entries come
+ * from the directory listing itself, so only symbolic links and the entries
+ * of file systems which don't report the types are stat'ed.
+ *
+ * The root itself is the first entry. The order of the entries is otherwise
+ * unspecified, except that a directory comes before its contents.
+ *
+ * @return false if path_ doesn't exist.
+ */
+bool walkDirectory(
+  const std::string& path_,
+  TaskExecutor& executor_,
+  std::size_t maxParallel_,
+  const DirBatchCallback& callback_,
+  const DirWalkOptions& options_ = DirWalkOptions());
+
+/**
+ * The results of the directory walks shared by the parsers. The first parser
+ * which iterates an input directory walks it with walkDirectory(), and the
+ * ones coming later (or waiting for the same walk) iterate the stored
+ * entries. This way the input is read from the disk only once.
+ */
+class DirectoryWalkCache
+{
+public:
+  DirectoryWalkCache(TaskExecutor& executor_);
+
+  DirectoryWalkCache(const DirectoryWalkCache&) = delete;
+  DirectoryWalkCache& operator=(const DirectoryWalkCache&) = delete;
+
+  /**
+   * Calls the callback on the root and on the entries under it in the order
+   * of walkDirectory(), like iterateDirectoryRecursive() does.
+   * @param maxParallel_ The parallelism of the walk if it isn't cached yet.
+   * @return false if the root doesn't exist or the callback returns false on
+   * it.
+   */
+  bool iterate(
+    const std::string& path_,
+    std::size_t maxParallel_,
+    const DirEntryCallback& callback_);
+
+  /**
+   * Drops the stored walks.
+   */
+  void clear();
+
+private:
+  struct Listing
+  {
+    std::mutex mutex;
+    bool done = false;
+    bool exists = false;
+    std::vector<DirEntry> entries;
+  };
+
+  TaskExecutor& _executor;
+
+  std::mutex _mutex;
+  std::unordered_map<std::string, std::shared_ptr<Listing>> _listings;
+};
+
 } // util
 } // cc
 
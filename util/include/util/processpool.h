@@ -0,0 +1,379 @@
+#ifndef CC_UTIL_PROCESSPOOL_H
+#define CC_UTIL_PROCESSPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <util/cancellation.h>
+#include <util/logutil.h>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * @brief A pool of supervised helper processes.
+ *
+ * Worker is a util::PipedProcess subclass (or anything with an isAlive()
+ * member function) which serves requests over its pipes, e.g. a Thrift client
+ * of a Java process. Every call borrows the idle healthy worker with the
+ * lowest average response time. If every worker is busy then the call waits.
+ *
+ * Before a worker gets a request it is checked whether its process is still
+ * alive. Dead workers are restarted by the factory. If a worker dies during a
+ * call then the call is retried once on another (or the restarted) worker. A
+ * worker which dies more than maxRestarts_ times in a minute is given up for a
+ * back-off period, which doubles on each repeated failure up to half an hour,
+ * and it is restarted by the first call after that. While every worker is
+ * given up the calls throw Unavailable.
+ *
+ * Every call gets a correlation ID which is unique in the pool, for logging.
+ * Thrift over a pipe pair is strictly request-response, so a worker serves one
+ * request at a time: multiplexing the requests of several calls over the same
+ * pipes is out of scope.
+ *
+ * @code
+ *   util::ProcessPool<ServiceProcess> pool(4, [&](std::size_t){
+ *     return std::unique_ptr<ServiceProcess>(new ServiceProcess(...));
+ *   });
+ *
+ *   pool.call([&](ServiceProcess& process_, std::uint64_t){
+ *     process_.search(result, params);
+ *   });
+ * @endcode
+ */
+template <typename Worker>
+class ProcessPool
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * Creates the worker of the given slot of the pool.
+   */
+  typedef std::function<std::unique_ptr<Worker> (std::size_t)> Factory;
+
+  /**
+   * Thrown if there is no healthy worker in the pool.
+   */
+  class Unavailable : public std::runtime_error
+  {
+  public:
+    Unavailable(const std::string& msg_) : std::runtime_error(msg_) {}
+  };
+
+  /**
+   * Starts the workers.
+   * @param size_ Number of workers. At least one is started.
+   * @param maxRestarts_ Maximal number of restarts of a worker in a minute.
+   */
+  ProcessPool(
+    std::size_t size_,
+    Factory factory_,
+    std::size_t maxRestarts_ = 5)
+    : _factory(std::move(factory_)),
+      _maxRestarts(maxRestarts_),
+      _nextId(0)
+  {
+    for (std::size_t i = 0; i < std::max<std::size_t>(size_, 1); ++i)
+    {
+      std::unique_ptr<Slot> slot(new Slot);
+      slot->index = i;
+      slot->worker = _factory(i);
+      _slots.push_back(std::move(slot));
+    }
+  }
+
+  ProcessPool(const ProcessPool&) = delete;
+  ProcessPool& operator=(const ProcessPool&) = delete;
+
+  /**
+   * Calls func_ with a worker and the correlation ID of the call, and returns
+   * its result.
+   * @throw Unavailable if there is no healthy worker.
+   */
+  template <typename F>
+  auto call(F func_) -> decltype(func_(std::declval<Worker&>(), 0ull))
+  {
+    const std::uint64_t id = ++_nextId;
+
+    for (int attempt = 0; ; ++attempt)
+    {
+      Lease lease(*this);
+
+      try
+      {
+        return func_(*lease.worker(), id);
+      }
+      catch (...)
+      {
+        if (!lease.died())
+          throw;
+
+        LOG(warning)
+          << "Helper process " << lease.index() << " died during request "
+          << id << (attempt == 0 ? ", retrying" : "");
+
+        if (attempt != 0)
+          throw;
+      }
+    }
+  }
+
+  /**
+   * Returns the number of workers.
+   */
+  std::size_t size() const
+  {
+    return _slots.size();
+  }
+
+private:
+  struct Slot
+  {
+    std::size_t index = 0;
+    std::unique_ptr<Worker> worker;
+
+    bool busy = false;
+    Clock::duration avgLatency = Clock::duration::zero();
+
+    bool dead = false;
+    bool restarting = false;
+    std::deque<Clock::time_point> restarts;
+
+    /**
+     * A worker which died too often is given up until failedUntil. The
+     * back-off is zero if the worker has served a call since it was last
+     * given up.
+     */
+    bool failed = false;
+    Clock::time_point failedUntil;
+    Clock::duration backoff = Clock::duration::zero();
+  };
+
+  /**
+   * A worker borrowed for a call.
+   */
+  class Lease
+  {
+  public:
+    Lease(ProcessPool& pool_) : _pool(pool_), _slot(pool_.acquire()),
+      _start(Clock::now())
+    {
+    }
+
+    ~Lease()
+    {
+      _pool.release(*_slot, Clock::now() - _start);
+    }
+
+    Worker* worker() const { return _slot->worker.get(); }
+    std::size_t index() const { return _slot->index; }
+
+    /**
+     * Returns true if the process of the worker has exited. The worker is
+     * restarted before its next use.
+     */
+    bool died()
+    {
+      std::lock_guard<std::mutex> guard(_pool._lock);
+
+      if (!_slot->worker->isAlive())
+        _slot->dead = true;
+
+      return _slot->dead;
+    }
+
+  private:
+    ProcessPool& _pool;
+    Slot* _slot;
+    Clock::time_point _start;
+  };
+
+  /**
+   * Waits for the fastest idle healthy worker, restarting the dead ones.
+   */
+  Slot* acquire()
+  {
+    std::unique_lock<std::mutex> lock(_lock);
+
+    while (true)
+    {
+      Slot* best = nullptr;
+      bool usable = false;
+      bool restarted = false;
+
+      for (std::size_t i = 0; i < _slots.size() && !restarted; ++i)
+      {
+        Slot& slot = *_slots[i];
+
+        if (isRestartable(slot))
+        {
+          restart(slot, lock);
+          restarted = true;
+          continue;
+        }
+
+        if (slot.failed)
+          continue;
+
+        usable = true;
+
+        if (slot.dead || slot.restarting || slot.busy)
+          continue;
+
+        if (!best || slot.avgLatency < best->avgLatency)
+          best = &slot;
+      }
+
+      // The lock was released during the restart, so the state has to be
+      // checked again.
+      if (restarted)
+        continue;
+
+      if (!usable)
+        throw Unavailable("Every helper process has died repeatedly");
+
+      if (best)
+      {
+        best->busy = true;
+        return best;
+      }
+
+      _released.wait_for(lock, std::chrono::milliseconds(100));
+      CancellationToken::checkCurrent();
+    }
+  }
+
+  void release(Slot& slot_, Clock::duration latency_)
+  {
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+
+      slot_.busy = false;
+
+      // The back-off starts again once the worker has served a call.
+      if (!slot_.dead)
+        slot_.backoff = Clock::duration::zero();
+
+      slot_.avgLatency = (slot_.avgLatency * 7 + latency_) / 8;
+    }
+
+    _released.notify_all();
+  }
+
+  /**
+   * Returns true if the worker is idle and its process has exited, or its
+   * back-off period is over. This expects to be called in a locked context.
+   */
+  bool isRestartable(Slot& slot_)
+  {
+    if (slot_.failed)
+    {
+      if (Clock::now() < slot_.failedUntil)
+        return false;
+
+      LOG(info) << "Retrying helper process " << slot_.index;
+      slot_.failed = false;
+      slot_.dead = true;
+    }
+
+    if (slot_.restarting || slot_.busy)
+      return false;
+
+    if (!slot_.dead && slot_.worker && !slot_.worker->isAlive())
+    {
+      LOG(warning) << "Helper process " << slot_.index << " has exited";
+      slot_.dead = true;
+    }
+
+    return slot_.dead || !slot_.worker;
+  }
+
+  /**
+   * Replaces the worker of the slot by a new one. The lock is released while
+   * the worker is created.
+   */
+  void restart(Slot& slot_, std::unique_lock<std::mutex>& lock_)
+  {
+    const Clock::time_point now = Clock::now();
+
+    while (!slot_.restarts.empty() &&
+           now - slot_.restarts.front() > std::chrono::minutes(1))
+      slot_.restarts.pop_front();
+
+    if (slot_.restarts.size() >= _maxRestarts)
+    {
+      slot_.backoff = slot_.backoff == Clock::duration::zero()
+        ? Clock::duration(std::chrono::minutes(1))
+        : std::min<Clock::duration>(
+            slot_.backoff * 2, std::chrono::minutes(30));
+
+      LOG(error)
+        << "Helper process " << slot_.index << " died "
+        << slot_.restarts.size() << " times in a minute, giving up for "
+        << std::chrono::duration_cast<std::chrono::seconds>(
+             slot_.backoff).count() << " seconds";
+
+      slot_.failed = true;
+      slot_.failedUntil = now + slot_.backoff;
+      slot_.restarts.clear();
+      return;
+    }
+
+    slot_.restarts.push_back(now);
+    slot_.restarting = true;
+
+    std::unique_ptr<Worker> old = std::move(slot_.worker);
+    std::unique_ptr<Worker> worker;
+
+    lock_.unlock();
+
+    old.reset();
+
+    try
+    {
+      LOG(info) << "Restarting helper process " << slot_.index;
+      worker = _factory(slot_.index);
+    }
+    catch (const std::exception& ex)
+    {
+      LOG(error)
+        << "Failed to restart helper process " << slot_.index << ": "
+        << ex.what();
+    }
+
+    lock_.lock();
+
+    slot_.worker = std::move(worker);
+    slot_.dead = !slot_.worker;
+    slot_.restarting = false;
+
+    _released.notify_all();
+  }
+
+  Factory _factory;
+  const std::size_t _maxRestarts;
+  std::atomic<std::uint64_t> _nextId;
+
+  std::mutex _lock;
+  std::condition_variable _released;
+  std::vector<std::unique_ptr<Slot>> _slots;
+};
+
+} // util
+} // cc
+
+#endif // CC_UTIL_PROCESSPOOL_H
@@ -0,0 +1,127 @@
+#ifndef CC_UTIL_SHMRING_H
+#define CC_UTIL_SHMRING_H
+
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * @brief Shared memory ring buffers for talking to a child process.
+ *
+ * The buffer is an anonymous memory file (memfd) which is inherited by the
+ * child process of a util::PipedProcess. The descriptor is close-on-exec, so
+ * other processes started by the parent don't inherit it: the child has to
+ * call inheritInChild() between fork() and exec(). It contains two rings: the first one
+ * carries the messages of the parent to the child, the second one carries the
+ * answers. The pipes of the process remain the signalling channel: a frame is
+ * copied to the ring, and only its length is written to the pipe. A frame
+ * which doesn't fit in the free space of the ring is written to the pipe
+ * inline, so the writer never waits for the reader.
+ *
+ * The layout of a ring is a 64 byte header, of which the first 8 bytes are the
+ * read position of the reader (native byte order), followed by the data. The
+ * write position is known by the writer only. The length tokens on the pipe
+ * are big-endian 32 bit integers: a positive value is the length of a frame
+ * in the ring, a negative one is the length of an inline frame which follows
+ * the token.
+ */
+class ShmRing
+{
+public:
+  /**
+   * Exception class.
+   */
+  class Failure : public std::runtime_error
+  {
+  public:
+    Failure(const std::string& msg_);
+  };
+
+  /**
+   * Direction of the messages.
+   */
+  enum Direction
+  {
+    ToChild = 0, /*!< Written by the parent, read by the child process. */
+    ToParent = 1 /*!< Written by the child, read by the parent process. */
+  };
+
+  /**
+   * Size of the ring header in bytes.
+   */
+  static constexpr std::size_t HeaderSize = 64;
+
+  ShmRing(const ShmRing&) = delete;
+  ShmRing& operator=(const ShmRing&) = delete;
+
+  /**
+   * Creates and maps the memory file.
+   *
+   * @param capacity_ Size of the data part of a ring in bytes.
+   * @throw Failure if the memory file can't be created.
+   */
+  ShmRing(std::size_t capacity_ = 4 * 1024 * 1024);
+
+  ~ShmRing();
+
+  /**
+   * Returns the file descriptor of the memory file.
+   */
+  int fd() const { return _fd; }
+
+  /**
+   * Makes the descriptor of the memory file survive exec(). This has to be
+   * called in the child process after fork(), so the descriptor of the parent
+   * remains close-on-exec.
+   *
+   * @return The descriptor, which can be announced to the child as a command
+   * line argument.
+   * @throw Failure if the flags of the descriptor can't be changed.
+   */
+  int inheritInChild() const;
+
+  /**
+   * Writes a frame to the ToChild ring and its length token to the pipe.
+   *
+   * @throw Failure if writing to the pipe fails.
+   */
+  void write(int pipeFd_, const std::uint8_t* data_, std::uint32_t size_);
+
+  /**
+   * Reads the next frame of the ToParent ring. The frame is appended to
+   * frame_. This blocks until a length token arrives on the pipe.
+   *
+   * @throw Failure if reading from the pipe fails or the child process closed
+   * the pipe.
+   */
+  void read(int pipeFd_, std::vector<std::uint8_t>& frame_);
+
+private:
+  std::uint8_t* ring(Direction dir_) const;
+  std::uint64_t* readPos(Direction dir_) const;
+
+  int _fd;
+  std::size_t _capacity;
+  std::uint8_t* _memory;
+
+  /**
+   * Write position of the ToChild ring.
+   */
+  std::uint64_t _writePos;
+
+  /**
+   * Read position of the ToParent ring.
+   */
+  std::uint64_t _readPos;
+};
+
+} // util
+} // cc
+
+#endif // CC_UTIL_SHMRING_H
@@ -0,0 +1,31 @@
+#ifndef CC_UTIL_SYSINFO_H
+#define CC_UTIL_SYSINFO_H
+
+#include <cstddef>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * Returns the memory in bytes which can be allocated without swapping, as
+ * estimated by the kernel (MemAvailable in /proc/meminfo), or the free
+ * physical memory if the kernel doesn't give an estimate.
+ */
+std::size_t availableMemory();
+
+/**
+ * Returns the resident set size of the current process in bytes.
+ */
+std::size_t residentSetSize();
+
+/**
+ * Returns the CPU time consumed by the calling thread in seconds.
+ */
+double threadCpuTime();
+
+} // util
+} // cc
+
+#endif // CC_UTIL_SYSINFO_H
@@ -0,0 +1,167 @@
+#ifndef CC_UTIL_TASKGROUP_H
+#define CC_UTIL_TASKGROUP_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * @brief A fixed size pool of worker threads executing short-lived tasks.
+ *
+ * Unlike PooledJobQueue, the executor is not bound to a single job function
+ * and it is meant to be long-lived and shared: several TaskGroup objects can
+ * post their tasks to the same executor at the same time.
+ *
+ * Tasks running on the executor's threads are not in any database transaction
+ * initially, so util::OdbTransaction opens a separate transaction (and
+ * therefore a separate connection) for them.
+ */
+class TaskExecutor
+{
+public:
+  typedef std::function<void ()> Task;
+
+  /**
+   * @param threadCount_ The number of worker threads. At least one thread is
+   * always created.
+   */
+  TaskExecutor(std::size_t threadCount_);
+
+  /**
+   * Waits for the already posted tasks and joins the worker threads.
+   */
+  ~TaskExecutor();
+
+  TaskExecutor(const TaskExecutor&) = delete;
+  TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+  /**
+   * Schedules the given task for execution on one of the worker threads.
+   */
+  void post(Task task_);
+
+  /**
+   * Returns the number of worker threads.
+   */
+  std::size_t threadCount() const;
+
+private:
+  void worker();
+
+  std::mutex _lock;
+  std::condition_variable _signal;
+  std::deque<Task> _queue;
+  std::vector<std::thread> _threads;
+  bool _die;
+};
+
+/**
+ * @brief A set of independent tasks belonging to a single request.
+ *
+ * The tasks of a group run on a shared TaskExecutor, but at most
+ * maxParallel_ of them at the same time. The thread which calls wait() also
+ * takes part in the work: it executes the tasks which haven't been picked up
+ * by a worker thread yet. Therefore the group can't deadlock even if the
+ * executor is saturated (e.g. by nested groups), and if maxParallel_ is 1 then every task runs
+ * synchronously in wait() (this is required for database backends with a
+ * single connection, such as SQLite).
+ *
+ * The groups sharing an executor take turns: a worker thread executes one task
+ * of a group and then goes to the end of the executor's queue.
+ *
+ * The group may have a deadline. Tasks which haven't started before the
+ * deadline are dropped, and the running ones can poll expired(). The deadline
+ * is propagated: a group created inside a task of another group inherits the
+ * deadline of the enclosing group unless an explicit one is given. Similarly,
+ * the tasks run with the util::CancellationToken of the thread which created
+ * the group, and they are dropped if that token is cancelled.
+ *
+ * @code
+ *   std::vector<AstNodeInfo> callees, callers;
+ *
+ *   util::TaskGroup group(executor, 4);
+ *   group.run([&]{ getReferences(callees, id, CALLEE, {}); });
+ *   group.run([&]{ getReferences(callers, id, CALLER, {}); });
+ *   group.wait();
+ * @endcode
+ *
+ * @warning Tasks usually capture local variables by reference, so wait() must
+ * be called before these go out of scope. The destructor also waits for the
+ * running tasks, but it doesn't rethrow their exceptions.
+ */
+class TaskGroup
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+  typedef TaskExecutor::Task Task;
+
+  /**
+   * @param executor_ The executor on which the tasks run.
+   * @param maxParallel_ Maximal number of tasks of this group running at the
+   * same time, including the one running on the thread calling wait().
+   * @param deadline_ The tasks not started until this time point are dropped.
+   * By default the deadline of the enclosing group is inherited, if any.
+   */
+  TaskGroup(
+    TaskExecutor& executor_,
+    std::size_t maxParallel_,
+    Clock::time_point deadline_ = currentDeadline());
+
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  /**
+   * Adds a new task to the group. The task may start immediately on a worker
+   * thread of the executor.
+   */
+  void run(Task task_);
+
+  /**
+   * Executes the pending tasks on the calling thread and waits for the ones
+   * running on the executor. If a task threw an exception then the first one
+   * is rethrown here.
+   * @return False if some tasks were dropped because the deadline expired.
+   */
+  bool wait();
+
+  /**
+   * Returns true if the deadline of the group has already expired or the
+   * cancellation token of its creator has been cancelled.
+   */
+  bool expired() const;
+
+  /**
+   * Returns the deadline of the group.
+   */
+  Clock::time_point deadline() const;
+
+  /**
+   * Returns the deadline of the task group which the current thread is
+   * working for or the deadline of the current cancellation token, whichever
+   * is earlier. Clock::time_point::max() if there is none of these.
+   */
+  static Clock::time_point currentDeadline();
+
+private:
+  struct State;
+
+  std::shared_ptr<State> _state;
+};
+
+} // util
+} // cc
+
+#endif // CC_UTIL_TASKGROUP_H
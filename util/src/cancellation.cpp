@@ -0,0 +1,103 @@
+#include <util/cancellation.h>
+
+namespace cc
+{
+namespace util
+{
+
+thread_local std::shared_ptr<CancellationToken>
+  CancellationToken::tokenOfCurrentThread;
+
+CancellationToken::CancellationToken(
+  Clock::time_point deadline_,
+  Probe probe_,
+  Clock::duration probeInterval_)
+  : _deadline(deadline_),
+    _probe(std::move(probe_)),
+    _probeInterval(probeInterval_),
+    _cancelled(false),
+    _lastProbe(Clock::now().time_since_epoch().count())
+{
+}
+
+void CancellationToken::cancel()
+{
+  _cancelled = true;
+}
+
+bool CancellationToken::isCancelled()
+{
+  if (_cancelled)
+    return true;
+
+  Clock::time_point now = Clock::now();
+
+  if (now >= _deadline)
+    return true;
+
+  if (_probe)
+  {
+    Clock::rep last = _lastProbe;
+    Clock::rep nowRep = now.time_since_epoch().count();
+
+    // Only one of the threads working for this token calls the probe.
+    if (nowRep - last >= _probeInterval.count() &&
+        _lastProbe.compare_exchange_strong(last, nowRep) &&
+        _probe())
+      _cancelled = true;
+  }
+
+  return _cancelled;
+}
+
+bool CancellationToken::isExpired() const
+{
+  return Clock::now() >= _deadline;
+}
+
+CancellationToken::Clock::time_point CancellationToken::deadline() const
+{
+  return _deadline;
+}
+
+void CancellationToken::throwIfCancelled()
+{
+  if (!isCancelled())
+    return;
+
+  if (_cancelled)
+    throw RequestCancelled("Request has been cancelled");
+  else
+    throw RequestCancelled("Request deadline exceeded");
+}
+
+std::shared_ptr<CancellationToken> CancellationToken::current()
+{
+  return tokenOfCurrentThread;
+}
+
+void CancellationToken::checkCurrent()
+{
+  if (tokenOfCurrentThread)
+    tokenOfCurrentThread->throwIfCancelled();
+}
+
+bool CancellationToken::isCurrentCancelled()
+{
+  return tokenOfCurrentThread && tokenOfCurrentThread->isCancelled();
+}
+
+CancellationScope::CancellationScope(
+  std::shared_ptr<CancellationToken> token_)
+  : _prevToken(std::move(token_))
+{
+  std::swap(_prevToken, CancellationToken::tokenOfCurrentThread);
+}
+
+CancellationScope::~CancellationScope()
+{
+  std::swap(_prevToken, CancellationToken::tokenOfCurrentThread);
+}
+
+} // util
+} // cc
@@ -17,6 +17,7 @@
 #endif
 
 #include <odb/connection.hxx>
+#include <odb/transaction.hxx>
 
 #include <util/logutil.h>
 #include <util/dbutil.h>
@@ -450,6 +451,64 @@ void createIndexes(
     "Creating indexes from file");
 }
 
+bool addMissingColumn(
+  std::shared_ptr<odb::database> db_,
+  const std::string& table_,
+  const std::string& column_,
+  const std::string& definition_)
+{
+  odb::connection_ptr connection = db_->connection();
+
+  // A failed statement aborts the whole transaction in PostgreSQL, so the
+  // check and the modification run in separate transactions.
+  try
+  {
+    odb::transaction transaction(connection->begin());
+    connection->execute(
+      "SELECT \"" + column_ + "\" FROM \"" + table_ + "\" LIMIT 0");
+    transaction.commit();
+    return false;
+  }
+  catch (const odb::exception&)
+  {
+  }
+
+  try
+  {
+    odb::transaction transaction(connection->begin());
+    connection->execute(
+      "ALTER TABLE \"" + table_ + "\" ADD COLUMN \"" + column_ + "\" " +
+      definition_);
+    transaction.commit();
+  }
+  catch (const odb::exception& ex)
+  {
+    LOG(warning)
+      << "Failed to add column " << column_ << " to table " << table_ << ": "
+      << ex.what();
+    return false;
+  }
+
+  LOG(info) << "Added column " << column_ << " to table " << table_;
+  return true;
+}
+
+void upgradeSchema(std::shared_ptr<odb::database> db_)
+{
+#ifdef DATABASE_PGSQL
+  const std::string completedColumn = "BOOLEAN NOT NULL DEFAULT TRUE";
+#else
+  const std::string completedColumn = "INTEGER NOT NULL DEFAULT 1";
+#endif
+
+  // The build actions which were stored before the completion markers existed
+  // count as completed.
+  addMissingColumn(db_, "BuildAction", "completed", completedColumn);
+
+  // The MIME type of the files without it is detected again when needed.
+  addMissingColumn(db_, "File", "mimeType", "TEXT NULL");
+}
+
 std::string updateConnectionString(
   std::string connStr_,
   const std::string& key_,
@@ -1,5 +1,7 @@
 #include <cstdlib>
 
+#include <sys/stat.h>
+
 #include <boost/filesystem.hpp>
 
 #include <util/filesystem.h>
@@ -50,5 +52,18 @@ std::string binaryPathToInstallDir(const char* path)
   throw std::runtime_error(std::string("Could not find ") + path + std::string("."));
 }
 
+std::string fileVersion(const std::string& path_)
+{
+  struct stat st;
+
+  if (::stat(path_.c_str(), &st) != 0)
+    return std::string();
+
+  return
+    std::to_string(st.st_mtim.tv_sec) + '.' +
+    std::to_string(st.st_mtim.tv_nsec) + '.' +
+    std::to_string(st.st_size);
+}
+
 } // namespace util
 } // namespace cc
@@ -1,6 +1,198 @@
+#include <sstream>
+
 #include <util/graph.h>
 #include "graphpimpl.h"
 
+namespace
+{
+
+/**
+ * Writes the given string as a JSON string literal.
+ */
+void writeJsonString(std::ostream& out_, const char* str_)
+{
+  static const char* hex = "0123456789abcdef";
+
+  out_ << '"';
+
+  for (const char* c = str_; *c; ++c)
+    switch (*c)
+    {
+      case '"':  out_ << "\\\""; break;
+      case '\\': out_ << "\\\\"; break;
+      case '\n': out_ << "\\n"; break;
+      case '\r': out_ << "\\r"; break;
+      case '\t': out_ << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20)
+          out_ << "\\u00" << hex[(*c >> 4) & 0xf] << hex[*c & 0xf];
+        else
+          out_ << *c;
+    }
+
+  out_ << '"';
+}
+
+/**
+ * Writes the non-empty attributes of the given graph object (graph, node or
+ * edge) as JSON object members: "attributes" and "html" if there is any HTML
+ * label among the attributes.
+ */
+void writeJsonAttributes(
+  std::ostream& out_,
+  Agraph_t* graph_,
+  void* object_,
+  int kind_)
+{
+  std::vector<const char*> html;
+  bool first = true;
+
+  out_ << "\"attributes\":{";
+
+  for (Agsym_t* sym = agnxtattr(graph_, kind_, nullptr);
+       sym;
+       sym = agnxtattr(graph_, kind_, sym))
+  {
+    char* value = agxget(object_, sym);
+
+    // The id attribute is the same as the identifier of the object.
+    if (!value || !*value || std::string(sym->name) == "id")
+      continue;
+
+    if (!first)
+      out_ << ',';
+    first = false;
+
+    writeJsonString(out_, sym->name);
+    out_ << ':';
+    writeJsonString(out_, value);
+
+    if (aghtmlstr(value))
+      html.push_back(sym->name);
+  }
+
+  out_ << '}';
+
+  if (!html.empty())
+  {
+    out_ << ",\"html\":[";
+    for (std::size_t i = 0; i < html.size(); ++i)
+    {
+      if (i)
+        out_ << ',';
+      writeJsonString(out_, html[i]);
+    }
+    out_ << ']';
+  }
+}
+
+/**
+ * Returns the model of the graph in JSON format, see util::Graph. If nodes_ or
+ * edges_ is given then only these nodes or edges are written, and only the
+ * written nodes are listed in the clusters.
+ */
+std::string graphToJson(
+  Agraph_t* graph_,
+  const std::set<std::string>* nodes_ = nullptr,
+  const std::set<std::string>* edges_ = nullptr)
+{
+  std::ostringstream out;
+
+  auto hasNode = [nodes_](Agnode_t* node_){
+    return !nodes_ || nodes_->count(agnameof(node_));
+  };
+
+  out << "{\"directed\":" << (agisdirected(graph_) ? "true" : "false") << ',';
+  writeJsonAttributes(out, graph_, graph_, AGRAPH);
+
+  out << ",\"nodes\":[";
+  bool firstNode = true;
+  for (Agnode_t* node = agfstnode(graph_);
+       node;
+       node = agnxtnode(graph_, node))
+  {
+    if (!hasNode(node))
+      continue;
+
+    if (!firstNode)
+      out << ',';
+    firstNode = false;
+
+    out << "{\"id\":";
+    writeJsonString(out, agnameof(node));
+    out << ',';
+    writeJsonAttributes(out, graph_, node, AGNODE);
+    out << '}';
+  }
+
+  out << "],\"edges\":[";
+  bool firstEdge = true;
+  for (Agnode_t* node = agfstnode(graph_);
+       node;
+       node = agnxtnode(graph_, node))
+    for (Agedge_t* edge = agfstout(graph_, node);
+         edge;
+         edge = agnxtout(graph_, edge))
+    {
+      if (edges_ && !edges_->count(agnameof(edge)))
+        continue;
+
+      if (!firstEdge)
+        out << ',';
+      firstEdge = false;
+
+      out << "{\"id\":";
+      writeJsonString(out, agnameof(edge));
+      out << ",\"from\":";
+      writeJsonString(out, agnameof(agtail(edge)));
+      out << ",\"to\":";
+      writeJsonString(out, agnameof(aghead(edge)));
+      out << ',';
+      writeJsonAttributes(out, graph_, edge, AGEDGE);
+      out << '}';
+    }
+
+  out << "],\"clusters\":[";
+  bool firstCluster = true;
+  for (Agraph_t* subgraph = agfstsubg(graph_);
+       subgraph;
+       subgraph = agnxtsubg(subgraph))
+  {
+    std::vector<Agnode_t*> nodes;
+    for (Agnode_t* node = agfstnode(subgraph);
+         node;
+         node = agnxtnode(subgraph, node))
+      if (hasNode(node))
+        nodes.push_back(node);
+
+    if (nodes_ && nodes.empty())
+      continue;
+
+    if (!firstCluster)
+      out << ',';
+    firstCluster = false;
+
+    out << "{\"id\":";
+    writeJsonString(out, agnameof(subgraph));
+    out << ",\"nodes\":[";
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+      if (i)
+        out << ',';
+      writeJsonString(out, agnameof(nodes[i]));
+    }
+    out << "],";
+    writeJsonAttributes(out, graph_, subgraph, AGRAPH);
+    out << '}';
+  }
+
+  out << "]}";
+
+  return out.str();
+}
+
+}
+
 namespace cc
 {
 namespace util
@@ -264,6 +456,9 @@ std::string Graph::getEdgeAttribute(const Edge& edge_, const std::string& key_)
 // TODO: Called twice after each other it segfaults.
 std::string Graph::output(Graph::Format format_) const
 {
+  if (format_ == Graph::JSON)
+    return graphToJson(_graphPimpl->_graph);
+
   char** result        = new char*;
   unsigned int* length = new unsigned int;
 
@@ -286,6 +481,13 @@ std::string Graph::output(Graph::Format format_) const
   return res;
 }
 
+std::string Graph::outputJson(
+  const std::set<Node>& nodes_,
+  const std::set<Edge>& edges_) const
+{
+  return graphToJson(_graphPimpl->_graph, &nodes_, &edges_);
+}
+
 std::vector<Graph::Node> Graph::getChildren(const Node& node) const
 {
   std::vector<Graph::Node> result;
@@ -0,0 +1,75 @@
+#include <map>
+#include <mutex>
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <util/dbutil.h>
+#include <util/libraryindex.h>
+#include <util/logutil.h>
+
+namespace cc
+{
+namespace util
+{
+
+LibraryIndex::LibraryIndex(
+  std::shared_ptr<odb::database> db_,
+  const std::string& connStr_)
+  : _db(std::move(db_)), _connStr(connStr_)
+{
+}
+
+std::shared_ptr<LibraryIndex> LibraryIndex::connect(const std::string& connStr_)
+{
+  static std::mutex lock;
+  static std::map<std::string, std::weak_ptr<LibraryIndex>> indexes;
+
+  std::lock_guard<std::mutex> guard(lock);
+
+  std::shared_ptr<LibraryIndex> index = indexes[connStr_].lock();
+  if (index)
+    return index;
+
+  std::shared_ptr<odb::database> db = connectDatabase(connStr_, false);
+  if (!db)
+  {
+    LOG(error) << "Couldn't connect to the library index: " << connStr_;
+    return nullptr;
+  }
+
+  index = std::make_shared<LibraryIndex>(db, connStr_);
+  indexes[connStr_] = index;
+
+  return index;
+}
+
+std::shared_ptr<LibraryIndex> LibraryIndex::forProject(
+  const std::string& datadir_)
+{
+  const std::string projectInfo = datadir_ + "/project_info.json";
+
+  if (!boost::filesystem::exists(projectInfo))
+    return nullptr;
+
+  boost::property_tree::ptree root;
+  boost::property_tree::read_json(projectInfo, root);
+
+  std::string connStr = root.get<std::string>("libraryIndex", "");
+
+  return connStr.empty() ? nullptr : connect(connStr);
+}
+
+odb::database& LibraryIndex::db() const
+{
+  return *_db;
+}
+
+const std::string& LibraryIndex::connectionString() const
+{
+  return _connStr;
+}
+
+} // util
+} // cc
@@ -1,4 +1,9 @@
+#include <algorithm>
 #include <chrono>
+#include <unordered_set>
+
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include <boost/filesystem.hpp>
 
@@ -10,6 +15,8 @@ namespace fs = boost::filesystem;
 namespace
 {
 
+using cc::util::DirEntry;
+
 /**
 * Context to iterateDirectoryRecursive.
 */
@@ -30,13 +37,12 @@ struct TraverseContext
  std::size_t numDirsVisited = 0;
 };
 
-bool iterateDirectoryRecursive(
-  TraverseContext& context_,
-  const std::string& path_,
-  cc::util::DirIterCallback callback_)
+/**
+ * Counts the entry in the context and reports the status of the iteration
+ * periodically.
+ */
+void countEntry(TraverseContext& context_, DirEntry::Type type_)
 {
-  //--- Status reporting ---//
-
   auto currTime = std::chrono::system_clock::now();
   if ((currTime - context_.lastReportTime) >= std::chrono::seconds(15))
   {
@@ -48,23 +54,136 @@ bool iterateDirectoryRecursive(
     context_.lastReportTime = currTime;
   }
 
-  fs::path p(path_);
+  if (type_ == DirEntry::Type::Directory)
+    ++context_.numDirsVisited;
+  else if (type_ == DirEntry::Type::Regular)
+    ++context_.numFilesVisited;
+}
 
-  if (!fs::exists(p))
-  {
-    LOG(warning) << "Not found: " << p;
-    return true;
-  }
+/**
+ * An entry of a directory listing, see listDirectory().
+ */
+struct ListedEntry
+{
+  std::string name;
+  DirEntry::Type type;
+  bool symlink;
+};
 
-  if (fs::is_directory(p))
+DirEntry::Type getType(mode_t mode_)
+{
+  if (S_ISDIR(mode_))
+    return DirEntry::Type::Directory;
+  if (S_ISREG(mode_))
+    return DirEntry::Type::Regular;
+  return DirEntry::Type::Other;
+}
+
+DirEntry::Type getType(const fs::file_status& status_)
+{
+  if (fs::is_directory(status_))
+    return DirEntry::Type::Directory;
+  if (fs::is_regular_file(status_))
+    return DirEntry::Type::Regular;
+  return DirEntry::Type::Other;
+}
+
+std::string joinPath(const std::string& dir_, const std::string& name_)
+{
+  return !dir_.empty() && dir_.back() == '/'
+    ? dir_ + name_
+    : dir_ + '/' + name_;
+}
+
+std::string canonicalPath(const std::string& path_)
+{
+  boost::system::error_code ec;
+  fs::path canonical = fs::canonical(path_, ec);
+  return ec ? path_ : canonical.string();
+}
+
+/**
+ * Lists a directory with readdir(), which takes the types of the entries from
+ * the getdents() system call. Only the symbolic links and the entries of
+ * unknown type are stat'ed. Dangling symbolic links are left out.
+ * @return false if the directory can't be read.
+ */
+bool listDirectory(const std::string& path_, std::vector<ListedEntry>& entries_)
+{
+  DIR* dir = ::opendir(path_.c_str());
+
+  if (!dir)
   {
-    ++context_.numDirsVisited;
+    LOG(warning) << "Can't read directory: " << path_;
+    return false;
   }
-  else if(fs::is_regular_file(p))
+
+  while (const struct dirent* ent = ::readdir(dir))
   {
-    ++context_.numFilesVisited;
+    const char* name = ent->d_name;
+
+    if (name[0] == '.' &&
+        (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+      continue;
+
+    ListedEntry entry;
+    entry.name = name;
+    entry.symlink = ent->d_type == DT_LNK;
+
+    switch (ent->d_type)
+    {
+      case DT_REG:
+        entry.type = DirEntry::Type::Regular;
+        break;
+
+      case DT_DIR:
+        entry.type = DirEntry::Type::Directory;
+        break;
+
+      case DT_LNK:
+      case DT_UNKNOWN:
+      {
+        std::string path = joinPath(path_, entry.name);
+        struct stat st;
+
+        if (ent->d_type == DT_UNKNOWN)
+        {
+          if (::lstat(path.c_str(), &st) != 0)
+            continue;
+
+          entry.symlink = S_ISLNK(st.st_mode);
+        }
+
+        if (entry.symlink && ::stat(path.c_str(), &st) != 0)
+        {
+          LOG(warning) << "Not found: " << path;
+          continue;
+        }
+
+        entry.type = getType(st.st_mode);
+        break;
+      }
+
+      default:
+        entry.type = DirEntry::Type::Other;
+    }
+
+    entries_.push_back(std::move(entry));
   }
 
+  ::closedir(dir);
+
+  return true;
+}
+
+bool iterateDirectoryRecursive(
+  TraverseContext& context_,
+  const std::string& path_,
+  DirEntry::Type type_,
+  cc::util::DirIterCallback& callback_)
+{
+  countEntry(context_, type_);
+
   //--- Call callback ---//
 
   if (!callback_(path_))
@@ -72,18 +191,190 @@ bool iterateDirectoryRecursive(
 
   //--- Iterate over directory content ---//
 
-  if (fs::is_directory(p))
-    for (fs::directory_iterator it(p), end_iter; it != end_iter; ++it)
-    {
-      std::string path = it->path().c_str();
+  if (type_ == DirEntry::Type::Directory)
+  {
+    std::vector<ListedEntry> entries;
+    listDirectory(path_, entries);
 
-      if (!iterateDirectoryRecursive(context_, path , callback_))
-        continue;
-    }
+    for (const ListedEntry& entry : entries)
+      iterateDirectoryRecursive(
+        context_, joinPath(path_, entry.name), entry.type, callback_);
+  }
 
   return true;
 }
 
+/**
+ * A parallel directory walk, see cc::util::walkDirectory(). Every directory
+ * is read by a separate task of a task group, so the idle threads of the
+ * executor pick up the subdirectories found by the busy ones.
+ */
+class DirectoryWalk
+{
+public:
+  DirectoryWalk(
+    cc::util::TaskExecutor& executor_,
+    std::size_t maxParallel_,
+    const cc::util::DirBatchCallback& callback_,
+    const cc::util::DirWalkOptions& options_)
+    : _group(executor_, maxParallel_),
+      _callback(callback_),
+      _batchSize(std::max<std::size_t>(options_.batchSize, 1)),
+      _count(0)
+  {
+    for (const std::string& dir : options_.skipDirectories)
+      _skipDirectories.insert(canonicalPath(dir));
+  }
+
+  void run(const std::string& path_, DirEntry::Type type_)
+  {
+    std::string canonical;
+    bool descend = type_ == DirEntry::Type::Directory;
+
+    if (descend && !_skipDirectories.empty())
+    {
+      canonical = canonicalPath(path_);
+
+      if (_skipDirectories.count(canonical))
+      {
+        LOG(info) << "Skipping " << path_;
+        descend = false;
+      }
+    }
+
+    std::vector<DirEntry> root{DirEntry{path_, type_, DirEntry::npos}};
+    std::size_t index = deliver(root);
+
+    if (descend)
+      _group.run([this, path_, canonical, index]{
+        visit(path_, canonical, index);
+      });
+
+    _group.wait();
+
+    std::lock_guard<std::mutex> guard(_mutex);
+    flush();
+
+    LOG(debug)
+      << "Directory walk of " << path_ << ": "
+      << _context.numFilesVisited << " files in "
+      << _context.numDirsVisited << " directories.";
+  }
+
+private:
+  /**
+   * Reads the directory, delivers its entries and starts the walk of its
+   * subdirectories. The canonical path is computed only if there are
+   * directories to skip.
+   */
+  void visit(
+    const std::string& path_,
+    const std::string& canonicalPath_,
+    std::size_t index_)
+  {
+    std::vector<ListedEntry> listed;
+    if (!listDirectory(path_, listed))
+      return;
+
+    struct Subdir
+    {
+      std::string path;
+      std::string canonicalPath;
+      std::size_t offset;
+    };
+
+    std::vector<DirEntry> entries;
+    std::vector<Subdir> subdirs;
+    entries.reserve(listed.size());
+
+    for (const ListedEntry& entry : listed)
+    {
+      std::string path = joinPath(path_, entry.name);
+
+      if (entry.type == DirEntry::Type::Directory)
+      {
+        std::string canonical;
+
+        if (!_skipDirectories.empty())
+        {
+          canonical = entry.symlink
+            ? canonicalPath(path)
+            : joinPath(canonicalPath_, entry.name);
+
+          if (_skipDirectories.count(canonical))
+          {
+            LOG(info) << "Skipping " << path;
+            continue;
+          }
+        }
+
+        subdirs.push_back(Subdir{path, std::move(canonical), entries.size()});
+      }
+
+      entries.push_back(DirEntry{std::move(path), entry.type, index_});
+    }
+
+    std::size_t first = deliver(entries);
+
+    for (const Subdir& subdir : subdirs)
+    {
+      std::size_t index = first + subdir.offset;
+
+      _group.run([this, subdir, index]{
+        visit(subdir.path, subdir.canonicalPath, index);
+      });
+    }
+  }
+
+  /**
+   * Numbers the entries and adds them to the current batch. The batches are
+   * passed to the callback under the same lock, so a directory is delivered
+   * before its contents, which are numbered only after it has been read.
+   * @return The index of the first entry.
+   */
+  std::size_t deliver(std::vector<DirEntry>& entries_)
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+
+    std::size_t first = _count;
+    _count += entries_.size();
+
+    for (DirEntry& entry : entries_)
+    {
+      countEntry(_context, entry.type);
+
+      _batch.push_back(std::move(entry));
+      if (_batch.size() >= _batchSize)
+        flush();
+    }
+
+    return first;
+  }
+
+  /**
+   * Passes the current batch to the callback. The lock must be held by the
+   * caller.
+   */
+  void flush()
+  {
+    if (_batch.empty())
+      return;
+
+    _callback(_batch);
+    _batch.clear();
+  }
+
+  cc::util::TaskGroup _group;
+  const cc::util::DirBatchCallback& _callback;
+  const std::size_t _batchSize;
+  std::unordered_set<std::string> _skipDirectories;
+
+  std::mutex _mutex;
+  std::vector<DirEntry> _batch;
+  std::size_t _count;
+  TraverseContext _context;
+};
+
 } // anonymus namespace
 
 namespace cc
@@ -91,14 +382,124 @@ namespace cc
 namespace util
 {
 
+const std::size_t DirEntry::npos;
+
 bool iterateDirectoryRecursive(
   const std::string& path_,
   DirIterCallback callback_)
 {
+  boost::system::error_code ec;
+  fs::file_status status = fs::status(path_, ec);
+
+  if (!fs::exists(status))
+  {
+    LOG(warning) << "Not found: " << path_;
+    return true;
+  }
+
   TraverseContext ctx;
-  std::string path = path_;
-  return ::iterateDirectoryRecursive(ctx, path, callback_);
+  return ::iterateDirectoryRecursive(ctx, path_, getType(status), callback_);
 }
 
+bool walkDirectory(
+  const std::string& path_,
+  TaskExecutor& executor_,
+  std::size_t maxParallel_,
+  const DirBatchCallback& callback_,
+  const DirWalkOptions& options_)
+{
+  boost::system::error_code ec;
+  fs::file_status status = fs::status(path_, ec);
+
+  if (!fs::exists(status))
+  {
+    LOG(warning) << "Not found: " << path_;
+    return false;
+  }
+
+  DirectoryWalk(executor_, maxParallel_, callback_, options_)
+    .run(path_, getType(status));
+
+  return true;
+}
+
+DirectoryWalkCache::DirectoryWalkCache(TaskExecutor& executor_)
+  : _executor(executor_)
+{
+}
+
+bool DirectoryWalkCache::iterate(
+  const std::string& path_,
+  std::size_t maxParallel_,
+  const DirEntryCallback& callback_)
+{
+  std::shared_ptr<Listing> listing;
+
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+
+    std::shared_ptr<Listing>& cached = _listings[path_];
+    if (!cached)
+      cached = std::make_shared<Listing>();
+    listing = cached;
+  }
+
+  {
+    // The other parsers iterating the same directory wait for the walk here.
+    std::lock_guard<std::mutex> guard(listing->mutex);
+
+    if (!listing->done)
+    {
+      listing->entries.clear();
+      listing->exists = walkDirectory(path_, _executor, maxParallel_,
+        [&listing](const std::vector<DirEntry>& batch_)
+        {
+          listing->entries.insert(
+            listing->entries.end(), batch_.begin(), batch_.end());
+        });
+      listing->done = true;
+    }
+    else
+      LOG(debug)
+        << "Directory walk of " << path_ << " is shared: "
+        << listing->entries.size() << " entries.";
+  }
+
+  if (!listing->exists)
+    return false;
+
+  // The parent of an entry precedes it, so the pruned subtrees are marked in
+  // one pass.
+  const std::vector<DirEntry>& entries = listing->entries;
+  std::vector<bool> pruned(entries.size(), false);
+
+  for (std::size_t i = 0; i < entries.size(); ++i)
+  {
+    const DirEntry& entry = entries[i];
+
+    if (entry.parent != DirEntry::npos && pruned[entry.parent])
+    {
+      pruned[i] = true;
+      continue;
+    }
+
+    if (!callback_(entry))
+    {
+      if (i == 0)
+        return false;
+
+      pruned[i] = entry.type == DirEntry::Type::Directory;
+    }
+  }
+
+  return true;
 }
+
+void DirectoryWalkCache::clear()
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+  _listings.clear();
 }
+
+} // util
+} // cc
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <util/shmring.h>
+
+namespace
+{
+
+void writeAll(int fd_, const void* data_, std::size_t size_)
+{
+  const char* data = static_cast<const char*>(data_);
+
+  while (size_ > 0)
+  {
+    ssize_t n = ::write(fd_, data, size_);
+
+    if (n < 0 && errno == EINTR)
+      continue;
+
+    if (n <= 0)
+      throw cc::util::ShmRing::Failure("write to pipe failed!");
+
+    data += n;
+    size_ -= n;
+  }
+}
+
+void readAll(int fd_, void* data_, std::size_t size_)
+{
+  char* data = static_cast<char*>(data_);
+
+  while (size_ > 0)
+  {
+    ssize_t n = ::read(fd_, data, size_);
+
+    if (n < 0 && errno == EINTR)
+      continue;
+
+    if (n <= 0)
+      throw cc::util::ShmRing::Failure(n == 0
+        ? "pipe closed!" : "read from pipe failed!");
+
+    data += n;
+    size_ -= n;
+  }
+}
+
+}
+
+namespace cc
+{
+namespace util
+{
+
+ShmRing::Failure::Failure(const std::string& msg_) :
+  std::runtime_error(msg_) {}
+
+ShmRing::ShmRing(std::size_t capacity_)
+  : _fd(-1), _capacity(capacity_), _memory(nullptr), _writePos(0),
+    _readPos(0)
+{
+  const std::size_t size = 2 * (HeaderSize + _capacity);
+
+  // Only the child process of this ring may inherit the descriptor, see
+  // inheritInChild().
+  _fd = ::memfd_create("cc-ipc-ring", MFD_CLOEXEC);
+  if (_fd < 0)
+    throw Failure("memfd_create failed!");
+
+  if (::ftruncate(_fd, size) != 0)
+  {
+    ::close(_fd);
+    throw Failure("ftruncate failed!");
+  }
+
+  void* memory = ::mmap(
+    nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+
+  if (memory == MAP_FAILED)
+  {
+    ::close(_fd);
+    throw Failure("mmap failed!");
+  }
+
+  _memory = static_cast<std::uint8_t*>(memory);
+}
+
+ShmRing::~ShmRing()
+{
+  ::munmap(_memory, 2 * (HeaderSize + _capacity));
+  ::close(_fd);
+}
+
+int ShmRing::inheritInChild() const
+{
+  int flags = ::fcntl(_fd, F_GETFD);
+  if (flags < 0 || ::fcntl(_fd, F_SETFD, flags & ~FD_CLOEXEC) != 0)
+    throw Failure("fcntl failed!");
+
+  return _fd;
+}
+
+std::uint8_t* ShmRing::ring(Direction dir_) const
+{
+  return _memory + dir_ * (HeaderSize + _capacity) + HeaderSize;
+}
+
+std::uint64_t* ShmRing::readPos(Direction dir_) const
+{
+  return reinterpret_cast<std::uint64_t*>(
+    _memory + dir_ * (HeaderSize + _capacity));
+}
+
+void ShmRing::write(
+  int pipeFd_,
+  const std::uint8_t* data_,
+  std::uint32_t size_)
+{
+  if (size_ == 0)
+    return;
+
+  // The reader publishes its position after copying the frame out, so the
+  // space before it can be overwritten.
+  const std::uint64_t readerPos
+    = __atomic_load_n(readPos(ToChild), __ATOMIC_ACQUIRE);
+
+  if (size_ > _capacity - (_writePos - readerPos))
+  {
+    std::int32_t token = htonl(-static_cast<std::int32_t>(size_));
+    writeAll(pipeFd_, &token, sizeof(token));
+    writeAll(pipeFd_, data_, size_);
+    return;
+  }
+
+  std::uint8_t* data = ring(ToChild);
+  const std::size_t offset = _writePos % _capacity;
+  const std::size_t first = std::min<std::size_t>(size_, _capacity - offset);
+
+  std::memcpy(data + offset, data_, first);
+  std::memcpy(data, data_ + first, size_ - first);
+
+  _writePos += size_;
+
+  // The pipe write is a system call, so the frame is visible to the reader
+  // when it gets the token.
+  std::int32_t token = htonl(static_cast<std::int32_t>(size_));
+  writeAll(pipeFd_, &token, sizeof(token));
+}
+
+void ShmRing::read(int pipeFd_, std::vector<std::uint8_t>& frame_)
+{
+  std::int32_t token;
+  readAll(pipeFd_, &token, sizeof(token));
+  token = ntohl(token);
+
+  const std::size_t begin = frame_.size();
+
+  if (token < 0)
+  {
+    const std::size_t size = -static_cast<std::int64_t>(token);
+    frame_.resize(begin + size);
+    readAll(pipeFd_, frame_.data() + begin, size);
+    return;
+  }
+
+  const std::size_t size = token;
+  if (size > _capacity)
+    throw Failure("invalid frame length!");
+
+  frame_.resize(begin + size);
+
+  const std::uint8_t* data = ring(ToParent);
+  const std::size_t offset = _readPos % _capacity;
+  const std::size_t first = std::min(size, _capacity - offset);
+
+  std::memcpy(frame_.data() + begin, data + offset, first);
+  std::memcpy(frame_.data() + begin + first, data, size - first);
+
+  _readPos += size;
+
+  __atomic_store_n(readPos(ToParent), _readPos, __ATOMIC_RELEASE);
+}
+
+} // util
+} // cc
@@ -0,0 +1,52 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <time.h>
+#include <unistd.h>
+
+#include <util/sysinfo.h>
+
+namespace cc
+{
+namespace util
+{
+
+std::size_t availableMemory()
+{
+  std::ifstream meminfo("/proc/meminfo");
+  std::string line;
+
+  while (std::getline(meminfo, line))
+  {
+    std::istringstream fields(line);
+    std::string key;
+    std::size_t value;
+
+    if (fields >> key >> value && key == "MemAvailable:")
+      return value * 1024;
+  }
+
+  return static_cast<std::size_t>(::sysconf(_SC_AVPHYS_PAGES))
+    * ::sysconf(_SC_PAGESIZE);
+}
+
+std::size_t residentSetSize()
+{
+  std::ifstream statm("/proc/self/statm");
+  std::size_t size, resident = 0;
+  statm >> size >> resident;
+
+  return resident * ::sysconf(_SC_PAGESIZE);
+}
+
+double threadCpuTime()
+{
+  timespec time;
+  ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+} // util
+} // cc
@@ -0,0 +1,301 @@
+#include <algorithm>
+
+#include <util/cancellation.h>
+#include <util/taskgroup.h>
+
+namespace
+{
+
+/**
+ * The deadline of the task group which the current thread is working for.
+ */
+thread_local cc::util::TaskGroup::Clock::time_point currentGroupDeadline
+  = cc::util::TaskGroup::Clock::time_point::max();
+
+/**
+ * This class sets the deadline of the current thread for the lifetime of the
+ * object and restores the previous one at destruction.
+ */
+class DeadlineRestore
+{
+public:
+  DeadlineRestore(cc::util::TaskGroup::Clock::time_point deadline_)
+    : _prevDeadline(currentGroupDeadline)
+  {
+    currentGroupDeadline = deadline_;
+  }
+
+  ~DeadlineRestore()
+  {
+    currentGroupDeadline = _prevDeadline;
+  }
+
+private:
+  cc::util::TaskGroup::Clock::time_point _prevDeadline;
+};
+
+}
+
+namespace cc
+{
+namespace util
+{
+
+TaskExecutor::TaskExecutor(std::size_t threadCount_) : _die(false)
+{
+  threadCount_ = std::max<std::size_t>(threadCount_, 1);
+
+  for (std::size_t i = 0; i < threadCount_; ++i)
+    _threads.emplace_back(&TaskExecutor::worker, this);
+}
+
+TaskExecutor::~TaskExecutor()
+{
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _die = true;
+  }
+
+  _signal.notify_all();
+
+  for (std::thread& t : _threads)
+    if (t.joinable())
+      t.join();
+}
+
+void TaskExecutor::post(Task task_)
+{
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _queue.push_back(std::move(task_));
+  }
+
+  _signal.notify_one();
+}
+
+std::size_t TaskExecutor::threadCount() const
+{
+  return _threads.size();
+}
+
+void TaskExecutor::worker()
+{
+  while (true)
+  {
+    Task task;
+
+    {
+      std::unique_lock<std::mutex> lock(_lock);
+      _signal.wait(lock, [this]{ return _die || !_queue.empty(); });
+
+      if (_queue.empty())
+        return;
+
+      task = std::move(_queue.front());
+      _queue.pop_front();
+    }
+
+    task();
+  }
+}
+
+/**
+ * The shared state of a task group. The executor's worker threads refer to it
+ * through an std::shared_ptr, because a worker may pick up a slot of the group
+ * only after the group has finished and has been destroyed.
+ */
+struct TaskGroup::State
+{
+  State(
+    TaskExecutor& executor_,
+    std::size_t maxParallel_,
+    Clock::time_point deadline_)
+    : executor(executor_),
+      maxParallel(std::max<std::size_t>(maxParallel_, 1)),
+      deadline(deadline_),
+      token(CancellationToken::current()),
+      slots(0),
+      running(0),
+      dropped(false)
+  {
+  }
+
+  /**
+   * Requests worker threads for the pending tasks while there are free slots.
+   * One slot is always reserved for the thread calling wait(). The lock must
+   * be held by the caller.
+   */
+  void dispatch(const std::shared_ptr<State>& self_)
+  {
+    while (slots + running + 1 < maxParallel && slots < pending.size())
+    {
+      ++slots;
+      executor.post([self_]{ self_->work(self_); });
+    }
+  }
+
+  /**
+   * Executes a pending task on a worker thread. A worker doesn't own any task
+   * when it is posted, so the thread calling wait() may consume them earlier.
+   *
+   * The worker executes only one task and then, if there are more, it posts
+   * itself to the end of the executor's queue. This way the groups sharing an
+   * executor take turns on its threads, and a group with many long tasks can't
+   * starve the other ones.
+   */
+  void work(const std::shared_ptr<State>& self_)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    --slots;
+
+    if (!pending.empty())
+    {
+      Task task = std::move(pending.front());
+      pending.pop_front();
+      ++running;
+
+      lock.unlock();
+      execute(task);
+      lock.lock();
+
+      --running;
+
+      if (!pending.empty())
+      {
+        ++slots;
+        executor.post([self_]{ self_->work(self_); });
+      }
+    }
+
+    done.notify_all();
+  }
+
+  /**
+   * Returns true if the deadline has expired or the work of the creator of the
+   * group has been cancelled.
+   */
+  bool expired()
+  {
+    return Clock::now() >= deadline || (token && token->isCancelled());
+  }
+
+  /**
+   * Runs a task of the group on the current thread unless the group has
+   * expired and records the first exception. The task runs with the
+   * cancellation token of the creator of the group.
+   */
+  void execute(Task& task_)
+  {
+    if (expired())
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      dropped = true;
+      return;
+    }
+
+    DeadlineRestore deadlineRestore(deadline);
+    CancellationScope cancellationScope(token);
+
+    try
+    {
+      task_();
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      if (!exception)
+        exception = std::current_exception();
+    }
+  }
+
+  TaskExecutor& executor;
+  const std::size_t maxParallel;
+  const Clock::time_point deadline;
+  const std::shared_ptr<CancellationToken> token;
+
+  std::mutex mutex;
+  std::condition_variable done;
+  std::deque<Task> pending;
+  std::size_t slots;
+  std::size_t running;
+  std::exception_ptr exception;
+  bool dropped;
+};
+
+TaskGroup::TaskGroup(
+  TaskExecutor& executor_,
+  std::size_t maxParallel_,
+  Clock::time_point deadline_)
+  : _state(std::make_shared<State>(executor_, maxParallel_, deadline_))
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+  std::unique_lock<std::mutex> lock(_state->mutex);
+
+  // The pending tasks may refer to objects which have already been destroyed
+  // if wait() hasn't been called, so these are not executed.
+  _state->pending.clear();
+  _state->done.wait(lock, [this]{ return _state->running == 0; });
+}
+
+void TaskGroup::run(Task task_)
+{
+  std::lock_guard<std::mutex> guard(_state->mutex);
+  _state->pending.push_back(std::move(task_));
+  _state->dispatch(_state);
+}
+
+bool TaskGroup::wait()
+{
+  std::unique_lock<std::mutex> lock(_state->mutex);
+
+  while (true)
+  {
+    if (!_state->pending.empty())
+    {
+      Task task = std::move(_state->pending.front());
+      _state->pending.pop_front();
+
+      lock.unlock();
+      _state->execute(task);
+      lock.lock();
+    }
+    else if (_state->running != 0)
+      _state->done.wait(lock);
+    else
+      break;
+  }
+
+  if (_state->exception)
+  {
+    std::exception_ptr ex = _state->exception;
+    _state->exception = nullptr;
+    std::rethrow_exception(ex);
+  }
+
+  return !_state->dropped;
+}
+
+bool TaskGroup::expired() const
+{
+  return _state->expired();
+}
+
+TaskGroup::Clock::time_point TaskGroup::deadline() const
+{
+  return _state->deadline;
+}
+
+TaskGroup::Clock::time_point TaskGroup::currentDeadline()
+{
+  std::shared_ptr<CancellationToken> token = CancellationToken::current();
+
+  return token
+    ? std::min(currentGroupDeadline, token->deadline())
+    : currentGroupDeadline;
+}
+
+} // util
+} // cc
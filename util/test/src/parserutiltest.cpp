@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <util/parserutil.h>
+#include <util/taskgroup.h>
+
+namespace fs = boost::filesystem;
+
+using namespace cc;
+
+class ParserUtilTest : public ::testing::Test
+{
+protected:
+  /**
+   * Creates the following tree in a temporary directory:
+   *   root/a/x.cpp
+   *   root/a/b/y.cpp
+   *   root/c/z.cpp
+   *   root/top.txt
+   */
+  virtual void SetUp() override
+  {
+    _root = (fs::temp_directory_path() / fs::unique_path()).string();
+
+    fs::create_directories(_root + "/a/b");
+    fs::create_directories(_root + "/c");
+
+    for (const char* file : {"/a/x.cpp", "/a/b/y.cpp", "/c/z.cpp", "/top.txt"})
+      std::ofstream(_root + file) << file;
+  }
+
+  virtual void TearDown() override
+  {
+    fs::remove_all(_root);
+  }
+
+  /**
+   * Returns the paths of the tree relative to the root, the root is ".".
+   */
+  std::set<std::string> relative(const std::vector<std::string>& paths_)
+  {
+    std::set<std::string> result;
+
+    for (const std::string& path : paths_)
+      result.insert(path == _root ? "." : path.substr(_root.size() + 1));
+
+    return result;
+  }
+
+  std::string _root;
+  util::TaskExecutor _executor{4};
+};
+
+TEST_F(ParserUtilTest, WalkDirectoryDeliversParentsFirst)
+{
+  util::DirWalkOptions options;
+  options.batchSize = 2;
+
+  std::vector<util::DirEntry> entries;
+
+  ASSERT_TRUE(util::walkDirectory(_root, _executor, 4,
+    [&entries](const std::vector<util::DirEntry>& batch_)
+    {
+      EXPECT_LE(batch_.size(), 2u);
+      entries.insert(entries.end(), batch_.begin(), batch_.end());
+    },
+    options));
+
+  ASSERT_EQ(entries.size(), 8u);
+  EXPECT_EQ(entries[0].path, _root);
+  EXPECT_EQ(entries[0].parent, util::DirEntry::npos);
+  EXPECT_EQ(entries[0].type, util::DirEntry::Type::Directory);
+
+  std::vector<std::string> paths;
+
+  for (std::size_t i = 0; i < entries.size(); ++i)
+  {
+    const util::DirEntry& entry = entries[i];
+    paths.push_back(entry.path);
+
+    if (i == 0)
+      continue;
+
+    ASSERT_LT(entry.parent, i);
+    EXPECT_EQ(
+      fs::path(entry.path).parent_path().string(),
+      entries[entry.parent].path);
+    EXPECT_EQ(
+      entries[entry.parent].type, util::DirEntry::Type::Directory);
+  }
+
+  EXPECT_EQ(relative(paths), std::set<std::string>({
+    ".", "a", "a/x.cpp", "a/b", "a/b/y.cpp", "c", "c/z.cpp", "top.txt"}));
+}
+
+TEST_F(ParserUtilTest, WalkDirectoryReportsTypes)
+{
+  std::vector<util::DirEntry> entries;
+
+  util::walkDirectory(_root, _executor, 1,
+    [&entries](const std::vector<util::DirEntry>& batch_)
+    {
+      entries.insert(entries.end(), batch_.begin(), batch_.end());
+    });
+
+  for (const util::DirEntry& entry : entries)
+    EXPECT_EQ(
+      entry.type,
+      fs::is_directory(entry.path)
+        ? util::DirEntry::Type::Directory
+        : util::DirEntry::Type::Regular) << entry.path;
+}
+
+TEST_F(ParserUtilTest, WalkDirectoryMissingRoot)
+{
+  bool called = false;
+
+  EXPECT_FALSE(util::walkDirectory(_root + "/missing", _executor, 4,
+    [&called](const std::vector<util::DirEntry>&) { called = true; }));
+  EXPECT_FALSE(called);
+}
+
+TEST_F(ParserUtilTest, WalkDirectorySkipsDirectories)
+{
+  util::DirWalkOptions options;
+  options.skipDirectories.push_back(fs::canonical(_root + "/a").string());
+
+  std::vector<std::string> paths;
+
+  util::walkDirectory(_root, _executor, 4,
+    [&paths](const std::vector<util::DirEntry>& batch_)
+    {
+      for (const util::DirEntry& entry : batch_)
+        paths.push_back(entry.path);
+    },
+    options);
+
+  EXPECT_EQ(relative(paths), std::set<std::string>({
+    ".", "c", "c/z.cpp", "top.txt"}));
+}
+
+TEST_F(ParserUtilTest, WalkCacheIteratesLikeRecursiveIteration)
+{
+  std::vector<std::string> expected;
+  util::iterateDirectoryRecursive(_root,
+    [&expected](const std::string& path_)
+    {
+      expected.push_back(path_);
+      return true;
+    });
+
+  util::DirectoryWalkCache cache(_executor);
+  std::vector<std::string> paths;
+
+  EXPECT_TRUE(cache.iterate(_root, 4,
+    [&paths](const util::DirEntry& entry_)
+    {
+      paths.push_back(entry_.path);
+      return true;
+    }));
+
+  EXPECT_EQ(relative(paths), relative(expected));
+}
+
+TEST_F(ParserUtilTest, WalkCachePrunesSubtrees)
+{
+  util::DirectoryWalkCache cache(_executor);
+  std::vector<std::string> paths;
+
+  EXPECT_TRUE(cache.iterate(_root, 4,
+    [this, &paths](const util::DirEntry& entry_)
+    {
+      paths.push_back(entry_.path);
+      return entry_.path != _root + "/a";
+    }));
+
+  EXPECT_EQ(relative(paths), std::set<std::string>({
+    ".", "a", "c", "c/z.cpp", "top.txt"}));
+
+  // Returning false on a file doesn't prune anything else.
+  paths.clear();
+
+  EXPECT_TRUE(cache.iterate(_root, 4,
+    [this, &paths](const util::DirEntry& entry_)
+    {
+      paths.push_back(entry_.path);
+      return entry_.path != _root + "/top.txt";
+    }));
+
+  EXPECT_EQ(paths.size(), 8u);
+}
+
+TEST_F(ParserUtilTest, WalkCacheStopsAtRoot)
+{
+  util::DirectoryWalkCache cache(_executor);
+  std::size_t calls = 0;
+
+  EXPECT_FALSE(cache.iterate(_root, 4,
+    [&calls](const util::DirEntry&)
+    {
+      ++calls;
+      return false;
+    }));
+  EXPECT_EQ(calls, 1u);
+
+  EXPECT_FALSE(cache.iterate(_root + "/missing", 4,
+    [](const util::DirEntry&) { return true; }));
+}
+
+TEST_F(ParserUtilTest, WalkCacheSharesWalks)
+{
+  util::DirectoryWalkCache cache(_executor);
+
+  auto count = [&cache, this]()
+  {
+    std::size_t entries = 0;
+    cache.iterate(_root, 4,
+      [&entries](const util::DirEntry&)
+      {
+        ++entries;
+        return true;
+      });
+    return entries;
+  };
+
+  EXPECT_EQ(count(), 8u);
+
+  // The stored walk is iterated, so the new file isn't seen until the cache
+  // is cleared.
+  std::ofstream(_root + "/new.cpp") << "new";
+  EXPECT_EQ(count(), 8u);
+
+  cache.clear();
+  EXPECT_EQ(count(), 9u);
+}
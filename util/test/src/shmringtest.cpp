@@ -0,0 +1,250 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <util/shmring.h>
+
+using namespace cc;
+
+class ShmRingTest : public ::testing::Test
+{
+protected:
+  static constexpr std::size_t Capacity = 16;
+
+  virtual void SetUp() override
+  {
+    _ring.reset(new util::ShmRing(Capacity));
+
+    ASSERT_EQ(::pipe(_toChild), 0);
+    ASSERT_EQ(::pipe(_toParent), 0);
+
+    // The child process maps the same memory file.
+    void* memory = ::mmap(nullptr, MappedSize, PROT_READ | PROT_WRITE,
+      MAP_SHARED, _ring->fd(), 0);
+    ASSERT_NE(memory, MAP_FAILED);
+    _child = static_cast<std::uint8_t*>(memory);
+  }
+
+  virtual void TearDown() override
+  {
+    ::munmap(_child, MappedSize);
+    ::close(_toChild[0]);
+    ::close(_toChild[1]);
+    ::close(_toParent[0]);
+    ::close(_toParent[1]);
+  }
+
+  /**
+   * Reads the next frame written by the parent in the same way as the child
+   * process does.
+   */
+  std::vector<std::uint8_t> childRead()
+  {
+    std::int32_t token;
+    EXPECT_EQ(::read(_toChild[0], &token, sizeof(token)), 4);
+    token = ntohl(token);
+
+    if (token < 0)
+    {
+      std::vector<std::uint8_t> frame(-token);
+      EXPECT_EQ(::read(_toChild[0], frame.data(), frame.size()),
+        static_cast<ssize_t>(frame.size()));
+      return frame;
+    }
+
+    std::vector<std::uint8_t> frame(token);
+    const std::uint8_t* data = ring(util::ShmRing::ToChild);
+
+    for (std::size_t i = 0; i < frame.size(); ++i)
+      frame[i] = data[(_childReadPos + i) % Capacity];
+
+    _childReadPos += frame.size();
+    *readPos(util::ShmRing::ToChild) = _childReadPos;
+
+    return frame;
+  }
+
+  /**
+   * Writes a frame to the parent in the same way as the child process does.
+   * The frame is written inline if it doesn't fit in the ring.
+   */
+  void childWrite(const std::vector<std::uint8_t>& frame_)
+  {
+    const std::int32_t size = frame_.size();
+    const std::uint64_t used
+      = _childWritePos - *readPos(util::ShmRing::ToParent);
+
+    if (frame_.size() > Capacity - used)
+    {
+      std::int32_t token = htonl(-size);
+      ASSERT_EQ(::write(_toParent[1], &token, sizeof(token)), 4);
+      ASSERT_EQ(::write(_toParent[1], frame_.data(), frame_.size()),
+        static_cast<ssize_t>(frame_.size()));
+      return;
+    }
+
+    std::uint8_t* data = ring(util::ShmRing::ToParent);
+
+    for (std::size_t i = 0; i < frame_.size(); ++i)
+      data[(_childWritePos + i) % Capacity] = frame_[i];
+
+    _childWritePos += frame_.size();
+
+    std::int32_t token = htonl(size);
+    ASSERT_EQ(::write(_toParent[1], &token, sizeof(token)), 4);
+  }
+
+  /**
+   * Returns the number of bytes waiting in the pipe to the child.
+   */
+  int pendingToChild()
+  {
+    int count = 0;
+    while (true)
+    {
+      fd_set fds;
+      FD_ZERO(&fds);
+      FD_SET(_toChild[0], &fds);
+      timeval timeout{0, 0};
+
+      if (::select(_toChild[0] + 1, &fds, nullptr, nullptr, &timeout) <= 0)
+        return count;
+
+      std::uint8_t byte;
+      ::read(_toChild[0], &byte, 1);
+      ++count;
+    }
+  }
+
+  std::uint8_t* ring(util::ShmRing::Direction dir_)
+  {
+    return _child + dir_ * (util::ShmRing::HeaderSize + Capacity)
+      + util::ShmRing::HeaderSize;
+  }
+
+  std::uint64_t* readPos(util::ShmRing::Direction dir_)
+  {
+    return reinterpret_cast<std::uint64_t*>(
+      _child + dir_ * (util::ShmRing::HeaderSize + Capacity));
+  }
+
+  static std::vector<std::uint8_t> bytes(std::uint8_t first_, std::size_t n_)
+  {
+    std::vector<std::uint8_t> result(n_);
+    for (std::size_t i = 0; i < n_; ++i)
+      result[i] = first_ + i;
+    return result;
+  }
+
+  static constexpr std::size_t MappedSize
+    = 2 * (util::ShmRing::HeaderSize + Capacity);
+
+  std::unique_ptr<util::ShmRing> _ring;
+  std::uint8_t* _child;
+  int _toChild[2];
+  int _toParent[2];
+  std::uint64_t _childReadPos = 0;
+  std::uint64_t _childWritePos = 0;
+};
+
+constexpr std::size_t ShmRingTest::Capacity;
+constexpr std::size_t ShmRingTest::MappedSize;
+
+TEST_F(ShmRingTest, WriteWrapsAround)
+{
+  const std::vector<std::uint8_t> first = bytes(1, 10);
+  const std::vector<std::uint8_t> second = bytes(100, 12);
+
+  _ring->write(_toChild[1], first.data(), first.size());
+  EXPECT_EQ(childRead(), first);
+
+  // The second frame starts at offset 10 and continues at the beginning.
+  _ring->write(_toChild[1], second.data(), second.size());
+  EXPECT_EQ(childRead(), second);
+  EXPECT_EQ(pendingToChild(), 0);
+}
+
+TEST_F(ShmRingTest, WriteOverflowsInline)
+{
+  const std::vector<std::uint8_t> first = bytes(1, 10);
+  const std::vector<std::uint8_t> second = bytes(50, 10);
+  const std::vector<std::uint8_t> third = bytes(200, 6);
+
+  // The first frame is not consumed yet, so the second one doesn't fit.
+  _ring->write(_toChild[1], first.data(), first.size());
+  _ring->write(_toChild[1], second.data(), second.size());
+
+  // The third one still fits in the free space of the ring.
+  _ring->write(_toChild[1], third.data(), third.size());
+
+  EXPECT_EQ(childRead(), first);
+  EXPECT_EQ(childRead(), second);
+  EXPECT_EQ(childRead(), third);
+  EXPECT_EQ(pendingToChild(), 0);
+}
+
+TEST_F(ShmRingTest, WriteLargerThanCapacity)
+{
+  const std::vector<std::uint8_t> frame = bytes(0, 3 * Capacity);
+
+  _ring->write(_toChild[1], frame.data(), frame.size());
+  EXPECT_EQ(childRead(), frame);
+}
+
+TEST_F(ShmRingTest, ReadWrapsAroundAndAppends)
+{
+  const std::vector<std::uint8_t> first = bytes(1, 10);
+  const std::vector<std::uint8_t> second = bytes(100, 12);
+
+  std::vector<std::uint8_t> frame;
+
+  childWrite(first);
+  _ring->read(_toParent[0], frame);
+  EXPECT_EQ(frame, first);
+  EXPECT_EQ(*readPos(util::ShmRing::ToParent), 10u);
+
+  // The frame is appended to the buffer.
+  childWrite(second);
+  _ring->read(_toParent[0], frame);
+
+  std::vector<std::uint8_t> expected = first;
+  expected.insert(expected.end(), second.begin(), second.end());
+  EXPECT_EQ(frame, expected);
+  EXPECT_EQ(*readPos(util::ShmRing::ToParent), 22u);
+}
+
+TEST_F(ShmRingTest, ReadInlineFrame)
+{
+  const std::vector<std::uint8_t> first = bytes(1, 10);
+  const std::vector<std::uint8_t> second = bytes(50, 10);
+
+  childWrite(first);
+  childWrite(second);
+
+  std::vector<std::uint8_t> frame;
+  _ring->read(_toParent[0], frame);
+  EXPECT_EQ(frame, first);
+
+  frame.clear();
+  _ring->read(_toParent[0], frame);
+  EXPECT_EQ(frame, second);
+
+  // Inline frames don't move the read position of the ring.
+  EXPECT_EQ(*readPos(util::ShmRing::ToParent), 10u);
+}
+
+TEST_F(ShmRingTest, ReadFailsOnClosedPipe)
+{
+  ::close(_toParent[1]);
+  _toParent[1] = -1;
+
+  std::vector<std::uint8_t> frame;
+  EXPECT_THROW(_ring->read(_toParent[0], frame), util::ShmRing::Failure);
+}
@@ -0,0 +1,150 @@
+define([],
+function () {
+  /**
+   * Header of a Thrift JSON message up to the sequence id, e.g. [1,"getFile",1,
+   */
+  var messageHeader = /^(\[\s*-?\d+\s*,\s*"[^"]*"\s*,\s*-?\d+\s*,\s*)(-?\d+)/;
+
+  /**
+   * Maximal total length of the cached responses in characters.
+   */
+  var maxCacheSize = 32 * 1024 * 1024;
+
+  /**
+   * Cached service responses by the URL and the message without its sequence
+   * id. Every entry contains the ETag and the body of the response.
+   */
+  var cache = {};
+
+  /**
+   * Keys of the cache in the order of their insertion, so that the oldest
+   * entries can be evicted.
+   */
+  var cacheKeys = [];
+  var cacheSize = 0;
+
+  function cacheKey(url, message) {
+    return url + ' ' + message.replace(messageHeader, '$1');
+  }
+
+  function setSeqId(message, seqIdSource) {
+    var match = messageHeader.exec(seqIdSource);
+    return match
+      ? message.replace(messageHeader, '$1' + match[2])
+      : message;
+  }
+
+  function store(key, etag, body) {
+    if (cache[key]) {
+      cacheSize -= cache[key].body.length;
+      cacheKeys.splice(cacheKeys.indexOf(key), 1);
+    }
+
+    if (body.length > maxCacheSize)
+      return;
+
+    cache[key] = { etag : etag, body : body };
+    cacheKeys.push(key);
+    cacheSize += body.length;
+
+    while (cacheSize > maxCacheSize) {
+      var oldest = cacheKeys.shift();
+      cacheSize -= cache[oldest].body.length;
+      delete cache[oldest];
+    }
+  }
+
+  /**
+   * Thrift HTTP transport which revalidates the responses of the earlier
+   * calls: the webserver sends an ETag with the responses which changes only
+   * when the workspace is reparsed. Browsers don't cache the responses of POST
+   * requests, so the transport keeps the responses itself, sends their ETag in
+   * the If-None-Match header and reuses the cached response if the server
+   * answers with 304 Not Modified.
+   */
+  function CachingTransport(url, options) {
+    Thrift.Transport.call(this, url, options);
+  }
+
+  CachingTransport.prototype = Object.create(Thrift.Transport.prototype);
+  CachingTransport.prototype.constructor = CachingTransport;
+
+  CachingTransport.prototype.flush = function (async, callback) {
+    var self = this;
+
+    if ((async && !callback) || this.url === undefined || this.url === '')
+      return this.send_buf;
+
+    var message = this.send_buf;
+    var key = cacheKey(this.url, message);
+    var entry = cache[key];
+
+    // Returns the body of the response or undefined if the request failed.
+    function responseBody(xreq) {
+      if (xreq.status === 304 && entry)
+        return setSeqId(entry.body, message);
+
+      if (xreq.status !== 200)
+        return undefined;
+
+      var etag = xreq.getResponseHeader('ETag');
+      if (etag)
+        store(key, etag, xreq.responseText);
+
+      return xreq.responseText;
+    }
+
+    var xreq = this.getXmlHttpRequestObject();
+
+    if (xreq.overrideMimeType)
+      xreq.overrideMimeType('application/vnd.apache.thrift.json; charset=utf-8');
+
+    if (callback) {
+      xreq.onreadystatechange = function () {
+        if (this.readyState !== 4)
+          return;
+
+        var body = responseBody(this);
+        if (body !== undefined) {
+          self.setRecvBuffer(body);
+          callback();
+        }
+      };
+
+      xreq.onerror = function () {
+        self.setRecvBuffer('');
+        callback();
+      };
+    }
+
+    xreq.open('POST', this.url, !!async);
+
+    Object.keys(this.customHeaders || {}).forEach(function (header) {
+      xreq.setRequestHeader(header, self.customHeaders[header]);
+    });
+
+    xreq.setRequestHeader(
+      'Accept', 'application/vnd.apache.thrift.json; charset=utf-8');
+    xreq.setRequestHeader(
+      'Content-Type', 'application/vnd.apache.thrift.json; charset=utf-8');
+
+    if (entry)
+      xreq.setRequestHeader('If-None-Match', entry.etag);
+
+    xreq.send(message);
+
+    if (async && callback)
+      return;
+
+    if (xreq.readyState !== 4)
+      throw 'encountered an unknown ajax ready state: ' + xreq.readyState;
+
+    var body = responseBody(xreq);
+    if (body === undefined)
+      throw 'encountered a unknown request status: ' + xreq.status;
+
+    this.setRecvBuffer(body);
+  };
+
+  return CachingTransport;
+});
@@ -1,7 +1,8 @@
 define([
+  'codecompass/cachingTransport',
   'codecompass/urlHandler',
   'exports'],
-function (urlHandler, exports) {
+function (CachingTransport, urlHandler, exports) {
 
   /**
    * This object is mapping a file type with a service.
@@ -21,7 +22,7 @@ function (urlHandler, exports) {
         url = workspace + '/' + url;
 
       var service
-        = new Client(new Thrift.Protocol(new Thrift.Transport(url)));
+        = new Client(new Thrift.Protocol(new CachingTransport(url)));
 
       //--- Map filetypes to service for each language service ---//
 
@@ -0,0 +1,493 @@
+define([],
+function () {
+
+  var FONT_SIZE = 14;
+  var CHAR_WIDTH = 7;
+  var LINE_HEIGHT = 17;
+  var NODE_PADDING = 12;
+  var RANK_GAP = 60;
+  var ORDER_GAP = 24;
+  var CLUSTER_PADDING = 12;
+  var MARGIN = 20;
+
+  /**
+   * This function rounds a coordinate to one decimal place.
+   */
+  function num(value) {
+    return Math.round(value * 10) / 10;
+  }
+
+  /**
+   * This function escapes the given text for an SVG attribute or text node.
+   */
+  function escapeXml(text) {
+    return String(text)
+      .replace(/&/g, '&amp;')
+      .replace(/</g, '&lt;')
+      .replace(/>/g, '&gt;')
+      .replace(/"/g, '&quot;');
+  }
+
+  /**
+   * This function returns the lines of a Graphviz label. The tags of
+   * HTML-like labels are dropped, their table rows and line breaks become
+   * separate lines.
+   */
+  function labelLines(object) {
+    var attributes = object.attributes || {};
+    var label = attributes.label;
+
+    if (label === undefined)
+      return [object.id];
+
+    if (object.html && object.html.indexOf('label') !== -1) {
+      label = label
+        .replace(/<br\s*\/?>|<\/tr>/gi, '\n')
+        .replace(/<[^>]*>/g, '')
+        .replace(/&lt;/g, '<')
+        .replace(/&gt;/g, '>')
+        .replace(/&quot;/g, '"')
+        .replace(/&nbsp;/g, ' ')
+        .replace(/&amp;/g, '&');
+    } else {
+      label = label.replace(/\\[nlr]/g, '\n');
+    }
+
+    var lines = label.split('\n').map(function (line) {
+      return line.trim();
+    }).filter(function (line) {
+      return line.length !== 0;
+    });
+
+    return lines.length ? lines : [''];
+  }
+
+  /**
+   * This function assigns a rank to every node: the length of the longest
+   * path leading to it. The edges closing a cycle are ignored.
+   */
+  function computeRanks(nodeIds, edges) {
+    var outgoing = {};
+    var state = {};
+    var order = [];
+
+    nodeIds.forEach(function (id) { outgoing[id] = []; });
+
+    edges.forEach(function (edge) {
+      if (outgoing[edge.from] && outgoing[edge.to] && edge.from !== edge.to)
+        outgoing[edge.from].push(edge.to);
+    });
+
+    // Depth-first search for a topological order. The back edges are the ones
+    // closing a cycle.
+    var back = {};
+
+    nodeIds.forEach(function (root) {
+      if (state[root])
+        return;
+
+      var stack = [{ id : root, next : 0 }];
+      state[root] = 1;
+
+      while (stack.length) {
+        var top = stack[stack.length - 1];
+        var targets = outgoing[top.id];
+
+        if (top.next < targets.length) {
+          var target = targets[top.next++];
+
+          if (state[target] === 1)
+            back[top.id + '\n' + target] = true;
+          else if (!state[target]) {
+            state[target] = 1;
+            stack.push({ id : target, next : 0 });
+          }
+        } else {
+          state[top.id] = 2;
+          order.push(top.id);
+          stack.pop();
+        }
+      }
+    });
+
+    var ranks = {};
+    nodeIds.forEach(function (id) { ranks[id] = 0; });
+
+    for (var i = order.length - 1; i >= 0; --i) {
+      var from = order[i];
+
+      outgoing[from].forEach(function (to) {
+        if (!back[from + '\n' + to])
+          ranks[to] = Math.max(ranks[to], ranks[from] + 1);
+      });
+    }
+
+    return ranks;
+  }
+
+  /**
+   * This function lays out the graph in layers along the rank direction of
+   * the graph (the rankdir attribute, as in Graphviz). Inside a layer the
+   * nodes are ordered by the average position of their predecessors.
+   * @return The position (center) and size of every node.
+   */
+  function layout(graph) {
+    var rankdir = (graph.attributes && graph.attributes.rankdir) || 'TB';
+    var horizontal = rankdir === 'LR' || rankdir === 'RL';
+
+    var boxes = {};
+    var nodeIds = graph.nodes.map(function (node) {
+      var lines = labelLines(node);
+      var width = Math.max.apply(null, lines.map(function (line) {
+        return line.length;
+      })) * CHAR_WIDTH + 2 * NODE_PADDING;
+      var height = lines.length * LINE_HEIGHT + NODE_PADDING;
+
+      var shape = node.attributes.shape;
+      if (shape === 'diamond') {
+        width *= 1.6;
+        height *= 1.6;
+      } else if (shape !== 'box' && shape !== 'rect' &&
+                 shape !== 'rectangle' && shape !== 'record' &&
+                 shape !== 'Mrecord' && shape !== 'plaintext') {
+        width *= 1.2;
+        height *= 1.2;
+      }
+
+      boxes[node.id] = {
+        lines : lines,
+        width : num(Math.max(width, 40)),
+        height : num(Math.max(height, 30))
+      };
+
+      return node.id;
+    });
+
+    var ranks = computeRanks(nodeIds, graph.edges);
+
+    //--- Layers ---//
+
+    var layers = [];
+    nodeIds.forEach(function (id) {
+      var rank = ranks[id];
+      (layers[rank] = layers[rank] || []).push(id);
+    });
+
+    var predecessors = {};
+    graph.edges.forEach(function (edge) {
+      (predecessors[edge.to] = predecessors[edge.to] || []).push(edge.from);
+    });
+
+    var position = {};
+
+    layers.forEach(function (layer) {
+      if (!layer)
+        return;
+
+      var keys = {};
+      layer.forEach(function (id, index) {
+        var placed = (predecessors[id] || []).filter(function (pred) {
+          return position[pred] !== undefined;
+        });
+
+        keys[id] = placed.length
+          ? placed.reduce(function (sum, pred) {
+              return sum + position[pred];
+            }, 0) / placed.length
+          : index;
+      });
+
+      layer.sort(function (lhs, rhs) { return keys[lhs] - keys[rhs]; });
+      layer.forEach(function (id, index) { position[id] = index; });
+    });
+
+    //--- Coordinates ---//
+
+    // The rank axis is vertical for TB and BT, horizontal for LR and RL.
+    function along(box) { return horizontal ? box.width : box.height; }
+    function across(box) { return horizontal ? box.height : box.width; }
+
+    var layerThickness = layers.map(function (layer) {
+      return Math.max.apply(null, (layer || []).map(function (id) {
+        return along(boxes[id]);
+      }).concat([0]));
+    });
+
+    var layerLength = layers.map(function (layer) {
+      return (layer || []).reduce(function (sum, id) {
+        return sum + across(boxes[id]) + ORDER_GAP;
+      }, -ORDER_GAP);
+    });
+
+    var maxLength = Math.max.apply(null, layerLength.concat([0]));
+    var rankPos = 0;
+
+    layers.forEach(function (layer, rank) {
+      if (!layer)
+        return;
+
+      var orderPos = (maxLength - layerLength[rank]) / 2;
+      var center = rankPos + layerThickness[rank] / 2;
+
+      layer.forEach(function (id) {
+        var box = boxes[id];
+        var mid = orderPos + across(box) / 2;
+
+        box.x = num(horizontal ? center : mid);
+        box.y = num(horizontal ? mid : center);
+
+        orderPos += across(box) + ORDER_GAP;
+      });
+
+      rankPos += layerThickness[rank] + RANK_GAP;
+    });
+
+    // The first rank is at the bottom or on the right.
+    nodeIds.forEach(function (id) {
+      if (rankdir === 'BT')
+        boxes[id].y = -boxes[id].y;
+      else if (rankdir === 'RL')
+        boxes[id].x = -boxes[id].x;
+    });
+
+    return boxes;
+  }
+
+  /**
+   * This function returns the point where the line from the center of the
+   * node towards (dx, dy) leaves its shape.
+   */
+  function borderPoint(box, shape, dx, dy) {
+    var a = box.width / 2;
+    var b = box.height / 2;
+    var t;
+
+    if (dx === 0 && dy === 0)
+      return { x : box.x, y : box.y };
+
+    if (shape === 'diamond')
+      t = 1 / (Math.abs(dx) / a + Math.abs(dy) / b);
+    else if (shape === 'box' || shape === 'rect' || shape === 'rectangle' ||
+             shape === 'record' || shape === 'Mrecord' ||
+             shape === 'plaintext')
+      t = Math.min(
+        dx ? a / Math.abs(dx) : Infinity,
+        dy ? b / Math.abs(dy) : Infinity);
+    else
+      t = 1 / Math.sqrt((dx * dx) / (a * a) + (dy * dy) / (b * b));
+
+    return { x : num(box.x + dx * t), y : num(box.y + dy * t) };
+  }
+
+  function renderShape(box, attributes) {
+    var shape = attributes.shape;
+    var filled = (attributes.style || '').indexOf('filled') !== -1;
+    var fill = filled
+      ? attributes.fillcolor || attributes.color || 'lightgrey'
+      : 'white';
+    var paint = 'fill="' + escapeXml(fill) + '" stroke="'
+      + escapeXml(attributes.color || 'black') + '"';
+
+    var a = box.width / 2;
+    var b = box.height / 2;
+
+    if (shape === 'plaintext')
+      return '';
+
+    if (shape === 'diamond')
+      return '<polygon ' + paint + ' points="'
+        + box.x + ',' + (box.y - b) + ' ' + (box.x + a) + ',' + box.y + ' '
+        + box.x + ',' + (box.y + b) + ' ' + (box.x - a) + ',' + box.y + '"/>';
+
+    if (shape === 'box' || shape === 'rect' || shape === 'rectangle' ||
+        shape === 'record' || shape === 'Mrecord')
+      return '<rect ' + paint + ' x="' + (box.x - a) + '" y="' + (box.y - b)
+        + '" width="' + box.width + '" height="' + box.height + '"'
+        + (shape === 'Mrecord' ? ' rx="6" ry="6"' : '') + '/>';
+
+    return '<ellipse ' + paint + ' cx="' + box.x + '" cy="' + box.y
+      + '" rx="' + a + '" ry="' + b + '"/>';
+  }
+
+  function renderText(box, attributes) {
+    var top = num(
+      box.y - (box.lines.length * LINE_HEIGHT) / 2 + FONT_SIZE - 2);
+
+    return '<text text-anchor="middle" font-family="Times,serif" font-size="'
+      + FONT_SIZE + '" fill="' + escapeXml(attributes.fontcolor || 'black')
+      + '">' + box.lines.map(function (line, i) {
+        return '<tspan x="' + box.x + '" y="' + (top + i * LINE_HEIGHT)
+          + '">' + escapeXml(line) + '</tspan>';
+      }).join('') + '</text>';
+  }
+
+  function renderEdge(edge, boxes, shapes) {
+    var from = boxes[edge.from];
+    var to = boxes[edge.to];
+
+    if (!from || !to)
+      return '';
+
+    var attributes = edge.attributes || {};
+    var color = escapeXml(attributes.color || 'black');
+    var style = attributes.style || '';
+    var dash = style.indexOf('dashed') !== -1 ? ' stroke-dasharray="5,2"'
+      : style.indexOf('dotted') !== -1 ? ' stroke-dasharray="1,5"' : '';
+
+    var dx = to.x - from.x;
+    var dy = to.y - from.y;
+    var start = borderPoint(from, shapes[edge.from], dx, dy);
+    var end = borderPoint(to, shapes[edge.to], -dx, -dy);
+
+    var length = Math.sqrt(dx * dx + dy * dy) || 1;
+    var ux = dx / length;
+    var uy = dy / length;
+
+    // The line ends at the base of the arrowhead.
+    var baseX = end.x - ux * 10;
+    var baseY = end.y - uy * 10;
+
+    var result = '<g id="' + escapeXml(edge.id) + '" class="edge">'
+      + '<path fill="none" stroke="' + color + '"' + dash + ' d="M'
+      + start.x + ',' + start.y + 'L' + num(baseX) + ',' + num(baseY) + '"/>';
+
+    if (attributes.arrowhead !== 'none') {
+      var hollow = attributes.arrowhead === 'empty' ||
+                   attributes.arrowhead === 'onormal';
+
+      result += '<polygon fill="' + (hollow ? 'white' : color)
+        + '" stroke="' + color + '" points="'
+        + end.x + ',' + end.y + ' '
+        + num(baseX - uy * 4) + ',' + num(baseY + ux * 4) + ' '
+        + num(baseX + uy * 4) + ',' + num(baseY - ux * 4) + '"/>';
+    }
+
+    return result + '</g>';
+  }
+
+  /**
+   * This function returns the rectangle around the nodes of the cluster,
+   * including the place of its label, or null if none of its nodes is drawn.
+   */
+  function clusterRect(cluster, boxes) {
+    var members = cluster.nodes.map(function (id) {
+      return boxes[id];
+    }).filter(function (box) { return box; });
+
+    if (!members.length)
+      return null;
+
+    var left = Math.min.apply(null, members.map(function (box) {
+      return box.x - box.width / 2;
+    })) - CLUSTER_PADDING;
+    var right = Math.max.apply(null, members.map(function (box) {
+      return box.x + box.width / 2;
+    })) + CLUSTER_PADDING;
+    var top = Math.min.apply(null, members.map(function (box) {
+      return box.y - box.height / 2;
+    })) - CLUSTER_PADDING - LINE_HEIGHT;
+    var bottom = Math.max.apply(null, members.map(function (box) {
+      return box.y + box.height / 2;
+    })) + CLUSTER_PADDING;
+
+    return { left : left, top : top, right : right, bottom : bottom };
+  }
+
+  function renderCluster(cluster, rect) {
+    var attributes = cluster.attributes || {};
+
+    return '<g id="' + escapeXml(cluster.id) + '" class="cluster">'
+      + '<rect fill="none" stroke="' + escapeXml(attributes.color || 'black')
+      + '" x="' + num(rect.left) + '" y="' + num(rect.top) + '" width="'
+      + num(rect.right - rect.left) + '" height="'
+      + num(rect.bottom - rect.top) + '"/>'
+      + '<text text-anchor="middle" font-family="Times,serif" font-size="'
+      + FONT_SIZE + '" x="' + num((rect.left + rect.right) / 2) + '" y="'
+      + num(rect.top + LINE_HEIGHT - 2) + '">'
+      + escapeXml(attributes.label || '') + '</text></g>';
+  }
+
+  return {
+    /**
+     * This function lays out and draws a graph which is given in the JSON
+     * format of the diagrams (see DiagramFormat.JSON in language.thrift).
+     * The structure of the result is similar to the SVG output of Graphviz:
+     * the nodes are "node" class groups of which the id is the node ID, so the
+     * same mouse handlers can be used for both.
+     * @param {Object} graph The parsed JSON graph.
+     * @return {String} The diagram as an SVG document.
+     */
+    render : function (graph) {
+      graph.attributes = graph.attributes || {};
+      graph.nodes.forEach(function (node) {
+        node.attributes = node.attributes || {};
+      });
+
+      var boxes = layout(graph);
+
+      var shapes = {};
+      graph.nodes.forEach(function (node) {
+        shapes[node.id] = node.attributes.shape;
+      });
+
+      //--- Bounding box ---//
+
+      var rects = graph.nodes.map(function (node) {
+        var box = boxes[node.id];
+
+        return {
+          left : box.x - box.width / 2,
+          top : box.y - box.height / 2,
+          right : box.x + box.width / 2,
+          bottom : box.y + box.height / 2
+        };
+      });
+
+      var clusters = (graph.clusters || []).map(function (cluster) {
+        var rect = clusterRect(cluster, boxes);
+        if (rect)
+          rects.push(rect);
+        return { cluster : cluster, rect : rect };
+      });
+
+      function bound(side, fn) {
+        return rects.length
+          ? fn.apply(null, rects.map(function (rect) { return rect[side]; }))
+          : 0;
+      }
+
+      var left = bound('left', Math.min) - MARGIN;
+      var top = bound('top', Math.min) - MARGIN;
+      var width = num(bound('right', Math.max) + MARGIN - left);
+      var height = num(bound('bottom', Math.max) + MARGIN - top);
+
+      //--- Drawing ---//
+
+      var svg = '<svg xmlns="http://www.w3.org/2000/svg" width="'
+        + width + 'pt" height="' + height + 'pt" viewBox="0 0 '
+        + width + ' ' + height + '">'
+        + '<g class="graph" transform="translate(' + num(-left) + ' '
+        + num(-top) + ')">';
+
+      clusters.forEach(function (item) {
+        if (item.rect)
+          svg += renderCluster(item.cluster, item.rect);
+      });
+
+      graph.edges.forEach(function (edge) {
+        svg += renderEdge(edge, boxes, shapes);
+      });
+
+      graph.nodes.forEach(function (node) {
+        var box = boxes[node.id];
+
+        svg += '<g id="' + escapeXml(node.id) + '" class="node">'
+          + renderShape(box, node.attributes)
+          + renderText(box, node.attributes)
+          + '</g>';
+      });
+
+      return svg + '</g></svg>';
+    }
+  };
+});
@@ -10,9 +10,11 @@ require([
   'dijit/Dialog',
   'codecompass/urlHandler',
   'codecompass/viewHandler',
-  'codecompass/model'],
+  'codecompass/model',
+  'codecompass/view/component/ContextMenu',
+  'codecompass/view/component/GraphRenderer'],
 function (declare, attr, dom, query, topic, BorderContainer, ContentPane,
-  Button, Dialog, urlHandler, viewHandler, model) {
+  Button, Dialog, urlHandler, viewHandler, model, ContextMenu, GraphRenderer) {
 
   var Diagram = declare(BorderContainer, {
     constructor : function () {
@@ -77,40 +79,7 @@ function (declare, attr, dom, query, topic, BorderContainer, ContentPane,
         }));
 
         this._handler.getDiagram(diagramType, node, function (svg) {
-          if (svg) {
-            var svgDom = dom.toDom(svg);
-  
-            // Remove default browser tooltips.
-            // TODO: Sometimes the default browser tooltips are in an <a> tag
-            // which contains an xlink:title attribute. This is the case for
-            // example in "provides" relation where the provided functions are
-            // listed in the tooltip. These should also be placed in a Dojo
-            // Tooltip so these can also be removed from the diagram.
-            query('.node title', svgDom).forEach(function (node) {
-              dom.destroy(node);
-            });
-  
-            query('.edge title', svgDom).forEach(function (node) {
-              dom.destroy(node);
-            });
-  
-            query('.graph title', svgDom).forEach(function (node) {
-              dom.destroy(node);
-            });
-  
-            that._diagCont.set('content', svgDom);
-            that._svg = svg;
-
-            that._setDiagramZoomable();
-            that._setMouseEvents();
-          } else {
-            that._diagCont.set('content', dom.create('div', {
-              innerHTML : 'No diagram',
-              style : 'margin: 100px 0px 0px 10px;\
-                text-align: center;\
-                font-weight: bold'
-            }));
-          }
+          that._showDiagram(svg);
         });
       } catch (ex) {
         console.error(ex);
@@ -118,6 +87,53 @@ function (declare, attr, dom, query, topic, BorderContainer, ContentPane,
       }
     },
 
+    /**
+     * This function displays the diagram given by the handler: either an SVG
+     * laid out by the server or a graph model in the JSON format of the
+     * diagrams, which is laid out here.
+     */
+    _showDiagram : function (svg) {
+      var that = this;
+
+      if (svg && typeof svg === 'object')
+        svg = svg.nodes.length ? GraphRenderer.render(svg) : null;
+
+      if (svg) {
+        var svgDom = dom.toDom(svg);
+  
+        // Remove default browser tooltips.
+        // TODO: Sometimes the default browser tooltips are in an <a> tag
+        // which contains an xlink:title attribute. This is the case for
+        // example in "provides" relation where the provided functions are
+        // listed in the tooltip. These should also be placed in a Dojo
+        // Tooltip so these can also be removed from the diagram.
+        query('.node title', svgDom).forEach(function (node) {
+          dom.destroy(node);
+        });
+  
+        query('.edge title', svgDom).forEach(function (node) {
+          dom.destroy(node);
+        });
+  
+        query('.graph title', svgDom).forEach(function (node) {
+          dom.destroy(node);
+        });
+  
+        that._diagCont.set('content', svgDom);
+        that._svg = svg;
+
+        that._setDiagramZoomable();
+        that._setMouseEvents();
+      } else {
+        that._diagCont.set('content', dom.create('div', {
+          innerHTML : 'No diagram',
+          style : 'margin: 100px 0px 0px 10px;\
+            text-align: center;\
+            font-weight: bold'
+        }));
+      }
+    },
+
     setState : function (state) {
       if ( state.center !== this.id ||
           !state.diagNode ||
@@ -219,6 +235,43 @@ function (declare, attr, dom, query, topic, BorderContainer, ContentPane,
       nodes.on('mousedown', function (event) {
         clickPos = { x : event.clientX, y : event.clientY };
       });
+
+      //--- Context menu of nodes ---//
+
+      if (this._contextMenu) {
+        this._contextMenu.destroyRecursive();
+        this._contextMenu = null;
+      }
+
+      // Handlers of incremental diagrams give actions which change the graph
+      // model of the diagram, e.g. expand or collapse a node.
+      if (!this._handler.getNodeActions)
+        return;
+
+      var contextMenu = new ContextMenu({
+        targetNodeIds : [this._diagCont.id],
+        selector      : '.node'
+      });
+
+      nodes.on('contextmenu', function () {
+        var nodeId = this.id;
+
+        contextMenu.clear();
+
+        that._handler.getNodeActions(that._diagramType, nodeId).forEach(
+        function (action) {
+          contextMenu.addChild({
+            label   : action.label,
+            onClick : function () {
+              action.action(function (graph) {
+                that._showDiagram(graph);
+              });
+            }
+          });
+        });
+      });
+
+      this._contextMenu = contextMenu;
     }
   });
 
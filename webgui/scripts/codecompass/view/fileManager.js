@@ -217,6 +217,7 @@ function (on, query, dom, style, domConstruct, topic, declare, Memory,
       if (!node.isExpandable)
         topic.publish('codecompass/openFile', {
           fileId     : item.fileInfo.id,
+          fileInfo   : item.fileInfo,
           moduleId   : 'text',
           info       : 'Open file: ' + item.fileInfo.name,
           newSession : true
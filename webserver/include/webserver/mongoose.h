@@ -92,6 +92,7 @@ const char **mg_get_valid_option_names(void);
 const char *mg_get_option(const struct mg_server *server, const char *name);
 void mg_set_listening_socket(struct mg_server *, int sock);
 int mg_get_listening_socket(struct mg_server *);
+int mg_get_socket(struct mg_connection *);
 void mg_iterate_over_connections(struct mg_server *, mg_handler_t, void *);
 struct mg_connection *mg_next(struct mg_server *, struct mg_connection *);
 void mg_wakeup_server(struct mg_server *);
@@ -112,6 +113,7 @@ size_t mg_websocket_printf(struct mg_connection* conn, int opcode,
                            const char *fmt, ...);
 
 void mg_send_file(struct mg_connection *, const char *path);
+void mg_send_file_fd(struct mg_connection *, int fd, size_t len);
 
 const char *mg_get_header(const struct mg_connection *, const char *name);
 const char *mg_get_mime_type(const char *name, const char *default_mime_type);
@@ -1,6 +1,7 @@
 #ifndef CC_WEBSERVER_PLUGINHELPER_H
 #define CC_WEBSERVER_PLUGINHELPER_H
 
+#include <algorithm>
 #include <memory>
 
 #include <boost/filesystem.hpp>
@@ -23,6 +24,31 @@ namespace cc
 namespace webserver
 {
 
+/**
+ * Returns the maximal number of identical concurrent service calls answered by
+ * a single computation, or 0 if coalescing is turned off. See ThriftHandler.
+ */
+inline std::size_t maxCoalescedRequests(const ServerContext& ctx_)
+{
+  return ctx_.options.count("coalesce-requests")
+    ? std::max(ctx_.options["coalesce-requests"].as<int>(), 0)
+    : 0;
+}
+
+/**
+ * Returns the file of which the modification time identifies the current
+ * version of the parsed workspace in the given data directory, or an empty
+ * string if ETags are turned off. See ThriftHandler.
+ */
+inline std::string workspaceVersionFile(
+  const ServerContext& ctx_,
+  const std::string& datadir_)
+{
+  return ctx_.options.count("etag") && !ctx_.options["etag"].as<bool>()
+    ? std::string()
+    : datadir_ + "/project_info.json";
+}
+
 template <typename RequestHandlerT, typename ServiceFactoryT>
 inline void registerPluginSimple(
   const ServerContext& ctx_,
@@ -77,6 +103,9 @@ inline void registerPluginSimple(
       continue;
     }
 
+    // The workspace may have been parsed by an earlier version.
+    util::upgradeSchema(db);
+
     try
     {
       // Create handler
@@ -105,24 +134,43 @@ inline void registerPluginSimple(
       "There are no parsed projects in the given workspace directory.");
 }
 
-#define CODECOMPASS_SERVICE_FACTORY_WITH_CFG(serviceName, nspace) \
+/**
+ * These macros create the factory of a service handler for
+ * registerPluginSimple(). The handler is wrapped into a ThriftHandler which
+ * coalesces the identical concurrent calls and answers the conditional
+ * requests by 304 Not Modified when the workspace hasn't changed.
+ *
+ * pureMethods is an std::unordered_set<std::string> of the names of the
+ * service methods which have no side effects and of which the result depends
+ * only on the arguments and the parsed workspace, not on the session. Only the
+ * calls of these methods are coalesced and get ETags, the other calls are
+ * always executed. See the pureMethods_ parameter of ThriftHandler.
+ */
+#define CODECOMPASS_SERVICE_FACTORY_WITH_CFG(serviceName, nspace, pureMethods) \
   [](std::shared_ptr<odb::database>& db_, \
      std::shared_ptr<std::string> datadir_, \
      const cc::webserver::ServerContext& ctx_) { \
     return new cc::webserver::ThriftHandler< \
       cc::service::nspace::serviceName##ServiceProcessor>( \
         new cc::service::nspace::serviceName##ServiceHandler( \
-          db_, datadir_, ctx_)); \
+          db_, datadir_, ctx_), \
+        cc::webserver::maxCoalescedRequests(ctx_), \
+        cc::webserver::workspaceVersionFile(ctx_, *datadir_), \
+        pureMethods); \
   }
 
-#define CODECOMPASS_LANGUAGE_SERVICE_FACTORY_WITH_CFG(serviceName) \
+#define CODECOMPASS_LANGUAGE_SERVICE_FACTORY_WITH_CFG( \
+  serviceName, pureMethods) \
   [](std::shared_ptr<odb::database>& db_, \
      std::shared_ptr<std::string> datadir_, \
      const cc::webserver::ServerContext& ctx_) { \
     return new cc::webserver::ThriftHandler< \
       cc::service::language::LanguageServiceProcessor>( \
         new cc::service::language::serviceName##ServiceHandler( \
-          db_, datadir_, ctx_)); \
+          db_, datadir_, ctx_), \
+        cc::webserver::maxCoalescedRequests(ctx_), \
+        cc::webserver::workspaceVersionFile(ctx_, *datadir_), \
+        pureMethods); \
   }
 
 } // webserver
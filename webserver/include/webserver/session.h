@@ -2,6 +2,10 @@
 #define CC_WEBSERVER_SESSION_H
 
 #include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -31,14 +35,43 @@ public:
 
   SessionTimePoint lastHit() const { return _lastHit; }
 
+  /**
+   * Returns the object stored in the session by the given key. If there is no
+   * such object yet, it is created by factory_. Services can keep state
+   * between the requests of a user this way, which is released together with
+   * the session, i.e. when it expires or the user logs out.
+   */
+  template <typename T, typename F>
+  std::shared_ptr<T> getData(const std::string& key_, F factory_)
+  {
+    return std::static_pointer_cast<T>(getDataImpl(key_,
+      [&factory_]() -> std::shared_ptr<void> { return factory_(); }));
+  }
+
   const std::string sessId;
   const std::string username;
 
 private:
+  struct Data
+  {
+    std::mutex lock;
+    std::map<std::string, std::shared_ptr<void>> objects;
+  };
+
+  std::shared_ptr<void> getDataImpl(
+    const std::string& key_,
+    const std::function<std::shared_ptr<void> ()>& factory_);
+
   /**
    * The last time the cookie was found in a request for this session.
    */
   SessionTimePoint _lastHit;
+
+  /**
+   * Objects stored in the session by the services. The session objects are
+   * moved into the session manager, hence the indirection.
+   */
+  std::shared_ptr<Data> _data;
 };
 
 /**
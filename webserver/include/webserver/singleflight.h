@@ -0,0 +1,147 @@
+#ifndef CC_WEBSERVER_SINGLEFLIGHT_H
+#define CC_WEBSERVER_SINGLEFLIGHT_H
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <util/cancellation.h>
+
+namespace cc
+{
+namespace webserver
+{
+
+/**
+ * @brief Coalescing of identical concurrent computations.
+ *
+ * If a computation with the same key is already in flight then the caller
+ * doesn't start a new one, but waits for the running one (the leader) and
+ * gets a copy of its result. At most maxFollowers_ callers may wait for the
+ * same computation, so that a single slow key can't tie up every webserver
+ * thread. Further callers compute the result on their own.
+ *
+ * A result is shared only if the leader finished normally: if it threw an
+ * exception or its request has been cancelled (see util::CancellationToken)
+ * then the followers retry, and one of them becomes the new leader.
+ */
+class SingleFlight
+{
+public:
+  typedef std::function<std::string ()> Computation;
+
+  /**
+   * @param maxFollowers_ Maximal number of callers waiting for the same
+   * computation.
+   */
+  SingleFlight(std::size_t maxFollowers_) : _maxFollowers(maxFollowers_)
+  {
+  }
+
+  /**
+   * Returns the result of func_ for the given key, either by computing it or
+   * by waiting for an identical computation in flight.
+   * @param shared_ Set to true if the result comes from another computation.
+   */
+  std::string run(const std::string& key_, Computation func_, bool& shared_)
+  {
+    shared_ = false;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true)
+    {
+      auto it = _flights.find(key_);
+
+      if (it == _flights.end())
+        break;
+
+      std::shared_ptr<Flight> flight = it->second;
+
+      if (flight->followers >= _maxFollowers)
+      {
+        // Too many waiters, compute independently without becoming a leader.
+        lock.unlock();
+        return func_();
+      }
+
+      ++flight->followers;
+      flight->cond.wait(lock, [&flight]{ return flight->done; });
+      --flight->followers;
+
+      if (flight->succeeded)
+      {
+        shared_ = true;
+        return flight->result;
+      }
+
+      // The leader failed, its entry is already removed: retry.
+    }
+
+    std::shared_ptr<Flight> flight = std::make_shared<Flight>();
+    _flights[key_] = flight;
+    lock.unlock();
+
+    std::string result;
+    bool succeeded = false;
+
+    try
+    {
+      result = func_();
+      succeeded = !util::CancellationToken::isCurrentCancelled();
+    }
+    catch (...)
+    {
+      finish(key_, flight, result, false);
+      throw;
+    }
+
+    finish(key_, flight, result, succeeded);
+    return result;
+  }
+
+private:
+  struct Flight
+  {
+    std::condition_variable cond;
+    std::string result;
+    std::size_t followers = 0;
+    bool done = false;
+    bool succeeded = false;
+  };
+
+  /**
+   * Publishes the result of the leader and wakes up the followers.
+   */
+  void finish(
+    const std::string& key_,
+    const std::shared_ptr<Flight>& flight_,
+    const std::string& result_,
+    bool succeeded_)
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+
+    _flights.erase(key_);
+
+    flight_->done = true;
+    flight_->succeeded = succeeded_;
+
+    if (succeeded_ && flight_->followers)
+      flight_->result = result_;
+
+    flight_->cond.notify_all();
+  }
+
+  const std::size_t _maxFollowers;
+
+  std::mutex _mutex;
+  std::map<std::string, std::shared_ptr<Flight>> _flights;
+};
+
+} // webserver
+} // cc
+
+#endif // CC_WEBSERVER_SINGLEFLIGHT_H
@@ -2,16 +2,22 @@
 #define CC_WEBSERVER_THRIFTHANDLER_H
 
 #include <stdio.h>
+#include <cctype>
 #include <memory>
+#include <unordered_set>
 
 #include <thrift/transport/TBufferTransports.h>
 #include <thrift/transport/THttpServer.h>
 #include <thrift/transport/TTransport.h>
 #include <thrift/protocol/TJSONProtocol.h>
 
+#include <util/cancellation.h>
+#include <util/filesystem.h>
+#include <util/hash.h>
 #include <util/logutil.h>
 
 #include "mongoose.h"
+#include "singleflight.h"
 
 /**
  * Returns the demangled name of the type described by the given type info.
@@ -44,6 +50,65 @@ namespace cc
 namespace webserver
 {
 
+/**
+ * Finds the sequence id in a message of Thrift's JSON protocol. The message
+ * starts with a header like [1,"methodName",1,42,...] where 42 is the
+ * sequence id.
+ *
+ * @param begin_ The position of the first character of the sequence id.
+ * @param end_ The position after the last character of the sequence id.
+ * @return False if the message header is malformed.
+ */
+inline bool findThriftJsonSeqId(
+  const std::string& message_,
+  std::size_t& begin_,
+  std::size_t& end_)
+{
+  // Method names can't contain quotes, so the end of the name is the next
+  // quote after the opening one.
+  std::size_t nameBegin = message_.find('"');
+  if (nameBegin == std::string::npos)
+    return false;
+
+  std::size_t nameEnd = message_.find('"', nameBegin + 1);
+  if (nameEnd == std::string::npos)
+    return false;
+
+  std::size_t typeEnd = message_.find(',', nameEnd + 2);
+  if (typeEnd == std::string::npos)
+    return false;
+
+  begin_ = typeEnd + 1;
+  end_ = message_.find(',', begin_);
+
+  if (end_ == std::string::npos || end_ == begin_)
+    return false;
+
+  for (std::size_t i = begin_; i < end_; ++i)
+    if (!std::isdigit(static_cast<unsigned char>(message_[i])) &&
+        message_[i] != '-')
+      return false;
+
+  return true;
+}
+
+/**
+ * Returns the method name in a message of Thrift's JSON protocol, or an empty
+ * string if the message header is malformed.
+ */
+inline std::string getThriftJsonMethodName(const std::string& message_)
+{
+  std::size_t nameBegin = message_.find('"');
+  if (nameBegin == std::string::npos)
+    return std::string();
+
+  std::size_t nameEnd = message_.find('"', nameBegin + 1);
+  if (nameEnd == std::string::npos)
+    return std::string();
+
+  return message_.substr(nameBegin + 1, nameEnd - nameBegin - 1);
+}
+
 template<class Processor>
 class ThriftHandler : public RequestHandler
 {
@@ -88,15 +153,48 @@ protected:
   };
 
 public:
+  /**
+   * @param maxCoalesced_ If not zero then identical concurrent calls of the
+   * pure methods are answered by a single computation, see SingleFlight. This
+   * is the maximal number of calls waiting for the same computation.
+   * @param versionFile_ If not empty then the responses of the pure methods
+   * get an ETag computed from the modification time of this file and the call
+   * (method name and arguments), and conditional requests with a matching
+   * If-None-Match header are answered by 304 Not Modified without calling the
+   * service. The file has to be rewritten whenever the data behind the service
+   * changes, e.g. the project_info.json of a workspace, which is written by
+   * each parse.
+   * @param pureMethods_ The methods which have no side effects and of which
+   * the result doesn't depend on the session, only on the arguments and the
+   * data behind the version file. The other calls are always executed.
+   */
   template<class Handler>
-  ThriftHandler(Handler *handler_)
-    : _processor(std::shared_ptr<Handler>(handler_))
+  ThriftHandler(
+    Handler *handler_,
+    std::size_t maxCoalesced_ = 0,
+    std::string versionFile_ = std::string(),
+    std::unordered_set<std::string> pureMethods_ = {})
+    : _processor(std::shared_ptr<Handler>(handler_)),
+      _singleFlight(maxCoalesced_ && !pureMethods_.empty()
+        ? std::make_unique<SingleFlight>(maxCoalesced_)
+        : nullptr),
+      _versionFile(std::move(versionFile_)),
+      _pureMethods(std::move(pureMethods_))
   {
   }
 
   template<class Handler>
-  ThriftHandler(Handler handler_)
-    : _processor(handler_)
+  ThriftHandler(
+    Handler handler_,
+    std::size_t maxCoalesced_ = 0,
+    std::string versionFile_ = std::string(),
+    std::unordered_set<std::string> pureMethods_ = {})
+    : _processor(handler_),
+      _singleFlight(maxCoalesced_ && !pureMethods_.empty()
+        ? std::make_unique<SingleFlight>(maxCoalesced_)
+        : nullptr),
+      _versionFile(std::move(versionFile_)),
+      _pureMethods(std::move(pureMethods_))
   {
   }
 
@@ -107,32 +205,71 @@ public:
 
   int beginRequest(struct mg_connection *conn_) override
   {
-    using namespace ::apache::thrift;
-    using namespace ::apache::thrift::transport;
-    using namespace ::apache::thrift::protocol;
-
     try
     {
       std::string content{conn_->content, conn_->content + conn_->content_len};
 
       LOG(debug) << "Request content:\n" << content;
 
-      std::shared_ptr<TTransport> inputBuffer(
-        new TMemoryBuffer((std::uint8_t*)content.c_str(), content.length()));
-
-      std::shared_ptr<TTransport> outputBuffer(new TMemoryBuffer(4096));
-
-      std::shared_ptr<TProtocol> inputProtocol(
-        new TJSONProtocol(inputBuffer));
-      std::shared_ptr<TProtocol> outputProtocol(
-        new TJSONProtocol(outputBuffer));
-
-      CallContext ctx{conn_, nullptr};
-      _processor.process(inputProtocol, outputProtocol, &ctx);
-
-      TMemoryBuffer *mBuffer = dynamic_cast<TMemoryBuffer*>(outputBuffer.get());
-
-      std::string response = mBuffer->getBufferAsString();
+      std::string response;
+      std::size_t seqBegin, seqEnd;
+      bool hasSeqId = findThriftJsonSeqId(content, seqBegin, seqEnd);
+
+      // Only the calls of the pure methods may be coalesced or answered by
+      // 304 Not Modified.
+      bool pure = hasSeqId &&
+        _pureMethods.count(getThriftJsonMethodName(content));
+
+      // The key is the service and the message without its sequence id,
+      // i.e. the method name and the arguments.
+      std::string key;
+      if (pure)
+        key = std::string(conn_->uri) + ' '
+          + content.substr(0, seqBegin) + content.substr(seqEnd);
+
+      std::string etag = pure ? computeETag(key) : std::string();
+
+      if (!etag.empty())
+      {
+        const char* ifNoneMatch = mg_get_header(conn_, "If-None-Match");
+
+        if (ifNoneMatch && etag == ifNoneMatch)
+        {
+          LOG(debug) << "Not modified: " << conn_->uri;
+
+          mg_send_status(conn_, 304);
+          mg_send_header(conn_, "ETag", etag.c_str());
+          mg_send_header(conn_, "Cache-Control", "no-cache");
+          mg_write(conn_, "\r\n", 2);
+
+          return MG_TRUE;
+        }
+      }
+
+      if (_singleFlight && pure)
+      {
+        bool shared;
+        response = _singleFlight->run(
+          key, [&, this]{ return process(conn_, content); }, shared);
+
+        // The response of the leader contains its own sequence id.
+        std::size_t respSeqBegin, respSeqEnd;
+        if (shared &&
+            findThriftJsonSeqId(response, respSeqBegin, respSeqEnd))
+        {
+          LOG(debug) << "Coalesced request: " << conn_->uri;
+
+          response.replace(respSeqBegin, respSeqEnd - respSeqBegin,
+            content, seqBegin, seqEnd - seqBegin);
+        }
+      }
+      else
+        response = process(conn_, content);
+
+      // The response of a cancelled call is an exception which must not be
+      // reused by the client.
+      if (util::CancellationToken::isCurrentCancelled())
+        etag.clear();
 
       LOG(debug)
         << "Response:\n" << response.c_str() << std::endl;
@@ -142,6 +279,16 @@ public:
       mg_send_header(
         conn_, "Content-Length", std::to_string(response.length()).c_str());
 
+      // The client has to revalidate the response before reusing it, because
+      // the workspace may be reparsed any time.
+      if (!etag.empty())
+      {
+        mg_send_header(conn_, "ETag", etag.c_str());
+        mg_send_header(conn_, "Cache-Control", "no-cache");
+      }
+      else
+        mg_send_header(conn_, "Cache-Control", "no-store");
+
       // Terminate headers
       mg_write(conn_, "\r\n", 2);
 
@@ -163,7 +310,61 @@ public:
   }
 
 private:
+  /**
+   * Returns the entity tag of the response for the given call key, which
+   * changes whenever the version file is modified. An empty string is
+   * returned if no version file is given or it can't be accessed.
+   */
+  std::string computeETag(const std::string& key_) const
+  {
+    if (_versionFile.empty())
+      return std::string();
+
+    const std::string version = util::fileVersion(_versionFile);
+
+    if (version.empty())
+      return std::string();
+
+    return '"' + util::sha1Hash(version + ' ' + key_) + '"';
+  }
+
+  /**
+   * Executes the Thrift call in the given request content and returns the
+   * serialized response.
+   */
+  std::string process(struct mg_connection *conn_, const std::string& content_)
+  {
+    using namespace ::apache::thrift;
+    using namespace ::apache::thrift::transport;
+    using namespace ::apache::thrift::protocol;
+
+    std::shared_ptr<TTransport> inputBuffer(
+      new TMemoryBuffer((std::uint8_t*)content_.c_str(), content_.length()));
+
+    std::shared_ptr<TTransport> outputBuffer(new TMemoryBuffer(4096));
+
+    std::shared_ptr<TProtocol> inputProtocol(
+      new TJSONProtocol(inputBuffer));
+    std::shared_ptr<TProtocol> outputProtocol(
+      new TJSONProtocol(outputBuffer));
+
+    CallContext ctx{conn_, nullptr};
+    _processor.process(inputProtocol, outputProtocol, &ctx);
+
+    // A cancelled service call throws util::RequestCancelled, which the
+    // processor sends to the client as an application exception.
+    if (util::CancellationToken::isCurrentCancelled())
+      LOG(debug) << "Request cancelled: " << conn_->uri;
+
+    TMemoryBuffer *mBuffer = dynamic_cast<TMemoryBuffer*>(outputBuffer.get());
+
+    return mBuffer->getBufferAsString();
+  }
+
   LoggingProcessor _processor;
+  std::unique_ptr<SingleFlight> _singleFlight;
+  const std::string _versionFile;
+  const std::unordered_set<std::string> _pureMethods;
 };
 
 } // namespace webserver
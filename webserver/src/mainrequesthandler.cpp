@@ -1,3 +1,8 @@
+#include <cerrno>
+
+#include <sys/socket.h>
+
+#include <util/cancellation.h>
 #include <util/logutil.h>
 #include <util/util.h>
 
@@ -35,6 +40,19 @@ static void writeRedirect(struct mg_connection* conn_, const char* loc_)
   mg_write(conn_, "\r\n\r\n", 4);
 }
 
+/**
+ * Returns true if the peer has closed the connection on the given socket.
+ * The function doesn't consume any data from the socket.
+ */
+static bool isConnectionClosed(int sock_)
+{
+  char c;
+  ssize_t n = ::recv(sock_, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+
+  return n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK
+    && errno != EINTR);
+}
+
 namespace cc
 {
 namespace webserver
@@ -76,7 +94,20 @@ int MainRequestHandler::begin_request_handler(struct mg_connection* conn_)
 
   auto handler = pluginHandler.getImplementation(uri);
   if (handler)
+  {
+    // The request is cancelled if it runs out of time or the client closes
+    // the connection (e.g. the user navigates away), so that the services can
+    // abandon the work. See util::CancellationToken.
+    int sock = mg_get_socket(conn_);
+    util::CancellationScope cancellationScope(
+      std::make_shared<util::CancellationToken>(
+        requestTimeout.count() > 0
+          ? util::CancellationToken::Clock::now() + requestTimeout
+          : util::CancellationToken::Clock::time_point::max(),
+        [sock]() { return isConnectionClosed(sock); }));
+
     return handler->beginRequest(conn_);
+  }
 
   if (uri.find("doxygen/") == 0)
   {
@@ -84,6 +115,9 @@ int MainRequestHandler::begin_request_handler(struct mg_connection* conn_)
     return MG_MORE;
   }
 
+  if (staticFiles)
+    return staticFiles->serve(conn_, uri);
+
   // Returning MG_FALSE tells mongoose that we didn't served the request
   // so mongoose should serve it.
   return MG_FALSE;
@@ -1,9 +1,14 @@
 #ifndef CC_WEBSERVER_MAINREQUESTHANDLER_H
 #define CC_WEBSERVER_MAINREQUESTHANDLER_H
 
+#include <chrono>
+#include <memory>
+
 #include <webserver/pluginhandler.h>
 #include <webserver/requesthandler.h>
 
+#include "staticfilestore.h"
+
 namespace cc
 {
 namespace webserver
@@ -19,6 +24,18 @@ public:
   PluginHandler<RequestHandler> pluginHandler;
   std::map<std::string, std::string> dataDir;
 
+  /**
+   * Requests handled by plugins are cancelled after this duration.
+   * Zero means no deadline.
+   */
+  std::chrono::seconds requestTimeout{0};
+
+  /**
+   * The static files of the web GUI. The files which are not in the store are
+   * served by mongoose from the document root.
+   */
+  std::shared_ptr<StaticFileStore> staticFiles;
+
   int operator()(struct mg_connection* conn_, enum mg_event ev_);
 
 private:
@@ -112,6 +112,9 @@ typedef SOCKET sock_t;
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 #define closesocket(x) close(x)
 #define __cdecl
 #define INVALID_SOCKET (-1)
@@ -209,6 +212,7 @@ struct ns_connection {
 #define NSF_ACCEPTED                (1 << 5)
 #define NSF_WANT_READ               (1 << 6)
 #define NSF_WANT_WRITE              (1 << 7)
+#define NSF_POLL_WRITABLE           (1 << 8)  // Poll even if nothing to send
 
 #define NSF_USER_1                  (1 << 26)
 #define NSF_USER_2                  (1 << 27)
@@ -865,7 +869,8 @@ int ns_server_poll(struct ns_server *server, int milli) {
       ns_add_to_set(conn->sock, &read_set, &max_fd);
     }
     if (((conn->flags & NSF_CONNECTING) && !(conn->flags & NSF_WANT_READ)) ||
-        (conn->send_iobuf.len > 0 && !(conn->flags & NSF_CONNECTING) &&
+        ((conn->send_iobuf.len > 0 || (conn->flags & NSF_POLL_WRITABLE)) &&
+         !(conn->flags & NSF_CONNECTING) &&
          !(conn->flags & NSF_BUFFER_BUT_DONT_SEND))) {
       //DBG(("%p write_set", conn));
       ns_add_to_set(conn->sock, &write_set, &max_fd);
@@ -914,7 +919,8 @@ int ns_server_poll(struct ns_server *server, int milli) {
       if (FD_ISSET(conn->sock, &write_set)) {
         if (conn->flags & NSF_CONNECTING) {
           ns_read_from_socket(conn);
-        } else if (!(conn->flags & NSF_BUFFER_BUT_DONT_SEND)) {
+        } else if (!(conn->flags & NSF_BUFFER_BUT_DONT_SEND) &&
+                   conn->send_iobuf.len > 0) {
           conn->last_io_time = current_time;
           ns_write_to_socket(conn);
         }
@@ -2965,9 +2971,29 @@ static void gmt_time_string(char *buf, size_t buf_len, time_t *t) {
   strftime(buf, buf_len, "%a, %d %b %Y %H:%M:%S GMT", gmtime(t));
 }
 
+// File data of plain (non-SSL) connections is sent by sendfile(), directly
+// from the page cache, instead of copying it to the send buffer.
+static void enable_sendfile(struct connection *conn) {
+#ifdef __linux__
+  if (conn->ns_conn->ssl == NULL) {
+    conn->ns_conn->flags |= NSF_POLL_WRITABLE;
+  }
+#else
+  (void) conn;
+#endif
+}
+
+// Versioned URLs ("?v=<version>") never change their content, so these can
+// be cached forever. Other files have to be revalidated by their Etag.
+static const char *cache_control_header(const struct connection *conn) {
+  const char *qs = conn->mg_conn.query_string;
+  return qs != NULL && !strncmp(qs, "v=", 2) ?
+    "public, max-age=31536000, immutable" : "no-cache";
+}
+
 static void open_file_endpoint(struct connection *conn, const char *path,
                                file_stat_t *st) {
-  char date[64], lm[64], etag[64], range[64], headers[500];
+  char date[64], lm[64], etag[64], range[64], headers[600];
   const char *msg = "OK", *hdr;
   time_t curtime = time(NULL);
   int64_t r1, r2;
@@ -3007,12 +3033,14 @@ static void open_file_endpoint(struct connection *conn, const char *path,
                   "Date: %s\r\n"
                   "Last-Modified: %s\r\n"
                   "Etag: %s\r\n"
+                  "Cache-Control: %s\r\n"
                   "Content-Type: %.*s\r\n"
                   "Content-Length: %" INT64_FMT "\r\n"
                   "Connection: %s\r\n"
                   "Accept-Ranges: bytes\r\n"
                   "%s%s\r\n",
                   conn->mg_conn.status_code, msg, date, lm, etag,
+                  cache_control_header(conn),
                   (int) mime_vec.len, mime_vec.ptr, conn->cl,
                   suggest_connection_header(&conn->mg_conn),
                   range, MONGOOSE_USE_EXTRA_HTTP_HEADERS);
@@ -3022,6 +3050,8 @@ static void open_file_endpoint(struct connection *conn, const char *path,
     conn->ns_conn->flags |= NSF_FINISHED_SENDING_DATA;
     close(conn->endpoint.fd);
     conn->endpoint_type = EP_NONE;
+  } else {
+    enable_sendfile(conn);
   }
 }
 #endif  // MONGOOSE_NO_FILESYSTEM
@@ -4208,6 +4238,15 @@ void mg_send_file(struct mg_connection *c, const char *file_name) {
   const int exists = stat(file_name, &st) == 0;
   mg_send_file_internal(c, file_name, &st, exists);
 }
+
+void mg_send_file_fd(struct mg_connection *c, int fd, size_t len) {
+  struct connection *conn = MG_CONN_2_CONN(c);
+  conn->endpoint_type = EP_FILE;
+  conn->endpoint.fd = fd;
+  conn->cl = (int64_t) len;
+  ns_set_close_on_exec(fd);
+  enable_sendfile(conn);
+}
 #endif  // !MONGOOSE_NO_FILESYSTEM
 
 static void open_local_endpoint(struct connection *conn, int skip_user) {
@@ -4529,7 +4568,8 @@ static void close_local_endpoint(struct connection *conn) {
   conn->cl = conn->num_bytes_sent = conn->request_len = 0;
   conn->ns_conn->flags &= ~(NSF_FINISHED_SENDING_DATA |
                             NSF_BUFFER_BUT_DONT_SEND | NSF_CLOSE_IMMEDIATELY |
-                            MG_HEADERS_SENT | MG_LONG_RUNNING);
+                            NSF_POLL_WRITABLE | MG_HEADERS_SENT |
+                            MG_LONG_RUNNING);
   c->num_headers = c->status_code = c->is_websocket = c->content_len = 0;
   conn->endpoint.nc = NULL;
   c->request_method = c->uri = c->http_version = c->query_string = NULL;
@@ -4547,6 +4587,37 @@ static void transfer_file_data(struct connection *conn) {
   char buf[IOBUF_SIZE];
   int n;
 
+#ifdef __linux__
+  if (conn->ns_conn->flags & NSF_POLL_WRITABLE) {
+    ssize_t sent;
+
+    // The headers must be sent first.
+    if (conn->ns_conn->send_iobuf.len > 0) return;
+
+    sent = sendfile(conn->ns_conn->sock, conn->endpoint.fd, NULL,
+                    conn->cl < (int64_t) (1 << 20) ? (size_t) conn->cl :
+                    (size_t) (1 << 20));
+
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+                     errno == EINTR)) {
+      return;  // Socket buffer is full, wait until it becomes writable
+    } else if (sent < 0) {
+      close_local_endpoint(conn);
+      conn->ns_conn->flags |= NSF_CLOSE_IMMEDIATELY;
+    } else if (sent == 0) {
+      close_local_endpoint(conn);
+    } else {
+      conn->ns_conn->last_io_time = time(NULL);
+      conn->num_bytes_sent += sent;
+      conn->cl -= sent;
+      if (conn->cl <= 0) {
+        close_local_endpoint(conn);
+      }
+    }
+    return;
+  }
+#endif
+
   // If output buffer is too big, don't send anything. Wait until
   // mongoose drains already buffered data to the client.
   if (conn->ns_conn->send_iobuf.len > sizeof(buf) * 2) return;
@@ -5043,6 +5114,10 @@ int mg_get_listening_socket(struct mg_server *server) {
   return server->ns_server.listening_sock;
 }
 
+int mg_get_socket(struct mg_connection *c) {
+  return (int) MG_CONN_2_CONN(c)->ns_conn->sock;
+}
+
 const char *mg_get_option(const struct mg_server *server, const char *name) {
   const char **opts = (const char **) server->config_options;
   int i = get_option_index(name);
@@ -15,10 +15,24 @@ namespace webserver
 
 Session::Session(std::string sessId_, std::string username_)
   : sessId(std::move(sessId_)), username(std::move(username_)),
-    _lastHit(std::chrono::steady_clock::now())
+    _lastHit(std::chrono::steady_clock::now()),
+    _data(std::make_shared<Data>())
 {
 }
 
+std::shared_ptr<void> Session::getDataImpl(
+  const std::string& key_,
+  const std::function<std::shared_ptr<void> ()>& factory_)
+{
+  const std::lock_guard<std::mutex> lock{_data->lock};
+
+  std::shared_ptr<void>& object = _data->objects[key_];
+  if (!object)
+    object = factory_();
+
+  return object;
+}
+
 thread_local Session* SessionManagerAccess::requestSessionOfCurrentTread = nullptr;
 
 Session* SessionManagerAccess::getCurrentSession() const {
@@ -0,0 +1,470 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+#include <zlib.h>
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#include <util/hash.h>
+#include <util/logutil.h>
+#include <util/taskgroup.h>
+
+#include "staticfilestore.h"
+
+namespace
+{
+
+/**
+ * The uncompressed content of files larger than this is not kept in memory,
+ * but it is sent by sendfile() from the disk.
+ */
+const std::uint64_t SendfileThreshold = 1024 * 1024;
+
+/**
+ * Files smaller than this are not compressed.
+ */
+const std::size_t MinCompressedSize = 256;
+
+/**
+ * Brotli's maximal quality is about ten times slower than this one, which
+ * would delay the first response of the larger scripts too much.
+ */
+const int BrotliQuality = 9;
+
+bool isCompressible(const std::string& mimeType_)
+{
+  return mimeType_.compare(0, 5, "text/") == 0
+    || mimeType_ == "application/javascript"
+    || mimeType_ == "application/x-javascript"
+    || mimeType_ == "application/json"
+    || mimeType_ == "application/xml"
+    || mimeType_ == "image/svg+xml";
+}
+
+std::string gzipCompress(const std::string& data_)
+{
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+
+  // 16 is added to the window bits for writing a gzip header.
+  if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9,
+      Z_DEFAULT_STRATEGY) != Z_OK)
+    return std::string();
+
+  std::string result(deflateBound(&stream, data_.size()), '\0');
+
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data_.data()));
+  stream.avail_in = data_.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+  stream.avail_out = result.size();
+
+  int ret = deflate(&stream, Z_FINISH);
+  result.resize(ret == Z_STREAM_END ? stream.total_out : 0);
+
+  deflateEnd(&stream);
+
+  return result;
+}
+
+std::string brotliCompress(const std::string& data_)
+{
+#ifdef HAVE_BROTLI
+  std::size_t size = BrotliEncoderMaxCompressedSize(data_.size());
+  if (!size)
+    return std::string();
+
+  std::string result(size, '\0');
+
+  if (!BrotliEncoderCompress(
+    BrotliQuality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+    data_.size(), reinterpret_cast<const std::uint8_t*>(data_.data()),
+    &size, reinterpret_cast<std::uint8_t*>(&result[0])))
+    return std::string();
+
+  result.resize(size);
+  return result;
+#else
+  (void)data_;
+  return std::string();
+#endif
+}
+
+/**
+ * Returns true if the given Accept-Encoding header contains the encoding
+ * and it is not explicitly refused by a zero quality value.
+ */
+bool acceptsEncoding(const char* header_, const std::string& encoding_)
+{
+  if (!header_)
+    return false;
+
+  std::stringstream ss(header_);
+  std::string item;
+
+  while (std::getline(ss, item, ','))
+  {
+    std::size_t begin = item.find_first_not_of(' ');
+    if (begin == std::string::npos)
+      continue;
+
+    std::size_t end = item.find(';', begin);
+    std::string name = item.substr(begin, end == std::string::npos
+      ? std::string::npos : end - begin);
+    name.erase(name.find_last_not_of(' ') + 1);
+
+    if (name != encoding_)
+      continue;
+
+    std::size_t q = item.find("q=", begin);
+    return q == std::string::npos || std::atof(item.c_str() + q + 2) > 0;
+  }
+
+  return false;
+}
+
+}
+
+namespace cc
+{
+namespace webserver
+{
+
+const std::string StaticFileStore::VersionPlaceholder = "__CC_WEBGUI_VERSION__";
+
+StaticFileStore::StaticFileStore(
+  const std::string& root_,
+  std::size_t memoryLimit_,
+  std::size_t threadCount_)
+  : _memoryLimit(memoryLimit_), _memory(0)
+{
+  namespace fs = boost::filesystem;
+
+  std::string root = root_;
+  while (root.size() > 1 && root.back() == '/')
+    root.pop_back();
+
+  //--- Collect the files ---//
+
+  std::vector<std::string> keys;
+  std::vector<Asset> assets;
+  boost::system::error_code ec;
+
+  for (fs::recursive_directory_iterator it(root, ec), end;
+       it != end;
+       it.increment(ec))
+  {
+    if (ec || !fs::is_regular_file(it->status()))
+      continue;
+
+    Asset asset;
+    asset.path = it->path().native();
+    asset.mimeType = mg_get_mime_type(asset.path.c_str(), "text/plain");
+
+    keys.push_back(asset.path.substr(root.size() + 1));
+    assets.push_back(std::move(asset));
+  }
+
+  //--- Hash the files ---//
+
+  {
+    util::TaskExecutor executor(threadCount_);
+    util::TaskGroup group(executor, threadCount_);
+
+    for (Asset& asset : assets)
+      group.run([&asset]{ load(asset); });
+
+    group.wait();
+  }
+
+  //--- Compute the version ---//
+
+  std::vector<std::size_t> order(assets.size());
+  for (std::size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+
+  std::sort(order.begin(), order.end(),
+    [&keys](std::size_t a_, std::size_t b_){ return keys[a_] < keys[b_]; });
+
+  std::string versionData;
+  for (std::size_t i : order)
+    versionData += keys[i] + ' ' + assets[i].hash + '\n';
+
+  _version = util::sha1Hash(versionData).substr(0, 16);
+
+  //--- Fill in the version in the pages ---//
+
+  for (Asset& asset : assets)
+  {
+    if (asset.mimeType != "text/html" ||
+        asset.content.find(VersionPlaceholder) == std::string::npos)
+      continue;
+
+    for (std::size_t pos = asset.content.find(VersionPlaceholder);
+         pos != std::string::npos;
+         pos = asset.content.find(VersionPlaceholder, pos))
+      asset.content.replace(pos, VersionPlaceholder.size(), _version);
+
+    asset.size = asset.content.size();
+    asset.hash = util::sha1Hash(asset.content).substr(0, 20);
+  }
+
+  //--- Apply the memory limit ---//
+
+  for (std::size_t i : order)
+  {
+    Asset& asset = assets[i];
+
+    // The pages with the version have been modified, so these can't be read
+    // from the disk.
+    bool versioned = asset.mimeType == "text/html" && asset.inMemory;
+
+    if (_memory + asset.content.size() > _memoryLimit && !versioned)
+    {
+      std::string().swap(asset.content);
+      asset.inMemory = false;
+    }
+    else
+      _memory += asset.content.size();
+
+    _assets.emplace(std::move(keys[i]), std::move(asset));
+  }
+
+  LOG(info)
+    << "Static files: " << _assets.size() << " files, "
+    << _memory / 1024 << " KiB in memory, version " << _version;
+}
+
+void StaticFileStore::load(Asset& asset_)
+{
+  std::ifstream file(asset_.path, std::ios::binary);
+  std::stringstream ss;
+  ss << file.rdbuf();
+
+  struct stat st;
+  if (!file || ::stat(asset_.path.c_str(), &st) != 0)
+  {
+    LOG(warning) << "Can't read static file: " << asset_.path;
+    return;
+  }
+
+  asset_.content = ss.str();
+  asset_.size = asset_.content.size();
+  asset_.mtime = st.st_mtime;
+  asset_.hash = util::sha1Hash(asset_.content).substr(0, 20);
+
+  asset_.inMemory = asset_.size <= SendfileThreshold;
+  if (!asset_.inMemory)
+    std::string().swap(asset_.content);
+}
+
+void StaticFileStore::compress(Asset& asset_)
+{
+  if (asset_.compressed)
+    return;
+
+  asset_.compressed = true;
+
+  if (asset_.size < MinCompressedSize || !isCompressible(asset_.mimeType))
+    return;
+
+  //--- Read the content if it is not in memory ---//
+
+  std::string fromDisk;
+
+  if (!asset_.inMemory)
+  {
+    std::ifstream file(asset_.path, std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+
+    struct stat st;
+    if (!file || ::stat(asset_.path.c_str(), &st) != 0 ||
+        static_cast<std::uint64_t>(st.st_size) != asset_.size ||
+        st.st_mtime != asset_.mtime)
+      return;
+
+    fromDisk = ss.str();
+  }
+
+  const std::string& content = asset_.inMemory ? asset_.content : fromDisk;
+
+  //--- Compress ---//
+
+  // The compressed variants are kept only if they are considerably smaller.
+  const std::size_t limit = content.size() / 10 * 9;
+
+  std::string gzip = gzipCompress(content);
+  if (gzip.size() > limit)
+    gzip.clear();
+
+  std::string brotli = brotliCompress(content);
+  if (brotli.size() > limit)
+    brotli.clear();
+
+  //--- Apply the memory limit ---//
+
+  std::size_t size = gzip.size() + brotli.size();
+
+  {
+    std::lock_guard<std::mutex> guard(_memoryMutex);
+
+    if (_memory + size > _memoryLimit)
+    {
+      LOG(debug)
+        << "Static file cache is full, " << asset_.path
+        << " is served uncompressed.";
+      return;
+    }
+
+    _memory += size;
+  }
+
+  asset_.gzip = std::move(gzip);
+  asset_.brotli = std::move(brotli);
+}
+
+const std::string& StaticFileStore::version() const
+{
+  return _version;
+}
+
+int StaticFileStore::serve(
+  struct mg_connection* conn_,
+  const std::string& uri_)
+{
+  if (std::strcmp(conn_->request_method, "GET") != 0 &&
+      std::strcmp(conn_->request_method, "HEAD") != 0)
+    return MG_FALSE;
+
+  auto it = _assets.find(uri_.empty() || uri_.back() == '/'
+    ? uri_ + "index.html"
+    : uri_);
+
+  if (it == _assets.end() || it->second.hash.empty())
+    return MG_FALSE;
+
+  Asset& asset = it->second;
+
+  //--- Select the variant ---//
+
+  const char* acceptEncoding = mg_get_header(conn_, "Accept-Encoding");
+  const bool acceptsBrotli = acceptsEncoding(acceptEncoding, "br");
+  const bool acceptsGzip = acceptsEncoding(acceptEncoding, "gzip");
+
+  // The variants aren't modified once the asset is compressed, so these can be
+  // read without holding the lock afterwards.
+  bool compressed;
+  {
+    std::lock_guard<std::mutex> guard(*asset.mutex);
+    if (acceptsBrotli || acceptsGzip)
+      compress(asset);
+    compressed = asset.compressed;
+  }
+
+  const std::string* body = asset.inMemory ? &asset.content : nullptr;
+  const char* encoding = nullptr;
+  std::string etag = asset.hash;
+
+  if (compressed && !asset.brotli.empty() && acceptsBrotli)
+  {
+    body = &asset.brotli;
+    encoding = "br";
+    etag += "-br";
+  }
+  else if (compressed && !asset.gzip.empty() && acceptsGzip)
+  {
+    body = &asset.gzip;
+    encoding = "gzip";
+    etag += "-gz";
+  }
+
+  etag = '"' + etag + '"';
+
+  // Versioned URLs never change their content, so these can be cached
+  // forever. Other files have to be revalidated by their ETag.
+  const char* cacheControl
+    = conn_->query_string && std::strncmp(conn_->query_string, "v=", 2) == 0
+    ? "public, max-age=31536000, immutable"
+    : "no-cache";
+
+  const bool hasVariants
+    = asset.size >= MinCompressedSize && isCompressible(asset.mimeType);
+
+  const char* ifNoneMatch = mg_get_header(conn_, "If-None-Match");
+  if (ifNoneMatch && etag == ifNoneMatch)
+  {
+    mg_send_status(conn_, 304);
+    mg_send_header(conn_, "ETag", etag.c_str());
+    mg_send_header(conn_, "Cache-Control", cacheControl);
+    if (hasVariants)
+      mg_send_header(conn_, "Vary", "Accept-Encoding");
+    mg_write(conn_, "\r\n", 2);
+    return MG_TRUE;
+  }
+
+  //--- Open the file if it is not in memory ---//
+
+  int fd = -1;
+
+  if (!body)
+  {
+    struct stat st;
+
+    fd = ::open(asset.path.c_str(), O_RDONLY);
+
+    // The file has been modified since the startup: it doesn't match the
+    // ETag any more, so let mongoose serve it.
+    if (fd < 0 || ::fstat(fd, &st) != 0 ||
+        static_cast<std::uint64_t>(st.st_size) != asset.size ||
+        st.st_mtime != asset.mtime)
+    {
+      if (fd >= 0)
+        ::close(fd);
+      return MG_FALSE;
+    }
+  }
+
+  //--- Send the response ---//
+
+  const std::uint64_t length = body ? body->size() : asset.size;
+
+  mg_send_header(conn_, "Content-Type", asset.mimeType.c_str());
+  mg_send_header(conn_, "Content-Length", std::to_string(length).c_str());
+  mg_send_header(conn_, "ETag", etag.c_str());
+  mg_send_header(conn_, "Cache-Control", cacheControl);
+  if (hasVariants)
+    mg_send_header(conn_, "Vary", "Accept-Encoding");
+  if (encoding)
+    mg_send_header(conn_, "Content-Encoding", encoding);
+  mg_write(conn_, "\r\n", 2);
+
+  if (std::strcmp(conn_->request_method, "HEAD") == 0)
+  {
+    if (fd >= 0)
+      ::close(fd);
+    return MG_TRUE;
+  }
+
+  if (body)
+  {
+    mg_write(conn_, body->data(), body->size());
+    return MG_TRUE;
+  }
+
+  // Mongoose closes the file after sending it.
+  mg_send_file_fd(conn_, fd, asset.size);
+  return MG_MORE;
+}
+
+} // webserver
+} // cc
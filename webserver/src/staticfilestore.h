@@ -0,0 +1,114 @@
+#ifndef CC_WEBSERVER_STATICFILESTORE_H
+#define CC_WEBSERVER_STATICFILESTORE_H
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <webserver/mongoose.h>
+
+namespace cc
+{
+namespace webserver
+{
+
+/**
+ * @brief In-memory store of the static files of the web GUI.
+ *
+ * The whole directory tree is loaded at startup. Every file is identified by
+ * the hash of its content, which is used as its ETag, and the version of the
+ * web GUI is computed from these hashes. The version replaces the
+ * VersionPlaceholder in the HTML pages, which refer to the other files with
+ * versioned URLs (?v=<version>). Such URLs are cached by the browsers forever.
+ *
+ * Textual files (scripts, style sheets, etc.) are also compressed by gzip and,
+ * if the webserver is built with Brotli support, by Brotli when they are first
+ * requested by a client accepting a compressed encoding, and the smallest
+ * variant accepted by the client is sent.
+ *
+ * The uncompressed content of large files is not kept in memory: these are
+ * sent directly from the disk by sendfile(). The contents and the compressed
+ * variants together are kept under the memory limit: beyond it the files are
+ * served from the disk and uncompressed.
+ */
+class StaticFileStore
+{
+public:
+  /**
+   * The placeholder of the version in the HTML pages.
+   */
+  static const std::string VersionPlaceholder;
+
+  /**
+   * Loads the files of the given directory.
+   * @param memoryLimit_ Maximal size of the file contents and compressed
+   * variants kept in memory.
+   * @param threadCount_ Number of threads used for hashing.
+   */
+  StaticFileStore(
+    const std::string& root_,
+    std::size_t memoryLimit_,
+    std::size_t threadCount_);
+
+  /**
+   * Returns the version of the web GUI, which changes whenever the content
+   * of any file changes.
+   */
+  const std::string& version() const;
+
+  /**
+   * Serves the file belonging to the given URI, which is relative to the root
+   * directory. Returns MG_FALSE if the file is not in the store, so that
+   * mongoose can serve it from the disk (e.g. it has been created after the
+   * startup).
+   */
+  int serve(struct mg_connection* conn_, const std::string& uri_);
+
+private:
+  struct Asset
+  {
+    std::string path;
+    std::string mimeType;
+    std::string hash;
+    std::uint64_t size = 0;
+    std::time_t mtime = 0;
+    bool inMemory = false;
+    std::string content;
+
+    /**
+     * Guards the compressed variants, which are computed on the first
+     * request only.
+     */
+    std::unique_ptr<std::mutex> mutex{new std::mutex};
+    bool compressed = false;
+    std::string gzip;
+    std::string brotli;
+  };
+
+  /**
+   * Reads the file of the asset and computes its hash.
+   */
+  static void load(Asset& asset_);
+
+  /**
+   * Computes the compressed variants of the asset unless it has been done
+   * already. The variants are dropped if they don't fit in the memory limit.
+   * The mutex of the asset must be held by the caller.
+   */
+  void compress(Asset& asset_);
+
+  std::unordered_map<std::string, Asset> _assets;
+  std::string _version;
+
+  const std::size_t _memoryLimit;
+  std::mutex _memoryMutex;
+  std::size_t _memory;
+};
+
+} // webserver
+} // cc
+
+#endif // CC_WEBSERVER_STATICFILESTORE_H
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 
 #include <boost/filesystem.hpp>
@@ -38,7 +39,27 @@ po::options_description commandLineArguments()
          "Logging level of the parser. Possible values are: debug, info, warning, "
          "error, critical")
         ("jobs,j", po::value<int>()->default_value(4),
-         "Number of worker threads.");
+         "Number of worker threads.")
+        ("request-timeout", po::value<int>()->default_value(300),
+         "Number of seconds after which a service request is cancelled. "
+         "Services stop working on cancelled requests and reply with an "
+         "error. Requests are also cancelled when the client closes the "
+         "connection. 0 means no timeout.")
+        ("coalesce-requests", po::value<int>()->default_value(8),
+         "Identical calls of side-effect free service methods arriving at "
+         "the same time are answered by a single computation. This is the "
+         "maximal number of calls waiting for the same computation. 0 turns "
+         "coalescing off.")
+        ("etag", po::value<bool>()->default_value(true),
+         "The responses of side-effect free service methods get an ETag "
+         "which changes only when the workspace is reparsed, so that clients "
+         "can revalidate the results of earlier calls instead of downloading "
+         "them again.")
+        ("static-cache-size", po::value<int>()->default_value(256),
+         "The static files of the web GUI are loaded into memory at startup, "
+         "and their compressed variants are added on their first request. "
+         "This is the maximal memory used for them in MiB. The rest of the "
+         "files are served from the disk, uncompressed.");
 
     return desc;
 }
@@ -116,6 +137,13 @@ int main(int argc, char* argv[])
     std::unique_ptr<SessionManager> sessions{
         std::make_unique<SessionManager>(authHandler.get_ptr())};
     requestHandler.sessionManager = sessions.get();
+    requestHandler.requestTimeout
+        = std::chrono::seconds(vm["request-timeout"].as<int>());
+    requestHandler.staticFiles = std::make_shared<StaticFileStore>(
+        vm["webguiDir"].as<std::string>(),
+        static_cast<std::size_t>(
+          std::max(vm["static-cache-size"].as<int>(), 0)) * 1024 * 1024,
+        static_cast<std::size_t>(std::max(vm["jobs"].as<int>(), 1)));
 
     //--- Process workspaces ---//
 